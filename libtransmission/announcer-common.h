@@ -9,14 +9,19 @@
 #error only the libtransmission announcer module should #include this header.
 #endif
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <compare>
+#include <cstddef> // size_t
 #include <cstdint> // uint64_t
 #include <ctime>
+#include <map>
 #include <optional>
+#include <set>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "libtransmission/announcer.h"
@@ -238,3 +243,200 @@ struct tr_scrape_response
      * this is an unofficial extension that some trackers won't support. */
     time_t min_request_interval;
 };
+
+// ---
+
+// A tracker's scrape URL and budget, shared by every tier that scrapes it.
+struct tr_scrape_info
+{
+    // how many scrape requests a tracker may leave unanswered
+    static auto constexpr MaxRequestsInFlight = size_t{ 2U };
+
+    // how many seconds to wait between scrape requests to a tracker
+    static auto constexpr MinRequestInterval = time_t{ 1 };
+
+    tr_scrape_info(tr_interned_string scrape_url_in, size_t const multiscrape_max_in)
+        : multiscrape_max{ multiscrape_max_in }
+        , scrape_url{ scrape_url_in }
+    {
+    }
+
+    [[nodiscard]] constexpr bool is_busy() const noexcept
+    {
+        return requests_in_flight >= MaxRequestsInFlight;
+    }
+
+    [[nodiscard]] constexpr bool is_throttled(time_t const now) const noexcept
+    {
+        return now < next_request_at;
+    }
+
+    constexpr void on_request_sent(time_t const now) noexcept
+    {
+        ++requests_in_flight;
+        next_request_at = now + MinRequestInterval;
+    }
+
+    size_t multiscrape_max;
+
+    // how many of our scrape requests this tracker hasn't answered yet
+    size_t requests_in_flight = 0U;
+
+    // the earliest time the next scrape request may be sent
+    time_t next_request_at = 0;
+
+    // the (torrent id, tier id) of tiers that are due for a scrape
+    // but are waiting for a request in flight to be answered first
+    std::set<std::pair<tr_torrent_id_t, size_t>> waiting;
+
+    tr_interned_string scrape_url;
+};
+
+// Decides which of the tiers that are due for a scrape get scraped in
+// one upkeep and how their info_hashes are packed into requests, keeping
+// within the upkeep's budget and each tracker's `tr_scrape_info` budget.
+template<typename Tier>
+struct tr_scrape_plan
+{
+    // `due` is each tier that needs a scrape, with its tracker's scrape info.
+    // Tiers in `announcing` are skipped, since the announce response
+    // will have the swarm counts. The trackers' budgets are charged for
+    // the requests that are planned.
+    [[nodiscard]] static tr_scrape_plan make(
+        std::vector<std::pair<tr_scrape_info*, Tier>> const& due,
+        std::vector<Tier> announcing,
+        size_t const max_requests,
+        time_t const now)
+    {
+        std::ranges::sort(announcing);
+
+        // group the tiers by tracker so that each tracker's
+        // info_hashes are packed into as few requests as possible
+        auto by_tracker = std::vector<std::pair<tr_scrape_info*, std::vector<Tier>>>{};
+        auto tracker_idx = std::map<tr_scrape_info*, size_t>{};
+        for (auto const& [scrape_info, tier] : due)
+        {
+            if (std::ranges::binary_search(announcing, tier))
+            {
+                continue;
+            }
+
+            auto const [it, is_new] = tracker_idx.try_emplace(scrape_info, std::size(by_tracker));
+            if (is_new)
+            {
+                by_tracker.emplace_back(scrape_info, std::vector<Tier>{});
+            }
+
+            by_tracker[it->second].second.push_back(tier);
+        }
+
+        auto plan = tr_scrape_plan{};
+        for (auto& [scrape_info, tiers] : by_tracker)
+        {
+            auto const max_hashes = std::min(scrape_info->multiscrape_max, size_t{ TrMultiscrapeMax });
+            auto it = std::begin(tiers);
+            auto const end = std::end(tiers);
+
+            while (it != end && std::size(plan.requests) < max_requests && !scrape_info->is_busy() &&
+                   !scrape_info->is_throttled(now))
+            {
+                auto& request_tiers = plan.requests.emplace_back(scrape_info, std::vector<Tier>{}).second;
+                scrape_info->on_request_sent(now);
+
+                for (; it != end && std::size(request_tiers) < max_hashes; ++it)
+                {
+                    request_tiers.push_back(*it);
+                }
+            }
+
+            for (; it != end; ++it)
+            {
+                if (scrape_info->is_busy())
+                {
+                    plan.busy.emplace_back(scrape_info, *it);
+                }
+                else if (scrape_info->is_throttled(now))
+                {
+                    plan.throttled.emplace_back(scrape_info, *it);
+                }
+                else
+                {
+                    plan.deferred.push_back(*it);
+                }
+            }
+        }
+
+        return plan;
+    }
+
+    // the requests to send, each with the tiers to scrape from one tracker
+    std::vector<std::pair<tr_scrape_info*, std::vector<Tier>>> requests;
+
+    // tiers whose tracker already has too many requests in flight.
+    // They should wait until one of those is answered.
+    std::vector<std::pair<tr_scrape_info*, Tier>> busy;
+
+    // tiers whose tracker was sent a request too recently.
+    // They should wait until the tracker's `next_request_at`.
+    std::vector<std::pair<tr_scrape_info*, Tier>> throttled;
+
+    // tiers that didn't fit into this upkeep's `max_requests`
+    std::vector<Tier> deferred;
+};
+
+// ---
+
+// A min-heap of upcoming announce and scrape deadlines, so that upkeep
+// only has to look at tiers that are due instead of scanning every tier
+// of every torrent. Each tier has at most one live deadline of each kind.
+// When a deadline changes, its old heap entry is skipped once it reaches
+// the top, and the heap is rebuilt if skipped entries pile up.
+class tr_announcer_schedule
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Announce,
+        Scrape
+    };
+
+    struct Entry
+    {
+        time_t at;
+        tr_torrent_id_t tor_id;
+        size_t tier_id;
+        Kind kind;
+
+        [[nodiscard]] constexpr auto operator<=>(Entry const&) const noexcept = default;
+    };
+
+    // Sets a tier's deadline of the given kind, or removes it if `at` is 0.
+    void set(tr_torrent_id_t tor_id, size_t tier_id, Kind kind, time_t at);
+
+    // Removes both of a tier's deadlines.
+    void erase(size_t tier_id);
+
+    // Removes and returns the deadlines at or before `now`, earliest first.
+    [[nodiscard]] std::vector<Entry> pop_due(time_t now);
+
+    // the number of deadlines that haven't come due yet
+    [[nodiscard]] auto size() const noexcept
+    {
+        return std::size(deadlines_);
+    }
+
+    // the number of heap entries, including ones that are no longer live
+    [[nodiscard]] auto heap_size() const noexcept
+    {
+        return std::size(heap_);
+    }
+
+private:
+    static auto constexpr MinCompactSize = size_t{ 64U };
+
+    void maybe_compact();
+
+    std::map<std::pair<size_t, Kind>, Entry> deadlines_;
+
+    std::vector<Entry> heap_;
+};
@@ -18,6 +18,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 #ifdef _WIN32
@@ -359,12 +360,108 @@ private:
 
 // --- TRACKER
 
+struct tau_tracker;
+
+// Maps every outstanding transaction id to the tracker it was sent to,
+// so that incoming responses can be routed without scanning every tracker.
+using tau_transactions = std::unordered_map<tau_transaction_t, tau_tracker*>;
+
+// A FIFO of pending requests that can also be searched by transaction id.
+//
+// Requests are appended as they're created and every request of a given
+// type has the same timeout, so the queue is also sorted by expiry time.
+template<typename T>
+class tau_request_queue
+{
+public:
+    using iterator = typename std::list<T>::iterator;
+
+    tau_request_queue(tau_transactions& transactions, tau_tracker* tracker)
+        : transactions_{ transactions }
+        , tracker_{ tracker }
+    {
+    }
+
+    tau_request_queue(tau_request_queue const&) = delete;
+    tau_request_queue(tau_request_queue&&) = delete;
+    tau_request_queue& operator=(tau_request_queue const&) = delete;
+    tau_request_queue& operator=(tau_request_queue&&) = delete;
+
+    ~tau_request_queue()
+    {
+        clear();
+    }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        auto& req = requests_.emplace_back(std::forward<Args>(args)...);
+        by_id_.try_emplace(req.transaction_id, std::prev(std::end(requests_)));
+        transactions_.insert_or_assign(req.transaction_id, tracker_);
+        return req;
+    }
+
+    iterator erase(iterator it)
+    {
+        forget(it->transaction_id);
+        return requests_.erase(it);
+    }
+
+    void clear()
+    {
+        for (auto const& req : requests_)
+        {
+            forget(req.transaction_id);
+        }
+
+        requests_.clear();
+    }
+
+    [[nodiscard]] iterator find(tau_transaction_t const id)
+    {
+        auto const it = by_id_.find(id);
+        return it == std::end(by_id_) ? std::end(requests_) : it->second;
+    }
+
+    [[nodiscard]] auto begin() noexcept
+    {
+        return std::begin(requests_);
+    }
+
+    [[nodiscard]] auto end() noexcept
+    {
+        return std::end(requests_);
+    }
+
+    [[nodiscard]] auto empty() const noexcept
+    {
+        return std::empty(requests_);
+    }
+
+private:
+    void forget(tau_transaction_t const id)
+    {
+        by_id_.erase(id);
+
+        if (auto const it = transactions_.find(id); it != std::end(transactions_) && it->second == tracker_)
+        {
+            transactions_.erase(it);
+        }
+    }
+
+    std::list<T> requests_;
+    std::unordered_map<tau_transaction_t, iterator> by_id_;
+    tau_transactions& transactions_;
+    tau_tracker* const tracker_;
+};
+
 struct tau_tracker
 {
     using Mediator = tr_announcer_udp::Mediator;
 
     tau_tracker(
         Mediator& mediator,
+        tau_transactions& transactions,
         std::string_view const authority_in,
         std::string_view const host_in,
         std::string_view const host_lookup_in,
@@ -373,10 +470,26 @@ struct tau_tracker
         , host{ host_in }
         , host_lookup{ host_lookup_in }
         , port{ port_in }
+        , announces{ transactions, this }
+        , scrapes{ transactions, this }
         , mediator_{ mediator }
+        , transactions_{ transactions }
     {
     }
 
+    tau_tracker(tau_tracker const&) = delete;
+    tau_tracker(tau_tracker&&) = delete;
+    tau_tracker& operator=(tau_tracker const&) = delete;
+    tau_tracker& operator=(tau_tracker&&) = delete;
+
+    ~tau_tracker()
+    {
+        for (auto const id : connection_transaction_id)
+        {
+            forget_connection_transaction(id);
+        }
+    }
+
     void sendto(tr_address_type ip_protocol, std::byte const* buf, size_t buflen)
     {
         TR_ASSERT(tr_address::is_valid(ip_protocol));
@@ -405,6 +518,7 @@ struct tau_tracker
         }
 
         connecting_at[ip_protocol] = 0;
+        forget_connection_transaction(connection_transaction_id[ip_protocol]);
         connection_transaction_id[ip_protocol] = 0;
 
         if (action == TAU_ACTION_CONNECT)
@@ -486,6 +600,7 @@ struct tau_tracker
 
                 conn_at = now;
                 conn_transc_id = tau_transaction_new();
+                transactions_.insert_or_assign(conn_transc_id, this);
                 logtrace(
                     log_name(),
                     fmt::format("Trying to connect {}. Transaction ID is {}", tr_ip_protocol_to_sv(ipp_enum), conn_transc_id));
@@ -560,20 +675,15 @@ private:
     }
 
     template<typename T>
-    void timeout_requests(std::list<T>& requests, time_t now, std::string_view name)
+    void timeout_requests(tau_request_queue<T>& requests, time_t now, std::string_view name)
     {
-        for (auto it = std::begin(requests); it != std::end(requests);)
+        // the queue is sorted by expiry, so stop at the first live request
+        for (auto it = std::begin(requests); it != std::end(requests) && it->expires_at() <= now;)
         {
-            if (auto& req = *it; req.expires_at() <= now)
-            {
-                logtrace(log_name(), fmt::format("timeout {} req {}", name, fmt::ptr(&req)));
-                req.fail(false, true, "");
-                it = requests.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
+            auto& req = *it;
+            logtrace(log_name(), fmt::format("timeout {} req {}", name, fmt::ptr(&req)));
+            req.fail(false, true, "");
+            it = requests.erase(it);
         }
     }
 
@@ -591,7 +701,7 @@ private:
     }
 
     template<typename T>
-    void maybe_send_requests(std::list<T>& reqs, time_t now)
+    void maybe_send_requests(tau_request_queue<T>& reqs, time_t now)
     {
         for (auto it = std::begin(reqs); it != std::end(reqs);)
         {
@@ -654,11 +764,20 @@ public:
     std::array<tau_connection_t, NUM_TR_AF_INET_TYPES> connection_id = {};
     std::array<tau_transaction_t, NUM_TR_AF_INET_TYPES> connection_transaction_id = {};
 
-    std::list<tau_announce_request> announces;
-    std::list<tau_scrape_request> scrapes;
+    tau_request_queue<tau_announce_request> announces;
+    tau_request_queue<tau_scrape_request> scrapes;
 
 private:
+    void forget_connection_transaction(tau_transaction_t const id)
+    {
+        if (auto const it = transactions_.find(id); id != 0 && it != std::end(transactions_) && it->second == this)
+        {
+            transactions_.erase(it);
+        }
+    }
+
     Mediator& mediator_;
+    tau_transactions& transactions_;
 
     std::array<std::optional<std::future<std::optional<tr_socket_address>>>, NUM_TR_AF_INET_TYPES> addr_pending_dns_;
 
@@ -739,45 +858,45 @@ public:
 
         auto const socket_address = tr_socket_address::from_sockaddr(from);
         auto const ip_protocol = socket_address ? socket_address->address().type : NUM_TR_AF_INET_TYPES;
-        for (auto& tracker : trackers_)
+
+        auto const iter = transactions_.find(transaction_id);
+        if (iter == std::end(transactions_))
         {
-            // is it a connection response?
-            if (tr_address::is_valid(ip_protocol) && tracker.connecting_at[ip_protocol] != 0 &&
-                transaction_id == tracker.connection_transaction_id[ip_protocol])
-            {
-                logtrace(tracker.log_name(), fmt::format("{} is my connection request!", transaction_id));
-                tracker.on_connection_response(ip_protocol, action_id, buf);
-                return true;
-            }
+            return false;
+        }
+
+        auto& tracker = *iter->second;
 
-            // is it a response to one of this tracker's announces?
-            if (auto& reqs = tracker.announces; !std::empty(reqs))
+        // is it a connection response?
+        if (tr_address::is_valid(ip_protocol) && tracker.connecting_at[ip_protocol] != 0 &&
+            transaction_id == tracker.connection_transaction_id[ip_protocol])
+        {
+            logtrace(tracker.log_name(), fmt::format("{} is my connection request!", transaction_id));
+            tracker.on_connection_response(ip_protocol, action_id, buf);
+            return true;
+        }
+
+        // is it a response to one of this tracker's announces?
+        if (auto& reqs = tracker.announces; !std::empty(reqs))
+        {
+            if (auto it = reqs.find(transaction_id); it != std::end(reqs))
             {
-                if (auto it = std::ranges::find_if(
-                        reqs,
-                        [&transaction_id](auto const& req) { return req.transaction_id == transaction_id; });
-                    it != std::ranges::end(reqs))
-                {
-                    logtrace(tracker.log_name(), fmt::format("{} is an announce request!", transaction_id));
-                    it->on_response(ip_protocol, action_id, buf);
-                    reqs.erase(it);
-                    return true;
-                }
+                logtrace(tracker.log_name(), fmt::format("{} is an announce request!", transaction_id));
+                it->on_response(ip_protocol, action_id, buf);
+                reqs.erase(it);
+                return true;
             }
+        }
 
-            // is it a response to one of this tracker's scrapes?
-            if (auto& reqs = tracker.scrapes; !std::empty(reqs))
+        // is it a response to one of this tracker's scrapes?
+        if (auto& reqs = tracker.scrapes; !std::empty(reqs))
+        {
+            if (auto it = reqs.find(transaction_id); it != std::end(reqs))
             {
-                if (auto it = std::ranges::find_if(
-                        reqs,
-                        [&transaction_id](auto const& req) { return req.transaction_id == transaction_id; });
-                    it != std::ranges::end(reqs))
-                {
-                    logtrace(tracker.log_name(), fmt::format("{} is a scrape request!", transaction_id));
-                    it->on_response(action_id, buf);
-                    reqs.erase(it);
-                    return true;
-                }
+                logtrace(tracker.log_name(), fmt::format("{} is a scrape request!", transaction_id));
+                it->on_response(action_id, buf);
+                reqs.erase(it);
+                return true;
             }
         }
 
@@ -805,21 +924,20 @@ private:
 
         // see if we already have it
         auto const authority = parsed->authority;
-        for (auto& tracker : trackers_)
+        if (auto const it = tracker_by_authority_.find(authority); it != std::end(tracker_by_authority_))
         {
-            if (tracker.authority == authority)
-            {
-                return &tracker;
-            }
+            return it->second;
         }
 
         // we don't have it -- build a new one
         auto& tracker = trackers_.emplace_back(
             mediator_,
+            transactions_,
             authority,
             parsed->host,
             parsed->host_wo_brackets,
             tr_port::from_host(parsed->port));
+        tracker_by_authority_.try_emplace(tracker.authority, &tracker);
         logtrace(tracker.log_name(), "New tau_tracker created");
         return &tracker;
     }
@@ -849,7 +967,11 @@ private:
         return false;
     }
 
+    // declared before `trackers_` so that it outlives them
+    tau_transactions transactions_;
+
     std::list<tau_tracker> trackers_;
+    std::unordered_map<std::string_view, tau_tracker*> tracker_by_authority_;
 
     Mediator& mediator_;
 };
@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <ctime>
 #include <deque>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <memory>
@@ -17,6 +18,7 @@
 #include <optional>
 #include <ranges>
 #include <set>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -101,18 +103,7 @@ struct StopsCompare
 
 // ---
 
-struct tr_scrape_info
-{
-    size_t multiscrape_max;
-
-    tr_interned_string scrape_url;
-
-    constexpr tr_scrape_info(tr_interned_string scrape_url_in, size_t const multiscrape_max_in)
-        : multiscrape_max{ multiscrape_max_in }
-        , scrape_url{ scrape_url_in }
-    {
-    }
-};
+struct tr_tier;
 
 /**
  * "global" (per-tr_session) fields
@@ -160,6 +151,34 @@ public:
         tr_announce_response const& response);
     void onScrapeDone(tr_scrape_response const& response);
 
+    // Call this whenever a tier's announce or scrape time may have changed,
+    // or when something that was blocking it (e.g. an announce in progress)
+    // is finished.
+    void schedule(tr_tier const& tier);
+
+    // Sets just one of a tier's deadlines, e.g. to retry something
+    // that was due but had to be put off.
+    void defer(tr_tier const& tier, tr_announcer_schedule::Kind kind, time_t at);
+
+    // Puts tiers that were waiting on a tracker back into the schedule.
+    void wake(std::set<std::pair<tr_torrent_id_t, size_t>> const& tiers);
+
+    // Pops the tiers whose announce or scrape deadline has passed.
+    // Each tier appears at most once, though it may turn out to need
+    // neither an announce nor a scrape. Those no longer need a deadline
+    // and are dropped from the schedule until `schedule()` is called again.
+    [[nodiscard]] std::vector<tr_tier*> pop_due_tiers(time_t now);
+
+    [[nodiscard]] size_t queue_depth() const noexcept override
+    {
+        return deadlines_.size();
+    }
+
+    [[nodiscard]] time_t lateness() const noexcept override
+    {
+        return lateness_;
+    }
+
     [[nodiscard]] tr_scrape_info* scrape_info(tr_interned_string url)
     {
         if (std::empty(url))
@@ -232,6 +251,11 @@ private:
 
     std::set<tr_announce_request, StopsCompare> stops_;
 
+    tr_announcer_schedule deadlines_;
+
+    // how late the most overdue deadline was in the latest upkeep
+    time_t lateness_ = 0;
+
     bool is_shutting_down_ = false;
 };
 
@@ -365,6 +389,7 @@ struct tr_tier
 {
     tr_tier(tr_announcer_impl* announcer, tr_torrent* tor_in, std::vector<tr_announce_list::tracker_info const*> const& infos)
         : tor{ tor_in }
+        , announcer_{ announcer }
     {
         trackers.reserve(std::size(infos));
         for (auto const* info : infos)
@@ -406,7 +431,10 @@ struct tr_tier
     {
         auto const* const tracker = currentTracker();
 
-        return !isScraping && scrapeAt != 0 && scrapeAt <= now && tracker != nullptr && tracker->scrape_info != nullptr;
+        // An announce in flight will probably bring back the swarm counts too,
+        // so don't scrape until it's done. onAnnounceDone() reschedules the scrape.
+        return !isScraping && !isAnnouncing && scrapeAt != 0 && scrapeAt <= now && tracker != nullptr &&
+            tracker->scrape_info != nullptr;
     }
 
     [[nodiscard]] auto countDownloaders() const
@@ -441,6 +469,8 @@ struct tr_tier
         lastAnnounceStartTime = 0;
         lastScrapeStartTime = 0;
 
+        announcer_->schedule(*this);
+
         return currentTracker();
     }
 
@@ -470,6 +500,11 @@ struct tr_tier
         return this->manualAnnounceAllowedAt <= tr_time();
     }
 
+    [[nodiscard]] constexpr auto* announcer() const noexcept
+    {
+        return announcer_;
+    }
+
     void scheduleNextScrape()
     {
         scheduleNextScrape(this->scrapeIntervalSec);
@@ -483,6 +518,7 @@ struct tr_tier
     void scheduleNextScrape(time_t interval_secs)
     {
         this->scrapeAt = getNextScrapeTime(tor->session, this, interval_secs);
+        announcer_->schedule(*this);
     }
 
     std::deque<tr_announce_event> announce_events;
@@ -530,6 +566,8 @@ struct tr_tier
     bool isScraping = false;
 
 private:
+    tr_announcer_impl* const announcer_;
+
     // unless the tracker says otherwise, this is the announce interval
     static auto constexpr DefaultAnnounceIntervalSec = time_t{ 60 * 10 };
 
@@ -657,6 +695,136 @@ private:
     }
 };
 
+// ---
+
+void tr_announcer_schedule::set(tr_torrent_id_t const tor_id, size_t const tier_id, Kind const kind, time_t const at)
+{
+    auto const key = std::pair{ tier_id, kind };
+
+    if (at == 0)
+    {
+        deadlines_.erase(key);
+        maybe_compact();
+        return;
+    }
+
+    auto const entry = Entry{ at, tor_id, tier_id, kind };
+    if (auto const [it, is_new] = deadlines_.try_emplace(key, entry); !is_new)
+    {
+        if (it->second == entry)
+        {
+            return;
+        }
+
+        it->second = entry;
+    }
+
+    heap_.push_back(entry);
+    std::ranges::push_heap(heap_, std::greater{});
+    maybe_compact();
+}
+
+void tr_announcer_schedule::erase(size_t const tier_id)
+{
+    deadlines_.erase({ tier_id, Kind::Announce });
+    deadlines_.erase({ tier_id, Kind::Scrape });
+    maybe_compact();
+}
+
+std::vector<tr_announcer_schedule::Entry> tr_announcer_schedule::pop_due(time_t const now)
+{
+    auto due = std::vector<Entry>{};
+
+    while (!std::empty(heap_) && heap_.front().at <= now)
+    {
+        std::ranges::pop_heap(heap_, std::greater{});
+        auto const entry = heap_.back();
+        heap_.pop_back();
+
+        // skip entries for deadlines that have since moved or been removed
+        if (auto const it = deadlines_.find({ entry.tier_id, entry.kind });
+            it != std::end(deadlines_) && it->second == entry)
+        {
+            deadlines_.erase(it);
+            due.push_back(entry);
+        }
+    }
+
+    return due;
+}
+
+void tr_announcer_schedule::maybe_compact()
+{
+    if (std::size(heap_) <= std::max(MinCompactSize, std::size(deadlines_) * 2U))
+    {
+        return;
+    }
+
+    heap_.clear();
+    for (auto const& [key, entry] : deadlines_)
+    {
+        heap_.push_back(entry);
+    }
+    std::ranges::make_heap(heap_, std::greater{});
+}
+
+// ---
+
+void tr_announcer_impl::schedule(tr_tier const& tier)
+{
+    using Kind = tr_announcer_schedule::Kind;
+
+    auto const tor_id = tier.tor->id();
+    deadlines_.set(tor_id, tier.id, Kind::Announce, tier.announceAt);
+    deadlines_.set(tor_id, tier.id, Kind::Scrape, tier.scrapeAt);
+}
+
+void tr_announcer_impl::defer(tr_tier const& tier, tr_announcer_schedule::Kind const kind, time_t const at)
+{
+    deadlines_.set(tier.tor->id(), tier.id, kind, at);
+}
+
+void tr_announcer_impl::wake(std::set<std::pair<tr_torrent_id_t, size_t>> const& tiers)
+{
+    for (auto const& [tor_id, tier_id] : tiers)
+    {
+        if (auto* const tor = session->torrents().get(tor_id); tor != nullptr && tor->torrent_announcer != nullptr)
+        {
+            if (auto const* const tier = tor->torrent_announcer->getTier(tier_id); tier != nullptr)
+            {
+                schedule(*tier);
+            }
+        }
+    }
+}
+
+std::vector<tr_tier*> tr_announcer_impl::pop_due_tiers(time_t now)
+{
+    auto tiers = std::vector<tr_tier*>{};
+
+    lateness_ = 0;
+    for (auto const& [at, tor_id, tier_id, kind] : deadlines_.pop_due(now))
+    {
+        lateness_ = std::max(lateness_, now - at);
+
+        auto* const tor = session->torrents().get(tor_id);
+        if (tor == nullptr || tor->torrent_announcer == nullptr)
+        {
+            continue;
+        }
+
+        if (auto* const tier = tor->torrent_announcer->getTier(tier_id); tier != nullptr)
+        {
+            tiers.push_back(tier);
+        }
+    }
+
+    std::ranges::sort(tiers);
+    auto const [first, last] = std::ranges::unique(tiers);
+    tiers.erase(first, last);
+    return tiers;
+}
+
 // --- PUBLISH
 
 namespace
@@ -851,6 +1019,7 @@ void tier_announce_event_push(tr_tier* tier, tr_announce_event e, time_t announc
     events.push_back(e);
     tier->announceAt = announce_at;
     tier_update_announce_priority(tier);
+    tier->announcer()->schedule(*tier);
 
     tr_logAddTrace_tier_announce_queue(tier);
     tr_logAddTraceTier(tier, fmt::format("announcing in {} seconds", difftime(announce_at, tr_time())));
@@ -1037,6 +1206,7 @@ void tr_announcer_impl::onAnnounceDone(
     tier->lastAnnounceSucceeded = false;
     tier->isAnnouncing = false;
     tier->manualAnnounceAllowedAt = now + tier->announceMinIntervalSec;
+    schedule(*tier);
 
     if (response.external_ip)
     {
@@ -1224,6 +1394,8 @@ void tr_announcer_impl::removeTorrent(tr_torrent* tor)
         {
             stops_.emplace(create_announce_request(this, tor, &tier, TR_ANNOUNCE_EVENT_STOPPED));
         }
+
+        deadlines_.erase(tier.id);
     }
 
     tor->torrent_announcer = nullptr;
@@ -1359,6 +1531,7 @@ void tr_announcer_impl::onScrapeDone(tr_scrape_response const& response)
 
         tier->isScraping = false;
         tier->lastScrapeTime = now;
+        schedule(*tier);
         tier->lastScrapeSucceeded = false;
         tier->lastScrapeTimedOut = response.did_timeout;
 
@@ -1400,13 +1573,14 @@ void tr_announcer_impl::onScrapeDone(tr_scrape_response const& response)
 
 namespace
 {
-void multiscrape(tr_announcer_impl* announcer, std::vector<tr_tier*> const& tiers)
+void multiscrape(tr_announcer_impl* announcer, std::vector<tr_tier*> const& tiers, std::vector<tr_tier*> announcing)
 {
+    using Kind = tr_announcer_schedule::Kind;
+
     auto const now = tr_time();
-    auto requests = std::array<tr_scrape_request, MaxScrapesPerUpkeep>{};
-    auto request_count = size_t{};
 
-    // batch as many info_hashes into a request as we can
+    auto due = std::vector<std::pair<tr_scrape_info*, tr_tier*>>{};
+    due.reserve(std::size(tiers));
     for (auto* tier : tiers)
     {
         auto const* const current_tracker = tier->currentTracker();
@@ -1416,63 +1590,60 @@ void multiscrape(tr_announcer_impl* announcer, std::vector<tr_tier*> const& tier
             continue;
         }
 
-        auto const* const scrape_info = current_tracker->scrape_info;
+        auto* const scrape_info = current_tracker->scrape_info;
         TR_ASSERT(scrape_info != nullptr);
         if (scrape_info == nullptr)
         {
             continue;
         }
 
-        bool found = false;
+        due.emplace_back(scrape_info, tier);
+    }
 
-        /* if there's a request with this scrape URL and a free slot, use it */
-        for (size_t j = 0; !found && j < request_count; ++j)
-        {
-            auto* const req = &requests[j];
+    auto const plan = tr_scrape_plan<tr_tier*>::make(due, std::move(announcing), MaxScrapesPerUpkeep, now);
 
-            if (req->info_hash_count >= scrape_info->multiscrape_max)
-            {
-                continue;
-            }
+    // Tiers whose tracker is busy wait for it to answer; the response
+    // callback below puts them back into the schedule. The others are
+    // retried once their tracker or the next upkeep has room for them.
+    for (auto const& [scrape_info, tier] : plan.busy)
+    {
+        scrape_info->waiting.emplace(tier->tor->id(), tier->id);
+    }
 
-            if (scrape_info->scrape_url != req->scrape_url)
-            {
-                continue;
-            }
+    for (auto const& [scrape_info, tier] : plan.throttled)
+    {
+        announcer->defer(*tier, Kind::Scrape, scrape_info->next_request_at);
+    }
 
-            req->info_hash[req->info_hash_count] = tier->tor->info_hash();
-            ++req->info_hash_count;
-            tier->isScraping = true;
-            tier->lastScrapeStartTime = now;
-            found = true;
-        }
+    for (auto* const tier : plan.deferred)
+    {
+        announcer->defer(*tier, Kind::Scrape, tier->scrapeAt);
+    }
 
-        /* otherwise, if there's room for another request, build a new one */
-        if (!found && request_count < MaxScrapesPerUpkeep)
-        {
-            auto* const req = &requests[request_count];
-            req->scrape_url = scrape_info->scrape_url;
-            req->log_name = tier->buildLogName();
+    /* build and send the requests */
+    for (auto const& [scrape_info, request_tiers] : plan.requests)
+    {
+        auto req = tr_scrape_request{};
+        req.scrape_url = scrape_info->scrape_url;
+        req.log_name = request_tiers.front()->buildLogName();
 
-            req->info_hash[req->info_hash_count] = tier->tor->info_hash();
-            ++req->info_hash_count;
+        for (auto* const tier : request_tiers)
+        {
+            req.info_hash[req.info_hash_count] = tier->tor->info_hash();
+            ++req.info_hash_count;
             tier->isScraping = true;
             tier->lastScrapeStartTime = now;
-
-            ++request_count;
         }
-    }
 
-    /* send the requests we just built */
-    for (size_t i = 0; i < request_count; ++i)
-    {
         announcer->scrape(
-            requests[i],
-            [session = announcer->session, announcer](tr_scrape_response const& response)
+            req,
+            [session = announcer->session, announcer, scrape_info](tr_scrape_response const& response)
             {
                 if (session->announcer_)
                 {
+                    --scrape_info->requests_in_flight;
                     announcer->onScrapeDone(response);
+                    announcer->wake(std::exchange(scrape_info->waiting, {}));
                 }
             });
     }
@@ -1558,29 +1729,31 @@ void scrapeAndAnnounceMore(tr_announcer_impl* announcer)
     /* build a list of tiers that need to be announced */
     auto announce_me = std::vector<tr_tier*>{};
     auto scrape_me = std::vector<tr_tier*>{};
-    for (auto* const tor : announcer->session->torrents())
+    for (auto* const tier : announcer->pop_due_tiers(now))
     {
-        for (auto& tier : tor->torrent_announcer->tiers)
+        if (tier->needsToAnnounce(now))
         {
-            if (tier.needsToAnnounce(now))
-            {
-                announce_me.push_back(&tier);
-            }
+            announce_me.push_back(tier);
+        }
 
-            if (tier.needsToScrape(now))
-            {
-                scrape_me.push_back(&tier);
-            }
+        if (tier->needsToScrape(now))
+        {
+            scrape_me.push_back(tier);
         }
     }
 
-    /* First, scrape what we can. We handle scrapes first because
-     * we can work through that queue much faster than announces
-     * (thanks to multiscrape) _and_ the scrape responses will tell
-     * us which swarms are interesting and should be announced next. */
-    multiscrape(announcer, scrape_me);
+    if (!std::empty(announce_me) || !std::empty(scrape_me))
+    {
+        tr_logAddTrace(
+            fmt::format(
+                "upkeep: {} announces and {} scrapes due, up to {}s late; {} deadlines pending",
+                std::size(announce_me),
+                std::size(scrape_me),
+                announcer->lateness(),
+                announcer->queue_depth()));
+    }
 
-    /* Second, announce what we can. If there aren't enough slots
+    /* Pick the announces to make. If there aren't enough slots
      * available, use compareAnnounceTiers to prioritize. */
     if (announce_me.size() > MaxAnnouncesPerUpkeep)
     {
@@ -1592,14 +1765,36 @@ void scrapeAndAnnounceMore(tr_announcer_impl* announcer)
             std::end(announce_me),
             [](auto const* a, auto const* b) { return compareAnnounceTiers(a, b) < 0; });
         // NOLINTEND(readability-redundant-casting)
-        announce_me.resize(MaxAnnouncesPerUpkeep);
     }
 
-    for (auto*& tier : announce_me)
+    auto const n_announces = std::min(std::size(announce_me), size_t{ MaxAnnouncesPerUpkeep });
+    auto const announcing = std::span{ std::data(announce_me), n_announces };
+
+    /* First, scrape what we can. We handle scrapes first because
+     * we can work through that queue much faster than announces
+     * (thanks to multiscrape) _and_ the scrape responses will tell
+     * us which swarms are interesting and should be announced next.
+     * Tiers that are about to announce don't need to be scraped too,
+     * since the announce response will have the swarm counts. */
+    multiscrape(announcer, scrape_me, { std::begin(announcing), std::end(announcing) });
+
+    /* Second, make the announces. */
+    for (auto* const tier : announcing)
     {
         tr_logAddTraceTier(tier, "Announcing to tracker");
         tierAnnounce(announcer, tier);
     }
+
+    // Announces that were due but didn't fit into this upkeep
+    // go back into the schedule so they're retried next time.
+    // multiscrape() has already done the same for scrapes.
+    for (auto* const tier : announce_me)
+    {
+        if (!tier->isAnnouncing)
+        {
+            announcer->defer(*tier, tr_announcer_schedule::Kind::Announce, tier->announceAt);
+        }
+    }
 }
 } // namespace upkeep_helpers
 } // namespace
@@ -15,6 +15,7 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -54,8 +55,10 @@ struct tr_tracker_event
     std::string_view text;
     tr_interned_string announce_url;
 
-    // for Peers events
-    std::vector<tr_pex> pex;
+    // for Peers events.
+    // This points into the tracker's response and is only valid
+    // for the duration of the callback.
+    std::span<tr_pex const> pex;
 
     // for Peers and Counts events
     std::optional<int64_t> leechers;
@@ -79,6 +82,12 @@ public:
     virtual void startShutdown() = 0;
 
     virtual void upkeep() = 0;
+
+    // the number of announce and scrape deadlines that haven't come due yet
+    [[nodiscard]] virtual size_t queue_depth() const noexcept = 0;
+
+    // how many seconds late the most overdue deadline was in the latest upkeep
+    [[nodiscard]] virtual time_t lateness() const noexcept = 0;
 };
 
 // --- For torrent customers
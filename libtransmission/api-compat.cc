@@ -8,8 +8,10 @@
 #include <cstddef>
 #include <deque>
 #include <initializer_list>
+#include <memory>
 #include <ranges>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "libtransmission/api-compat.h"
@@ -573,12 +575,17 @@ struct State
     bool was_legacy = false;
     std::deque<tr_quark> path;
 
-    [[nodiscard]] bool current_key_is_any_of(std::initializer_list<tr_quark> const pool) const noexcept
+    [[nodiscard]] tr_quark current_key() const noexcept
     {
-        return !std::empty(path) && std::count(std::cbegin(pool), std::cend(pool), path.back()) != 0U;
+        return std::empty(path) ? tr_quark{ TR_KEY_NONE } : path.back();
     }
 };
 
+[[nodiscard]] bool key_is_any_of(tr_quark const key, std::initializer_list<tr_quark> const pool) noexcept
+{
+    return key != TR_KEY_NONE && std::count(std::cbegin(pool), std::cend(pool), key) != 0U;
+}
+
 [[nodiscard]] State makeState(tr_variant::Map const& top)
 {
     auto state = State{};
@@ -608,8 +615,10 @@ struct State
     {
         if (auto const* const args = top.find_if<tr_variant::Map>(state.was_jsonrpc ? TR_KEY_result : TR_KEY_arguments))
         {
+            // legacy responses from convert_except_keys() still have the current keys
             state.is_free_space_response = args->contains(TR_KEY_path) &&
-                args->contains(state.was_jsonrpc ? TR_KEY_size_bytes : TR_KEY_size_bytes_kebab_APICOMPAT);
+                (args->contains(TR_KEY_size_bytes) ||
+                 (state.was_legacy && args->contains(TR_KEY_size_bytes_kebab_APICOMPAT)));
             state.is_torrent = args->contains(TR_KEY_torrents);
         }
     }
@@ -688,9 +697,12 @@ struct State
     return keys::LegacySettingsKeyLookup.lookup_or(src, src);
 }
 
-[[nodiscard]] std::optional<std::string_view> convert_string(State const& state, std::string_view const src)
+[[nodiscard]] std::optional<std::string_view> convert_string(
+    State const& state,
+    tr_quark const current_key,
+    std::string_view const src)
 {
-    if (state.is_settings && state.current_key_is_any_of({ TR_KEY_sort_mode, TR_KEY_sort_mode_kebab_APICOMPAT }))
+    if (state.is_settings && key_is_any_of(current_key, { TR_KEY_sort_mode, TR_KEY_sort_mode_kebab_APICOMPAT }))
     {
         static auto constexpr Strings = std::array<std::pair<std::string_view /*Tr5*/, std::string_view /*Tr4*/>, 10U>{ {
             { "sort_by_activity", "sort-by-activity" },
@@ -713,7 +725,7 @@ struct State
         }
     }
 
-    if (state.is_settings && state.current_key_is_any_of({ TR_KEY_filter_mode, TR_KEY_filter_mode_kebab_APICOMPAT }))
+    if (state.is_settings && key_is_any_of(current_key, { TR_KEY_filter_mode, TR_KEY_filter_mode_kebab_APICOMPAT }))
     {
         static auto constexpr Strings = std::array<std::pair<std::string_view, std::string_view>, 8U>{ {
             { "show_active", "show-active" },
@@ -734,7 +746,7 @@ struct State
         }
     }
 
-    if (state.is_settings && state.current_key_is_any_of({ TR_KEY_statusbar_stats, TR_KEY_statusbar_stats_kebab_APICOMPAT }))
+    if (state.is_settings && key_is_any_of(current_key, { TR_KEY_statusbar_stats, TR_KEY_statusbar_stats_kebab_APICOMPAT }))
     {
         static auto constexpr Strings = std::array<std::pair<std::string_view, std::string_view>, 4U>{ {
             { "total_ratio", "total-ratio" },
@@ -754,7 +766,7 @@ struct State
     // TODO(ckerr): replace `new_key == TR_KEY_TORRENTS` here to turn on convert
     // if it's an array inside an array val whose key was `torrents`.
     // This is for the edge case of table mode: `torrents : [ [ 'key1', 'key2' ], [ ... ] ]`
-    if (state.is_rpc && state.current_key_is_any_of({ TR_KEY_method, TR_KEY_fields, TR_KEY_ids, TR_KEY_torrents }))
+    if (state.is_rpc && key_is_any_of(current_key, { TR_KEY_method, TR_KEY_fields, TR_KEY_ids, TR_KEY_torrents }))
     {
         if (auto const old_key = tr_quark_lookup(src))
         {
@@ -777,7 +789,7 @@ void convert_keys(tr_variant& var, State& state)
 
             if constexpr (std::is_same_v<ValueType, std::string> || std::is_same_v<ValueType, std::string_view>)
             {
-                if (auto const new_val = convert_string(state, val))
+                if (auto const new_val = convert_string(state, state.current_key(), val))
                 {
                     val = *new_val;
                 }
@@ -1026,9 +1038,13 @@ void convert_jsonrpc(tr_variant::Map& top, State const& state)
 
             if (auto* data = error.find_if<tr_variant::Map>(TR_KEY_data))
             {
-                if (auto const errmsg = data->value_if<std::string_view>(TR_KEY_error_string_camel_APICOMPAT))
+                // check both spellings: convert_except_keys() doesn't rename keys
+                for (auto const key : { TR_KEY_error_string_camel_APICOMPAT, TR_KEY_error_string })
                 {
-                    top.try_emplace(TR_KEY_result, *errmsg);
+                    if (auto const errmsg = data->value_if<std::string_view>(key))
+                    {
+                        top.try_emplace(TR_KEY_result, *errmsg);
+                    }
                 }
 
                 if (auto const result = data->find(TR_KEY_result); result != std::end(*data))
@@ -1127,6 +1143,29 @@ void convert_jsonrpc(tr_variant::Map& top, State const& state)
     }
 }
 
+// Renames keys as convert_keys() would, but while a tr_variant_serde writes them
+class KeyStyle final : public tr_variant_serde::KeyStyle
+{
+public:
+    explicit KeyStyle(State state)
+        : state_{ std::move(state) }
+    {
+    }
+
+    [[nodiscard]] tr_quark key(tr_quark const key) const override
+    {
+        return convert_key(state_, key);
+    }
+
+    [[nodiscard]] std::optional<std::string_view> string(tr_quark const parent_key, std::string_view const str) const override
+    {
+        return convert_string(state_, parent_key, str);
+    }
+
+private:
+    State const state_;
+};
+
 // TODO(TR5) change default to Tr5.
 Style default_style_g = tr_env_get_string("TR_SAVE_VERSION_FORMAT", "4") == "5" ? Style::Tr5 : Style::Tr4;
 
@@ -1154,6 +1193,30 @@ void convert(tr_variant& var, Style const tgt_style)
     }
 }
 
+void convert_except_keys(tr_variant& var, Style const tgt_style)
+{
+    if (auto* const top = var.get_if<tr_variant::Map>())
+    {
+        auto state = makeState(*top);
+        state.style = tgt_style;
+        convert_settings_encryption(*top, state);
+        convert_jsonrpc(*top, state);
+    }
+}
+
+std::unique_ptr<tr_variant_serde::KeyStyle> make_key_style(tr_variant const& var, Style const tgt_style)
+{
+    auto const* const top = var.get_if<tr_variant::Map>();
+    if (top == nullptr)
+    {
+        return {};
+    }
+
+    auto state = makeState(*top);
+    state.style = tgt_style;
+    return std::make_unique<KeyStyle>(std::move(state));
+}
+
 void convert_outgoing_data(tr_variant& var)
 {
     convert(var, default_style());
@@ -6,8 +6,9 @@
 #pragma once
 
 #include <cstdint> // uint8_t
+#include <memory>
 
-struct tr_variant;
+#include "libtransmission/variant.h"
 
 namespace tr::api_compat
 {
@@ -21,6 +22,17 @@ void convert(tr_variant& var, Style tgt_style);
 void convert_incoming_data(tr_variant& var);
 void convert_outgoing_data(tr_variant& var);
 
+// convert() renames every key in the tree, which is a whole extra pass
+// over big messages like a torrent_get response. convert_except_keys()
+// makes the other changes, and the KeyStyle from make_key_style() renames
+// the keys while the converted message is serialized:
+//
+//   convert_except_keys(var, style);
+//   auto const key_style = make_key_style(var, style);
+//   auto const json = tr_variant_serde::json().key_style(key_style.get()).to_string(var);
+void convert_except_keys(tr_variant& var, Style tgt_style);
+[[nodiscard]] std::unique_ptr<tr_variant_serde::KeyStyle> make_key_style(tr_variant const& var, Style tgt_style);
+
 [[nodiscard]] Style default_style();
 void set_default_style(Style style);
 
@@ -0,0 +1,269 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <cerrno> // ECANCELED, ETIMEDOUT
+#include <chrono>
+#include <cstdint> // uintmax_t
+#include <functional>
+#include <iterator> // std::back_inserter
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility> // std::move
+#include <vector>
+
+#include "libtransmission/capacity-cache.h"
+#include "libtransmission/error.h"
+#include "libtransmission/file.h"
+#include "libtransmission/timer.h"
+
+tr_capacity_cache::tr_capacity_cache(
+    Mediator& mediator,
+    GetCapacityFunc get_capacity,
+    std::chrono::milliseconds const max_age,
+    std::chrono::milliseconds const max_wait)
+    : mediator_{ mediator }
+    , get_capacity_{ std::move(get_capacity) }
+    , max_age_{ max_age }
+    , max_wait_{ max_wait }
+    , upkeep_timer_{ mediator.timer_maker().create([this]() { on_upkeep(); }) }
+{
+    shared_->mediator = &mediator;
+    shared_->cache = this;
+    upkeep_timer_->start_repeating(UpkeepInterval);
+}
+
+tr_capacity_cache::~tr_capacity_cache()
+{
+    {
+        auto const lock = std::scoped_lock{ shared_->mutex };
+        shared_->mediator = nullptr;
+        shared_->cache = nullptr;
+    }
+
+    // nothing will answer the waiters now, so don't leave them hanging
+    auto waiters = std::vector<Waiter>{};
+    for (auto& [path, entry] : entries_)
+    {
+        std::ranges::move(entry.waiters, std::back_inserter(waiters));
+    }
+    entries_.clear();
+
+    for (auto const& waiter : waiters)
+    {
+        waiter.callback({}, tr_error{ ECANCELED, "Stopped checking free space" });
+    }
+}
+
+tr_capacity_cache::Entries::iterator tr_capacity_cache::touch(std::string_view const path, Clock::time_point const now)
+{
+    auto iter = entries_.find(path);
+    if (iter == std::end(entries_))
+    {
+        iter = entries_.try_emplace(std::string{ path }).first;
+    }
+
+    iter->second.used_at = now;
+    return iter;
+}
+
+void tr_capacity_cache::refresh(std::string const& path, Entry& entry)
+{
+    // Checks of hung mounts count against the limit until they return,
+    // so a pile of them can't keep spawning threads.
+    if (n_refreshing_ >= MaxRefreshes)
+    {
+        return;
+    }
+
+    ++n_refreshing_;
+    entry.is_refreshing = true;
+
+    auto worker = [shared = shared_, get_capacity = get_capacity_, path]()
+    {
+        auto error = tr_error{};
+        auto capacity = get_capacity(path, &error);
+
+        auto const lock = std::scoped_lock{ shared->mutex };
+        if (shared->mediator == nullptr)
+        {
+            return;
+        }
+
+        shared->mediator->queue_session_thread(
+            [shared, path, capacity, error = std::move(error)]() mutable
+            {
+                // the cache is only destroyed in the session thread, so no lock is needed here
+                if (shared->cache != nullptr)
+                {
+                    shared->cache->on_refreshed(path, capacity, std::move(error));
+                }
+            });
+    };
+
+    std::thread(std::move(worker)).detach();
+}
+
+void tr_capacity_cache::on_refreshed(std::string const& path, std::optional<tr_sys_path_capacity> capacity, tr_error&& error)
+{
+    --n_refreshing_;
+
+    auto const iter = entries_.find(path);
+    if (iter == std::end(entries_))
+    {
+        return;
+    }
+
+    auto& entry = iter->second;
+    entry.is_refreshing = false;
+    entry.error = std::move(error);
+    if (capacity)
+    {
+        entry.capacity = capacity;
+        entry.updated_at = mediator_.now();
+    }
+
+    // Collect the callbacks before calling any of them,
+    // since they're allowed to call back into the cache.
+    auto waiters = std::move(entry.waiters);
+    entry.waiters.clear();
+
+    auto notify = std::vector<std::pair<WatchFunc, bool>>{};
+    if (capacity)
+    {
+        for (auto& watcher : entry.watchers)
+        {
+            if (auto const is_low = capacity->available < watcher.threshold; watcher.is_low != is_low)
+            {
+                watcher.is_low = is_low;
+                notify.emplace_back(watcher.func, is_low);
+            }
+        }
+    }
+
+    for (auto const& [func, is_low] : notify)
+    {
+        func(path, capacity->available, is_low);
+    }
+
+    for (auto const& waiter : waiters)
+    {
+        waiter.callback(capacity, capacity ? tr_error{} : entry.error);
+    }
+}
+
+void tr_capacity_cache::on_upkeep()
+{
+    auto const now = mediator_.now();
+    auto expired = std::vector<Callback>{};
+
+    for (auto iter = std::begin(entries_); iter != std::end(entries_);)
+    {
+        auto& [path, entry] = *iter;
+
+        for (auto waiter = std::begin(entry.waiters); waiter != std::end(entry.waiters);)
+        {
+            if (waiter->deadline <= now)
+            {
+                expired.emplace_back(std::move(waiter->callback));
+                waiter = entry.waiters.erase(waiter);
+            }
+            else
+            {
+                ++waiter;
+            }
+        }
+
+        if (!std::empty(entry.watchers) || !std::empty(entry.waiters))
+        {
+            // this also retries the folders that were over the refresh limit
+            if (needs_refresh(entry, now))
+            {
+                refresh(path, entry);
+            }
+        }
+        else if (std::empty(entry.waiters) && !entry.is_refreshing && now - entry.used_at > max_age_)
+        {
+            iter = entries_.erase(iter);
+            continue;
+        }
+
+        ++iter;
+    }
+
+    for (auto const& callback : expired)
+    {
+        callback({}, tr_error{ ETIMEDOUT, "Timed out while checking free space" });
+    }
+}
+
+std::optional<tr_sys_path_capacity> tr_capacity_cache::get(std::string_view const path)
+{
+    auto const now = mediator_.now();
+    auto& [key, entry] = *touch(path, now);
+
+    if (needs_refresh(entry, now))
+    {
+        refresh(key, entry);
+    }
+
+    return is_fresh(entry, now) ? entry.capacity : std::nullopt;
+}
+
+void tr_capacity_cache::get(std::string_view const path, Callback callback)
+{
+    auto const now = mediator_.now();
+    auto& [key, entry] = *touch(path, now);
+
+    if (needs_refresh(entry, now))
+    {
+        refresh(key, entry);
+    }
+
+    if (is_fresh(entry, now))
+    {
+        callback(entry.capacity, {});
+        return;
+    }
+
+    entry.waiters.push_back({ std::move(callback), now + max_wait_ });
+}
+
+tr_capacity_cache::WatchId tr_capacity_cache::watch(std::string_view const path, uintmax_t const threshold, WatchFunc func)
+{
+    auto const now = mediator_.now();
+    auto& [key, entry] = *touch(path, now);
+
+    auto watcher = Watcher{};
+    watcher.id = ++next_watch_id_;
+    watcher.threshold = threshold;
+    watcher.func = std::move(func);
+
+    if (is_fresh(entry, now))
+    {
+        auto const available = entry.capacity->available;
+        watcher.is_low = available < threshold;
+        watcher.func(key, available, *watcher.is_low);
+    }
+
+    if (needs_refresh(entry, now))
+    {
+        refresh(key, entry);
+    }
+
+    return entry.watchers.emplace_back(std::move(watcher)).id;
+}
+
+void tr_capacity_cache::unwatch(WatchId const id)
+{
+    for (auto& [path, entry] : entries_)
+    {
+        std::erase_if(entry.watchers, [id](Watcher const& watcher) { return watcher.id == id; });
+    }
+}
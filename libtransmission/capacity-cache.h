@@ -0,0 +1,175 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#pragma once
+
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // uintmax_t, uint32_t
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "libtransmission/error.h"
+#include "libtransmission/file.h"
+#include "libtransmission/timer.h"
+
+/**
+ * Caches how much free space the folders we're asked about have.
+ *
+ * statvfs() can hang for a long time on network mounts, so it's never
+ * called in the session thread. Instead, each folder's capacity is
+ * fetched by a short-lived worker thread and handed back to the session
+ * thread. A folder has at most one fetch in flight, so a hung mount
+ * costs one blocked thread rather than one per request, and at most
+ * `MaxRefreshes` fetches are in flight at once. Folders that can't be
+ * fetched yet are retried by the upkeep timer, and their callers time
+ * out as usual if that takes too long.
+ *
+ * Cached values are refreshed once they're half of `max_age` old and
+ * are never served once they're older than `max_age`.
+ *
+ * Except where noted, every method must be called in the session thread,
+ * and every callback is called in it.
+ */
+class tr_capacity_cache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Mediator
+    {
+        virtual ~Mediator() = default;
+
+        [[nodiscard]] virtual tr::TimerMaker& timer_maker() = 0;
+
+        // Queue `func` to be called in the session thread.
+        // This is called from worker threads.
+        virtual void queue_session_thread(std::function<void()> func) = 0;
+
+        [[nodiscard]] virtual Clock::time_point now() const
+        {
+            return Clock::now();
+        }
+    };
+
+    // Called from worker threads, so it may block. Each worker has its own
+    // copy, which lets a hung worker outlive the cache and its mediator.
+    using GetCapacityFunc = std::function<std::optional<tr_sys_path_capacity>(std::string_view path, tr_error* error)>;
+
+    using Callback = std::function<void(std::optional<tr_sys_path_capacity> const& capacity, tr_error const& error)>;
+
+    // Called when a watched folder's free space drops below the
+    // watcher's threshold, or rises back above it.
+    using WatchFunc = std::function<void(std::string_view path, uintmax_t available, bool is_low)>;
+    using WatchId = uint32_t;
+
+    static auto constexpr DefaultMaxAge = std::chrono::milliseconds{ std::chrono::seconds{ 30 } };
+    static auto constexpr DefaultMaxWait = std::chrono::milliseconds{ std::chrono::seconds{ 5 } };
+
+    // How often watched folders are refreshed and late callbacks are timed out
+    static auto constexpr UpkeepInterval = std::chrono::milliseconds{ std::chrono::seconds{ 1 } };
+
+    // How many worker threads may be checking folders at once
+    static auto constexpr MaxRefreshes = size_t{ 4U };
+
+    explicit tr_capacity_cache(
+        Mediator& mediator,
+        GetCapacityFunc get_capacity = tr_sys_path_get_capacity,
+        std::chrono::milliseconds max_age = DefaultMaxAge,
+        std::chrono::milliseconds max_wait = DefaultMaxWait);
+    ~tr_capacity_cache();
+
+    tr_capacity_cache(tr_capacity_cache const&) = delete;
+    tr_capacity_cache(tr_capacity_cache&&) = delete;
+    tr_capacity_cache& operator=(tr_capacity_cache const&) = delete;
+    tr_capacity_cache& operator=(tr_capacity_cache&&) = delete;
+
+    // Returns the folder's capacity if it's known and no older than `max_age`.
+    // Never blocks, but starts a refresh if the value is missing or aging.
+    [[nodiscard]] std::optional<tr_sys_path_capacity> get(std::string_view path);
+
+    // Calls `callback` with a capacity that's no older than `max_age`.
+    // If the folder can't be checked in `max_wait`, or the cache is
+    // destroyed first, it's called with an error.
+    void get(std::string_view path, Callback callback);
+
+    // Keeps the folder's capacity fresh and calls `func` when its free
+    // space crosses `threshold`. It's also called once the space is first known.
+    WatchId watch(std::string_view path, uintmax_t threshold, WatchFunc func);
+    void unwatch(WatchId id);
+
+private:
+    struct Waiter
+    {
+        Callback callback;
+        Clock::time_point deadline;
+    };
+
+    struct Watcher
+    {
+        WatchId id = {};
+        uintmax_t threshold = {};
+        WatchFunc func;
+        std::optional<bool> is_low;
+    };
+
+    struct Entry
+    {
+        std::optional<tr_sys_path_capacity> capacity;
+        tr_error error;
+        Clock::time_point updated_at;
+        Clock::time_point used_at;
+        bool is_refreshing = false;
+        std::vector<Waiter> waiters;
+        std::vector<Watcher> watchers;
+    };
+
+    // What a worker thread needs to hand back its result.
+    // It outlives the cache so that hung workers can finish safely.
+    struct Shared
+    {
+        std::mutex mutex;
+        Mediator* mediator = nullptr;
+        tr_capacity_cache* cache = nullptr;
+    };
+
+    [[nodiscard]] bool is_fresh(Entry const& entry, Clock::time_point now) const noexcept
+    {
+        return entry.capacity && now - entry.updated_at <= max_age_;
+    }
+
+    [[nodiscard]] bool needs_refresh(Entry const& entry, Clock::time_point now) const noexcept
+    {
+        return !entry.is_refreshing && (!entry.capacity || now - entry.updated_at > max_age_ / 2);
+    }
+
+    using Entries = std::map<std::string, Entry, std::less<>>;
+
+    Entries::iterator touch(std::string_view path, Clock::time_point now);
+    void refresh(std::string const& path, Entry& entry);
+    void on_refreshed(std::string const& path, std::optional<tr_sys_path_capacity> capacity, tr_error&& error);
+    void on_upkeep();
+
+    Mediator& mediator_;
+    GetCapacityFunc const get_capacity_;
+    std::chrono::milliseconds const max_age_;
+    std::chrono::milliseconds const max_wait_;
+
+    Entries entries_;
+    size_t n_refreshing_ = 0U;
+    std::shared_ptr<Shared> shared_ = std::make_shared<Shared>();
+    std::unique_ptr<tr::Timer> upkeep_timer_;
+    WatchId next_watch_id_ = {};
+};
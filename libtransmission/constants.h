@@ -21,8 +21,11 @@ inline auto constexpr TrDefaultPeerSocketTos = std::string_view{ "le" };
 inline auto constexpr TrDefaultRpcPort = 9091U;
 inline auto constexpr TrDefaultRpcWhitelist = std::string_view{ "127.0.0.1,::1" };
 
+inline auto constexpr TrHttpServerRpcEventsRelativePath = std::string_view{ "rpc/events" };
 inline auto constexpr TrHttpServerRpcRelativePath = std::string_view{ "rpc" };
+inline auto constexpr TrHttpServerRpcStatsRelativePath = std::string_view{ "rpc/stats" };
 inline auto constexpr TrHttpServerWebRelativePath = std::string_view{ "web/" };
+inline auto constexpr TrRpcBencContentType = std::string_view{ "application/x-bencode" };
 inline auto constexpr TrRpcSessionIdHeader = std::string_view{ "X-Transmission-Session-Id" };
 inline auto constexpr TrRpcVersionHeader = std::string_view{ "X-Transmission-Rpc-Version" };
 
@@ -20,6 +20,7 @@
 
 #include <dirent.h>
 #include <fcntl.h> /* O_LARGEFILE, posix_fadvise(), [posix_]fallocate(), fcntl() */
+#include <sys/mman.h> /* mmap(), munmap() */
 #include <sys/stat.h>
 #include <unistd.h> /* lseek(), write(), ftruncate(), pread(), pwrite(), pathconf(), etc */
 
@@ -418,6 +419,79 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
 #endif /* USE_COPYFILE */
 }
 
+bool tr_sys_file_copy_range(
+    tr_sys_file_t in,
+    tr_sys_file_t out,
+    uint64_t offset,
+    uint64_t size,
+    uint64_t* bytes_copied,
+    tr_error* error)
+{
+    TR_ASSERT(in != TR_BAD_SYS_FILE);
+    TR_ASSERT(out != TR_BAD_SYS_FILE);
+    /* seek requires signed offset, so it should be in mod range */
+    TR_ASSERT(offset < UINT64_MAX / 2);
+
+    auto local_error = tr_error{};
+    if (error == nullptr)
+    {
+        error = &local_error;
+    }
+
+    auto copied = uint64_t{};
+    auto eof = false;
+
+#if defined(USE_COPY_FILE_RANGE)
+
+    /* any error here (e.g. EXDEV on older kernels) drops us to the user-space
+     * copy below, which reports real I/O errors itself */
+    while (copied < size)
+    {
+        auto in_offset = static_cast<off_t>(offset + copied);
+        auto out_offset = in_offset;
+        size_t const chunk_size = std::min({ size - copied, uint64_t{ SSIZE_MAX }, uint64_t{ INT32_MAX } });
+        auto const n_copied = copy_file_range(in, &in_offset, out, &out_offset, chunk_size, 0);
+        if (n_copied <= 0)
+        {
+            eof = n_copied == 0;
+            break;
+        }
+
+        copied += n_copied;
+    }
+
+#endif /* USE_COPY_FILE_RANGE */
+
+    if (!eof && copied < size)
+    {
+        static auto constexpr Buflen = uint64_t{ 1024U * 1024U }; /* 1024 KiB buffer */
+        auto buf = std::vector<char>{};
+        buf.resize(std::min(size - copied, Buflen));
+
+        while (copied < size)
+        {
+            uint64_t const chunk_size = std::min(size - copied, uint64_t{ std::size(buf) });
+            uint64_t bytes_read = 0;
+            uint64_t bytes_written = 0;
+
+            if (!tr_sys_file_read_at(in, std::data(buf), chunk_size, offset + copied, &bytes_read, error) ||
+                !tr_sys_file_write_at(out, std::data(buf), bytes_read, offset + copied, &bytes_written, error))
+            {
+                break;
+            }
+
+            copied += bytes_written;
+        }
+    }
+
+    if (bytes_copied != nullptr)
+    {
+        *bytes_copied = copied;
+    }
+
+    return !*error;
+}
+
 bool tr_sys_path_remove(std::string_view const path, tr_error* error)
 {
     auto const sz_path = tr_pathbuf{ path };
@@ -879,6 +953,41 @@ bool tr_sys_file_lock([[maybe_unused]] tr_sys_file_t handle, [[maybe_unused]] in
     return *result;
 }
 
+void* tr_sys_file_map_for_reading(tr_sys_file_t handle, uint64_t offset, uint64_t size, tr_error* error)
+{
+    TR_ASSERT(handle != TR_BAD_SYS_FILE);
+    TR_ASSERT(size > 0);
+
+    void* ret = mmap(nullptr, size, PROT_READ, MAP_SHARED, handle, static_cast<off_t>(offset));
+
+    if (ret == MAP_FAILED) // NOLINT(performance-no-int-to-ptr)
+    {
+        if (error != nullptr)
+        {
+            error->set_from_errno(errno);
+        }
+
+        ret = nullptr;
+    }
+
+    return ret;
+}
+
+bool tr_sys_file_unmap(void const* address, uint64_t size, tr_error* error)
+{
+    TR_ASSERT(address != nullptr);
+    TR_ASSERT(size > 0);
+
+    bool const ret = munmap(const_cast<void*>(address), size) != -1;
+
+    if (error != nullptr && !ret)
+    {
+        error->set_from_errno(errno);
+    }
+
+    return ret;
+}
+
 std::string tr_sys_dir_get_current(tr_error* error)
 {
     auto buf = std::vector<char>{};
@@ -11,6 +11,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <shlobj.h> /* SHCreateDirectoryEx() */
 #include <winioctl.h> /* FSCTL_SET_SPARSE */
@@ -504,6 +505,51 @@ bool tr_sys_path_copy(std::string_view const src_path, std::string_view const ds
     return true;
 }
 
+bool tr_sys_file_copy_range(
+    tr_sys_file_t in,
+    tr_sys_file_t out,
+    uint64_t offset,
+    uint64_t size,
+    uint64_t* bytes_copied,
+    tr_error* error)
+{
+    TR_ASSERT(in != TR_BAD_SYS_FILE);
+    TR_ASSERT(out != TR_BAD_SYS_FILE);
+
+    auto local_error = tr_error{};
+    if (error == nullptr)
+    {
+        error = &local_error;
+    }
+
+    static auto constexpr Buflen = uint64_t{ 1024U * 1024U };
+    auto buf = std::vector<char>{};
+    buf.resize(std::min(size, Buflen));
+
+    auto copied = uint64_t{};
+    while (copied < size)
+    {
+        uint64_t const chunk_size = std::min(size - copied, uint64_t{ std::size(buf) });
+        uint64_t bytes_read = 0;
+        uint64_t bytes_written = 0;
+
+        if (!tr_sys_file_read_at(in, std::data(buf), chunk_size, offset + copied, &bytes_read, error) || bytes_read == 0 ||
+            !tr_sys_file_write_at(out, std::data(buf), bytes_read, offset + copied, &bytes_written, error))
+        {
+            break;
+        }
+
+        copied += bytes_written;
+    }
+
+    if (bytes_copied != nullptr)
+    {
+        *bytes_copied = copied;
+    }
+
+    return !*error;
+}
+
 bool tr_sys_path_remove(std::string_view const path, tr_error* error)
 {
     bool ret = false;
@@ -834,6 +880,62 @@ bool tr_sys_file_lock(tr_sys_file_t handle, int operation, tr_error* error)
     return ret;
 }
 
+void* tr_sys_file_map_for_reading(tr_sys_file_t handle, uint64_t offset, uint64_t size, tr_error* error)
+{
+    TR_ASSERT(handle != TR_BAD_SYS_FILE);
+    TR_ASSERT(size > 0);
+
+    if (size > MAXSIZE_T)
+    {
+        set_system_error(error, ERROR_INVALID_PARAMETER);
+        return nullptr;
+    }
+
+    void* ret = nullptr;
+    HANDLE const mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping != nullptr)
+    {
+        auto native_offset = ULARGE_INTEGER{};
+        native_offset.QuadPart = offset;
+
+        ret = MapViewOfFile(
+            mapping,
+            FILE_MAP_READ,
+            native_offset.u.HighPart,
+            native_offset.u.LowPart,
+            static_cast<SIZE_T>(size));
+    }
+
+    if (ret == nullptr)
+    {
+        set_system_error(error, GetLastError());
+    }
+
+    if (mapping != nullptr)
+    {
+        // the view keeps its own reference to the mapping object
+        CloseHandle(mapping);
+    }
+
+    return ret;
+}
+
+bool tr_sys_file_unmap(void const* address, [[maybe_unused]] uint64_t size, tr_error* error)
+{
+    TR_ASSERT(address != nullptr);
+    TR_ASSERT(size > 0);
+
+    bool const ret = UnmapViewOfFile(address) != FALSE;
+
+    if (!ret)
+    {
+        set_system_error(error, GetLastError());
+    }
+
+    return ret;
+}
+
 std::string tr_sys_dir_get_current(tr_error* error)
 {
     if (auto const size = GetCurrentDirectoryW(0, nullptr); size != 0)
@@ -3,7 +3,10 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
+#include <cwctype>
 #include <filesystem>
 #include <system_error>
 #include <string>
@@ -16,6 +19,7 @@
 
 #include "libtransmission/error.h"
 #include "libtransmission/file.h"
+#include "libtransmission/tr-strbuf.h"
 
 namespace
 {
@@ -168,6 +172,41 @@ bool tr_sys_path_is_same(std::string_view path1, std::string_view path2, tr_erro
     return same;
 }
 
+bool tr_sys_path_is_same_device(std::string_view path1, std::string_view path2, tr_error* error)
+{
+#ifdef _WIN32
+    // Windows has no device ids, but a rename can't cross volumes
+    auto const u8path1 = tr_u8path(path1);
+    auto const u8path2 = tr_u8path(path2);
+
+    auto ec = std::error_code{};
+    if (!std::filesystem::exists(u8path1, ec) || !std::filesystem::exists(u8path2, ec))
+    {
+        maybe_set_error(error, ec);
+        return false;
+    }
+
+    auto const root1 = std::filesystem::absolute(u8path1, ec).root_name().wstring();
+    auto const root2 = std::filesystem::absolute(u8path2, ec).root_name().wstring();
+    maybe_set_error(error, ec);
+    return !ec && std::ranges::equal(root1, root2, [](wchar_t a, wchar_t b) { return std::towupper(a) == std::towupper(b); });
+#else
+    struct stat sb1 = {};
+    struct stat sb2 = {};
+    if (stat(tr_pathbuf{ path1 }.c_str(), &sb1) == -1 || stat(tr_pathbuf{ path2 }.c_str(), &sb2) == -1)
+    {
+        if (error != nullptr)
+        {
+            error->set_from_errno(errno);
+        }
+
+        return false;
+    }
+
+    return sb1.st_dev == sb2.st_dev;
+#endif
+}
+
 bool tr_sys_dir_create(std::string_view path, int flags, [[maybe_unused]] int permissions, tr_error* error)
 {
     auto const filesystem_path = tr_u8path(path);
@@ -197,6 +197,22 @@ bool tr_sys_path_is_relative(std::string_view path);
  */
 bool tr_sys_path_is_same(std::string_view path1, std::string_view path2, tr_error* error = nullptr);
 
+/**
+ * @brief Test to see if two paths are on the same device, i.e. whether a file
+ *        can be renamed from one to the other instead of being copied.
+ *
+ * @param[in]  path1 Path to first file or directory.
+ * @param[in]  path2 Path to second file or directory.
+ * @param[out] error Pointer to error object. Optional, pass `nullptr` if
+ *                   you are not interested in error details.
+ *
+ * @return `True` if both paths exist and are on the same device, `false`
+ *         otherwise. Note that `false` will also be returned in case of error;
+ *         if you need to distinguish the two, check if `error` is `nullptr`
+ *         afterwards.
+ */
+bool tr_sys_path_is_same_device(std::string_view path1, std::string_view path2, tr_error* error = nullptr);
+
 /**
  * @brief Portability wrapper for `realpath()`.
  *
@@ -392,6 +408,33 @@ bool tr_sys_file_write_at(
     uint64_t* bytes_written,
     tr_error* error = nullptr);
 
+/**
+ * @brief Copy a range of bytes from one file to the same offset in another,
+ *        in-kernel where possible. Not thread-safe.
+ *
+ * Unlike `tr_sys_path_copy()`, this lets callers copy large files in pieces,
+ * e.g. to report progress or to limit the copy speed.
+ *
+ * @param[in]  in           Valid file descriptor to copy from.
+ * @param[in]  out          Valid file descriptor to copy to.
+ * @param[in]  offset       File offset in bytes to start copying from.
+ * @param[in]  size         Number of bytes to copy.
+ * @param[out] bytes_copied Number of bytes actually copied. This is less than
+ *                          `size` if the end of `in` was reached. Optional,
+ *                          pass `nullptr` if you are not interested.
+ * @param[out] error        Pointer to error object. Optional, pass `nullptr`
+ *                          if you are not interested in error details.
+ *
+ * @return `True` on success, `false` otherwise (with `error` set accordingly).
+ */
+bool tr_sys_file_copy_range(
+    tr_sys_file_t in,
+    tr_sys_file_t out,
+    uint64_t offset,
+    uint64_t size,
+    uint64_t* bytes_copied,
+    tr_error* error = nullptr);
+
 /**
  * @brief Portability wrapper for `ftruncate()`.
  *
@@ -432,6 +475,35 @@ bool tr_sys_file_preallocate(tr_sys_file_t handle, uint64_t size, int flags, tr_
  */
 bool tr_sys_file_lock(tr_sys_file_t handle, int operation, tr_error* error = nullptr);
 
+/**
+ * @brief Portability wrapper for `mmap()` for reading.
+ *
+ * The mapping stays valid after `handle` is closed and must be released
+ * with @ref tr_sys_file_unmap.
+ *
+ * @param[in]  handle Valid file descriptor.
+ * @param[in]  offset Offset in file to map from.
+ * @param[in]  size   Number of bytes to map.
+ * @param[out] error  Pointer to error object. Optional, pass `nullptr` if you
+ *                    are not interested in error details.
+ *
+ * @return Pointer to mapped file data on success, `nullptr` otherwise (with
+ *         `error` set accordingly).
+ */
+void* tr_sys_file_map_for_reading(tr_sys_file_t handle, uint64_t offset, uint64_t size, tr_error* error = nullptr);
+
+/**
+ * @brief Portability wrapper for `munmap()`.
+ *
+ * @param[in]  address Pointer to mapped file data.
+ * @param[in]  size    Size of mapped data in bytes.
+ * @param[out] error   Pointer to error object. Optional, pass `nullptr` if you
+ *                     are not interested in error details.
+ *
+ * @return `True` on success, `false` otherwise (with `error` set accordingly).
+ */
+bool tr_sys_file_unmap(void const* address, uint64_t size, tr_error* error = nullptr);
+
 /* Directory-related wrappers */
 
 /**
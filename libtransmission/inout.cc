@@ -275,6 +275,8 @@ tr_error_code_t tr_ioWrite(
     }
     else
     {
+        tor.mark_files_written();
+
         auto [file_index, file_offset] = tor.file_offset(loc);
         auto& session = *tor.session;
         auto buf = writeme;
@@ -0,0 +1,158 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno> // ECANCELED
+#include <cstddef> // size_t
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility> // std::move
+#include <vector>
+
+#include "libtransmission/crypto-utils.h" // tr_base64_decode()
+#include "libtransmission/file.h"
+#include "libtransmission/metainfo-parser.h"
+#include "libtransmission/torrent-ctor.h"
+
+namespace
+{
+void parse_item(tr_metainfo_parser::Item& item)
+{
+    auto& [ctor, source, input, ok, error] = item;
+
+    if (source == tr_metainfo_parser::Source::Metainfo)
+    {
+        ok = ctor->set_metainfo(tr_base64_decode(input), &error);
+    }
+    else if (tr_sys_path_exists(input))
+    {
+        ok = ctor->set_metainfo_from_file(input, &error);
+    }
+    else
+    {
+        ok = ctor->set_metainfo_from_magnet_link(input, &error);
+    }
+}
+} // namespace
+
+struct tr_metainfo_parser::Job
+{
+    Job(std::vector<Item>&& items_in, DoneFunc&& on_done_in)
+        : items{ std::move(items_in) }
+        , on_done{ std::move(on_done_in) }
+    {
+    }
+
+    std::vector<Item> items;
+    DoneFunc on_done;
+    std::atomic<size_t> next_idx = 0U;
+    std::atomic<size_t> n_running = 0U;
+};
+
+tr_metainfo_parser::Item::Item(std::unique_ptr<tr_ctor> ctor_in, Source const source_in, std::string input_in)
+    : ctor{ std::move(ctor_in) }
+    , source{ source_in }
+    , input{ std::move(input_in) }
+{
+}
+
+tr_metainfo_parser::Item::Item(Item&&) noexcept = default;
+tr_metainfo_parser::Item& tr_metainfo_parser::Item::operator=(Item&&) noexcept = default;
+tr_metainfo_parser::Item::~Item() = default;
+
+tr_metainfo_parser::tr_metainfo_parser(Mediator& mediator, size_t const max_threads)
+    : max_threads_{ std::max(max_threads, size_t{ 1U }) }
+{
+    shared_->mediator = &mediator;
+    shared_->parser = this;
+}
+
+tr_metainfo_parser::~tr_metainfo_parser()
+{
+    {
+        auto const lock = std::scoped_lock{ shared_->mutex };
+        shared_->mediator = nullptr;
+        shared_->parser = nullptr;
+    }
+
+    // The workers may still be using the batches' items,
+    // so answer with stand-ins that failed instead.
+    auto jobs = std::move(jobs_);
+    for (auto const& job : jobs)
+    {
+        auto items = std::vector<Item>{};
+        items.reserve(std::size(job->items));
+        for (auto const& item : job->items)
+        {
+            auto& cancelled = items.emplace_back(nullptr, item.source, std::string{});
+            cancelled.error.set(ECANCELED, "Stopped parsing torrents");
+        }
+
+        job->on_done(std::move(items));
+    }
+}
+
+void tr_metainfo_parser::on_parsed(std::shared_ptr<Job> const& job)
+{
+    if (auto const iter = std::ranges::find(jobs_, job); iter != std::end(jobs_))
+    {
+        jobs_.erase(iter);
+        job->on_done(std::move(job->items));
+    }
+}
+
+void tr_metainfo_parser::parse(std::vector<Item> items, DoneFunc on_done)
+{
+    if (std::empty(items))
+    {
+        on_done(std::move(items));
+        return;
+    }
+
+    auto const n_threads = std::min({ size_t{ std::max(std::thread::hardware_concurrency(), 1U) },
+                                      max_threads_,
+                                      std::size(items) });
+    auto job = std::make_shared<Job>(std::move(items), std::move(on_done));
+    job->n_running = n_threads;
+    jobs_.emplace_back(job);
+
+    auto worker = [shared = shared_, job]()
+    {
+        for (auto idx = job->next_idx++; idx < std::size(job->items); idx = job->next_idx++)
+        {
+            parse_item(job->items[idx]);
+        }
+
+        // the last worker to finish hands the results back
+        if (--job->n_running != 0U)
+        {
+            return;
+        }
+
+        auto const lock = std::scoped_lock{ shared->mutex };
+        if (shared->mediator == nullptr)
+        {
+            return;
+        }
+
+        shared->mediator->queue_session_thread(
+            [shared, job]()
+            {
+                // the parser is only destroyed in the session thread, so no lock is needed here
+                if (auto* const parser = shared->parser; parser != nullptr)
+                {
+                    parser->on_parsed(job);
+                }
+            });
+    };
+
+    for (size_t i = 0U; i < n_threads; ++i)
+    {
+        std::thread(worker).detach();
+    }
+}
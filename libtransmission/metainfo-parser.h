@@ -0,0 +1,107 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "libtransmission/error.h"
+
+struct tr_ctor;
+
+/**
+ * Parses the metainfo of torrents that are about to be added.
+ *
+ * Decoding, parsing, and hashing one torrent's metainfo is cheap, but
+ * importing thousands of torrents at once would stall the session thread.
+ * Instead, a batch is split among a few short-lived worker threads and
+ * handed back to the session thread once every item has been parsed.
+ *
+ * Every method must be called in the session thread, and every callback is called in it.
+ */
+class tr_metainfo_parser
+{
+public:
+    struct Mediator
+    {
+        virtual ~Mediator() = default;
+
+        // Queue `func` to be called in the session thread.
+        // This is called from worker threads.
+        virtual void queue_session_thread(std::function<void()> func) = 0;
+    };
+
+    enum class Source : uint8_t
+    {
+        Metainfo, // base64-encoded .torrent contents
+        Filename, // a local .torrent file or a magnet link
+    };
+
+    // Defined out of line, since `tr_ctor` is incomplete here.
+    struct Item
+    {
+        Item(std::unique_ptr<tr_ctor> ctor_in, Source source_in, std::string input_in);
+        Item(Item&&) noexcept;
+        Item(Item const&) = delete;
+        Item& operator=(Item&&) noexcept;
+        Item& operator=(Item const&) = delete;
+        ~Item();
+
+        std::unique_ptr<tr_ctor> ctor;
+        Source source;
+        std::string input;
+
+        // set by the worker threads
+        bool ok = false;
+        tr_error error;
+    };
+
+    using DoneFunc = std::function<void(std::vector<Item>&& items)>;
+
+    static auto constexpr DefaultMaxThreads = size_t{ 4U };
+
+    explicit tr_metainfo_parser(Mediator& mediator, size_t max_threads = DefaultMaxThreads);
+    ~tr_metainfo_parser();
+
+    tr_metainfo_parser(tr_metainfo_parser const&) = delete;
+    tr_metainfo_parser(tr_metainfo_parser&&) = delete;
+    tr_metainfo_parser& operator=(tr_metainfo_parser const&) = delete;
+    tr_metainfo_parser& operator=(tr_metainfo_parser&&) = delete;
+
+    // Parses each item's input into its ctor, then calls `on_done` with the items
+    // in the same order. If the parser is destroyed first, `on_done` is called
+    // right away with items that failed with ECANCELED and have no ctor.
+    void parse(std::vector<Item> items, DoneFunc on_done);
+
+private:
+    struct Job;
+
+    // What a worker thread needs to hand back its results.
+    // It outlives the parser so that workers can finish safely.
+    struct Shared
+    {
+        std::mutex mutex;
+        Mediator* mediator = nullptr;
+        tr_metainfo_parser* parser = nullptr;
+    };
+
+    void on_parsed(std::shared_ptr<Job> const& job);
+
+    size_t const max_threads_;
+    std::shared_ptr<Shared> shared_ = std::make_shared<Shared>();
+
+    // batches that haven't been handed back yet
+    std::vector<std::shared_ptr<Job>> jobs_;
+};
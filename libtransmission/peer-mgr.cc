@@ -581,6 +581,18 @@ public:
         tr_socket_address const& socket_address,
         uint8_t const flags,
         tr_peer_from const from)
+    {
+        auto const client_external_address = tor->session->global_address(socket_address.address().type);
+        return ensure_info_exists(socket_address, flags, from, client_external_address.value_or(tr_address{}));
+    }
+
+    // Overload for callers adding many peers at once, so that they can
+    // look up our public address once instead of once per peer.
+    std::shared_ptr<tr_peer_info> ensure_info_exists(
+        tr_socket_address const& socket_address,
+        uint8_t const flags,
+        tr_peer_from const from,
+        tr_address const& client_external_address)
     {
         TR_ASSERT(socket_address.is_valid());
         TR_ASSERT(from < TR_PEER_FROM_N_TYPES);
@@ -600,7 +612,7 @@ public:
                                     socket_address,
                                     flags,
                                     from,
-                                    tor->session->global_address(socket_address.address().type).value_or(tr_address{}),
+                                    client_external_address,
                                     get_client_advertised_port))
                             .first->second;
             ++stats.known_peer_from_count[from];
@@ -1374,13 +1386,22 @@ size_t tr_peerMgrAddPex(tr_torrent* tor, tr_peer_from from, tr_pex const* pex, s
     tr_swarm* s = tor->swarm;
     auto const lock = s->manager->unique_lock();
 
+    // Trackers can hand us hundreds of peers at a time,
+    // so look up our public addresses once for the whole batch.
+    auto const client_external_addresses = std::array{
+        tor->session->global_address(TR_AF_INET).value_or(tr_address{}),
+        tor->session->global_address(TR_AF_INET6).value_or(tr_address{}),
+    };
+    static_assert(std::size(client_external_addresses) == NUM_TR_AF_INET_TYPES);
+
     for (tr_pex const* const end = pex + n_pex; pex != end; ++pex)
     {
         if (tr_isPex(pex) && /* safeguard against corrupt data */
             !s->manager->blocklists_.contains(pex->socket_address.address()) && pex->is_valid_for_peers(from) &&
             from != TR_PEER_FROM_INCOMING)
         {
-            s->ensure_info_exists(pex->socket_address, pex->flags, from);
+            auto const& client_external_address = client_external_addresses[pex->socket_address.address().type];
+            s->ensure_info_exists(pex->socket_address, pex->flags, from, client_external_address);
             ++n_used;
         }
     }
@@ -1665,6 +1686,20 @@ tr_webseed_view tr_peerMgrWebseed(tr_torrent const* tor, size_t i)
     return i >= n ? tr_webseed_view{} : tor->swarm->webseeds[i]->get_view();
 }
 
+uint64_t tr_peerMgrFastestWebseedSpeed(tr_torrent const* tor, uint64_t const now_msec)
+{
+    TR_ASSERT(tr_isTorrent(tor));
+    TR_ASSERT(tor->swarm != nullptr);
+
+    auto fastest = uint64_t{};
+    for (auto const& webseed : tor->swarm->webseeds)
+    {
+        fastest = std::max(fastest, webseed->get_piece_speed(now_msec, tr_direction::Down).base_quantity());
+    }
+
+    return fastest;
+}
+
 namespace
 {
 namespace peer_stat_helpers
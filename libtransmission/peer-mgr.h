@@ -699,4 +699,7 @@ void tr_peerMgrTorrentAvailability(tr_torrent const* tor, int8_t* tab, unsigned
 
 [[nodiscard]] tr_webseed_view tr_peerMgrWebseed(tr_torrent const* tor, size_t i);
 
+// return the download speed, in bytes per second, of the torrent's fastest webseed
+[[nodiscard]] uint64_t tr_peerMgrFastestWebseedSpeed(tr_torrent const* tor, uint64_t now_msec);
+
 /* @} */
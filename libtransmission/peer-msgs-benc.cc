@@ -0,0 +1,206 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <cstddef> // size_t
+#include <cstdint> // int64_t
+#include <string_view>
+
+#include "libtransmission/benc.h"
+#include "libtransmission/error.h"
+#include "libtransmission/peer-msgs-benc.h"
+
+using namespace std::literals;
+
+namespace
+{
+auto constexpr MaxBencDepth = 8;
+
+// Common base for the LTEP handlers: all of these messages are dicts.
+struct LtepHandler : public tr::benc::BasicHandler<MaxBencDepth>
+{
+    using BasicHandler = tr::benc::BasicHandler<MaxBencDepth>;
+
+    bool StartDict(Context const& context) override
+    {
+        if (depth() == 0U)
+        {
+            is_dict = true;
+        }
+
+        return BasicHandler::StartDict(context);
+    }
+
+    bool is_dict = false;
+};
+
+template<typename Handler>
+bool parse_dict(std::string_view benc, Handler& handler, char const** setme_end = nullptr)
+{
+    auto stack = tr::benc::ParserStack<MaxBencDepth>{};
+    auto error = tr_error{};
+    return tr::benc::parse(benc, stack, handler, setme_end, &error) && handler.is_dict;
+}
+} // namespace
+
+bool tr_ltepParseHandshake(std::string_view benc, tr_ltep_handshake& setme)
+{
+    struct HandshakeHandler final : public LtepHandler
+    {
+        explicit HandshakeHandler(tr_ltep_handshake& handshake)
+            : handshake_{ handshake }
+        {
+        }
+
+        bool Int64(int64_t value, Context const& /*context*/) override
+        {
+            if (pathIs("e"sv))
+            {
+                handshake_.e = value;
+            }
+            else if (pathIs("metadata_size"sv))
+            {
+                handshake_.metadata_size = value;
+            }
+            else if (pathIs("p"sv))
+            {
+                handshake_.p = value;
+            }
+            else if (pathIs("reqq"sv))
+            {
+                handshake_.reqq = value;
+            }
+            else if (pathIs("upload_only"sv))
+            {
+                handshake_.upload_only = value;
+            }
+            else if (pathIs("m"sv, "ut_holepunch"sv))
+            {
+                handshake_.ut_holepunch = value;
+            }
+            else if (pathIs("m"sv, "ut_metadata"sv))
+            {
+                handshake_.ut_metadata = value;
+            }
+            else if (pathIs("m"sv, "ut_pex"sv))
+            {
+                handshake_.ut_pex = value;
+            }
+
+            return true;
+        }
+
+        bool String(std::string_view value, Context const& /*context*/) override
+        {
+            if (pathIs("ipv4"sv))
+            {
+                handshake_.ipv4 = value;
+            }
+            else if (pathIs("ipv6"sv))
+            {
+                handshake_.ipv6 = value;
+            }
+            else if (pathIs("v"sv))
+            {
+                handshake_.v = value;
+            }
+            else if (pathIs("yourip"sv))
+            {
+                handshake_.yourip = value;
+            }
+
+            return true;
+        }
+
+    private:
+        tr_ltep_handshake& handshake_;
+    };
+
+    setme = {};
+    auto handler = HandshakeHandler{ setme };
+    return parse_dict(benc, handler);
+}
+
+bool tr_ltepParseUtPex(std::string_view benc, tr_ut_pex_msg& setme)
+{
+    struct PexHandler final : public LtepHandler
+    {
+        explicit PexHandler(tr_ut_pex_msg& pex)
+            : pex_{ pex }
+        {
+        }
+
+        bool String(std::string_view value, Context const& /*context*/) override
+        {
+            if (pathIs("added"sv))
+            {
+                pex_.added = value;
+            }
+            else if (pathIs("added.f"sv))
+            {
+                pex_.added_f = value;
+            }
+            else if (pathIs("added6"sv))
+            {
+                pex_.added6 = value;
+            }
+            else if (pathIs("added6.f"sv))
+            {
+                pex_.added6_f = value;
+            }
+
+            return true;
+        }
+
+    private:
+        tr_ut_pex_msg& pex_;
+    };
+
+    setme = {};
+    auto handler = PexHandler{ setme };
+    return parse_dict(benc, handler);
+}
+
+bool tr_ltepParseUtMetadata(std::string_view benc, tr_ut_metadata_msg& setme)
+{
+    struct MetadataHandler final : public LtepHandler
+    {
+        explicit MetadataHandler(tr_ut_metadata_msg& msg)
+            : msg_{ msg }
+        {
+        }
+
+        bool Int64(int64_t value, Context const& /*context*/) override
+        {
+            if (pathIs("msg_type"sv))
+            {
+                msg_.msg_type = value;
+            }
+            else if (pathIs("piece"sv))
+            {
+                msg_.piece = value;
+            }
+            else if (pathIs("total_size"sv))
+            {
+                msg_.total_size = value;
+            }
+
+            return true;
+        }
+
+    private:
+        tr_ut_metadata_msg& msg_;
+    };
+
+    setme = {};
+    auto handler = MetadataHandler{ setme };
+    char const* end = nullptr;
+    if (!parse_dict(benc, handler, &end))
+    {
+        return false;
+    }
+
+    setme.trailer = benc.substr(static_cast<size_t>(end - std::data(benc)));
+    return true;
+}
@@ -0,0 +1,71 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <cstdint> // int64_t
+#include <optional>
+#include <string_view>
+
+// Decoders for the bencoded LTEP messages that peers send us.
+//
+// These are parsed often enough that building a tr_variant tree for each
+// one is wasteful, so they're decoded with SAX-style handlers that keep
+// only the fields we use. Nothing here allocates: every string is a view
+// into the caller's buffer, so the results are only valid as long as it is.
+
+/** @brief A decoded BEP 10 extension handshake */
+struct tr_ltep_handshake
+{
+    // top-level dict
+    std::optional<int64_t> e;
+    std::optional<int64_t> metadata_size;
+    std::optional<int64_t> p;
+    std::optional<int64_t> reqq;
+    std::optional<int64_t> upload_only;
+    std::optional<std::string_view> ipv4;
+    std::optional<std::string_view> ipv6;
+    std::optional<std::string_view> v;
+    std::optional<std::string_view> yourip;
+
+    // the "m" dict of supported extensions
+    std::optional<int64_t> ut_holepunch;
+    std::optional<int64_t> ut_metadata;
+    std::optional<int64_t> ut_pex;
+};
+
+/** @brief A decoded BEP 11 peer exchange message */
+struct tr_ut_pex_msg
+{
+    std::optional<std::string_view> added;
+    std::optional<std::string_view> added_f;
+    std::optional<std::string_view> added6;
+    std::optional<std::string_view> added6_f;
+};
+
+/** @brief The bencoded dict at the front of a BEP 9 metadata message */
+struct tr_ut_metadata_msg
+{
+    int64_t msg_type = -1;
+    int64_t piece = -1;
+    int64_t total_size = 0;
+
+    // A data message's metadata piece follows the dict.
+    // This is everything in the payload after the dict.
+    std::string_view trailer;
+};
+
+/** @return true if `benc` is a bencoded dict that was decoded into `setme` */
+bool tr_ltepParseHandshake(std::string_view benc, tr_ltep_handshake& setme);
+
+/** @return true if `benc` is a bencoded dict that was decoded into `setme` */
+bool tr_ltepParseUtPex(std::string_view benc, tr_ut_pex_msg& setme);
+
+/** @return true if `benc` starts with a bencoded dict that was decoded into `setme` */
+bool tr_ltepParseUtMetadata(std::string_view benc, tr_ut_metadata_msg& setme);
@@ -38,6 +38,7 @@
 #include "libtransmission/peer-common.h"
 #include "libtransmission/peer-io.h"
 #include "libtransmission/peer-mgr.h"
+#include "libtransmission/peer-msgs-benc.h"
 #include "libtransmission/peer-msgs.h"
 #include "libtransmission/quark.h"
 #include "libtransmission/session.h"
@@ -989,36 +990,28 @@ void tr_peerMsgsImpl::parse_ut_pex(MessageReader& payload)
         return;
     }
 
-    auto const var = tr_variant_serde::benc().inplace().parse(payload.to_string_view());
-    if (!var)
-    {
-        return;
-    }
-
-    auto const* const map = var->get_if<tr_variant::Map>();
-    if (map == nullptr)
+    auto msg = tr_ut_pex_msg{};
+    if (!tr_ltepParseUtPex(payload.to_string_view(), msg))
     {
         return;
     }
 
     logtrace(this, "got ut pex");
 
-    if (auto const added = map->value_if<std::string_view>(TR_KEY_added))
+    if (auto const& added = msg.added)
     {
-        auto const added_f_sv = map->value_if<std::string_view>(TR_KEY_added_f);
-        auto const* const added_f = added_f_sv ? reinterpret_cast<uint8_t const*>(std::data(*added_f_sv)) : nullptr;
-        auto const added_f_len = added_f_sv ? std::size(*added_f_sv) : 0U;
+        auto const* const added_f = msg.added_f ? reinterpret_cast<uint8_t const*>(std::data(*msg.added_f)) : nullptr;
+        auto const added_f_len = msg.added_f ? std::size(*msg.added_f) : 0U;
 
         auto pex = tr_pex::from_compact_ipv4(std::data(*added), std::size(*added), added_f, added_f_len);
         pex.resize(std::min(MaxPexPeerCount, std::size(pex)));
         tr_peerMgrAddPex(&tor_, TR_PEER_FROM_PEX, std::data(pex), std::size(pex));
     }
 
-    if (auto const added = map->value_if<std::string_view>(TR_KEY_added6))
+    if (auto const& added = msg.added6)
     {
-        auto const added_f_sv = map->value_if<std::string_view>(TR_KEY_added6_f);
-        auto const* const added_f = added_f_sv ? reinterpret_cast<uint8_t const*>(std::data(*added_f_sv)) : nullptr;
-        auto const added_f_len = added_f_sv ? std::size(*added_f_sv) : 0U;
+        auto const* const added_f = msg.added6_f ? reinterpret_cast<uint8_t const*>(std::data(*msg.added6_f)) : nullptr;
+        auto const added_f_len = msg.added6_f ? std::size(*msg.added6_f) : 0U;
 
         auto pex = tr_pex::from_compact_ipv6(std::data(*added), std::size(*added), added_f, added_f_len);
         pex.resize(std::min(MaxPexPeerCount, std::size(pex)));
@@ -1228,8 +1221,8 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
 {
     auto const handshake_sv = payload.to_string_view();
 
-    auto var = tr_variant_serde::benc().inplace().parse(handshake_sv);
-    if (!var || !var->holds_alternative<tr_variant::Map>())
+    auto handshake = tr_ltep_handshake{};
+    if (!tr_ltepParseHandshake(handshake_sv, handshake))
     {
         logtrace(this, "got ltep handshake, couldn't get dictionary");
         return;
@@ -1242,40 +1235,34 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
         logwarn(this, "got ltep handshake, but peer did not advertise support in reserved bytes");
     }
 
-    auto const* const map = var->get_if<tr_variant::Map>();
-    TR_ASSERT(map != nullptr);
-
     // does the peer prefer encrypted connections?
-    if (auto const e = map->value_if<int64_t>(TR_KEY_e))
+    if (auto const e = handshake.e)
     {
         peer_info->set_encryption_preferred(*e != 0);
     }
 
     // check supported messages for utorrent pex
     auto holepunch_supported = false;
-    if (auto const* const sub = map->find_if<tr_variant::Map>(TR_KEY_m))
+    if (tor_.is_public())
     {
-        if (tor_.is_public())
+        if (auto const ut_pex = handshake.ut_pex)
         {
-            if (auto const ut_pex = sub->value_if<int64_t>(TR_KEY_ut_pex))
-            {
-                ut_pex_id_ = static_cast<uint8_t>(*ut_pex);
-                logtrace(this, fmt::format("msgs->ut_pex is {:d}", ut_pex_id_));
-            }
-
-            if (auto const ut_metadata = sub->value_if<int64_t>(TR_KEY_ut_metadata))
-            {
-                ut_metadata_id_ = static_cast<uint8_t>(*ut_metadata);
-                logtrace(this, fmt::format("msgs->ut_metadata_id_ is {:d}", ut_metadata_id_));
-            }
+            ut_pex_id_ = static_cast<uint8_t>(*ut_pex);
+            logtrace(this, fmt::format("msgs->ut_pex is {:d}", ut_pex_id_));
         }
 
-        if (auto const ut_holepunch = sub->value_if<int64_t>(TR_KEY_ut_holepunch))
+        if (auto const ut_metadata = handshake.ut_metadata)
         {
-            holepunch_supported = *ut_holepunch != 0;
+            ut_metadata_id_ = static_cast<uint8_t>(*ut_metadata);
+            logtrace(this, fmt::format("msgs->ut_metadata_id_ is {:d}", ut_metadata_id_));
         }
     }
 
+    if (auto const ut_holepunch = handshake.ut_holepunch)
+    {
+        holepunch_supported = *ut_holepunch != 0;
+    }
+
     // Transmission doesn't support this extension yet.
     // But its presence does indicate µTP support,
     // which we do care about...
@@ -1290,7 +1277,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     // look for metainfo size (BEP 9)
     if (can_xfer_metadata())
     {
-        if (auto const metadata_size = map->value_if<int64_t>(TR_KEY_metadata_size))
+        if (auto const metadata_size = handshake.metadata_size)
         {
             if (!tr_metadata_download::is_valid_metadata_size(*metadata_size))
             {
@@ -1304,7 +1291,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     }
 
     // look for upload_only (BEP 21)
-    if (auto const upload_only = map->value_if<int64_t>(TR_KEY_upload_only))
+    if (auto const upload_only = handshake.upload_only)
     {
         peer_info->set_upload_only(*upload_only != 0);
     }
@@ -1313,7 +1300,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     // Client name and version (as a utf-8 string). This is a much more
     // reliable way of identifying the client than relying on the
     // peer id encoding.
-    if (auto const sv = map->value_if<std::string_view>(TR_KEY_v))
+    if (auto const sv = handshake.v)
     {
         set_user_agent(tr_interned_string{ tr_strv_to_utf8_string(*sv) });
     }
@@ -1323,7 +1310,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     // this peer sees you as. i.e. this is the receiver's external ip
     // address (no port is included). This may be either an IPv4 (4 bytes)
     // or an IPv6 (16 bytes) address.
-    if (auto const sv = map->value_if<std::string_view>(TR_KEY_yourip))
+    if (auto const sv = handshake.yourip)
     {
         auto const* const bytes = reinterpret_cast<std::byte const*>(std::data(*sv));
         switch (std::size(*sv))
@@ -1340,7 +1327,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     }
 
     /* get peer's listening port */
-    if (auto const p = map->value_if<int64_t>(TR_KEY_p).value_or(0); p > 0)
+    if (auto const p = handshake.p.value_or(0); p > 0)
     {
         publish(tr_peer_event::GotPort(tr_port::from_host(p)));
         logtrace(this, fmt::format("peer's port is now {:d}", p));
@@ -1348,7 +1335,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
 
     if (io_->is_incoming())
     {
-        if (auto const addr_compact = map->value_if<std::string_view>(TR_KEY_ipv4);
+        if (auto const addr_compact = handshake.ipv4;
             addr_compact && std::size(*addr_compact) == tr_address::CompactAddrBytes[TR_AF_INET])
         {
             auto pex = tr_pex{ peer_info->listen_socket_address(), peer_info->pex_flags() };
@@ -1357,7 +1344,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
             tr_peerMgrAddPex(&tor_, TR_PEER_FROM_LTEP, &pex, 1);
         }
 
-        if (auto const addr_compact = map->value_if<std::string_view>(TR_KEY_ipv6);
+        if (auto const addr_compact = handshake.ipv6;
             addr_compact && std::size(*addr_compact) == tr_address::CompactAddrBytes[TR_AF_INET6])
         {
             auto pex = tr_pex{ peer_info->listen_socket_address(), peer_info->pex_flags() };
@@ -1368,7 +1355,7 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
     }
 
     /* get peer's maximum request queue size */
-    if (auto const reqq_in = map->value_if<int64_t>(TR_KEY_reqq).value_or(0); reqq_in > 0)
+    if (auto const reqq_in = handshake.reqq.value_or(0); reqq_in > 0)
     {
         peer_reqq_ = reqq_in;
     }
@@ -1377,28 +1364,16 @@ void tr_peerMsgsImpl::parse_ltep_handshake(MessageReader& payload)
 void tr_peerMsgsImpl::parse_ut_metadata(MessageReader& payload_in)
 {
     auto const tmp = payload_in.to_string_view();
-    auto const* const msg_end = std::data(tmp) + std::size(tmp);
 
-    auto serde = tr_variant_serde::benc();
-    auto const var = serde.inplace().parse(tmp);
-    if (!var)
+    auto msg = tr_ut_metadata_msg{};
+    if (!tr_ltepParseUtMetadata(tmp, msg))
     {
         auto const base64 = tr_base64_encode(tmp);
         logdbg(this, fmt::format("failed to parse ut_metadata msg: {}", base64));
         return;
     }
 
-    auto const* const map = var->get_if<tr_variant::Map>();
-    if (map == nullptr)
-    {
-        auto const base64 = tr_base64_encode(tmp);
-        logdbg(this, fmt::format("got ut_metadata msg that is not a dict: {}", base64));
-        return;
-    }
-
-    auto const msg_type = map->value_if<int64_t>(TR_KEY_msg_type).value_or(-1);
-    auto const piece = map->value_if<int64_t>(TR_KEY_piece).value_or(-1);
-    auto const total_size = map->value_if<int64_t>(TR_KEY_total_size).value_or(0);
+    auto const [msg_type, piece, total_size, trailer] = msg;
 
     logtrace(this, fmt::format("got ut_metadata msg: type {:d}, piece {:d}, total_size {:d}", msg_type, piece, total_size));
     if (tor_.is_private())
@@ -1409,9 +1384,9 @@ void tr_peerMsgsImpl::parse_ut_metadata(MessageReader& payload_in)
     switch (msg_type)
     {
     case MetadataMsgType::Data:
-        if (auto const piece_len = msg_end - serde.end(); piece * MetadataPieceSize + piece_len <= total_size)
+        if (auto const piece_len = static_cast<int64_t>(std::size(trailer)); piece * MetadataPieceSize + piece_len <= total_size)
         {
-            tor_.set_metadata_piece(piece, serde.end(), piece_len);
+            tor_.set_metadata_piece(piece, std::data(trailer), piece_len);
         }
         break;
 
@@ -1427,7 +1402,7 @@ void tr_peerMsgsImpl::parse_ut_metadata(MessageReader& payload_in)
             auto v = tr_variant::Map{ 2U };
             v.try_emplace(TR_KEY_msg_type, MetadataMsgType::Reject);
             v.try_emplace(TR_KEY_piece, piece);
-            protocol_send_message(BtPeerMsgs::Ltep, ut_metadata_id_, serde.to_string(std::move(v)));
+            protocol_send_message(BtPeerMsgs::Ltep, ut_metadata_id_, tr_variant_serde::benc().to_string(std::move(v)));
         }
         break;
 
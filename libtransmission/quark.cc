@@ -6,9 +6,14 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <deque>
 #include <iterator> // for std::distance()
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "libtransmission/quark.h"
@@ -57,6 +62,8 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "announce_ip"sv, // tr_session::Settings
     "announce_ip_enabled"sv, // tr_session::Settings
     "announce_state"sv, // rpc
+    "announcer_lateness"sv,
+    "announcer_queue_depth"sv,
     "anti-brute-force-enabled"sv, // rpc, rpc server settings
     "anti-brute-force-threshold"sv, // rpc server settings
     "anti_brute_force_enabled"sv, // rpc, rpc server settings
@@ -85,12 +92,16 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "blocklist_updates_enabled"sv, // gtk app, qt app
     "blocklist_url"sv, // rpc, tr_session::Settings
     "blocks"sv, // .resume
+    "buckets"sv, // rpc
     "bytesCompleted"sv, // rpc
     "bytes_completed"sv, // rpc
     "bytes_to_client"sv, // rpc
     "bytes_to_peer"sv, // rpc
     "cache-size-mb"sv, // rpc, tr_session::Settings
     "cache_size_mib"sv, // rpc, tr_session::Settings
+    "cancel"sv, // rpc
+    "change_epoch"sv, // rpc
+    "changed_since"sv, // rpc
     "clientIsChoked"sv, // rpc
     "clientIsInterested"sv, // rpc
     "clientName"sv, // rpc
@@ -108,6 +119,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "corrupt"sv, // .resume
     "corruptEver"sv, // rpc
     "corrupt_ever"sv, // rpc
+    "count"sv, // rpc
     "created by"sv, // .torrent
     "creation date"sv, // .torrent
     "creator"sv, // rpc
@@ -130,7 +142,9 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "details_window_height"sv, // gtk app
     "details_window_width"sv, // gtk app
     "dht-enabled"sv, // daemon, rpc, tr_session::Settings
+    "dht_announce_queue_depth"sv,
     "dht_enabled"sv, // daemon, rpc, tr_session::Settings
+    "dht_searches_per_second"sv,
     "dnd"sv, // .resume
     "done-date"sv, // .resume
     "doneDate"sv, // rpc
@@ -148,6 +162,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "download_count"sv, // rpc
     "download_dir"sv, // daemon, gtk app, rpc, tr_session::Settings
     "download_dir_free_space"sv, // rpc
+    "download_dir_low_space_mib"sv,
     "download_limit"sv, // rpc
     "download_limited"sv, // rpc
     "download_queue_enabled"sv, // rpc, tr_session::Settings
@@ -250,9 +265,11 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "incomplete-dir-enabled"sv, // daemon, rpc, tr_session::Settings
     "incomplete_dir"sv, // .resume, daemon, gtk app, rpc, tr_session::Settings
     "incomplete_dir_enabled"sv, // daemon, rpc, tr_session::Settings
+    "index"sv, // rpc
     "info"sv, // .torrent
     "inhibit-desktop-hibernation"sv, // gtk app, qt app
     "inhibit_desktop_hibernation"sv, // gtk app, qt app
+    "interval"sv, // rpc
     "ip_endpoints_ipv4"sv, // tr_session::Settings
     "ip_endpoints_ipv6"sv, // tr_session::Settings
     "ip_protocol"sv, // rpc
@@ -345,7 +362,9 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "move"sv, // rpc
     "msg_type"sv, // BT protocol
     "mtimes"sv, // .resume
+    "multiplexed_count"sv, // rpc
     "name"sv, // .resume, .torrent, rpc
+    "new_connection_count"sv, // rpc
     "nextAnnounceTime"sv, // rpc
     "nextScrapeTime"sv, // rpc
     "next_announce_time"sv, // rpc
@@ -407,6 +426,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "pieceCount"sv, // rpc
     "pieceSize"sv, // rpc
     "piece_count"sv, // rpc
+    "piece_hashes_mmap_enabled"sv, // tr_session::Settings
     "piece_size"sv, // rpc
     "pieces"sv, // .resume, .torrent, rpc
     "port"sv, // rpc
@@ -467,6 +487,8 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "recently_active"sv, // rpc
     "recheckProgress"sv, // rpc
     "recheck_progress"sv, // rpc
+    "relocate_speed_limit"sv, // settings
+    "relocation"sv, // rpc
     "remote-session-enabled"sv, // qt app
     "remote-session-host"sv, // qt app
     "remote-session-https"sv, // qt app
@@ -486,6 +508,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "rename-partial-files"sv, // rpc, tr_session::Settings
     "rename_partial_files"sv, // rpc, tr_session::Settings
     "reqq"sv, // BEP0010; BT protocol, rpc, tr_session::Settings
+    "request_count"sv, // rpc
     "result"sv, // rpc
     "rpc-authentication-required"sv, // daemon, rpc server settings
     "rpc-bind-address"sv, // daemon, rpc server settings
@@ -507,6 +530,8 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "rpc_enabled"sv, // daemon, rpc server settings
     "rpc_host_whitelist"sv, // rpc, rpc server settings
     "rpc_host_whitelist_enabled"sv, // rpc, rpc server settings
+    "rpc_large_response_compression_level"sv, // rpc server settings
+    "rpc_local_socket"sv,
     "rpc_password"sv, // daemon, rpc server settings
     "rpc_port"sv, // daemon, gtk app, rpc server settings
     "rpc_socket_mode"sv, // rpc server settings
@@ -517,6 +542,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "rpc_version_semver"sv, // rpc
     "rpc_whitelist"sv, // daemon, gtk app, rpc server settings
     "rpc_whitelist_enabled"sv, // daemon, rpc server settings
+    "rpc_worker_threads"sv, // rpc server settings
     "scrape"sv, // rpc
     "scrape-paused-torrents-enabled"sv, // tr_session::Settings
     "scrapeState"sv, // rpc
@@ -599,6 +625,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "size_when_done"sv, // rpc
     "sleep-per-seconds-during-verify"sv, // tr_session::Settings
     "sleep_per_seconds_during_verify"sv, // tr_session::Settings
+    "snapshot_count"sv, // rpc
     "socket_address"sv, // .resume
     "sort-mode"sv, // gtk app, qt app
     "sort-reversed"sv, // gtk app, qt app
@@ -657,6 +684,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "torrentCount"sv, // rpc
     "torrentFile"sv, // rpc
     "torrent_add"sv, // rpc
+    "torrent_add_batch"sv,
     "torrent_added"sv, // rpc
     "torrent_added_notification_enabled"sv, // gtk app, qt app
     "torrent_added_verify_mode"sv, // tr_session::Settings
@@ -691,6 +719,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "tracker_replace"sv, // rpc
     "tracker_stats"sv, // rpc
     "trackers"sv, // rpc
+    "transfer_time"sv, // rpc
     "trash-can-enabled"sv, // gtk app
     "trash-original-torrent-files"sv, // gtk app, rpc, tr_session::Settings
     "trash_can_enabled"sv, // gtk app
@@ -734,6 +763,7 @@ auto constexpr MyStatic = std::array<std::string_view, TR_N_KEYS>{
     "watch_dir"sv, // daemon, gtk app, qt app
     "watch_dir_enabled"sv, // daemon, gtk app, qt app
     "watch_dir_force_generic"sv, // daemon
+    "web_host_stats"sv, // rpc
     "webseeds"sv, // rpc
     "webseedsSendingToUs"sv, // rpc
     "webseeds_ex"sv, // rpc
@@ -757,13 +787,8 @@ bool constexpr quarks_are_sorted()
 static_assert(quarks_are_sorted(), "Predefined quarks must be sorted by their string value");
 static_assert(std::size(MyStatic) == TR_N_KEYS);
 
-auto& my_runtime{ *new std::vector<std::string_view>{} };
-
-} // namespace
-
-std::optional<tr_quark> tr_quark_lookup(std::string_view key)
+[[nodiscard]] std::optional<tr_quark> static_lookup(std::string_view key)
 {
-    // is it in our static array?
     auto constexpr Sbegin = std::begin(MyStatic);
     auto constexpr Send = std::end(MyStatic);
 
@@ -772,36 +797,127 @@ std::optional<tr_quark> tr_quark_lookup(std::string_view key)
         return std::distance(Sbegin, sit);
     }
 
-    /* was it added during runtime? */
-    auto const rbegin = std::begin(my_runtime);
-    auto const rend = std::end(my_runtime);
-    if (auto const rit = std::find(rbegin, rend, key); rit != rend)
+    return {};
+}
+
+// Quarks added at runtime. These live until the process exits,
+// so their strings are packed into large blocks instead of being
+// allocated one at a time. Safe to use from any thread.
+class RuntimeQuarks
+{
+public:
+    [[nodiscard]] std::optional<tr_quark> lookup(std::string_view key) const
+    {
+        auto const lock = std::shared_lock{ mutex_ };
+
+        if (auto const iter = by_string_.find(key); iter != std::end(by_string_))
+        {
+            return iter->second;
+        }
+
+        return {};
+    }
+
+    [[nodiscard]] tr_quark add(std::string_view key)
     {
-        return TR_N_KEYS + std::distance(rbegin, rit);
+        auto const lock = std::unique_lock{ mutex_ };
+
+        // check again in case another thread added it
+        if (auto const iter = by_string_.find(key); iter != std::end(by_string_))
+        {
+            return iter->second;
+        }
+
+        auto const perma = store(key);
+        auto const ret = TR_N_KEYS + std::size(by_quark_);
+        by_quark_.emplace_back(perma);
+        by_string_.try_emplace(perma, ret);
+        return ret;
     }
 
-    return {};
+    [[nodiscard]] std::string_view get(tr_quark q) const
+    {
+        auto const lock = std::shared_lock{ mutex_ };
+
+        TR_ASSERT(q - TR_N_KEYS < std::size(by_quark_));
+        return by_quark_[q - TR_N_KEYS];
+    }
+
+private:
+    // returns a zero-terminated copy of `key` that is never freed
+    [[nodiscard]] std::string_view store(std::string_view key)
+    {
+        auto const n_bytes = std::size(key) + 1U;
+        char* perma = nullptr;
+
+        if (n_bytes > BlockSize / 4U)
+        {
+            // big keys get their own allocation so they don't waste the rest of a block
+            perma = blocks_.emplace_back(std::make_unique<char[]>(n_bytes)).get();
+        }
+        else
+        {
+            if (block_ == nullptr || n_bytes > BlockSize - block_used_)
+            {
+                block_ = blocks_.emplace_back(std::make_unique<char[]>(BlockSize)).get();
+                block_used_ = 0U;
+            }
+
+            perma = block_ + block_used_;
+            block_used_ += n_bytes;
+        }
+
+        std::copy_n(std::data(key), std::size(key), perma);
+        perma[std::size(key)] = '\0';
+        return { perma, std::size(key) };
+    }
+
+    static auto constexpr BlockSize = size_t{ 4096U };
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string_view, tr_quark> by_string_;
+    std::deque<std::string_view> by_quark_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char* block_ = nullptr;
+    size_t block_used_ = 0U;
+};
+
+auto& my_runtime{ *new RuntimeQuarks{} };
+
+} // namespace
+
+std::optional<tr_quark> tr_quark_lookup(std::string_view key)
+{
+    // is it in our static array?
+    if (auto const quark = static_lookup(key); quark)
+    {
+        return quark;
+    }
+
+    // was it added during runtime?
+    return my_runtime.lookup(key);
 }
 
 tr_quark tr_quark_new(std::string_view str)
 {
+    // Most keys are already quarks, so look for `str` as-is first.
+    // Existing quarks are valid UTF-8, so if this matches then
+    // `str` didn't need to be converted anyway.
+    if (auto const prior = tr_quark_lookup(str); prior)
+    {
+        return *prior;
+    }
+
     auto const utf8 = tr_strv_to_utf8_string(str);
-    if (auto const prior = tr_quark_lookup(utf8); prior)
+    if (auto const prior = static_lookup(utf8); prior)
     {
         return *prior;
     }
 
-    auto const ret = TR_N_KEYS + std::size(my_runtime);
-    auto const len = std::size(utf8);
-    auto* perma = new char[len + 1];
-    std::copy_n(std::begin(utf8), len, perma);
-    perma[len] = '\0';
-    my_runtime.emplace_back(perma);
-    return ret;
+    return my_runtime.add(utf8);
 }
 
 std::string_view tr_quark_get_string_view(tr_quark q)
 {
-    TR_ASSERT(q < TR_N_KEYS + std::size(my_runtime));
-    return q < TR_N_KEYS ? MyStatic[q] : my_runtime[q - TR_N_KEYS];
+    return q < TR_N_KEYS ? MyStatic[q] : my_runtime.get(q);
 }
@@ -68,6 +68,8 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_announce_ip, /* settings */
     TR_KEY_announce_ip_enabled, /* settings */
     TR_KEY_announce_state, /* rpc */
+    TR_KEY_announcer_lateness,
+    TR_KEY_announcer_queue_depth,
     TR_KEY_anti_brute_force_enabled_kebab_APICOMPAT,
     TR_KEY_anti_brute_force_threshold_kebab_APICOMPAT,
     TR_KEY_anti_brute_force_enabled, /* rpc, settings */
@@ -96,12 +98,16 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_blocklist_updates_enabled,
     TR_KEY_blocklist_url,
     TR_KEY_blocks,
+    TR_KEY_buckets,
     TR_KEY_bytes_completed_camel_APICOMPAT,
     TR_KEY_bytes_completed,
     TR_KEY_bytes_to_client,
     TR_KEY_bytes_to_peer,
     TR_KEY_cache_size_mb_kebab_APICOMPAT,
     TR_KEY_cache_size_mib,
+    TR_KEY_cancel,
+    TR_KEY_change_epoch,
+    TR_KEY_changed_since,
     TR_KEY_client_is_choked_camel_APICOMPAT,
     TR_KEY_client_is_interested_camel_APICOMPAT,
     TR_KEY_client_name_camel_APICOMPAT,
@@ -119,6 +125,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_corrupt,
     TR_KEY_corrupt_ever_camel_APICOMPAT,
     TR_KEY_corrupt_ever,
+    TR_KEY_count,
     TR_KEY_created_by,
     TR_KEY_creation_date,
     TR_KEY_creator,
@@ -141,7 +148,9 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_details_window_height,
     TR_KEY_details_window_width,
     TR_KEY_dht_enabled_kebab_APICOMPAT,
+    TR_KEY_dht_announce_queue_depth,
     TR_KEY_dht_enabled,
+    TR_KEY_dht_searches_per_second,
     TR_KEY_dnd,
     TR_KEY_done_date_kebab_APICOMPAT,
     TR_KEY_done_date_camel_APICOMPAT,
@@ -159,6 +168,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_download_count,
     TR_KEY_download_dir,
     TR_KEY_download_dir_free_space,
+    TR_KEY_download_dir_low_space_mib,
     TR_KEY_download_limit,
     TR_KEY_download_limited,
     TR_KEY_download_queue_enabled,
@@ -261,9 +271,11 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_incomplete_dir_enabled_kebab_APICOMPAT,
     TR_KEY_incomplete_dir,
     TR_KEY_incomplete_dir_enabled,
+    TR_KEY_index,
     TR_KEY_info,
     TR_KEY_inhibit_desktop_hibernation_kebab_APICOMPAT,
     TR_KEY_inhibit_desktop_hibernation,
+    TR_KEY_interval,
     TR_KEY_ip_endpoints_ipv4,
     TR_KEY_ip_endpoints_ipv6,
     TR_KEY_ip_protocol,
@@ -356,7 +368,9 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_move,
     TR_KEY_msg_type,
     TR_KEY_mtimes,
+    TR_KEY_multiplexed_count,
     TR_KEY_name,
+    TR_KEY_new_connection_count,
     TR_KEY_next_announce_time_camel_APICOMPAT,
     TR_KEY_next_scrape_time_camel_APICOMPAT,
     TR_KEY_next_announce_time,
@@ -418,6 +432,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_piece_count_camel_APICOMPAT,
     TR_KEY_piece_size_camel_APICOMPAT,
     TR_KEY_piece_count,
+    TR_KEY_piece_hashes_mmap_enabled,
     TR_KEY_piece_size,
     TR_KEY_pieces,
     TR_KEY_port,
@@ -478,6 +493,8 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_recently_active,
     TR_KEY_recheck_progress_camel_APICOMPAT,
     TR_KEY_recheck_progress,
+    TR_KEY_relocate_speed_limit,
+    TR_KEY_relocation,
     TR_KEY_remote_session_enabled_kebab_APICOMPAT,
     TR_KEY_remote_session_host_kebab_APICOMPAT,
     TR_KEY_remote_session_https_kebab_APICOMPAT,
@@ -497,6 +514,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_rename_partial_files_kebab_APICOMPAT,
     TR_KEY_rename_partial_files,
     TR_KEY_reqq,
+    TR_KEY_request_count,
     TR_KEY_result,
     TR_KEY_rpc_authentication_required_kebab_APICOMPAT,
     TR_KEY_rpc_bind_address_kebab_APICOMPAT,
@@ -518,6 +536,8 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_rpc_enabled,
     TR_KEY_rpc_host_whitelist,
     TR_KEY_rpc_host_whitelist_enabled,
+    TR_KEY_rpc_large_response_compression_level,
+    TR_KEY_rpc_local_socket,
     TR_KEY_rpc_password,
     TR_KEY_rpc_port,
     TR_KEY_rpc_socket_mode,
@@ -528,6 +548,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_rpc_version_semver,
     TR_KEY_rpc_whitelist,
     TR_KEY_rpc_whitelist_enabled,
+    TR_KEY_rpc_worker_threads,
     TR_KEY_scrape,
     TR_KEY_scrape_paused_torrents_enabled_kebab_APICOMPAT,
     TR_KEY_scrape_state_camel_APICOMPAT,
@@ -610,6 +631,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_size_when_done,
     TR_KEY_sleep_per_seconds_during_verify_kebab_APICOMPAT,
     TR_KEY_sleep_per_seconds_during_verify,
+    TR_KEY_snapshot_count,
     TR_KEY_socket_address,
     TR_KEY_sort_mode_kebab_APICOMPAT,
     TR_KEY_sort_reversed_kebab_APICOMPAT,
@@ -668,6 +690,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_torrent_count_camel_APICOMPAT,
     TR_KEY_torrent_file_camel_APICOMPAT,
     TR_KEY_torrent_add,
+    TR_KEY_torrent_add_batch,
     TR_KEY_torrent_added,
     TR_KEY_torrent_added_notification_enabled,
     TR_KEY_torrent_added_verify_mode,
@@ -702,6 +725,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_tracker_replace,
     TR_KEY_tracker_stats,
     TR_KEY_trackers,
+    TR_KEY_transfer_time,
     TR_KEY_trash_can_enabled_kebab_APICOMPAT,
     TR_KEY_trash_original_torrent_files_kebab_APICOMPAT,
     TR_KEY_trash_can_enabled,
@@ -745,6 +769,7 @@ enum // NOLINT(performance-enum-size)
     TR_KEY_watch_dir,
     TR_KEY_watch_dir_enabled,
     TR_KEY_watch_dir_force_generic,
+    TR_KEY_web_host_stats,
     TR_KEY_webseeds,
     TR_KEY_webseeds_sending_to_us_camel_APICOMPAT,
     TR_KEY_webseeds_ex,
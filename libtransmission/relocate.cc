@@ -0,0 +1,297 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint> // uint64_t
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility> // for std::move()
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "libtransmission/error.h"
+#include "libtransmission/file.h"
+#include "libtransmission/relocate.h"
+#include "libtransmission/types.h"
+
+using namespace std::chrono_literals;
+
+namespace
+{
+auto constexpr ChunkSize = uint64_t{ 4U * 1024U * 1024U };
+
+// how long a throttled copy may sleep before checking to see if it was cancelled
+auto constexpr MaxSleepSlice = 100ms;
+} // namespace
+
+std::string tr_relocate_worker::staging_path(std::string_view const dst)
+{
+    return fmt::format("{:s}.relocating", dst);
+}
+
+void tr_relocate_worker::throttle(
+    Lane const& lane,
+    std::chrono::steady_clock::time_point const started_at,
+    uint64_t const job_bytes) const
+{
+    for (;;)
+    {
+        auto const limit = speed_limit();
+        if (limit == 0U || lane.stop_current)
+        {
+            return;
+        }
+
+        // how long copying `job_bytes` should have taken at this speed
+        auto const budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>{ static_cast<double>(job_bytes) / limit });
+        auto const ahead = started_at + budget - std::chrono::steady_clock::now();
+        if (ahead <= std::chrono::steady_clock::duration::zero())
+        {
+            return;
+        }
+
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(ahead, MaxSleepSlice));
+    }
+}
+
+void tr_relocate_worker::copy_file(
+    Lane& lane,
+    Job& job,
+    size_t const file_idx,
+    std::chrono::steady_clock::time_point const started_at,
+    uint64_t& job_bytes)
+{
+    auto const& file = job.result.files[file_idx];
+    auto& error = job.result.error;
+
+    if (!tr_sys_dir_create(tr_sys_path_dirname(file.dst), TR_SYS_DIR_CREATE_PARENTS, 0777, &error))
+    {
+        error.prefix_message("Unable to create directory for new file: ");
+        return;
+    }
+
+    auto const in = tr_sys_file_open(file.src, TR_SYS_FILE_READ | TR_SYS_FILE_SEQUENTIAL, 0, &error);
+    if (in == TR_BAD_SYS_FILE)
+    {
+        error.prefix_message("Unable to open source file: ");
+        return;
+    }
+
+    auto const out = tr_sys_file_open(
+        staging_path(file.dst),
+        TR_SYS_FILE_WRITE | TR_SYS_FILE_CREATE | TR_SYS_FILE_TRUNCATE,
+        0666,
+        &error);
+    if (out == TR_BAD_SYS_FILE)
+    {
+        tr_sys_file_close(in);
+        error.prefix_message("Unable to open destination file: ");
+        return;
+    }
+
+    for (auto offset = uint64_t{}; offset < file.size && !lane.stop_current;)
+    {
+        auto n_copied = uint64_t{};
+        if (!tr_sys_file_copy_range(in, out, offset, std::min(file.size - offset, ChunkSize), &n_copied, &error))
+        {
+            error.prefix_message("Unable to read/write: ");
+            break;
+        }
+
+        // the file shrank while we were copying it.
+        // that's for the caller to notice when it checks the file's size.
+        if (n_copied == 0U)
+        {
+            break;
+        }
+
+        offset += n_copied;
+        job_bytes += n_copied;
+
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+            job.copied[file_idx] = offset;
+        }
+
+        throttle(lane, started_at, job_bytes);
+    }
+
+    tr_sys_file_close(out);
+    tr_sys_file_close(in);
+}
+
+void tr_relocate_worker::run_job(Lane& lane, Job& job)
+{
+    auto const started_at = std::chrono::steady_clock::now();
+    auto job_bytes = uint64_t{};
+
+    auto& result = job.result;
+    for (size_t idx = 0, n = std::size(result.files); idx < n && !lane.stop_current && !result.error; ++idx)
+    {
+        copy_file(lane, job, idx, started_at, job_bytes);
+    }
+
+    result.cancelled = lane.stop_current;
+    if (result.cancelled || result.error)
+    {
+        for (auto const& file : result.files)
+        {
+            tr_sys_path_remove(staging_path(file.dst));
+        }
+    }
+
+    // copy, not move: progress() may be reading `result` until we're done
+    job.on_done(Result{ result });
+}
+
+void tr_relocate_worker::lane_thread_func(Lane* const lane)
+{
+    for (;;)
+    {
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+
+            lane->current.reset();
+            lane->stop_current = false;
+
+            if (std::empty(lane->todo))
+            {
+                lanes_.remove_if([lane](Lane const& that) { return &that == lane; });
+                lane_exited_cv_.notify_all();
+                return;
+            }
+
+            lane->current = std::move(lane->todo.front());
+            lane->todo.pop_front();
+        }
+
+        run_job(*lane, *lane->current);
+    }
+}
+
+void tr_relocate_worker::add(tr_torrent_id_t tor_id, std::string location, std::vector<File> files, DoneFunc on_done)
+{
+    auto const lock = std::scoped_lock{ mutex_ };
+
+    auto lane = std::ranges::find_if(
+        lanes_,
+        [&location](Lane const& that) { return tr_sys_path_is_same_device(that.device_path, location); });
+    auto const is_new_lane = lane == std::end(lanes_);
+    if (is_new_lane)
+    {
+        lane = lanes_.emplace(std::end(lanes_), location);
+    }
+
+    auto result = Result{};
+    result.tor_id = tor_id;
+    result.location = std::move(location);
+    result.files = std::move(files);
+    lane->todo.emplace_back(std::make_unique<Job>(std::move(result), std::move(on_done)));
+
+    if (is_new_lane)
+    {
+        std::thread(&tr_relocate_worker::lane_thread_func, this, &*lane).detach();
+    }
+}
+
+void tr_relocate_worker::cancel(tr_torrent_id_t const tor_id)
+{
+    auto const matches = [tor_id](std::unique_ptr<Job> const& job)
+    {
+        return job && job->result.tor_id == tor_id;
+    };
+
+    auto cancelled = std::vector<std::unique_ptr<Job>>{};
+
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+
+        for (auto& lane : lanes_)
+        {
+            for (auto iter = std::begin(lane.todo); iter != std::end(lane.todo);)
+            {
+                if (matches(*iter))
+                {
+                    cancelled.emplace_back(std::move(*iter));
+                    iter = lane.todo.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+
+            // the lane's thread calls on_done() once the job has stopped
+            if (matches(lane.current))
+            {
+                lane.stop_current = true;
+            }
+        }
+    }
+
+    for (auto& job : cancelled)
+    {
+        job->result.cancelled = true;
+        job->on_done(std::move(job->result));
+    }
+}
+
+std::optional<tr_relocate_worker::Progress> tr_relocate_worker::progress(tr_torrent_id_t const tor_id) const
+{
+    auto const lock = std::scoped_lock{ mutex_ };
+
+    auto const make_progress = [](Job const& job)
+    {
+        auto ret = Progress{};
+        ret.location = job.result.location;
+        ret.files.reserve(std::size(job.result.files));
+        for (size_t idx = 0, n = std::size(job.result.files); idx < n; ++idx)
+        {
+            auto const& file = job.result.files[idx];
+            ret.files.emplace_back(file.index, job.copied[idx]);
+            ret.bytes_copied += job.copied[idx];
+            ret.bytes_total += file.size;
+        }
+        return ret;
+    };
+
+    for (auto const& lane : lanes_)
+    {
+        if (lane.current && !lane.stop_current && lane.current->result.tor_id == tor_id)
+        {
+            return make_progress(*lane.current);
+        }
+
+        for (auto const& job : lane.todo)
+        {
+            if (job->result.tor_id == tor_id)
+            {
+                return make_progress(*job);
+            }
+        }
+    }
+
+    return {};
+}
+
+tr_relocate_worker::~tr_relocate_worker()
+{
+    auto lock = std::unique_lock{ mutex_ };
+    for (auto& lane : lanes_)
+    {
+        lane.todo.clear();
+        lane.stop_current = true;
+    }
+
+    // a stopped job only finishes the chunk that it's copying
+    lane_exited_cv_.wait(lock, [this]() { return std::empty(lanes_); });
+}
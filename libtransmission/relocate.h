@@ -0,0 +1,152 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#pragma once
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility> // std::pair
+#include <vector>
+
+#include "libtransmission/error.h"
+#include "libtransmission/types.h"
+
+// Copies torrents' files to a new location in the background, so that
+// moving a torrent to another device doesn't block the session thread.
+//
+// The worker only makes the copies: each file is copied to a staging path
+// next to its destination, and the caller decides (in the session thread)
+// whether to rename the staged copies into place and remove the originals.
+// Jobs whose destinations are on the same device run one after another;
+// jobs for different devices run concurrently.
+class tr_relocate_worker
+{
+public:
+    struct File
+    {
+        tr_file_index_t index = {};
+        std::string src;
+        std::string dst;
+
+        // the source's size and mtime when the job was queued,
+        // so that the caller can tell if it changed while being copied
+        uint64_t size = {};
+        time_t last_modified_at = {};
+    };
+
+    struct Result
+    {
+        tr_torrent_id_t tor_id = {};
+        std::string location;
+        std::vector<File> files;
+        bool cancelled = false;
+        tr_error error;
+    };
+
+    struct Progress
+    {
+        std::string location;
+        uint64_t bytes_copied = {};
+        uint64_t bytes_total = {};
+        std::vector<std::pair<tr_file_index_t, uint64_t>> files; // file index, bytes copied
+    };
+
+    // Called from a worker thread when a job ends. If the job was cancelled
+    // or failed, its staged copies have already been removed.
+    using DoneFunc = std::function<void(Result&&)>;
+
+    tr_relocate_worker() = default;
+    ~tr_relocate_worker();
+
+    tr_relocate_worker(tr_relocate_worker const&) = delete;
+    tr_relocate_worker(tr_relocate_worker&&) = delete;
+    tr_relocate_worker& operator=(tr_relocate_worker const&) = delete;
+    tr_relocate_worker& operator=(tr_relocate_worker&&) = delete;
+
+    [[nodiscard]] static std::string staging_path(std::string_view dst);
+
+    // `location` must exist: it's used to tell which device the job writes to.
+    void add(tr_torrent_id_t tor_id, std::string location, std::vector<File> files, DoneFunc on_done);
+
+    // Cancels the torrent's job without waiting for it to stop. Its DoneFunc
+    // is still called, with `cancelled` set, once its staged copies are removed.
+    void cancel(tr_torrent_id_t tor_id);
+
+    [[nodiscard]] std::optional<Progress> progress(tr_torrent_id_t tor_id) const;
+
+    // Limits how fast each device is written to. Zero means unlimited.
+    void set_speed_limit(uint64_t bytes_per_second) noexcept
+    {
+        speed_limit_ = bytes_per_second;
+    }
+
+    [[nodiscard]] uint64_t speed_limit() const noexcept
+    {
+        return speed_limit_;
+    }
+
+private:
+    struct Job
+    {
+        Job(Result result_in, DoneFunc on_done_in)
+            : result{ std::move(result_in) }
+            , on_done{ std::move(on_done_in) }
+            , copied(std::size(result.files))
+        {
+        }
+
+        Result result;
+        DoneFunc on_done;
+        std::vector<uint64_t> copied; // guarded by mutex_
+    };
+
+    // the jobs that write to one device
+    struct Lane
+    {
+        explicit Lane(std::string device_path_in)
+            : device_path{ std::move(device_path_in) }
+        {
+        }
+
+        std::string device_path;
+        std::deque<std::unique_ptr<Job>> todo;
+        std::unique_ptr<Job> current;
+        std::atomic<bool> stop_current = false;
+    };
+
+    void lane_thread_func(Lane* lane);
+
+    void run_job(Lane& lane, Job& job);
+
+    void copy_file(
+        Lane& lane,
+        Job& job,
+        size_t file_idx,
+        std::chrono::steady_clock::time_point started_at,
+        uint64_t& job_bytes);
+
+    void throttle(Lane const& lane, std::chrono::steady_clock::time_point started_at, uint64_t job_bytes) const;
+
+    mutable std::mutex mutex_;
+    std::condition_variable lane_exited_cv_;
+    std::list<Lane> lanes_;
+
+    std::atomic<uint64_t> speed_limit_ = {};
+};
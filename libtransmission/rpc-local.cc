@@ -0,0 +1,379 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <array>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t, uint32_t, uint64_t
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <event2/buffer.h>
+#include <event2/bufferevent.h>
+#include <event2/event.h>
+#include <event2/listener.h>
+#include <event2/util.h>
+
+#include <fmt/format.h>
+
+#include "libtransmission/log.h"
+#include "libtransmission/quark.h"
+#include "libtransmission/rpc-local.h"
+#include "libtransmission/rpcimpl.h"
+#include "libtransmission/session.h"
+#include "libtransmission/utils.h" // _()
+
+using namespace std::literals;
+
+struct tr_rpc_local_server::Connection : public std::enable_shared_from_this<Connection>
+{
+    explicit Connection(tr_rpc_local_server* server_in)
+        : server{ server_in }
+    {
+    }
+
+    tr_rpc_local_server* const server;
+    tr::evhelpers::bufferevent_unique_ptr bev;
+
+    // Responses that are waiting for an earlier one to be sent.
+    // `pending.front()` answers request number `first_seq`.
+    std::deque<std::optional<std::string>> pending;
+    uint64_t first_seq = 0U;
+
+    // reading stops while too many requests are waiting to be answered
+    bool is_read_paused = false;
+
+    // the client has hung up its end, so close once everything's been answered
+    bool is_read_closed = false;
+};
+
+namespace
+{
+auto constexpr HeaderSize = size_t{ 4U };
+
+// JSON messages are objects or arrays; benc dictionaries and lists start with a letter
+[[nodiscard]] tr_rpc_encoding get_encoding(std::string_view const message)
+{
+    auto const pos = message.find_first_not_of(" \t\r\n"sv);
+    return pos != std::string_view::npos && (message[pos] == '{' || message[pos] == '[') ? tr_rpc_encoding::Json :
+                                                                                           tr_rpc_encoding::Benc;
+}
+
+void add_message(evbuffer* const buf, std::string_view const message)
+{
+    auto const len = static_cast<uint32_t>(std::size(message));
+    auto const header = std::array<uint8_t, HeaderSize>{
+        static_cast<uint8_t>(len >> 24U),
+        static_cast<uint8_t>(len >> 16U),
+        static_cast<uint8_t>(len >> 8U),
+        static_cast<uint8_t>(len),
+    };
+    evbuffer_add(buf, std::data(header), std::size(header));
+    evbuffer_add(buf, std::data(message), std::size(message));
+}
+
+#ifndef _WIN32
+[[nodiscard]] std::optional<uid_t> get_peer_uid([[maybe_unused]] evutil_socket_t const sockfd)
+{
+#if defined(__linux__)
+    auto cred = ucred{};
+    auto len = socklen_t{ sizeof(cred) };
+    if (getsockopt(sockfd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0)
+    {
+        return cred.uid;
+    }
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+    auto uid = uid_t{};
+    auto gid = gid_t{};
+    if (getpeereid(sockfd, &uid, &gid) == 0)
+    {
+        return uid;
+    }
+#endif
+
+    return {};
+}
+#endif
+} // namespace
+
+tr_rpc_local_server::tr_rpc_local_server(tr_session* const session, tr_rpc_latency* const latency)
+    : session_{ session }
+    , latency_{ latency }
+{
+}
+
+tr_rpc_local_server::~tr_rpc_local_server()
+{
+    stop();
+}
+
+bool tr_rpc_local_server::start([[maybe_unused]] std::string_view const path, [[maybe_unused]] tr_mode_t const socket_mode)
+{
+    stop();
+
+#ifdef _WIN32
+    tr_logAddError(
+        fmt::format(
+            fmt::runtime(_("Unix sockets are unsupported on Windows. Please change '{key}' in your settings.")),
+            fmt::arg("key", tr_quark_get_string_view(TR_KEY_rpc_local_socket))));
+    return false;
+#else
+    auto addr = sockaddr_un{};
+    if (std::size(path) >= sizeof(addr.sun_path))
+    {
+        tr_logAddError(
+            fmt::format(
+                fmt::runtime(_("Couldn't listen for local RPC requests on '{path}': path is too long")),
+                fmt::arg("path", path)));
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::ranges::copy(path, addr.sun_path);
+
+    unlink(addr.sun_path);
+
+    auto const on_accept =
+        [](evconnlistener* /*listener*/, evutil_socket_t const sockfd, sockaddr* /*addr*/, int /*socklen*/, void* vself)
+    {
+        static_cast<tr_rpc_local_server*>(vself)->accept(sockfd);
+    };
+
+    listener_.reset(evconnlistener_new_bind(
+        session_->event_base(),
+        on_accept,
+        this,
+        LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC,
+        -1,
+        reinterpret_cast<sockaddr const*>(&addr),
+        sizeof(addr)));
+
+    if (!listener_)
+    {
+        auto const err = evutil_socket_geterror(-1);
+        tr_logAddError(
+            fmt::format(
+                fmt::runtime(_("Couldn't listen for local RPC requests on '{path}': {error} ({error_code})")),
+                fmt::arg("path", path),
+                fmt::arg("error", evutil_socket_error_to_string(err)),
+                fmt::arg("error_code", err)));
+        return false;
+    }
+
+    if (chmod(addr.sun_path, socket_mode) != 0)
+    {
+        tr_logAddWarn(
+            fmt::format(
+                fmt::runtime(_("Couldn't set RPC socket mode to {mode:#o}, defaulting to 0755")),
+                fmt::arg("mode", socket_mode)));
+    }
+
+    path_ = path;
+    tr_logAddInfo(fmt::format(fmt::runtime(_("Listening for local RPC requests on '{path}'")), fmt::arg("path", path_)));
+    return true;
+#endif
+}
+
+void tr_rpc_local_server::stop()
+{
+    connections_.clear();
+
+    if (!listener_)
+    {
+        return;
+    }
+
+    listener_.reset();
+
+#ifndef _WIN32
+    unlink(path_.c_str());
+#endif
+
+    tr_logAddInfo(
+        fmt::format(fmt::runtime(_("Stopped listening for local RPC requests on '{path}'")), fmt::arg("path", path_)));
+    path_.clear();
+}
+
+void tr_rpc_local_server::accept(evutil_socket_t const sockfd)
+{
+#ifndef _WIN32
+    auto const uid = get_peer_uid(sockfd);
+    if (auto const is_trusted = uid && (*uid == 0 || *uid == geteuid()); !is_trusted && !other_users_allowed_)
+    {
+        tr_logAddDebug(fmt::format("Rejected a local RPC connection from uid {}", uid ? fmt::to_string(*uid) : "unknown"));
+        evutil_closesocket(sockfd);
+        return;
+    }
+#endif
+
+    auto* const bev = bufferevent_socket_new(session_->event_base(), sockfd, BEV_OPT_CLOSE_ON_FREE);
+    if (bev == nullptr)
+    {
+        evutil_closesocket(sockfd);
+        return;
+    }
+
+    auto const on_read = [](bufferevent* /*bev*/, void* vconn)
+    {
+        auto* const conn = static_cast<Connection*>(vconn);
+        conn->server->read(conn->shared_from_this());
+    };
+
+    // the output buffer has been flushed
+    auto const on_write = [](bufferevent* /*bev*/, void* vconn)
+    {
+        if (auto* const conn = static_cast<Connection*>(vconn); conn->is_read_closed && std::empty(conn->pending))
+        {
+            conn->server->close(conn);
+        }
+    };
+
+    auto const on_event = [](bufferevent* bev, short what, void* vconn)
+    {
+        auto* const conn = static_cast<Connection*>(vconn);
+
+        // the client may hang up its end as soon as it's sent its last request,
+        // so keep answering until every request it sent has been answered
+        if ((what & BEV_EVENT_EOF) != 0 &&
+            (!std::empty(conn->pending) || evbuffer_get_length(bufferevent_get_output(bev)) != 0U))
+        {
+            conn->is_read_closed = true;
+            bufferevent_disable(bev, EV_READ);
+            return;
+        }
+
+        conn->server->close(conn);
+    };
+
+    auto conn = std::make_shared<Connection>(this);
+    conn->bev.reset(bev);
+    bufferevent_setcb(bev, on_read, on_write, on_event, conn.get());
+    bufferevent_setwatermark(bev, EV_READ, HeaderSize, 0U);
+    bufferevent_enable(bev, EV_READ | EV_WRITE);
+    connections_.emplace_back(std::move(conn));
+}
+
+void tr_rpc_local_server::read(std::shared_ptr<Connection> const& conn)
+{
+    auto* const bev = conn->bev.get();
+    auto* const input = bufferevent_get_input(bev);
+
+    while (std::size(conn->pending) < MaxPendingRequests)
+    {
+        auto header = std::array<uint8_t, HeaderSize>{};
+        if (evbuffer_copyout(input, std::data(header), std::size(header)) != static_cast<ev_ssize_t>(std::size(header)))
+        {
+            break;
+        }
+
+        auto const len = (uint32_t{ header[0] } << 24U) | (uint32_t{ header[1] } << 16U) | (uint32_t{ header[2] } << 8U) |
+            uint32_t{ header[3] };
+        if (len > MaxMessageSize)
+        {
+            tr_logAddDebug(fmt::format("Closing a local RPC connection that sent a {} byte message", len));
+            close(conn.get());
+            return;
+        }
+
+        if (evbuffer_get_length(input) < std::size(header) + len)
+        {
+            break;
+        }
+
+        // Async handlers may still be reading the request after this returns,
+        // since it's parsed in place, so keep it alive until it's answered.
+        auto request = std::make_shared<std::string>(len, '\0');
+        evbuffer_drain(input, std::size(header));
+        evbuffer_remove(input, std::data(*request), len);
+
+        auto const seq = conn->first_seq + std::size(conn->pending);
+        conn->pending.emplace_back();
+
+        auto const encoding = get_encoding(*request);
+        tr_rpc_request_exec_serialized(
+            session_,
+            *request,
+            encoding,
+            encoding,
+            // NOLINTNEXTLINE(cppcoreguidelines-rvalue-reference-param-not-moved)
+            [this, weak_conn = std::weak_ptr{ conn }, seq, request](std::string&& content)
+            {
+                // the connection may have been closed while this was being handled
+                if (auto const strong = weak_conn.lock(); strong)
+                {
+                    respond(strong, seq, std::move(content));
+                }
+            },
+            latency_);
+
+        // the response may have failed and closed the connection
+        if (!conn->bev)
+        {
+            return;
+        }
+    }
+
+    if (std::size(conn->pending) >= MaxPendingRequests)
+    {
+        conn->is_read_paused = true;
+        bufferevent_disable(bev, EV_READ);
+    }
+}
+
+void tr_rpc_local_server::respond(std::shared_ptr<Connection> const& conn, uint64_t const seq, std::string&& content)
+{
+    if (std::size(content) > MaxMessageSize)
+    {
+        tr_logAddDebug(fmt::format("Closing a local RPC connection whose response was {} bytes", std::size(content)));
+        close(conn.get());
+        return;
+    }
+
+    conn->pending[seq - conn->first_seq] = std::move(content);
+
+    auto* const bev = conn->bev.get();
+    auto* const output = bufferevent_get_output(bev);
+    while (!std::empty(conn->pending) && conn->pending.front())
+    {
+        add_message(output, *conn->pending.front());
+        conn->pending.pop_front();
+        ++conn->first_seq;
+    }
+
+    if (conn->is_read_paused && !conn->is_read_closed && std::size(conn->pending) < MaxPendingRequests)
+    {
+        conn->is_read_paused = false;
+        bufferevent_enable(bev, EV_READ);
+
+        // Requests that arrived while reading was paused are already buffered,
+        // so no new data may come to wake up the read callback.
+        bufferevent_trigger(bev, EV_READ, BEV_TRIG_DEFER_CALLBACKS);
+    }
+}
+
+void tr_rpc_local_server::close(Connection const* const conn)
+{
+    auto const iter = std::ranges::find_if(connections_, [conn](auto const& item) { return item.get() == conn; });
+    if (iter == std::end(connections_))
+    {
+        return;
+    }
+
+    // callers may still hold a reference, so let them see that it's closed
+    (*iter)->bev.reset();
+    connections_.erase(iter);
+}
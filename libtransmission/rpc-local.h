@@ -0,0 +1,97 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#ifndef __TRANSMISSION__
+#error only libtransmission should #include this header.
+#endif
+
+#pragma once
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <event2/util.h> // evutil_socket_t
+
+#include "libtransmission/types.h"
+#include "libtransmission/utils-ev.h"
+
+class tr_rpc_latency;
+struct tr_session;
+
+/**
+ * A lightweight RPC protocol for local clients, served on a Unix socket.
+ *
+ * Scripts that send many requests pay for evhttp's header parsing,
+ * Basic auth, and the CSRF session id on each one. Here, a connection
+ * is authorized once from its peer's credentials and then stays open.
+ *
+ * Each message is a 4-byte big-endian length followed by that many bytes
+ * of JSON or benc. Clients may send any number of requests without waiting.
+ * Each request gets one response, in request order and in the request's
+ * encoding. Notifications get an empty response.
+ *
+ * Every method must be called in the session thread.
+ */
+class tr_rpc_local_server
+{
+public:
+    // the longest message that's accepted or sent
+    static auto constexpr MaxMessageSize = uint32_t{ 64U * 1024U * 1024U };
+
+    // A connection stops reading once this many of its requests are waiting
+    // to be answered, and resumes when they're answered.
+    static auto constexpr MaxPendingRequests = size_t{ 64U };
+
+    tr_rpc_local_server(tr_session* session, tr_rpc_latency* latency = nullptr);
+    ~tr_rpc_local_server();
+
+    tr_rpc_local_server(tr_rpc_local_server const&) = delete;
+    tr_rpc_local_server(tr_rpc_local_server&&) = delete;
+    tr_rpc_local_server& operator=(tr_rpc_local_server const&) = delete;
+    tr_rpc_local_server& operator=(tr_rpc_local_server&&) = delete;
+
+    // Listens on a socket at `path`, replacing any file that's there.
+    bool start(std::string_view path, tr_mode_t socket_mode);
+    void stop();
+
+    [[nodiscard]] auto is_listening() const noexcept
+    {
+        return listener_ != nullptr;
+    }
+
+    // the socket's path, or empty if not listening
+    [[nodiscard]] constexpr auto const& path() const noexcept
+    {
+        return path_;
+    }
+
+    // Root and the user that Transmission runs as can always connect.
+    // Other users who can open the socket are only let in if this is set,
+    // since they have no way to give a password.
+    constexpr void set_other_users_allowed(bool allowed) noexcept
+    {
+        other_users_allowed_ = allowed;
+    }
+
+private:
+    struct Connection;
+
+    void accept(evutil_socket_t sockfd);
+    void read(std::shared_ptr<Connection> const& conn);
+    void respond(std::shared_ptr<Connection> const& conn, uint64_t seq, std::string&& content);
+    void close(Connection const* conn);
+
+    tr_session* const session_;
+    tr_rpc_latency* const latency_;
+
+    std::string path_;
+    tr::evhelpers::evconnlistener_unique_ptr listener_;
+    std::list<std::shared_ptr<Connection>> connections_;
+    bool other_users_allowed_ = false;
+};
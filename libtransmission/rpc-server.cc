@@ -6,13 +6,20 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstring> /* for strcspn() */
 #include <ctime>
+#include <deque>
+#include <functional> // std::less
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <ranges>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -26,6 +33,7 @@
 #endif
 
 #include <event2/buffer.h>
+#include <event2/bufferevent.h>
 #include <event2/http.h>
 #include <event2/listener.h>
 
@@ -37,10 +45,12 @@
 #include "libtransmission/crypto-utils.h" /* tr_ssha1_matches() */
 #include "libtransmission/error.h"
 #include "libtransmission/file-utils.h"
+#include "libtransmission/file.h"
 #include "libtransmission/log.h"
 #include "libtransmission/net.h"
 #include "libtransmission/platform.h" /* tr_getWebClientDir() */
 #include "libtransmission/quark.h"
+#include "libtransmission/rpc-local.h"
 #include "libtransmission/rpc-server.h"
 #include "libtransmission/rpcimpl.h"
 #include "libtransmission/session.h"
@@ -173,9 +183,90 @@ private:
     class tr_unix_addr unix_addr_;
 };
 
+// A client that's connected to the event stream.
+// Its events are sent as chunks of a response that stays open
+// until the client disconnects or the server is stopped.
+struct tr_rpc_subscriber
+{
+    tr_rpc_subscriber(tr_rpc_server* server_in, evhttp_request* req_in, tr_rpc_event_source&& source_in, time_t interval_in)
+        : server{ server_in }
+        , req{ req_in }
+        , source{ std::move(source_in) }
+        , interval{ interval_in }
+    {
+    }
+
+    tr_rpc_server* const server;
+    evhttp_request* const req;
+    tr_rpc_event_source source;
+    time_t const interval;
+    time_t next_push_at = 0;
+    time_t last_sent_at = 0;
+};
+
+// Answers RPC requests from a tr_rpc_snapshot on a small pool of threads.
+// evhttp isn't thread-safe, so the responses are sent from the session thread,
+// and requests that the snapshot can't answer are handed back to it.
+class tr_rpc_workers : public std::enable_shared_from_this<tr_rpc_workers>
+{
+public:
+    tr_rpc_workers(tr_rpc_server* server, size_t n_threads);
+    ~tr_rpc_workers();
+
+    tr_rpc_workers(tr_rpc_workers const&) = delete;
+    tr_rpc_workers(tr_rpc_workers&&) = delete;
+    tr_rpc_workers& operator=(tr_rpc_workers const&) = delete;
+    tr_rpc_workers& operator=(tr_rpc_workers&&) = delete;
+
+    void add(
+        evhttp_request* req,
+        std::string_view body,
+        tr_rpc_encoding request_encoding,
+        tr_rpc_encoding response_encoding,
+        std::shared_ptr<tr_rpc_snapshot const> snapshot);
+
+private:
+    struct Job
+    {
+        evhttp_request* req = nullptr;
+        std::string body;
+        tr_rpc_encoding request_encoding = tr_rpc_encoding::Json;
+        tr_rpc_encoding response_encoding = tr_rpc_encoding::Json;
+        std::shared_ptr<tr_rpc_snapshot const> snapshot;
+    };
+
+    void thread_func();
+
+    tr_rpc_server* const server_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    bool is_stopping_ = false;
+
+    std::vector<std::thread> threads_;
+};
+
 namespace
 {
 int constexpr DeflateLevel = 6; // medium / default
+auto constexpr MaxDeflateLevel = size_t{ 12U };
+
+// Responses at least this big are compressed with the
+// `rpc_large_response_compression_level` setting instead.
+auto constexpr LargeResponseSize = size_t{ 64U * 1024U };
+
+auto constexpr MaxEventSubscribers = size_t{ 64U };
+auto constexpr DefaultEventIntervalSecs = time_t{ 2 };
+auto constexpr MaxEventIntervalSecs = time_t{ 60 };
+
+// Idle streams get a blank line this often so that clients and proxies
+// can tell a quiet stream from a dead connection.
+auto constexpr EventHeartbeatSecs = time_t{ 15 };
+
+// Subscribers that aren't reading their events get no new ones while
+// this much is waiting to be sent. Their changes are coalesced instead.
+auto constexpr MaxEventBacklog = size_t{ 1024U * 1024U };
 
 // Prevent clickjacking on the browser-facing WebUI and RPC responses.
 // https://github.com/transmission/transmission/issues/8726
@@ -204,6 +295,22 @@ void send_simple_response(struct evhttp_request* req, int code, char const* text
     evbuffer_free(body);
 }
 
+// Returns `content` gzipped, or an empty string if that doesn't make it any smaller.
+[[nodiscard]] std::string gzip(libdeflate_compressor* compressor, std::string_view content)
+{
+    auto out = std::string{};
+    out.resize(libdeflate_gzip_compress_bound(compressor, std::size(content)));
+
+    auto const len = libdeflate_gzip_compress(
+        compressor,
+        std::data(content),
+        std::size(content),
+        std::data(out),
+        std::size(out));
+    out.resize(0U < len && len < std::size(content) ? len : 0U);
+    return out;
+}
+
 // ---
 
 [[nodiscard]] constexpr char const* mimetype_guess(std::string_view path)
@@ -230,27 +337,35 @@ void send_simple_response(struct evhttp_request* req, int code, char const* text
     return "application/octet-stream";
 }
 
+[[nodiscard]] bool accepts_gzip(struct evhttp_request* req)
+{
+    char const* encoding = evhttp_find_header(evhttp_request_get_input_headers(req), "Accept-Encoding");
+    return encoding != nullptr && tr_strv_contains(encoding, "gzip"sv);
+}
+
 [[nodiscard]] evbuffer* make_response(struct evhttp_request* req, tr_rpc_server const* server, std::string_view content)
 {
     auto* const out = evbuffer_new();
-    auto const* const input_headers = evhttp_request_get_input_headers(req);
     auto* const output_headers = evhttp_request_get_output_headers(req);
 
-    char const* encoding = evhttp_find_header(input_headers, "Accept-Encoding");
+    // Large responses, e.g. torrent_get on a big session, can use a faster
+    // level so that clients which poll often don't cost much CPU each time.
+    auto* const compressor = std::size(content) < LargeResponseSize ? server->compressor.get() :
+                                                                        server->large_response_compressor.get();
 
-    if (bool const do_compress = encoding != nullptr && tr_strv_contains(encoding, "gzip"sv); !do_compress)
+    if (compressor == nullptr || !accepts_gzip(req))
     {
         evbuffer_add(out, std::data(content), std::size(content));
     }
     else
     {
-        auto const max_compressed_len = libdeflate_deflate_compress_bound(server->compressor.get(), std::size(content));
+        auto const max_compressed_len = libdeflate_gzip_compress_bound(compressor, std::size(content));
 
         auto iov = evbuffer_iovec{};
         evbuffer_reserve_space(out, static_cast<ev_ssize_t>(std::max(std::size(content), max_compressed_len)), &iov, 1);
 
         auto const compressed_len = libdeflate_gzip_compress(
-            server->compressor.get(),
+            compressor,
             std::data(content),
             std::size(content),
             iov.iov_base,
@@ -288,9 +403,9 @@ void serve_file(struct evhttp_request* req, tr_rpc_server const* server, std::st
         return;
     }
 
-    auto content = std::vector<char>{};
-
-    if (auto error = tr_error{}; !tr_file_read(filename, content, &error))
+    auto error = tr_error{};
+    auto const file = server->web_files_->get(filename, &error);
+    if (!file)
     {
         send_simple_response(req, HTTP_NOTFOUND, fmt::format("{} ({})", filename, error.message()).c_str());
         return;
@@ -299,9 +414,32 @@ void serve_file(struct evhttp_request* req, tr_rpc_server const* server, std::st
     auto const now = tr_time();
     add_time_header(output_headers, "Date", now);
     add_time_header(output_headers, "Expires", now + (24 * 60 * 60));
+    evhttp_add_header(output_headers, "Vary", "Accept-Encoding");
+
+    auto const use_gzip = file->use_gzip(accepts_gzip(req));
+    evhttp_add_header(output_headers, "ETag", file->etag_for(use_gzip).c_str());
+
+    auto const* const input_headers = evhttp_request_get_input_headers(req);
+    if (auto const* const tags = evhttp_find_header(input_headers, "If-None-Match");
+        tags != nullptr && file->is_not_modified(use_gzip, tags))
+    {
+        evhttp_send_reply(req, HTTP_NOTMODIFIED, "Not Modified", nullptr);
+        return;
+    }
+
     evhttp_add_header(output_headers, "Content-Type", mimetype_guess(filename));
 
-    auto* const response = make_response(req, server, std::string_view{ std::data(content), std::size(content) });
+    auto* const response = evbuffer_new();
+    if (use_gzip)
+    {
+        evhttp_add_header(output_headers, "Content-Encoding", "gzip");
+        evbuffer_add(response, std::data(file->gzipped), std::size(file->gzipped));
+    }
+    else
+    {
+        evbuffer_add(response, std::data(file->content), std::size(file->content));
+    }
+
     evhttp_send_reply(req, HTTP_OK, "OK", response);
     evbuffer_free(response);
 }
@@ -370,26 +508,101 @@ void handle_web_client(struct evhttp_request* req, tr_rpc_server const* server)
     }
 }
 
-void handle_rpc_from_json(struct evhttp_request* req, tr_rpc_server* server, std::string_view json)
+void send_rpc_response(
+    struct evhttp_request* req,
+    tr_rpc_server const* server,
+    std::string_view content,
+    tr_rpc_encoding encoding = tr_rpc_encoding::Json)
+{
+    if (std::empty(content))
+    {
+        evhttp_send_reply(req, HTTP_NOCONTENT, "OK", nullptr);
+        return;
+    }
+
+    auto* const output_headers = evhttp_request_get_output_headers(req);
+    auto* const response = make_response(req, server, content);
+    evhttp_add_header(
+        output_headers,
+        "Content-Type",
+        encoding == tr_rpc_encoding::Benc ? std::data(TrRpcBencContentType) : "application/json; charset=UTF-8");
+    evhttp_send_reply(req, HTTP_OK, "OK", response);
+    evbuffer_free(response);
+}
+
+void handle_rpc_in_session_thread(
+    struct evhttp_request* req,
+    tr_rpc_server* server,
+    std::string_view body,
+    tr_rpc_encoding const request_encoding,
+    tr_rpc_encoding const response_encoding)
 {
-    tr_rpc_request_exec(
+    tr_rpc_request_exec_serialized(
         server->session,
-        json,
+        body,
+        request_encoding,
+        response_encoding,
         // NOLINTNEXTLINE(cppcoreguidelines-rvalue-reference-param-not-moved)
-        [req, server](tr_variant&& content)
-        {
-            if (!content.has_value())
-            {
-                evhttp_send_reply(req, HTTP_NOCONTENT, "OK", nullptr);
-                return;
-            }
+        [req, server, response_encoding](std::string&& content)
+        { send_rpc_response(req, server, content, response_encoding); },
+        &server->latency_);
+}
 
-            auto* const output_headers = evhttp_request_get_output_headers(req);
-            auto* const response = make_response(req, server, tr_variant_serde::json().compact().to_string(content));
-            evhttp_add_header(output_headers, "Content-Type", "application/json; charset=UTF-8");
-            evhttp_send_reply(req, HTTP_OK, "OK", response);
-            evbuffer_free(response);
-        });
+void on_snapshot_timer(tr_rpc_server* server)
+{
+    if (server->snapshot_wanted_)
+    {
+        server->snapshot_wanted_ = false;
+        server->snapshot_ = std::make_shared<tr_rpc_snapshot const>(server->session);
+        return;
+    }
+
+    // no requests in the last second, so stop refreshing until the next one
+    server->snapshot_.reset();
+    server->snapshot_timer_->stop();
+}
+
+void want_snapshot(tr_rpc_server* server)
+{
+    auto const n_threads = server->settings().worker_threads;
+    if (n_threads == 0U)
+    {
+        return;
+    }
+
+    if (!server->workers_)
+    {
+        server->workers_ = std::make_shared<tr_rpc_workers>(server, n_threads);
+    }
+
+    if (!server->snapshot_timer_)
+    {
+        server->snapshot_timer_ = server->session->timerMaker().create([server]() { on_snapshot_timer(server); });
+    }
+
+    // wake the timer back up if it went idle
+    if (!server->snapshot_ && !server->snapshot_wanted_)
+    {
+        server->snapshot_timer_->start_repeating(1s);
+    }
+
+    server->snapshot_wanted_ = true;
+}
+
+void stop_workers(tr_rpc_server* server)
+{
+    server->snapshot_timer_.reset();
+    server->snapshot_.reset();
+    server->snapshot_wanted_ = false;
+    server->workers_.reset();
+}
+
+// Clients can opt into benc by naming its MIME type in `Content-Type`
+// (for the request) and in `Accept` (for the response).
+[[nodiscard]] tr_rpc_encoding get_rpc_encoding(struct evhttp_request* req, char const* header)
+{
+    auto const* const val = evhttp_find_header(evhttp_request_get_input_headers(req), header);
+    return val != nullptr && tr_strv_contains(val, TrRpcBencContentType) ? tr_rpc_encoding::Benc : tr_rpc_encoding::Json;
 }
 
 void handle_rpc(struct evhttp_request* req, tr_rpc_server* server)
@@ -397,15 +610,169 @@ void handle_rpc(struct evhttp_request* req, tr_rpc_server* server)
     if (auto const cmd = evhttp_request_get_command(req); cmd == EVHTTP_REQ_POST)
     {
         auto* const input_buffer = evhttp_request_get_input_buffer(req);
-        auto json = std::string_view{ reinterpret_cast<char const*>(evbuffer_pullup(input_buffer, -1)),
-                                      evbuffer_get_length(input_buffer) };
-        handle_rpc_from_json(req, server, json);
+        auto const body = std::string_view{ reinterpret_cast<char const*>(evbuffer_pullup(input_buffer, -1)),
+                                            evbuffer_get_length(input_buffer) };
+        auto const request_encoding = get_rpc_encoding(req, "Content-Type");
+        auto const response_encoding = get_rpc_encoding(req, "Accept");
+
+        want_snapshot(server);
+
+        if (auto const& snapshot = server->snapshot_; server->workers_ && snapshot && snapshot->is_current())
+        {
+            server->workers_->add(req, body, request_encoding, response_encoding, snapshot);
+            return;
+        }
+
+        handle_rpc_in_session_thread(req, server, body, request_encoding, response_encoding);
         return;
     }
 
     send_simple_response(req, HTTP_BADMETHOD);
 }
 
+void handle_stats(struct evhttp_request* req, tr_rpc_server const* server)
+{
+    if (auto const cmd = evhttp_request_get_command(req); cmd != EVHTTP_REQ_GET)
+    {
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Allow", "GET");
+        send_simple_response(req, HTTP_BADMETHOD);
+        return;
+    }
+
+    send_rpc_response(req, server, tr_variant_serde::json().compact().to_string(tr_variant{ server->latency_.to_map() }));
+}
+
+// --- EVENT STREAM
+
+void push_event(tr_rpc_subscriber& sub, time_t now)
+{
+    sub.next_push_at = now + sub.interval;
+
+    auto* const bev = evhttp_connection_get_bufferevent(evhttp_request_get_connection(sub.req));
+    if (bev != nullptr && evbuffer_get_length(bufferevent_get_output(bev)) > MaxEventBacklog)
+    {
+        return;
+    }
+
+    auto payload = std::string{};
+    if (auto const event = sub.source.next(); event.has_value())
+    {
+        payload = tr_variant_serde::json().compact().to_string(event);
+    }
+    else if (now - sub.last_sent_at < EventHeartbeatSecs)
+    {
+        return;
+    }
+
+    payload += '\n';
+    auto* const buf = evbuffer_new();
+    evbuffer_add(buf, std::data(payload), std::size(payload));
+    evhttp_send_reply_chunk(sub.req, buf);
+    evbuffer_free(buf);
+    sub.last_sent_at = now;
+}
+
+void on_events_timer(tr_rpc_server* server)
+{
+    // Subscribers are batched onto a single one-second tick.
+    // Each one builds its event from whatever changed since its last push,
+    // so changes between pushes are coalesced into one event.
+    auto const now = tr_time();
+    for (auto const& sub : server->subscribers_)
+    {
+        if (sub->next_push_at <= now)
+        {
+            push_event(*sub, now);
+        }
+    }
+}
+
+void remove_subscriber(tr_rpc_server* server, tr_rpc_subscriber const* sub)
+{
+    std::erase_if(server->subscribers_, [sub](auto const& walk) { return walk.get() == sub; });
+
+    if (std::empty(server->subscribers_))
+    {
+        server->events_timer_.reset();
+    }
+}
+
+void on_subscriber_closed(struct evhttp_connection* /*con*/, void* vsub)
+{
+    auto* const sub = static_cast<tr_rpc_subscriber*>(vsub);
+    remove_subscriber(sub->server, sub);
+}
+
+void close_subscribers(tr_rpc_server* server)
+{
+    for (auto const& sub : server->subscribers_)
+    {
+        evhttp_connection_set_closecb(evhttp_request_get_connection(sub->req), nullptr, nullptr);
+        evhttp_send_reply_end(sub->req);
+    }
+
+    server->subscribers_.clear();
+    server->events_timer_.reset();
+}
+
+void handle_events(struct evhttp_request* req, tr_rpc_server* server)
+{
+    if (auto const cmd = evhttp_request_get_command(req); cmd != EVHTTP_REQ_POST)
+    {
+        send_simple_response(req, HTTP_BADMETHOD);
+        return;
+    }
+
+    auto* const input_buffer = evhttp_request_get_input_buffer(req);
+    auto const json = std::string_view{ reinterpret_cast<char const*>(evbuffer_pullup(input_buffer, -1)),
+                                        evbuffer_get_length(input_buffer) };
+    auto const otop = tr_variant_serde::json().inplace().known_keys_only().parse(json);
+    auto const* const params = otop ? otop->get_if<tr_variant::Map>() : nullptr;
+    if (params == nullptr)
+    {
+        send_simple_response(req, HTTP_BADREQUEST, "<p>Expected a JSON object of subscription params.</p>");
+        return;
+    }
+
+    auto source = tr_rpc_event_source{ server->session, *params };
+    if (!source.is_valid())
+    {
+        send_simple_response(req, HTTP_BADREQUEST, "<p>No fields specified.</p>");
+        return;
+    }
+
+    if (std::size(server->subscribers_) >= MaxEventSubscribers)
+    {
+        send_simple_response(req, HTTP_SERVUNAVAIL, "<p>Too many event stream subscribers.</p>");
+        return;
+    }
+
+    auto const interval = std::clamp(
+        static_cast<time_t>(params->value_if<int64_t>(TR_KEY_interval).value_or(DefaultEventIntervalSecs)),
+        time_t{ 1 },
+        MaxEventIntervalSecs);
+
+    auto& sub = *server->subscribers_.emplace_back(
+        std::make_unique<tr_rpc_subscriber>(server, req, std::move(source), interval));
+    evhttp_connection_set_closecb(evhttp_request_get_connection(req), on_subscriber_closed, &sub);
+
+    if (!server->events_timer_)
+    {
+        server->events_timer_ = server->session->timerMaker().create([server]() { on_events_timer(server); });
+        server->events_timer_->start_repeating(1s);
+    }
+
+    auto* const output_headers = evhttp_request_get_output_headers(req);
+    evhttp_add_header(output_headers, "Content-Type", "application/x-ndjson; charset=UTF-8");
+    evhttp_add_header(output_headers, "Cache-Control", "no-cache");
+    evhttp_send_reply_start(req, HTTP_OK, "OK");
+
+    // the first event is a snapshot, so send it right away
+    push_event(sub, tr_time());
+}
+
+// ---
+
 bool is_address_allowed(tr_rpc_server const* server, char const* address)
 {
     if (!server->is_whitelist_enabled())
@@ -597,6 +964,8 @@ void handle_request(struct evhttp_request* req, void* arg)
     auto const& base_path = server->url();
     auto const web_base_path = tr_urlbuf{ base_path, TrHttpServerWebRelativePath };
     auto const rpc_base_path = tr_urlbuf{ base_path, TrHttpServerRpcRelativePath };
+    auto const events_path = tr_urlbuf{ base_path, TrHttpServerRpcEventsRelativePath };
+    auto const stats_path = tr_urlbuf{ base_path, TrHttpServerRpcStatsRelativePath };
     auto const deprecated_web_path = tr_urlbuf{ base_path, "web" /*no trailing slash*/ };
 
     auto const uri = std::string_view{ evhttp_request_get_uri(req) };
@@ -628,8 +997,9 @@ void handle_request(struct evhttp_request* req, void* arg)
         send_simple_response(req, 421, Body);
     }
     else if (
-        !uri.starts_with(rpc_base_path.sv()) ||
-        (uri.size() != rpc_base_path.size() && uri.substr(rpc_base_path.size()) != "/"sv))
+        uri != events_path.sv() && uri != stats_path.sv() &&
+        (!uri.starts_with(rpc_base_path.sv()) ||
+         (uri.size() != rpc_base_path.size() && uri.substr(rpc_base_path.size()) != "/"sv)))
     {
         tr_logAddWarn(
             fmt::format(
@@ -666,6 +1036,14 @@ void handle_request(struct evhttp_request* req, void* arg)
         send_simple_response(req, 409, body.c_str());
     }
 #endif
+    else if (uri == events_path.sv())
+    {
+        handle_events(req, server);
+    }
+    else if (uri == stats_path.sv())
+    {
+        handle_stats(req, server);
+    }
     else
     {
         handle_rpc(req, server);
@@ -794,8 +1172,28 @@ int tr_evhttp_bind_socket(struct evhttp* httpd, char const* address, ev_uint16_t
     return evhttp_bind_socket(httpd, address, port);
 }
 
+void start_local_server(tr_rpc_server* server)
+{
+    auto& local_server = *server->local_server_;
+    auto const& path = server->settings().local_socket_path;
+
+    // `rpc_local_socket` may have been changed or cleared while running
+    if (local_server.is_listening() && local_server.path() != path)
+    {
+        local_server.stop();
+    }
+
+    if (!std::empty(path) && !local_server.is_listening())
+    {
+        local_server.set_other_users_allowed(!server->is_password_enabled());
+        local_server.start(path, server->settings().socket_mode);
+    }
+}
+
 void start_server(tr_rpc_server* server)
 {
+    start_local_server(server);
+
     if (server->httpd)
     {
         return;
@@ -856,6 +1254,8 @@ void stop_server(tr_rpc_server* server)
 
     rpc_server_start_retry_cancel(server);
 
+    server->local_server_->stop();
+
     auto& httpd = server->httpd;
     if (!httpd)
     {
@@ -864,6 +1264,8 @@ void stop_server(tr_rpc_server* server)
 
     auto const address = server->get_bind_address();
 
+    close_subscribers(server);
+    stop_workers(server);
     httpd.reset();
 
     if (server->bind_address_->is_unix_addr())
@@ -906,6 +1308,164 @@ auto parse_whitelist(std::string_view whitelist)
 
 } // namespace
 
+// ---
+
+tr_rpc_workers::tr_rpc_workers(tr_rpc_server* const server, size_t const n_threads)
+    : server_{ server }
+{
+    threads_.reserve(n_threads);
+    for (size_t i = 0U; i < n_threads; ++i)
+    {
+        threads_.emplace_back(&tr_rpc_workers::thread_func, this);
+    }
+}
+
+tr_rpc_workers::~tr_rpc_workers()
+{
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+        is_stopping_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void tr_rpc_workers::add(
+    evhttp_request* const req,
+    std::string_view const body,
+    tr_rpc_encoding const request_encoding,
+    tr_rpc_encoding const response_encoding,
+    std::shared_ptr<tr_rpc_snapshot const> snapshot)
+{
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+        jobs_.push_back(Job{ req, std::string{ body }, request_encoding, response_encoding, std::move(snapshot) });
+    }
+    cv_.notify_one();
+}
+
+void tr_rpc_workers::thread_func()
+{
+    for (;;)
+    {
+        auto job = Job{};
+
+        {
+            auto lock = std::unique_lock{ mutex_ };
+            cv_.wait(lock, [this]() { return is_stopping_ || !std::empty(jobs_); });
+            if (is_stopping_)
+            {
+                return;
+            }
+
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        auto response = job.snapshot->exec_serialized(
+            job.body,
+            job.request_encoding,
+            job.response_encoding,
+            &server_->latency_);
+
+        server_->session->queue_session_thread(
+            [weak_self = weak_from_this(),
+             req = job.req,
+             body = std::move(job.body),
+             request_encoding = job.request_encoding,
+             response_encoding = job.response_encoding,
+             response = std::move(response)]()
+            {
+                // if the server was stopped, so was this request's connection
+                auto const self = weak_self.lock();
+                if (!self)
+                {
+                    return;
+                }
+
+                if (response)
+                {
+                    send_rpc_response(req, self->server_, *response, response_encoding);
+                }
+                else
+                {
+                    handle_rpc_in_session_thread(req, self->server_, body, request_encoding, response_encoding);
+                }
+            });
+    }
+}
+
+// ---
+
+bool tr_rpc_web_files::File::is_not_modified(bool const use_gzip, std::string_view const if_none_match) const
+{
+    return tr_webEtagMatches(if_none_match, etag_for(use_gzip));
+}
+
+tr_rpc_web_files::tr_rpc_web_files()
+    : compressor_{ libdeflate_alloc_compressor(CompressionLevel), libdeflate_free_compressor }
+{
+}
+
+std::shared_ptr<tr_rpc_web_files::File const> tr_rpc_web_files::get(std::string_view const filename, tr_error* error)
+{
+    auto const info = tr_sys_path_get_info(filename, 0, error);
+    if (!info)
+    {
+        return {};
+    }
+
+    if (auto const iter = files_.find(filename); iter != std::end(files_))
+    {
+        if (auto const& file = *iter->second; file.size == info->size && file.last_modified_at == info->last_modified_at)
+        {
+            return iter->second;
+        }
+
+        total_size_ -= std::size(iter->second->content) + std::size(iter->second->gzipped);
+        files_.erase(iter);
+    }
+
+    auto content = std::vector<char>{};
+    if (!tr_file_read(filename, content, error))
+    {
+        return {};
+    }
+
+    auto file = std::make_shared<File>();
+    file->content.assign(std::data(content), std::size(content));
+    file->etag = fmt::format(R"("{:x}-{:x}")", info->last_modified_at, info->size);
+    file->gzipped_etag = fmt::format(R"("{:x}-{:x}-gzip")", info->last_modified_at, info->size);
+    file->size = info->size;
+    file->last_modified_at = info->last_modified_at;
+
+    if (std::size(file->content) > MaxFileSize)
+    {
+        return file;
+    }
+
+    file->gzipped = gzip(compressor_.get(), file->content);
+
+    // the web client's files are much smaller than this,
+    // so just start over if some other files fill it up
+    auto const file_size = std::size(file->content) + std::size(file->gzipped);
+    if (total_size_ + file_size > MaxTotalSize)
+    {
+        files_.clear();
+        total_size_ = 0U;
+    }
+
+    files_.try_emplace(std::string{ filename }, file);
+    total_size_ += file_size;
+    return file;
+}
+
+// ---
+
 void tr_rpc_server::set_enabled(bool is_enabled)
 {
     settings_.is_enabled = is_enabled;
@@ -969,6 +1529,7 @@ void tr_rpc_server::set_password(std::string_view password) noexcept
 void tr_rpc_server::set_password_enabled(bool enabled)
 {
     settings_.authentication_required = enabled;
+    local_server_->set_other_users_allowed(!enabled);
     tr_logAddDebug(fmt::format("setting password-enabled to '{}'", enabled));
 }
 
@@ -991,8 +1552,11 @@ void tr_rpc_server::set_anti_brute_force_enabled(bool enabled) noexcept
 
 tr_rpc_server::tr_rpc_server(tr_session* session_in, Settings&& settings)
     : compressor{ libdeflate_alloc_compressor(DeflateLevel), libdeflate_free_compressor }
+    , large_response_compressor{ nullptr, libdeflate_free_compressor }
     , web_client_dir_{ tr_getWebClientDir(session_in) }
+    , web_files_{ std::make_unique<tr_rpc_web_files>() }
     , bind_address_{ std::make_unique<class tr_rpc_address>() }
+    , local_server_{ std::make_unique<tr_rpc_local_server>(session_in, &latency_) }
     , session{ session_in }
 {
     load(std::move(settings));
@@ -1008,6 +1572,9 @@ void tr_rpc_server::load(Settings&& settings)
     }
 
     host_whitelist_ = parse_whitelist(settings_.host_whitelist_str);
+
+    auto const level = std::min(settings_.large_response_compression_level, MaxDeflateLevel);
+    large_response_compressor.reset(level == 0U ? nullptr : libdeflate_alloc_compressor(static_cast<int>(level)));
     set_password_enabled(settings_.authentication_required);
     set_whitelist(settings_.whitelist_str);
     set_username(settings_.username);
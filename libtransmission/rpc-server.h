@@ -11,6 +11,10 @@
 
 #include <array>
 #include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <ctime> // time_t
+#include <functional> // std::less
+#include <map>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -19,11 +23,17 @@
 #include "libtransmission/constants.h" // TrDefaultHttpServerBasePath
 #include "libtransmission/net.h"
 #include "libtransmission/quark.h"
+#include "libtransmission/rpcimpl.h" // tr_rpc_latency
 #include "libtransmission/session-settings.h"
 #include "libtransmission/types.h"
 #include "libtransmission/utils-ev.h"
 
+struct tr_error;
 class tr_rpc_address;
+class tr_rpc_local_server;
+class tr_rpc_snapshot;
+struct tr_rpc_subscriber;
+class tr_rpc_workers;
 struct tr_session;
 struct tr_variant;
 struct libdeflate_compressor;
@@ -33,6 +43,58 @@ namespace tr
 class Timer;
 }
 
+// The web client's files, kept in memory along with their gzipped copies
+// so that each file is read and compressed once rather than on every GET.
+// A file is reloaded when its size or mtime changes.
+class tr_rpc_web_files
+{
+public:
+    struct File
+    {
+        std::string content;
+        std::string gzipped; // empty if gzip doesn't make it any smaller
+        std::string etag;
+        std::string gzipped_etag;
+        uint64_t size = {};
+        time_t last_modified_at = {};
+
+        [[nodiscard]] bool use_gzip(bool accepts_gzip) const noexcept
+        {
+            return accepts_gzip && !std::empty(gzipped);
+        }
+
+        // The two encodings are different bytes, so each gets its own strong ETag
+        [[nodiscard]] std::string const& etag_for(bool use_gzip) const noexcept
+        {
+            return use_gzip ? gzipped_etag : etag;
+        }
+
+        // True if an `If-None-Match` header says the client already has this encoding
+        [[nodiscard]] bool is_not_modified(bool use_gzip, std::string_view if_none_match) const;
+    };
+
+    tr_rpc_web_files();
+
+    // Files that are too big to cache are still returned, but not kept or gzipped.
+    [[nodiscard]] std::shared_ptr<File const> get(std::string_view filename, tr_error* error);
+
+    [[nodiscard]] auto size() const noexcept
+    {
+        return std::size(files_);
+    }
+
+private:
+    // each file is only compressed once, so it's worth spending more time on it
+    static auto constexpr CompressionLevel = int{ 12 };
+
+    static auto constexpr MaxFileSize = size_t{ 16U * 1024U * 1024U };
+    static auto constexpr MaxTotalSize = size_t{ 64U * 1024U * 1024U };
+
+    std::unique_ptr<libdeflate_compressor, void (*)(libdeflate_compressor*)> compressor_;
+    std::map<std::string, std::shared_ptr<File const>, std::less<>> files_;
+    size_t total_size_ = 0U;
+};
+
 class tr_rpc_server
 {
 public:
@@ -124,6 +186,9 @@ public:
 
     std::unique_ptr<libdeflate_compressor, void (*)(libdeflate_compressor*)> compressor;
 
+    // used instead of `compressor` for large responses; null if they're sent uncompressed
+    std::unique_ptr<libdeflate_compressor, void (*)(libdeflate_compressor*)> large_response_compressor;
+
     [[nodiscard]] constexpr auto const& url() const noexcept
     {
         return settings_.url;
@@ -143,11 +208,29 @@ public:
     std::vector<std::string> host_whitelist_;
     std::vector<std::string> whitelist_;
     std::string const web_client_dir_;
+    std::unique_ptr<tr_rpc_web_files> web_files_;
 
     std::unique_ptr<tr_rpc_address> bind_address_;
 
     std::unique_ptr<tr::Timer> start_retry_timer;
     tr::evhelpers::evhttp_unique_ptr httpd;
+
+    // framed requests from local scripts; see `rpc_local_socket`
+    std::unique_ptr<tr_rpc_local_server> local_server_;
+
+    // clients connected to the event stream
+    std::vector<std::unique_ptr<tr_rpc_subscriber>> subscribers_;
+    std::unique_ptr<tr::Timer> events_timer_;
+
+    tr_rpc_latency latency_;
+
+    // Read-only requests are answered from `snapshot_` by `workers_`.
+    // The snapshot is refreshed every second while requests keep coming.
+    std::shared_ptr<tr_rpc_workers> workers_;
+    std::shared_ptr<tr_rpc_snapshot const> snapshot_;
+    std::unique_ptr<tr::Timer> snapshot_timer_;
+    bool snapshot_wanted_ = false;
+
     tr_session* const session;
 
     size_t login_attempts_ = 0U;
@@ -5,7 +5,10 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
 #include <cerrno>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <filesystem>
@@ -13,10 +16,12 @@
 #include <iterator>
 #include <memory>
 #include <numeric>
+#include <optional>
 #include <ranges>
 #include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -34,6 +39,7 @@
 #include "libtransmission/file-utils.h"
 #include "libtransmission/file.h"
 #include "libtransmission/log.h"
+#include "libtransmission/metainfo-parser.h"
 #include "libtransmission/net.h"
 #include "libtransmission/peer-mgr.h"
 #include "libtransmission/api-compat.h"
@@ -44,6 +50,7 @@
 #include "libtransmission/torrent-ctor.h"
 #include "libtransmission/torrent.h"
 #include "libtransmission/tr-assert.h"
+#include "libtransmission/tr-dht.h"
 #include "libtransmission/tr-strbuf.h"
 #include "libtransmission/types.h"
 #include "libtransmission/utils.h"
@@ -190,12 +197,22 @@ auto constexpr RecentlyActiveSeconds = time_t{ 60 };
 auto constexpr RpcVersion = int64_t{ 18 }; // TODO: 18 == 6.0.0, bump after all 6.0.x releases and before releasing 6.1.0
 auto constexpr RpcVersionMin = int64_t{ 14 };
 
+// Bumped whenever an RPC method with side effects runs, and again
+// when an async one finishes, so that a tr_rpc_snapshot can tell
+// when it's out of date.
+auto write_epoch = std::atomic<uint64_t>{};
+
 enum class TrFormat : uint8_t
 {
     Object,
     Table
 };
 
+[[nodiscard]] tr_variant_serde make_rpc_serde(tr_rpc_encoding const encoding)
+{
+    return encoding == tr_rpc_encoding::Benc ? tr_variant_serde::benc() : tr_variant_serde::json();
+}
+
 // ---
 
 /* For functions that can't be immediately executed, like torrentAdd,
@@ -210,6 +227,10 @@ struct tr_rpc_idle_data
 
     // TODO: api-compat
     bool is_jsonrpc;
+
+    // if false, legacy responses keep the current key spellings.
+    // see tr::api_compat::convert_except_keys()
+    bool convert_legacy_keys = true;
 };
 
 void tr_rpc_idle_done(struct tr_rpc_idle_data* data, JsonRpc::Error::Code code, std::string_view errmsg)
@@ -224,10 +245,14 @@ void tr_rpc_idle_done(struct tr_rpc_idle_data* data, JsonRpc::Error::Code code,
             std::move(data->id),
             is_success ? std::move(data->args_out) : Error::build_data(errmsg, std::move(data->args_out)),
             data->is_jsonrpc) };
-        if (!data->is_jsonrpc)
+        if (!data->is_jsonrpc && data->convert_legacy_keys)
         {
             tr::api_compat::convert(response, tr::api_compat::Style::Tr4);
         }
+        else if (!data->is_jsonrpc)
+        {
+            tr::api_compat::convert_except_keys(response, tr::api_compat::Style::Tr4);
+        }
         data->callback(std::move(response));
     }
     else // notification
@@ -692,6 +717,33 @@ namespace make_torrent_field_helpers
     return tr_variant{ std::move(vec) };
 }
 
+[[nodiscard]] auto make_relocation_map(tr_torrent const& tor)
+{
+    auto const progress = tor.session->relocate_progress(tor.id());
+    if (!progress)
+    {
+        return tr_variant{ tr_variant::Map{} };
+    }
+
+    auto files_vec = tr_variant::Vector{};
+    files_vec.reserve(std::size(progress->files));
+    for (auto const& [file_index, bytes_copied] : progress->files)
+    {
+        auto file_map = tr_variant::Map{ 3U };
+        file_map.try_emplace(TR_KEY_index, file_index);
+        file_map.try_emplace(TR_KEY_bytes_completed, bytes_copied);
+        file_map.try_emplace(TR_KEY_length, tor.file_size(file_index));
+        files_vec.emplace_back(std::move(file_map));
+    }
+
+    auto map = tr_variant::Map{ 4U };
+    map.try_emplace(TR_KEY_location, progress->location);
+    map.try_emplace(TR_KEY_bytes_completed, progress->bytes_copied);
+    map.try_emplace(TR_KEY_length, progress->bytes_total);
+    map.try_emplace(TR_KEY_files, std::move(files_vec));
+    return tr_variant{ std::move(map) };
+}
+
 [[nodiscard]] auto make_piece_bitfield(tr_torrent const& tor)
 {
     if (tor.has_metainfo())
@@ -764,6 +816,7 @@ namespace make_torrent_field_helpers
     case TR_KEY_rate_download:
     case TR_KEY_rate_upload:
     case TR_KEY_recheck_progress:
+    case TR_KEY_relocation:
     case TR_KEY_seconds_downloading:
     case TR_KEY_seconds_seeding:
     case TR_KEY_seed_idle_limit:
@@ -796,11 +849,151 @@ namespace make_torrent_field_helpers
     }
 }
 
-[[nodiscard]] tr_variant make_torrent_field(tr_torrent const& tor, tr_stat const& st, tr_quark key)
+// the torrent_get fields that are built from a tr_stat alone
+[[nodiscard]] auto constexpr isStatField(tr_quark key)
+{
+    switch (key)
+    {
+    case TR_KEY_activity_date:
+    case TR_KEY_added_date:
+    case TR_KEY_corrupt_ever:
+    case TR_KEY_desired_available:
+    case TR_KEY_done_date:
+    case TR_KEY_downloaded_ever:
+    case TR_KEY_edit_date:
+    case TR_KEY_error:
+    case TR_KEY_error_string:
+    case TR_KEY_eta:
+    case TR_KEY_eta_idle:
+    case TR_KEY_have_unchecked:
+    case TR_KEY_have_valid:
+    case TR_KEY_id:
+    case TR_KEY_is_finished:
+    case TR_KEY_is_stalled:
+    case TR_KEY_left_until_done:
+    case TR_KEY_metadata_percent_complete:
+    case TR_KEY_peers_connected:
+    case TR_KEY_peers_from:
+    case TR_KEY_peers_getting_from_us:
+    case TR_KEY_peers_sending_to_us:
+    case TR_KEY_percent_complete:
+    case TR_KEY_percent_done:
+    case TR_KEY_queue_position:
+    case TR_KEY_rate_download:
+    case TR_KEY_rate_upload:
+    case TR_KEY_recheck_progress:
+    case TR_KEY_seconds_downloading:
+    case TR_KEY_seconds_seeding:
+    case TR_KEY_size_when_done:
+    case TR_KEY_start_date:
+    case TR_KEY_status:
+    case TR_KEY_upload_ratio:
+    case TR_KEY_uploaded_ever:
+    case TR_KEY_webseeds_sending_to_us:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// Which tr_torrent::FieldGroup each torrent_get field is in.
+// `id` is left out because it's always sent.
+[[nodiscard]] constexpr std::optional<tr_torrent::FieldGroup> get_field_group(tr_quark key)
+{
+    using Group = tr_torrent::FieldGroup;
+
+    switch (key)
+    {
+    case TR_KEY_id:
+        return {};
+
+    case TR_KEY_availability:
+    case TR_KEY_peers:
+    case TR_KEY_peers_connected:
+    case TR_KEY_peers_from:
+    case TR_KEY_peers_getting_from_us:
+    case TR_KEY_peers_sending_to_us:
+    case TR_KEY_webseeds_ex:
+    case TR_KEY_webseeds_sending_to_us:
+        return Group::Peers;
+
+    case TR_KEY_bytes_completed:
+    case TR_KEY_file_count:
+    case TR_KEY_file_stats:
+    case TR_KEY_files:
+    case TR_KEY_pieces:
+    case TR_KEY_priorities:
+    case TR_KEY_wanted:
+        return Group::Files;
+
+    case TR_KEY_manual_announce_time:
+    case TR_KEY_tracker_list:
+    case TR_KEY_tracker_stats:
+    case TR_KEY_trackers:
+        return Group::Trackers;
+
+    case TR_KEY_bandwidth_priority:
+    case TR_KEY_comment:
+    case TR_KEY_creator:
+    case TR_KEY_date_created:
+    case TR_KEY_download_dir:
+    case TR_KEY_download_limit:
+    case TR_KEY_download_limited:
+    case TR_KEY_group:
+    case TR_KEY_hash_string:
+    case TR_KEY_honors_session_limits:
+    case TR_KEY_is_private:
+    case TR_KEY_labels:
+    case TR_KEY_magnet_link:
+    case TR_KEY_max_connected_peers:
+    case TR_KEY_name:
+    case TR_KEY_peer_limit:
+    case TR_KEY_piece_count:
+    case TR_KEY_piece_size:
+    case TR_KEY_primary_mime_type:
+    case TR_KEY_seed_idle_limit:
+    case TR_KEY_seed_idle_mode:
+    case TR_KEY_seed_ratio_limit:
+    case TR_KEY_seed_ratio_mode:
+    case TR_KEY_sequential_download:
+    case TR_KEY_sequential_download_from_piece:
+    case TR_KEY_source:
+    case TR_KEY_torrent_file:
+    case TR_KEY_total_size:
+    case TR_KEY_upload_limit:
+    case TR_KEY_upload_limited:
+    case TR_KEY_webseeds:
+        return Group::Metadata;
+
+    default:
+        return Group::Stats;
+    }
+}
+
+// Fields that tick along with the clock while a torrent is running.
+// Counting them as changes would make every running torrent change on
+// every poll, so they're only sent along with the rest of their group.
+[[nodiscard]] constexpr bool is_clock_driven(tr_quark const key)
+{
+    switch (key)
+    {
+    case TR_KEY_eta:
+    case TR_KEY_eta_idle:
+    case TR_KEY_seconds_downloading:
+    case TR_KEY_seconds_seeding:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+[[nodiscard]] tr_variant make_stat_field(tr_stat const& st, tr_quark key)
 {
     using namespace make_torrent_field_helpers;
 
-    TR_ASSERT(isSupportedTorrentGetField(key));
+    TR_ASSERT(isStatField(key));
 
     switch (key)
     {
@@ -808,30 +1001,12 @@ namespace make_torrent_field_helpers
         return st.activity_date;
     case TR_KEY_added_date:
         return st.added_date;
-    case TR_KEY_availability:
-        return make_piece_availability_vec(tor);
-    case TR_KEY_bandwidth_priority:
-        return tor.get_priority();
-    case TR_KEY_bytes_completed:
-        return make_bytes_completed_vec(tor);
-    case TR_KEY_comment:
-        return tor.comment();
     case TR_KEY_corrupt_ever:
         return st.corrupt_ever;
-    case TR_KEY_creator:
-        return tor.creator();
-    case TR_KEY_date_created:
-        return tor.date_created();
     case TR_KEY_desired_available:
         return st.desired_available;
     case TR_KEY_done_date:
         return st.done_date;
-    case TR_KEY_download_dir:
-        return tr_variant::unmanaged_string(tor.download_dir().sv());
-    case TR_KEY_download_limit:
-        return tr_torrentGetSpeedLimit_KBps(&tor, tr_direction::Down);
-    case TR_KEY_download_limited:
-        return tor.uses_speed_limit(tr_direction::Down);
     case TR_KEY_downloaded_ever:
         return st.downloaded_ever;
     case TR_KEY_edit_date:
@@ -844,48 +1019,20 @@ namespace make_torrent_field_helpers
         return st.eta;
     case TR_KEY_eta_idle:
         return st.eta_idle;
-    case TR_KEY_file_count:
-        return tor.file_count();
-    case TR_KEY_file_stats:
-        return make_file_stats_vec(tor);
-    case TR_KEY_files:
-        return make_file_vec(tor);
-    case TR_KEY_group:
-        return tr_variant::unmanaged_string(tor.bandwidth_group().sv());
-    case TR_KEY_hash_string:
-        return tr_variant::unmanaged_string(tor.info_hash_string().sv());
     case TR_KEY_have_unchecked:
         return st.have_unchecked;
     case TR_KEY_have_valid:
         return st.have_valid;
-    case TR_KEY_honors_session_limits:
-        return tor.uses_session_limits();
     case TR_KEY_id:
         return st.id;
     case TR_KEY_is_finished:
         return st.finished;
-    case TR_KEY_is_private:
-        return tor.is_private();
     case TR_KEY_is_stalled:
         return st.is_stalled;
-    case TR_KEY_labels:
-        return make_labels_vec(tor);
     case TR_KEY_left_until_done:
         return st.left_until_done;
-    case TR_KEY_magnet_link:
-        return tor.magnet();
-    case TR_KEY_manual_announce_time:
-        return tr_announcerNextManualAnnounce(&tor);
-    case TR_KEY_max_connected_peers:
-        return tor.peer_limit();
     case TR_KEY_metadata_percent_complete:
         return st.metadata_percent_complete;
-    case TR_KEY_name:
-        return tor.name();
-    case TR_KEY_peer_limit:
-        return tor.peer_limit();
-    case TR_KEY_peers:
-        return make_peer_vec(tor);
     case TR_KEY_peers_connected:
         return st.peers_connected;
     case TR_KEY_peers_from:
@@ -898,16 +1045,6 @@ namespace make_torrent_field_helpers
         return st.percent_complete;
     case TR_KEY_percent_done:
         return st.percent_done;
-    case TR_KEY_piece_count:
-        return tor.piece_count();
-    case TR_KEY_piece_size:
-        return tor.piece_size();
-    case TR_KEY_pieces:
-        return make_piece_bitfield(tor);
-    case TR_KEY_primary_mime_type:
-        return tr_variant::unmanaged_string(tor.primary_mime_type());
-    case TR_KEY_priorities:
-        return make_file_priorities_vec(tor);
     case TR_KEY_queue_position:
         return st.queue_position;
     case TR_KEY_rate_download:
@@ -920,6 +1057,89 @@ namespace make_torrent_field_helpers
         return st.seconds_downloading;
     case TR_KEY_seconds_seeding:
         return st.seconds_seeding;
+    case TR_KEY_size_when_done:
+        return st.size_when_done;
+    case TR_KEY_start_date:
+        return st.start_date;
+    case TR_KEY_status:
+        return st.activity;
+    case TR_KEY_upload_ratio:
+        return st.upload_ratio;
+    case TR_KEY_uploaded_ever:
+        return st.uploaded_ever;
+    case TR_KEY_webseeds_sending_to_us:
+        return st.webseeds_sending_to_us;
+    default:
+        return tr_variant{};
+    }
+}
+
+[[nodiscard]] tr_variant make_torrent_field(tr_torrent const& tor, tr_stat const& st, tr_quark key)
+{
+    using namespace make_torrent_field_helpers;
+
+    TR_ASSERT(isSupportedTorrentGetField(key));
+
+    switch (key)
+    {
+    case TR_KEY_availability:
+        return make_piece_availability_vec(tor);
+    case TR_KEY_bandwidth_priority:
+        return tor.get_priority();
+    case TR_KEY_bytes_completed:
+        return make_bytes_completed_vec(tor);
+    case TR_KEY_comment:
+        return tor.comment();
+    case TR_KEY_creator:
+        return tor.creator();
+    case TR_KEY_date_created:
+        return tor.date_created();
+    case TR_KEY_download_dir:
+        return tr_variant::unmanaged_string(tor.download_dir().sv());
+    case TR_KEY_download_limit:
+        return tr_torrentGetSpeedLimit_KBps(&tor, tr_direction::Down);
+    case TR_KEY_download_limited:
+        return tor.uses_speed_limit(tr_direction::Down);
+    case TR_KEY_file_count:
+        return tor.file_count();
+    case TR_KEY_file_stats:
+        return make_file_stats_vec(tor);
+    case TR_KEY_files:
+        return make_file_vec(tor);
+    case TR_KEY_group:
+        return tr_variant::unmanaged_string(tor.bandwidth_group().sv());
+    case TR_KEY_hash_string:
+        return tr_variant::unmanaged_string(tor.info_hash_string().sv());
+    case TR_KEY_honors_session_limits:
+        return tor.uses_session_limits();
+    case TR_KEY_is_private:
+        return tor.is_private();
+    case TR_KEY_labels:
+        return make_labels_vec(tor);
+    case TR_KEY_magnet_link:
+        return tor.magnet();
+    case TR_KEY_manual_announce_time:
+        return tr_announcerNextManualAnnounce(&tor);
+    case TR_KEY_max_connected_peers:
+        return tor.peer_limit();
+    case TR_KEY_name:
+        return tor.name();
+    case TR_KEY_peer_limit:
+        return tor.peer_limit();
+    case TR_KEY_peers:
+        return make_peer_vec(tor);
+    case TR_KEY_piece_count:
+        return tor.piece_count();
+    case TR_KEY_piece_size:
+        return tor.piece_size();
+    case TR_KEY_pieces:
+        return make_piece_bitfield(tor);
+    case TR_KEY_primary_mime_type:
+        return tr_variant::unmanaged_string(tor.primary_mime_type());
+    case TR_KEY_priorities:
+        return make_file_priorities_vec(tor);
+    case TR_KEY_relocation:
+        return make_relocation_map(tor);
     case TR_KEY_seed_idle_limit:
         return tor.idle_limit_minutes();
     case TR_KEY_seed_idle_mode:
@@ -932,14 +1152,8 @@ namespace make_torrent_field_helpers
         return tor.is_sequential_download();
     case TR_KEY_sequential_download_from_piece:
         return tor.sequential_download_from_piece();
-    case TR_KEY_size_when_done:
-        return st.size_when_done;
     case TR_KEY_source:
         return tor.source();
-    case TR_KEY_start_date:
-        return st.start_date;
-    case TR_KEY_status:
-        return st.activity;
     case TR_KEY_torrent_file:
         return tor.torrent_file();
     case TR_KEY_total_size:
@@ -954,23 +1168,25 @@ namespace make_torrent_field_helpers
         return tr_torrentGetSpeedLimit_KBps(&tor, tr_direction::Up);
     case TR_KEY_upload_limited:
         return tor.uses_speed_limit(tr_direction::Up);
-    case TR_KEY_upload_ratio:
-        return st.upload_ratio;
-    case TR_KEY_uploaded_ever:
-        return st.uploaded_ever;
     case TR_KEY_wanted:
         return make_file_wanted_vec(tor);
     case TR_KEY_webseeds:
         return make_webseed_vec(tor);
     case TR_KEY_webseeds_ex:
         return make_webseed_ex_vec(tor);
-    case TR_KEY_webseeds_sending_to_us:
-        return st.webseeds_sending_to_us;
     default:
-        return tr_variant{};
+        return make_stat_field(st, key);
     }
 }
 
+// A hash of a field's value, so that whether it changed can be told
+// without keeping a copy of the value. `changed_since` and the event
+// stream both use this, so they always agree on what counts as a change.
+[[nodiscard]] size_t make_field_fingerprint(tr_variant const& value)
+{
+    return std::hash<std::string>{}(tr_variant_serde::benc().to_string(value));
+}
+
 [[nodiscard]] auto make_torrent_info_map(tr_torrent* const tor, tr_quark const* const fields, size_t const field_count)
 {
     auto const st = tr_torrentStat(tor);
@@ -1004,33 +1220,59 @@ namespace make_torrent_field_helpers
                                        make_torrent_info_map(tor, fields, field_count);
 }
 
-[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> torrentGet(
-    tr_session* session,
-    tr_variant::Map const& args_in,
-    tr_variant::Map& args_out)
+// Like make_torrent_info(), but only has the fields whose groups changed
+// after `since`. Returns an empty variant if none of them did.
+// A group changed if any of its requested fields did, not counting the
+// clock-driven ones. Each field's value is tracked on its own, so that
+// clients asking for different fields agree on when a field changed.
+// Tables have no way to leave a field out, so they get every field or none.
+[[nodiscard]] tr_variant make_torrent_delta(
+    tr_torrent* const tor,
+    TrFormat const format,
+    std::vector<tr_quark> const& fields,
+    uint64_t const since)
 {
-    using namespace JsonRpc;
+    auto const st = tr_torrentStat(tor);
+    auto values = tr_variant::Vector{};
+    values.reserve(std::size(fields));
+    auto changed = std::array<bool, tr_torrent::NFieldGroups>{};
+    for (auto const key : fields)
+    {
+        auto const& value = values.emplace_back(make_torrent_field(*tor, st, key));
 
-    auto const torrents = getTorrents(session, args_in);
-    auto torrents_vec = tr_variant::Vector{};
+        if (auto const group = get_field_group(key); group && !is_clock_driven(key))
+        {
+            if (tor->observe_field(key, make_field_fingerprint(value)) > since)
+            {
+                changed[static_cast<size_t>(*group)] = true;
+            }
+        }
+    }
 
-    auto const format = args_in.value_if<std::string_view>(TR_KEY_format).value_or("object"sv) == "table"sv ? TrFormat::Table :
-                                                                                                              TrFormat::Object;
+    if (!std::ranges::any_of(changed, [](bool val) { return val; }))
+    {
+        return {};
+    }
 
-    if (auto val = args_in.value_if<std::string_view>(TR_KEY_ids); val == tr_quark_get_string_view(TR_KEY_recently_active))
+    if (format == TrFormat::Table)
     {
-        auto const cutoff = tr_time() - RecentlyActiveSeconds;
-        auto const ids = session->torrents().removedSince(cutoff);
+        return tr_variant{ std::move(values) };
+    }
 
-        auto removed_vec = tr_variant::Vector{};
-        removed_vec.reserve(std::size(ids));
-        for (auto const& id : ids)
+    auto info_map = tr_variant::Map{ std::size(fields) + 1U };
+    info_map.try_emplace(TR_KEY_id, tor->id());
+    for (size_t idx = 0U, n = std::size(fields); idx < n; ++idx)
+    {
+        if (auto const group = get_field_group(fields[idx]); !group || changed[static_cast<size_t>(*group)])
         {
-            removed_vec.emplace_back(id);
+            info_map.try_emplace(fields[idx], std::move(values[idx]));
         }
-        args_out.try_emplace(TR_KEY_removed, std::move(removed_vec));
     }
+    return tr_variant{ std::move(info_map) };
+}
 
+[[nodiscard]] auto get_torrent_get_fields(tr_variant::Map const& args_in)
+{
     auto keys = std::vector<tr_quark>{};
     if (auto const* const fields_vec = args_in.find_if<tr_variant::Vector>(TR_KEY_fields); fields_vec != nullptr)
     {
@@ -1047,7 +1289,55 @@ namespace make_torrent_field_helpers
             }
         }
     }
+    return keys;
+}
+
+[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> torrentGet(
+    tr_session* session,
+    tr_variant::Map const& args_in,
+    tr_variant::Map& args_out)
+{
+    using namespace JsonRpc;
+
+    auto const torrents = getTorrents(session, args_in);
+    auto torrents_vec = tr_variant::Vector{};
+
+    auto const format = args_in.value_if<std::string_view>(TR_KEY_format).value_or("object"sv) == "table"sv ? TrFormat::Table :
+                                                                                                              TrFormat::Object;
+
+    auto changed_since = std::optional<uint64_t>{};
+    if (auto const epoch = args_in.value_if<int64_t>(TR_KEY_changed_since))
+    {
+        // an epoch from the future must be from before a restart, so send everything
+        auto const is_known = *epoch >= 0 && static_cast<uint64_t>(*epoch) <= session->torrents().change_epoch();
+        changed_since = is_known ? static_cast<uint64_t>(*epoch) : uint64_t{};
+    }
+
+    if (changed_since)
+    {
+        auto removed_vec = tr_variant::Vector{};
+        for (auto const& id : session->torrents().removed_since_epoch(*changed_since))
+        {
+            removed_vec.emplace_back(id);
+        }
+        args_out.try_emplace(TR_KEY_removed, std::move(removed_vec));
+    }
+    else if (auto val = args_in.value_if<std::string_view>(TR_KEY_ids);
+             val == tr_quark_get_string_view(TR_KEY_recently_active))
+    {
+        auto const cutoff = tr_time() - RecentlyActiveSeconds;
+        auto const ids = session->torrents().removedSince(cutoff);
+
+        auto removed_vec = tr_variant::Vector{};
+        removed_vec.reserve(std::size(ids));
+        for (auto const& id : ids)
+        {
+            removed_vec.emplace_back(id);
+        }
+        args_out.try_emplace(TR_KEY_removed, std::move(removed_vec));
+    }
 
+    auto const keys = get_torrent_get_fields(args_in);
     if (std::empty(keys))
     {
         return { Error::INVALID_PARAMS, "no fields specified"s };
@@ -1064,10 +1354,23 @@ namespace make_torrent_field_helpers
 
     for (auto* const tor : torrents)
     {
-        torrents_vec.emplace_back(make_torrent_info(tor, format, std::data(keys), std::size(keys)));
+        if (!changed_since)
+        {
+            torrents_vec.emplace_back(make_torrent_info(tor, format, std::data(keys), std::size(keys)));
+        }
+        else if (auto delta = make_torrent_delta(tor, format, keys, *changed_since); delta.has_value())
+        {
+            torrents_vec.emplace_back(std::move(delta));
+        }
     }
 
     args_out.try_emplace(TR_KEY_torrents, std::move(torrents_vec));
+
+    if (changed_since)
+    {
+        args_out.try_emplace(TR_KEY_change_epoch, session->torrents().change_epoch());
+    }
+
     return { Error::SUCCESS, std::string{} }; // no error message
 }
 
@@ -1428,6 +1731,16 @@ namespace make_torrent_field_helpers
 {
     using namespace JsonRpc;
 
+    if (args_in.value_if<bool>(TR_KEY_cancel).value_or(false))
+    {
+        for (auto* tor : getTorrents(session, args_in))
+        {
+            tor->cancel_relocation();
+        }
+
+        return { Error::SUCCESS, std::string{} };
+    }
+
     auto const location = args_in.value_if<std::string_view>(TR_KEY_location);
     if (!location)
     {
@@ -1492,7 +1805,7 @@ void onPortTested(tr_web::FetchResponse const& web_response)
 {
     using namespace JsonRpc;
 
-    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data] = web_response;
+    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data, multiplexed] = web_response;
     auto* data = static_cast<tr_rpc_idle_data*>(user_data);
 
     if (auto const addr = tr_address::from_string(primary_ip);
@@ -1566,7 +1879,7 @@ void onBlocklistFetched(tr_web::FetchResponse const& web_response)
 {
     using namespace JsonRpc;
 
-    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data] = web_response;
+    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data, multiplexed] = web_response;
     auto* data = static_cast<struct tr_rpc_idle_data*>(user_data);
     auto* const session = data->session;
 
@@ -1663,7 +1976,7 @@ void blocklistUpdate(tr_session* session, tr_variant::Map const& /*args_in*/, st
 
 // ---
 
-void add_torrent_impl(struct tr_rpc_idle_data* data, tr_ctor& ctor)
+[[nodiscard]] JsonRpc::Error::Code add_torrent(tr_session* session, tr_ctor& ctor, tr_variant::Map& args_out)
 {
     using namespace JsonRpc;
 
@@ -1672,8 +1985,7 @@ void add_torrent_impl(struct tr_rpc_idle_data* data, tr_ctor& ctor)
 
     if (tor == nullptr && duplicate_of == nullptr)
     {
-        tr_rpc_idle_done(data, Error::CORRUPT_TORRENT, {});
-        return;
+        return Error::CORRUPT_TORRENT;
     }
 
     static auto constexpr Fields = std::array<tr_quark, 3U>{
@@ -1683,18 +1995,20 @@ void add_torrent_impl(struct tr_rpc_idle_data* data, tr_ctor& ctor)
     };
     if (duplicate_of != nullptr)
     {
-        data->args_out.try_emplace(
+        args_out.try_emplace(
             TR_KEY_torrent_duplicate,
             make_torrent_info(duplicate_of, TrFormat::Object, std::data(Fields), std::size(Fields)));
-        tr_rpc_idle_done(data, Error::SUCCESS, {});
-        return;
+        return Error::SUCCESS;
     }
 
-    data->session->rpcNotify(TR_RPC_TORRENT_ADDED, tor->id());
-    data->args_out.try_emplace(
-        TR_KEY_torrent_added,
-        make_torrent_info(tor, TrFormat::Object, std::data(Fields), std::size(Fields)));
-    tr_rpc_idle_done(data, Error::SUCCESS, {});
+    session->rpcNotify(TR_RPC_TORRENT_ADDED, tor->id());
+    args_out.try_emplace(TR_KEY_torrent_added, make_torrent_info(tor, TrFormat::Object, std::data(Fields), std::size(Fields)));
+    return Error::SUCCESS;
+}
+
+void add_torrent_impl(struct tr_rpc_idle_data* data, tr_ctor& ctor)
+{
+    tr_rpc_idle_done(data, add_torrent(data->session, ctor, data->args_out), {});
 }
 
 struct add_torrent_idle_data
@@ -1711,7 +2025,7 @@ struct add_torrent_idle_data
 
 void onMetadataFetched(tr_web::FetchResponse const& web_response)
 {
-    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data] = web_response;
+    auto const& [status, body, primary_ip, did_connect, did_timeout, user_data, multiplexed] = web_response;
     auto* data = static_cast<struct add_torrent_idle_data*>(user_data);
 
     tr_logAddTrace(
@@ -1762,33 +2076,17 @@ bool isCurlURL(std::string_view url)
     return files;
 }
 
-void torrentAdd(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle_data* idle_data)
+// sets torrent_add's optional arguments in `ctor`
+[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> set_add_options(tr_variant::Map const& args_in, tr_ctor& ctor)
 {
     using namespace JsonRpc;
 
-    TR_ASSERT(idle_data != nullptr);
-
-    auto const filename = args_in.value_if<std::string_view>(TR_KEY_filename).value_or(""sv);
-    auto const metainfo_base64 = args_in.value_if<std::string_view>(TR_KEY_metainfo).value_or(""sv);
-    if (std::empty(filename) && std::empty(metainfo_base64))
-    {
-        tr_rpc_idle_done(idle_data, Error::INVALID_PARAMS, "no filename or metainfo specified"sv);
-        return;
-    }
-
     auto const download_dir = args_in.value_if<std::string_view>(TR_KEY_download_dir);
     if (download_dir && tr_sys_path_is_relative(*download_dir))
     {
-        tr_rpc_idle_done(idle_data, Error::PATH_NOT_ABSOLUTE, "download directory path is not absolute"sv);
-        return;
+        return { Error::PATH_NOT_ABSOLUTE, "download directory path is not absolute"s };
     }
 
-    auto ctor = tr_ctor{ session };
-
-    // set the optional parameters
-
-    auto const cookies = args_in.value_if<std::string_view>(TR_KEY_cookies).value_or(""sv);
-
     if (download_dir && !std::empty(*download_dir))
     {
         ctor.set_download_dir(TR_FORCE, *download_dir);
@@ -1845,8 +2143,7 @@ void torrentAdd(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle
 
         if (err != Error::SUCCESS)
         {
-            tr_rpc_idle_done(idle_data, err, errmsg);
-            return;
+            return { err, std::move(errmsg) };
         }
 
         ctor.set_labels(std::move(labels));
@@ -1862,6 +2159,32 @@ void torrentAdd(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle
         ctor.set_sequential_download_from_piece(TR_FORCE, *val);
     }
 
+    return { Error::SUCCESS, {} };
+}
+
+void torrentAdd(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle_data* idle_data)
+{
+    using namespace JsonRpc;
+
+    TR_ASSERT(idle_data != nullptr);
+
+    auto const filename = args_in.value_if<std::string_view>(TR_KEY_filename).value_or(""sv);
+    auto const metainfo_base64 = args_in.value_if<std::string_view>(TR_KEY_metainfo).value_or(""sv);
+    if (std::empty(filename) && std::empty(metainfo_base64))
+    {
+        tr_rpc_idle_done(idle_data, Error::INVALID_PARAMS, "no filename or metainfo specified"sv);
+        return;
+    }
+
+    auto ctor = tr_ctor{ session };
+    if (auto const [err, errmsg] = set_add_options(args_in, ctor); err != Error::SUCCESS)
+    {
+        tr_rpc_idle_done(idle_data, err, errmsg);
+        return;
+    }
+
+    auto const cookies = args_in.value_if<std::string_view>(TR_KEY_cookies).value_or(""sv);
+
     tr_logAddTrace(fmt::format("torrentAdd: filename is '{}'", filename));
 
     if (isCurlURL(filename))
@@ -1901,6 +2224,111 @@ void torrentAdd(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle
     add_torrent_impl(idle_data, ctor);
 }
 
+// Adds many torrents in one request. Their metainfo is parsed on worker
+// threads, and then they're all added in one pass of the session thread.
+void torrentAddBatch(tr_session* session, tr_variant::Map const& args_in, tr_rpc_idle_data* idle_data)
+{
+    using namespace JsonRpc;
+
+    TR_ASSERT(idle_data != nullptr);
+
+    auto const* const torrents = args_in.find_if<tr_variant::Vector>(TR_KEY_torrents);
+    if (torrents == nullptr)
+    {
+        tr_rpc_idle_done(idle_data, Error::INVALID_PARAMS, "no torrents specified"sv);
+        return;
+    }
+
+    auto* const parser = session->metainfo_parser();
+    if (parser == nullptr)
+    {
+        tr_rpc_idle_done(idle_data, Error::SYSTEM_ERROR, "session is closing"sv);
+        return;
+    }
+
+    auto const make_error = [](Error::Code const code, std::string_view const errmsg)
+    {
+        auto ret = tr_variant::Map{ 1U };
+        ret.try_emplace(TR_KEY_error, Error::build(code, Error::build_data(errmsg, {})));
+        return ret;
+    };
+
+    // One result per torrent, in the request's order.
+    // It's shared because std::function can't hold move-only captures.
+    auto results = std::make_shared<std::vector<tr_variant::Map>>(std::size(*torrents));
+    auto items = std::vector<tr_metainfo_parser::Item>{};
+    auto item_results = std::vector<size_t>{};
+    items.reserve(std::size(*torrents));
+    item_results.reserve(std::size(*torrents));
+
+    for (size_t idx = 0U, n = std::size(*torrents); idx < n; ++idx)
+    {
+        auto const* const torrent_args = (*torrents)[idx].get_if<tr_variant::Map>();
+        if (torrent_args == nullptr)
+        {
+            (*results)[idx] = make_error(Error::INVALID_PARAMS, "torrent must be an Object"sv);
+            continue;
+        }
+
+        auto const filename = torrent_args->value_if<std::string_view>(TR_KEY_filename).value_or(""sv);
+        auto const metainfo_base64 = torrent_args->value_if<std::string_view>(TR_KEY_metainfo).value_or(""sv);
+        if (std::empty(filename) && std::empty(metainfo_base64))
+        {
+            (*results)[idx] = make_error(Error::INVALID_PARAMS, "no filename or metainfo specified"sv);
+            continue;
+        }
+
+        if (isCurlURL(filename))
+        {
+            (*results)[idx] = make_error(Error::INVALID_PARAMS, "URLs can only be added with torrent_add"sv);
+            continue;
+        }
+
+        auto ctor = std::make_unique<tr_ctor>(session);
+        if (auto const [err, errmsg] = set_add_options(*torrent_args, *ctor); err != Error::SUCCESS)
+        {
+            (*results)[idx] = make_error(err, errmsg);
+            continue;
+        }
+
+        using Source = tr_metainfo_parser::Source;
+        auto const source = std::empty(filename) ? Source::Metainfo : Source::Filename;
+        items.emplace_back(std::move(ctor), source, std::string{ source == Source::Metainfo ? metainfo_base64 : filename });
+        item_results.emplace_back(idx);
+    }
+
+    parser->parse(
+        std::move(items),
+        [session, idle_data, make_error, results, item_results = std::move(item_results)](
+            std::vector<tr_metainfo_parser::Item>&& parsed)
+        {
+            for (size_t idx = 0U, n = std::size(parsed); idx < n; ++idx)
+            {
+                auto& item = parsed[idx];
+                auto& result = (*results)[item_results[idx]];
+
+                if (!item.ok)
+                {
+                    result = make_error(Error::UNRECOGNIZED_INFO, item.error.message());
+                }
+                else if (auto const err = add_torrent(session, *item.ctor, result); err != Error::SUCCESS)
+                {
+                    result = make_error(err, {});
+                }
+            }
+
+            auto vec = tr_variant::Vector{};
+            vec.reserve(std::size(*results));
+            for (auto& result : *results)
+            {
+                vec.emplace_back(std::move(result));
+            }
+
+            idle_data->args_out.try_emplace(TR_KEY_torrents, std::move(vec));
+            tr_rpc_idle_done(idle_data, Error::SUCCESS, {});
+        });
+}
+
 // ---
 
 void add_strings_from_var(std::set<std::string_view>& strings, tr_variant const& var)
@@ -2024,7 +2452,7 @@ void add_strings_from_var(std::set<std::string_view>& strings, tr_variant const&
         std::end(torrents),
         [](auto const* tor) { return tor->is_running(); });
 
-    args_out.reserve(std::size(args_out) + 7U);
+    args_out.reserve(std::size(args_out) + 12U);
     args_out.try_emplace(TR_KEY_active_torrent_count, n_running);
     args_out.try_emplace(TR_KEY_cumulative_stats, make_stats_map(session->stats().cumulative()));
     args_out.try_emplace(TR_KEY_current_stats, make_stats_map(session->stats().current()));
@@ -2033,6 +2461,37 @@ void add_strings_from_var(std::set<std::string_view>& strings, tr_variant const&
     args_out.try_emplace(TR_KEY_torrent_count, total);
     args_out.try_emplace(TR_KEY_upload_speed, session->piece_speed(tr_direction::Up).base_quantity());
 
+    if (auto const* const announcer = session->announcer(); announcer != nullptr)
+    {
+        args_out.try_emplace(TR_KEY_announcer_lateness, announcer->lateness());
+        args_out.try_emplace(TR_KEY_announcer_queue_depth, announcer->queue_depth());
+    }
+
+    if (auto const* const dht = session->dht(); dht != nullptr)
+    {
+        args_out.try_emplace(TR_KEY_dht_announce_queue_depth, dht->announce_queue_depth());
+        args_out.try_emplace(TR_KEY_dht_searches_per_second, dht->searches_per_second());
+    }
+
+    if (auto const* const web = session->web(); web != nullptr)
+    {
+        auto const host_stats = web->host_stats();
+        auto hosts = tr_variant::Vector{};
+        hosts.reserve(std::size(host_stats));
+        for (auto const& [host, stats] : host_stats)
+        {
+            auto host_map = tr_variant::Map{ 6U };
+            host_map.try_emplace(TR_KEY_downloaded_bytes, stats.bytes_downloaded);
+            host_map.try_emplace(TR_KEY_host, host);
+            host_map.try_emplace(TR_KEY_multiplexed_count, stats.n_multiplexed);
+            host_map.try_emplace(TR_KEY_new_connection_count, stats.n_new_connections);
+            host_map.try_emplace(TR_KEY_request_count, stats.n_requests);
+            host_map.try_emplace(TR_KEY_transfer_time, std::chrono::duration<double>(stats.total_time).count());
+            hosts.emplace_back(std::move(host_map));
+        }
+        args_out.try_emplace(TR_KEY_web_host_stats, std::move(hosts));
+    }
+
     return { JsonRpc::Error::SUCCESS, std::string{} };
 }
 
@@ -2264,8 +2723,9 @@ using SessionAccessors = std::pair<SessionGetter, SessionSetter>;
         TR_KEY_download_dir_free_space,
         [](tr_session const& src) -> tr_variant
         {
-            // TODO(C++23): use std::optional::transform() instead
-            if (auto const space = tr_sys_path_get_capacity(src.downloadDir()))
+            // don't block on a slow disk: answer from the cache, or -1 until it's been checked
+            auto* const cache = src.capacity_cache();
+            if (auto const space = cache != nullptr ? cache->get(src.downloadDir()) : std::nullopt)
             {
                 return space->available;
             }
@@ -2755,38 +3215,48 @@ using SessionAccessors = std::pair<SessionGetter, SessionSetter>;
     return error_none;
 }
 
-[[nodiscard]] std::pair<JsonRpc::Error::Code, std::string> freeSpace(
-    tr_session* /*session*/,
-    tr_variant::Map const& args_in,
-    tr_variant::Map& args_out)
+void freeSpace(tr_session* session, tr_variant::Map const& args_in, struct tr_rpc_idle_data* idle_data)
 {
     using namespace JsonRpc;
 
     auto const path = args_in.value_if<std::string_view>(TR_KEY_path);
     if (!path)
     {
-        return { Error::INVALID_PARAMS, "directory path argument is missing"s };
+        tr_rpc_idle_done(idle_data, Error::INVALID_PARAMS, "directory path argument is missing"sv);
+        return;
     }
 
     if (tr_sys_path_is_relative(*path))
     {
-        return { Error::PATH_NOT_ABSOLUTE, "directory path is not absolute"s };
+        tr_rpc_idle_done(idle_data, Error::PATH_NOT_ABSOLUTE, "directory path is not absolute"sv);
+        return;
     }
 
-    // get the free space
-    auto error = tr_error{};
-    auto const capacity = tr_sys_path_get_capacity(*path, &error);
-
-    // response
-    args_out.try_emplace(TR_KEY_path, *path);
-    args_out.try_emplace(TR_KEY_size_bytes, capacity ? capacity->available : tr_variant{ -1 });
-    args_out.try_emplace(TR_KEY_total_size, capacity ? capacity->capacity : tr_variant{ -1 });
-
-    if (error)
+    auto* const cache = session->capacity_cache();
+    if (cache == nullptr)
     {
-        return { Error::SYSTEM_ERROR, std::string{ error.message() } };
+        tr_rpc_idle_done(idle_data, Error::SYSTEM_ERROR, "session is closing"sv);
+        return;
     }
-    return { Error::SUCCESS, std::string{} };
+
+    // get the free space.
+    // this may answer right away from the cache, or later when a worker has checked the disk.
+    cache->get(
+        *path,
+        [idle_data, path = std::string{ *path }](std::optional<tr_sys_path_capacity> const& capacity, tr_error const& error)
+        {
+            auto& args_out = idle_data->args_out;
+            args_out.try_emplace(TR_KEY_path, path);
+            args_out.try_emplace(TR_KEY_size_bytes, capacity ? capacity->available : tr_variant{ -1 });
+            args_out.try_emplace(TR_KEY_total_size, capacity ? capacity->capacity : tr_variant{ -1 });
+
+            if (error)
+            {
+                tr_rpc_idle_done(idle_data, Error::SYSTEM_ERROR, error.message());
+                return;
+            }
+            tr_rpc_idle_done(idle_data, Error::SUCCESS, {});
+        });
 }
 
 // ---
@@ -2804,8 +3274,7 @@ using SessionAccessors = std::pair<SessionGetter, SessionSetter>;
 
 using SyncHandler = std::pair<JsonRpc::Error::Code, std::string> (*)(tr_session*, tr_variant::Map const&, tr_variant::Map&);
 
-auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler, bool /*has_side_effects*/>, 20U>{ {
-    { TR_KEY_free_space, { freeSpace, false } },
+auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler, bool /*has_side_effects*/>, 19U>{ {
     { TR_KEY_group_get, { groupGet, false } },
     { TR_KEY_group_set, { groupSet, true } },
     { TR_KEY_queue_move_bottom, { queueMoveBottom, true } },
@@ -2829,10 +3298,12 @@ auto const sync_handlers = small::max_size_map<tr_quark, std::pair<SyncHandler,
 
 using AsyncHandler = void (*)(tr_session*, tr_variant::Map const&, tr_rpc_idle_data*);
 
-auto const async_handlers = small::max_size_map<tr_quark, std::pair<AsyncHandler, bool /*has_side_effects*/>, 4U>{ {
+auto const async_handlers = small::max_size_map<tr_quark, std::pair<AsyncHandler, bool /*has_side_effects*/>, 6U>{ {
     { TR_KEY_blocklist_update, { blocklistUpdate, true } },
+    { TR_KEY_free_space, { freeSpace, false } },
     { TR_KEY_port_test, { portTest, false } },
     { TR_KEY_torrent_add, { torrentAdd, true } },
+    { TR_KEY_torrent_add_batch, { torrentAddBatch, true } },
     { TR_KEY_torrent_rename_path, { torrentRenamePath, true } },
 } };
 
@@ -2840,7 +3311,13 @@ void noop_response_callback(tr_variant&& /*response*/)
 {
 }
 
-void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_response_func&& callback, bool is_batch)
+void tr_rpc_request_exec_impl(
+    tr_session* session,
+    tr_variant& request,
+    tr_rpc_response_func&& callback,
+    bool is_batch,
+    bool convert_legacy_keys = true,
+    tr_rpc_latency* latency = nullptr)
 {
     using namespace JsonRpc;
 
@@ -2895,13 +3372,25 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
     }
 
     auto const method_name = map->value_if<std::string_view>(TR_KEY_method).value_or(""sv);
-    auto const method_key = tr_quark_new(method_name);
+    // don't add quarks for unknown method names; they won't have handlers anyway
+    auto const method_key = tr_quark_lookup(method_name).value_or(TR_KEY_NONE);
 
     auto* const data = new tr_rpc_idle_data{};
     data->session = session;
     data->is_jsonrpc = is_jsonrpc;
+    data->convert_legacy_keys = convert_legacy_keys;
     data->callback = std::move(callback);
 
+    if (latency != nullptr)
+    {
+        auto const started_at = std::chrono::steady_clock::now();
+        data->callback = [latency, method_key, started_at, inner = std::move(data->callback)](tr_variant&& response)
+        {
+            inner(std::move(response));
+            latency->record(method_key, std::chrono::steady_clock::now() - started_at, false);
+        };
+    }
+
     if (auto iter = map->find(TR_KEY_id); iter != std::end(*map))
     {
         tr_variant const& id = iter->second;
@@ -2925,6 +3414,19 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
             return;
         }
 
+        if (has_side_effects)
+        {
+            // Bump it again when the work is done, since that's when most
+            // of the changes land. Otherwise, a snapshot taken while the
+            // work was in progress would still look current afterwards.
+            ++write_epoch;
+            data->callback = [inner = std::move(data->callback)](tr_variant&& response)
+            {
+                ++write_epoch;
+                inner(std::move(response));
+            };
+        }
+
         func(session, *params, data);
         return;
     }
@@ -2938,6 +3440,11 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
             return;
         }
 
+        if (has_side_effects)
+        {
+            ++write_epoch;
+        }
+
         auto const [err, errmsg] = func(session, *params, data->args_out);
         tr_rpc_idle_done(data, err, errmsg);
         return;
@@ -2947,7 +3454,11 @@ void tr_rpc_request_exec_impl(tr_session* session, tr_variant& request, tr_rpc_r
     tr_rpc_idle_done(data, Error::METHOD_NOT_FOUND, {});
 }
 
-void tr_rpc_request_exec_batch(tr_session* session, tr_variant::Vector& requests, tr_rpc_response_func&& callback)
+void tr_rpc_request_exec_batch(
+    tr_session* session,
+    tr_variant::Vector& requests,
+    tr_rpc_response_func&& callback,
+    tr_rpc_latency* latency)
 {
     auto const n_requests = std::size(requests);
     auto responses = std::make_shared<tr_variant::Vector>(n_requests);
@@ -2975,30 +3486,401 @@ void tr_rpc_request_exec_batch(tr_session* session, tr_variant::Vector& requests
                     (*cb)(!std::empty(*responses) ? std::move(*responses) : tr_variant{});
                 }
             },
-            true);
+            true,
+            true,
+            latency);
     }
 }
-} // namespace
 
-// TODO(tearfur): take `tr_variant const& request` after removing api_compat
-void tr_rpc_request_exec(tr_session* session, tr_variant& request, tr_rpc_response_func&& callback)
+void tr_rpc_request_exec_top(
+    tr_session* session,
+    tr_variant& request,
+    tr_rpc_response_func&& callback,
+    bool convert_legacy_keys,
+    tr_rpc_latency* latency = nullptr)
 {
     auto const lock = session->unique_lock();
 
     if (auto* const vec = request.get_if<tr_variant::Vector>(); vec != nullptr)
     {
-        tr_rpc_request_exec_batch(session, *vec, std::move(callback));
+        tr_rpc_request_exec_batch(session, *vec, std::move(callback), latency);
+        return;
+    }
+
+    tr_rpc_request_exec_impl(session, request, std::move(callback), false, convert_legacy_keys, latency);
+}
+} // namespace
+
+// ---
+
+tr_rpc_latency::tr_rpc_latency()
+    : histograms_(std::size(sync_handlers) + std::size(async_handlers))
+{
+    methods_.reserve(std::size(histograms_));
+    for (auto const& [key, handler] : sync_handlers)
+    {
+        methods_.emplace_back(key);
+    }
+    for (auto const& [key, handler] : async_handlers)
+    {
+        methods_.emplace_back(key);
+    }
+    std::ranges::sort(methods_);
+}
+
+void tr_rpc_latency::record(
+    tr_quark const method,
+    std::chrono::steady_clock::duration const elapsed,
+    bool const from_snapshot) noexcept
+{
+    auto const iter = std::ranges::lower_bound(methods_, method);
+    if (iter == std::end(methods_) || *iter != method)
+    {
         return;
     }
 
-    tr_rpc_request_exec_impl(session, request, std::move(callback), false);
+    auto const usec = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    auto const bucket = std::min(
+        static_cast<size_t>(std::bit_width(static_cast<uint64_t>(std::max(usec, decltype(usec){})) >> MinBucketBits)),
+        NumBuckets - 1U);
+
+    auto& histogram = histograms_[iter - std::begin(methods_)];
+    histogram.buckets[bucket].fetch_add(1U, std::memory_order_relaxed);
+    if (from_snapshot)
+    {
+        histogram.snapshot_count.fetch_add(1U, std::memory_order_relaxed);
+    }
+}
+
+tr_variant::Map tr_rpc_latency::to_map() const
+{
+    auto ret = tr_variant::Map{};
+
+    for (size_t i = 0U, n = std::size(methods_); i < n; ++i)
+    {
+        auto const& histogram = histograms_[i];
+
+        auto count = uint64_t{};
+        auto buckets = tr_variant::Vector{};
+        buckets.reserve(NumBuckets);
+        for (auto const& bucket : histogram.buckets)
+        {
+            auto const n_requests = bucket.load(std::memory_order_relaxed);
+            count += n_requests;
+            buckets.emplace_back(n_requests);
+        }
+
+        if (count == 0U)
+        {
+            continue;
+        }
+
+        auto method_map = tr_variant::Map{ 3U };
+        method_map.try_emplace(TR_KEY_buckets, std::move(buckets));
+        method_map.try_emplace(TR_KEY_count, count);
+        method_map.try_emplace(TR_KEY_snapshot_count, histogram.snapshot_count.load(std::memory_order_relaxed));
+        ret.try_emplace(methods_[i], std::move(method_map));
+    }
+
+    return ret;
+}
+
+// ---
+
+tr_rpc_snapshot::tr_rpc_snapshot(tr_session* const session)
+    : taken_at_{ tr_time() }
+    , write_epoch_{ write_epoch.load() }
+{
+    auto const lock = session->unique_lock();
+
+    auto const torrents = session->torrents().get_all();
+    torrents_ = tr_torrentStat(std::data(torrents), std::size(torrents));
+    std::ranges::sort(torrents_, {}, &tr_stat::id);
+
+    std::ignore = sessionStats(session, tr_variant::Map{}, session_stats_);
+}
+
+bool tr_rpc_snapshot::is_current() const noexcept
+{
+    return write_epoch_ == write_epoch.load();
+}
+
+bool tr_rpc_snapshot::torrent_get(tr_variant::Map const& params, tr_variant::Map& args_out) const
+{
+    // `changed_since` records what each torrent looked like, which needs the session thread
+    auto const keys = get_torrent_get_fields(params);
+    if (std::empty(keys) || !std::ranges::all_of(keys, [](tr_quark key) { return isStatField(key); }) ||
+        params.contains(TR_KEY_changed_since))
+    {
+        return false;
+    }
+
+    auto stats = std::vector<tr_stat const*>{};
+    if (auto const iter = params.find(TR_KEY_ids); iter == std::end(params))
+    {
+        stats.reserve(std::size(torrents_));
+        std::ranges::transform(torrents_, std::back_inserter(stats), [](auto const& st) { return &st; });
+    }
+    else
+    {
+        // "recently_active" and hash strings need the session thread
+        auto const add_stat_from_var = [this, &stats](tr_variant const& var)
+        {
+            auto const id = var.value_if<tr_torrent_id_t>();
+            if (!id)
+            {
+                return false;
+            }
+
+            if (auto const it = std::ranges::lower_bound(torrents_, *id, {}, &tr_stat::id);
+                it != std::end(torrents_) && it->id == *id)
+            {
+                stats.emplace_back(&*it);
+            }
+
+            return true;
+        };
+
+        if (auto const* const ids_vec = iter->second.get_if<tr_variant::Vector>(); ids_vec != nullptr)
+        {
+            if (!std::ranges::all_of(*ids_vec, add_stat_from_var))
+            {
+                return false;
+            }
+        }
+        else if (!add_stat_from_var(iter->second))
+        {
+            return false;
+        }
+    }
+
+    auto const format = params.value_if<std::string_view>(TR_KEY_format).value_or("object"sv) == "table"sv ? TrFormat::Table :
+                                                                                                            TrFormat::Object;
+
+    auto torrents_vec = tr_variant::Vector{};
+    torrents_vec.reserve(std::size(stats) + 1U);
+
+    if (format == TrFormat::Table)
+    {
+        auto names = tr_variant::Vector{};
+        names.reserve(std::size(keys));
+        std::ranges::transform(keys, std::back_inserter(names), [](tr_quark key) { return tr_quark_get_string_view(key); });
+        torrents_vec.emplace_back(std::move(names));
+
+        for (auto const* const st : stats)
+        {
+            auto info_vec = tr_variant::Vector{};
+            info_vec.reserve(std::size(keys));
+            for (auto const key : keys)
+            {
+                info_vec.emplace_back(make_stat_field(*st, key));
+            }
+            torrents_vec.emplace_back(std::move(info_vec));
+        }
+    }
+    else
+    {
+        for (auto const* const st : stats)
+        {
+            auto info_map = tr_variant::Map{ std::size(keys) };
+            for (auto const key : keys)
+            {
+                info_map.try_emplace(key, make_stat_field(*st, key));
+            }
+            torrents_vec.emplace_back(std::move(info_map));
+        }
+    }
+
+    args_out.try_emplace(TR_KEY_torrents, std::move(torrents_vec));
+    return true;
+}
+
+std::optional<std::string> tr_rpc_snapshot::exec_serialized(
+    std::string_view request,
+    tr_rpc_encoding const request_encoding,
+    tr_rpc_encoding const response_encoding,
+    tr_rpc_latency* const latency) const
+{
+    using namespace JsonRpc;
+
+    auto const started_at = std::chrono::steady_clock::now();
+
+    if (!is_current())
+    {
+        return {};
+    }
+
+    auto otop = make_rpc_serde(request_encoding).inplace().known_keys_only().parse(request);
+    auto* const map = otop ? otop->get_if<tr_variant::Map>() : nullptr;
+    if (map == nullptr || map->value_if<std::string_view>(TR_KEY_jsonrpc) != Version)
+    {
+        return {};
+    }
+
+    // let the session thread report bad ids
+    auto const id_iter = map->find(TR_KEY_id);
+    if (id_iter != std::end(*map) && !is_valid_id(id_iter->second))
+    {
+        return {};
+    }
+
+    auto const method_name = map->value_if<std::string_view>(TR_KEY_method).value_or(""sv);
+    auto const method_key = tr_quark_lookup(method_name).value_or(TR_KEY_NONE);
+    if (method_key != TR_KEY_session_stats && method_key != TR_KEY_torrent_get)
+    {
+        return {};
+    }
+
+    auto response = std::string{};
+
+    // these methods have no side effects, so notifications are no-ops
+    if (id_iter != std::end(*map))
+    {
+        auto const empty_params = tr_variant::Map{};
+        auto const* params = map->find_if<tr_variant::Map>(TR_KEY_params);
+        if (params == nullptr)
+        {
+            params = &empty_params;
+        }
+
+        auto [err, errmsg] = std::pair{ Error::SUCCESS, std::string{} };
+        auto args_out = tr_variant::Map{};
+        switch (method_key)
+        {
+        case TR_KEY_session_stats:
+            args_out = session_stats_.clone();
+            break;
+
+        default:
+            if (!torrent_get(*params, args_out))
+            {
+                return {};
+            }
+            break;
+        }
+
+        response = make_rpc_serde(response_encoding).compact().to_string(tr_variant{ build_response(
+            err,
+            std::move(id_iter->second),
+            err == Error::SUCCESS ? std::move(args_out) : Error::build_data(errmsg, std::move(args_out))) });
+    }
+
+    if (latency != nullptr)
+    {
+        latency->record(method_key, std::chrono::steady_clock::now() - started_at, true);
+    }
+
+    return response;
+}
+
+// ---
+
+tr_rpc_event_source::tr_rpc_event_source(tr_session* session, tr_variant::Map const& params)
+    : session_{ session }
+    , fields_{ get_torrent_get_fields(params) }
+    , with_session_stats_{ params.value_if<bool>(TR_KEY_session_stats).value_or(false) }
+{
+}
+
+tr_variant tr_rpc_event_source::next()
+{
+    auto const lock = session_->unique_lock();
+    auto const now = tr_time();
+    auto event = tr_variant::Map{ 3U };
+
+    if (!std::empty(fields_))
+    {
+        auto const& torrents = session_->torrents();
+
+        // Changes made later in the same second as the previous event
+        // have the same timestamp, so look back an extra second for them.
+        // Values that didn't actually change are filtered out below.
+        auto const changed = last_event_at_ ?
+            torrents.get_matching([cutoff = *last_event_at_ - 1](auto const* tor) { return tor->has_changed_since(cutoff); }) :
+            torrents.get_all();
+
+        auto torrents_vec = tr_variant::Vector{};
+        for (auto* const tor : changed)
+        {
+            auto const st = tr_torrentStat(tor);
+            auto [iter, is_new] = sent_.try_emplace(tor->id());
+            auto& sent = iter->second;
+            sent.resize(std::size(fields_));
+
+            auto delta = tr_variant::Map{};
+            for (size_t i = 0U, n = std::size(fields_); i < n; ++i)
+            {
+                auto value = make_torrent_field(*tor, st, fields_[i]);
+                if (auto const digest = make_field_fingerprint(value); is_new || digest != sent[i])
+                {
+                    sent[i] = digest;
+                    delta.try_emplace(fields_[i], std::move(value));
+                }
+            }
+
+            if (!std::empty(delta))
+            {
+                delta.try_emplace(TR_KEY_id, tor->id());
+                torrents_vec.emplace_back(std::move(delta));
+            }
+        }
+
+        auto removed_vec = tr_variant::Vector{};
+        if (last_event_at_)
+        {
+            for (auto const id : torrents.removedSince(*last_event_at_ - 1))
+            {
+                if (sent_.erase(id) != 0U)
+                {
+                    removed_vec.emplace_back(id);
+                }
+            }
+        }
+
+        if (!std::empty(torrents_vec))
+        {
+            event.try_emplace(TR_KEY_torrents, std::move(torrents_vec));
+        }
+
+        if (!std::empty(removed_vec))
+        {
+            event.try_emplace(TR_KEY_removed, std::move(removed_vec));
+        }
+    }
+
+    if (with_session_stats_)
+    {
+        auto stats_map = tr_variant::Map{};
+        std::ignore = sessionStats(session_, tr_variant::Map{}, stats_map);
+        auto stats = tr_variant{ std::move(stats_map) };
+        if (auto const digest = make_field_fingerprint(stats); digest != sent_stats_)
+        {
+            sent_stats_ = digest;
+            event.try_emplace(TR_KEY_session_stats, std::move(stats));
+        }
+    }
+
+    last_event_at_ = now;
+
+    if (std::empty(event))
+    {
+        return {};
+    }
+
+    return tr_variant{ std::move(event) };
+}
+
+// TODO(tearfur): take `tr_variant const& request` after removing api_compat
+void tr_rpc_request_exec(tr_session* session, tr_variant& request, tr_rpc_response_func&& callback)
+{
+    tr_rpc_request_exec_top(session, request, std::move(callback), true);
 }
 
 void tr_rpc_request_exec(tr_session* session, std::string_view request, tr_rpc_response_func&& callback)
 {
     using namespace JsonRpc;
 
-    auto serde = tr_variant_serde::json().inplace();
+    auto serde = tr_variant_serde::json().inplace().known_keys_only();
     if (auto otop = serde.parse(request); otop)
     {
         tr_rpc_request_exec(session, *otop, std::move(callback));
@@ -3007,3 +3889,56 @@ void tr_rpc_request_exec(tr_session* session, std::string_view request, tr_rpc_r
 
     callback(build_response(Error::PARSE_ERROR, nullptr, Error::build_data(serde.error_.message(), {})));
 }
+
+void tr_rpc_request_exec_json(
+    tr_session* session,
+    std::string_view request,
+    tr_rpc_json_response_func&& callback,
+    tr_rpc_latency* latency)
+{
+    tr_rpc_request_exec_serialized(
+        session,
+        request,
+        tr_rpc_encoding::Json,
+        tr_rpc_encoding::Json,
+        std::move(callback),
+        latency);
+}
+
+void tr_rpc_request_exec_serialized(
+    tr_session* session,
+    std::string_view request,
+    tr_rpc_encoding const request_encoding,
+    tr_rpc_encoding const response_encoding,
+    tr_rpc_json_response_func&& callback,
+    tr_rpc_latency* latency)
+{
+    using namespace JsonRpc;
+
+    auto serialize = [callback = std::move(callback), serde = make_rpc_serde(response_encoding)](tr_variant&& response) mutable
+    {
+        if (!response.has_value())
+        {
+            callback({});
+            return;
+        }
+
+        // legacy responses skipped their key renaming; do it while writing them
+        auto key_style = std::unique_ptr<tr_variant_serde::KeyStyle>{};
+        if (auto const* const map = response.get_if<tr_variant::Map>(); map != nullptr && !map->contains(TR_KEY_jsonrpc))
+        {
+            key_style = tr::api_compat::make_key_style(response, tr::api_compat::Style::Tr4);
+        }
+
+        callback(serde.compact().key_style(key_style.get()).to_string(response));
+    };
+
+    auto serde = make_rpc_serde(request_encoding);
+    if (auto otop = serde.inplace().known_keys_only().parse(request); otop)
+    {
+        tr_rpc_request_exec_top(session, *otop, std::move(serialize), false, latency);
+        return;
+    }
+
+    serialize(build_response(Error::PARSE_ERROR, nullptr, Error::build_data(serde.error_.message(), {})));
+}
@@ -5,11 +5,24 @@
 
 #pragma once
 
-#include <cstdint> // int16_t
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef> // size_t
+#include <cstdint> // int16_t, uint64_t
+#include <ctime> // time_t
 #include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "libtransmission/quark.h"
+#include "libtransmission/types.h" // tr_stat, tr_torrent_id_t
+#include "libtransmission/variant.h"
 
 struct tr_session;
-struct tr_variant;
 
 #define RPC_VERSION_VARS(major, minor, patch) \
     auto inline constexpr TrRpcVersionSemver = std::string_view{ #major "." #minor "." #patch }; \
@@ -54,3 +67,141 @@ using tr_rpc_response_func = std::function<void(tr_variant&& response)>;
 void tr_rpc_request_exec(tr_session* session, tr_variant& request, tr_rpc_response_func&& callback = {});
 
 void tr_rpc_request_exec(tr_session* session, std::string_view request, tr_rpc_response_func&& callback = {});
+
+/**
+ * Per-method latency histograms for RPC requests.
+ * Requests can be recorded from any thread.
+ */
+class tr_rpc_latency
+{
+public:
+    // Bucket `i` counts the requests that took less than `2^(i + MinBucketBits)`
+    // microseconds. The last bucket also counts everything slower than that.
+    static auto constexpr MinBucketBits = 6U; // 64 µs
+    static auto constexpr NumBuckets = size_t{ 16U };
+
+    tr_rpc_latency();
+
+    void record(tr_quark method, std::chrono::steady_clock::duration elapsed, bool from_snapshot) noexcept;
+
+    // @return a map of method name to `{ count, snapshot_count, buckets }`
+    [[nodiscard]] tr_variant::Map to_map() const;
+
+private:
+    struct Histogram
+    {
+        std::array<std::atomic<uint64_t>, NumBuckets> buckets = {};
+        std::atomic<uint64_t> snapshot_count = {};
+    };
+
+    std::vector<tr_quark> methods_; // sorted
+    std::vector<Histogram> histograms_;
+};
+
+using tr_rpc_json_response_func = std::function<void(std::string&& json)>;
+
+// Like tr_rpc_request_exec(), but passes `callback` the response as JSON,
+// or an empty string if there's no response, e.g. for notifications.
+// Legacy responses have their keys renamed while they are serialized
+// instead of in a separate pass over the response.
+void tr_rpc_request_exec_json(
+    tr_session* session,
+    std::string_view request,
+    tr_rpc_json_response_func&& callback,
+    tr_rpc_latency* latency = nullptr);
+
+// How an RPC request or response is serialized over the wire.
+enum class tr_rpc_encoding : uint8_t
+{
+    Json,
+    Benc, // smaller and cheaper to write, but has no bool, real, or null types
+};
+
+// Like tr_rpc_request_exec_json(), but `request` is parsed as `request_encoding`
+// and the response is serialized as `response_encoding`.
+void tr_rpc_request_exec_serialized(
+    tr_session* session,
+    std::string_view request,
+    tr_rpc_encoding request_encoding,
+    tr_rpc_encoding response_encoding,
+    tr_rpc_json_response_func&& callback,
+    tr_rpc_latency* latency = nullptr);
+
+/**
+ * A read-only copy of the torrent and session stats, taken on the session thread.
+ *
+ * It can answer some read-only JSON-RPC requests on any thread without taking
+ * the session lock: `session_stats`, and `torrent_get` when every requested
+ * field comes from tr_stat and `ids` is omitted or only holds ids.
+ * Anything else, including legacy and batch requests, needs the session thread.
+ */
+class tr_rpc_snapshot
+{
+public:
+    explicit tr_rpc_snapshot(tr_session* session);
+
+    [[nodiscard]] constexpr auto taken_at() const noexcept
+    {
+        return taken_at_;
+    }
+
+    // @return false if an RPC method with side effects has run since this was taken
+    [[nodiscard]] bool is_current() const noexcept;
+
+    // @return the response to `request`, which is empty for notifications,
+    // or nullopt if the request needs the session thread
+    [[nodiscard]] std::optional<std::string> exec_serialized(
+        std::string_view request,
+        tr_rpc_encoding request_encoding,
+        tr_rpc_encoding response_encoding,
+        tr_rpc_latency* latency = nullptr) const;
+
+    [[nodiscard]] std::optional<std::string> exec_json(std::string_view request, tr_rpc_latency* latency = nullptr) const
+    {
+        return exec_serialized(request, tr_rpc_encoding::Json, tr_rpc_encoding::Json, latency);
+    }
+
+private:
+    [[nodiscard]] bool torrent_get(tr_variant::Map const& params, tr_variant::Map& args_out) const;
+
+    std::vector<tr_stat> torrents_; // sorted by id
+    tr_variant::Map session_stats_;
+    time_t taken_at_;
+    uint64_t write_epoch_;
+};
+
+/**
+ * Builds the events pushed to one subscriber of the RPC event stream.
+ *
+ * The subscription's params are the same `fields` as `torrent_get`, plus
+ * an optional `session_stats` boolean. Each event only holds what changed
+ * since the previous one: `torrents` lists the subscribed fields whose
+ * values changed (always with `id`), `removed` lists the ids of torrents
+ * that are gone, and `session_stats` is included when those changed.
+ * The first event is a full snapshot.
+ */
+class tr_rpc_event_source
+{
+public:
+    tr_rpc_event_source(tr_session* session, tr_variant::Map const& params);
+
+    [[nodiscard]] bool is_valid() const noexcept
+    {
+        return !std::empty(fields_) || with_session_stats_;
+    }
+
+    // @return the next event, or an empty variant if nothing changed
+    [[nodiscard]] tr_variant next();
+
+private:
+    tr_session* session_;
+    std::vector<tr_quark> fields_;
+    bool with_session_stats_;
+
+    // fingerprints of the values of `fields_` that were last sent for each torrent,
+    // made the same way as the ones passed to tr_torrent::observe_field()
+    std::unordered_map<tr_torrent_id_t, std::vector<size_t>> sent_;
+    std::optional<size_t> sent_stats_;
+
+    std::optional<time_t> last_event_at_;
+};
@@ -90,6 +90,7 @@ public:
     bool lpd_enabled = true;
     bool peer_port_random_on_start = false;
     bool pex_enabled = true;
+    bool piece_hashes_mmap_enabled = false;
     bool port_forwarding_enabled = true;
     bool queue_stalled_enabled = true;
     bool ratio_limit_enabled = false;
@@ -108,10 +109,12 @@ public:
     bool utp_enabled = true;
     double ratio_limit = 2.0;
     size_t unused_cache_size_mbytes = 4U; // TODO(TR5): remove
+    size_t download_dir_low_space_mib = 0U;
     size_t download_queue_size = 5U;
     size_t peer_limit_global = TrDefaultPeerLimitGlobal;
     size_t peer_limit_per_torrent = TrDefaultPeerLimitTorrent;
     size_t queue_stalled_minutes = 30U;
+    size_t relocate_speed_limit = 0U;
     size_t reqq = 2000U;
     size_t seed_queue_size = 10U;
     size_t speed_limit_down = 100U;
@@ -165,6 +168,7 @@ public:
         Field<&SessionSettings::default_trackers_str>{ TR_KEY_default_trackers },
         Field<&SessionSettings::dht_enabled>{ TR_KEY_dht_enabled },
         Field<&SessionSettings::download_dir>{ TR_KEY_download_dir },
+        Field<&SessionSettings::download_dir_low_space_mib>{ TR_KEY_download_dir_low_space_mib },
         Field<&SessionSettings::download_queue_enabled>{ TR_KEY_download_queue_enabled },
         Field<&SessionSettings::download_queue_size>{ TR_KEY_download_queue_size },
         Field<&SessionSettings::encryption_mode>{ TR_KEY_encryption },
@@ -185,6 +189,7 @@ public:
         Field<&SessionSettings::peer_port_random_on_start>{ TR_KEY_peer_port_random_on_start },
         Field<&SessionSettings::peer_socket_diffserv>{ TR_KEY_peer_socket_diffserv },
         Field<&SessionSettings::pex_enabled>{ TR_KEY_pex_enabled },
+        Field<&SessionSettings::piece_hashes_mmap_enabled>{ TR_KEY_piece_hashes_mmap_enabled },
         Field<&SessionSettings::port_forwarding_enabled>{ TR_KEY_port_forwarding_enabled },
         Field<&SessionSettings::preallocation_mode>{ TR_KEY_preallocation },
         Field<&SessionSettings::preferred_transports>{ TR_KEY_preferred_transports },
@@ -192,6 +197,7 @@ public:
         Field<&SessionSettings::queue_stalled_enabled>{ TR_KEY_queue_stalled_enabled },
         Field<&SessionSettings::queue_stalled_minutes>{ TR_KEY_queue_stalled_minutes },
         Field<&SessionSettings::ratio_limit>{ TR_KEY_seed_ratio_limit },
+        Field<&SessionSettings::relocate_speed_limit>{ TR_KEY_relocate_speed_limit },
         Field<&SessionSettings::ratio_limit_enabled>{ TR_KEY_seed_ratio_limited },
         Field<&SessionSettings::is_incomplete_file_naming_enabled>{ TR_KEY_rename_partial_files },
         Field<&SessionSettings::reqq>{ TR_KEY_reqq },
@@ -299,8 +305,11 @@ public:
     bool is_host_whitelist_enabled = true;
     bool is_whitelist_enabled = true;
     size_t anti_brute_force_limit = 100U;
+    size_t large_response_compression_level = 1U;
+    size_t worker_threads = 2U;
     std::string bind_address_str = "0.0.0.0";
     std::string host_whitelist_str;
+    std::string local_socket_path;
     std::string salted_password;
     std::string url = std::string{ TrDefaultHttpServerBasePath };
     std::string username;
@@ -321,13 +330,16 @@ public:
         Field<&RpcServerSettings::is_enabled>{ TR_KEY_rpc_enabled },
         Field<&RpcServerSettings::host_whitelist_str>{ TR_KEY_rpc_host_whitelist },
         Field<&RpcServerSettings::is_host_whitelist_enabled>{ TR_KEY_rpc_host_whitelist_enabled },
+        Field<&RpcServerSettings::large_response_compression_level>{ TR_KEY_rpc_large_response_compression_level },
+        Field<&RpcServerSettings::local_socket_path>{ TR_KEY_rpc_local_socket },
         Field<&RpcServerSettings::port>{ TR_KEY_rpc_port },
         Field<&RpcServerSettings::salted_password>{ TR_KEY_rpc_password },
         Field<&RpcServerSettings::socket_mode>{ TR_KEY_rpc_socket_mode },
         Field<&RpcServerSettings::url>{ TR_KEY_rpc_url },
         Field<&RpcServerSettings::username>{ TR_KEY_rpc_username },
         Field<&RpcServerSettings::whitelist_str>{ TR_KEY_rpc_whitelist },
-        Field<&RpcServerSettings::is_whitelist_enabled>{ TR_KEY_rpc_whitelist_enabled });
+        Field<&RpcServerSettings::is_whitelist_enabled>{ TR_KEY_rpc_whitelist_enabled },
+        Field<&RpcServerSettings::worker_threads>{ TR_KEY_rpc_worker_threads });
 };
 
 struct SessionSettingsSnapshot final
@@ -41,6 +41,7 @@
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
 #include "libtransmission/net.h"
+#include "libtransmission/peer-common.h" // tr_swarmGetStats()
 #include "libtransmission/peer-mgr.h"
 #include "libtransmission/peer-socket-tcp.h"
 #include "libtransmission/peer-socket.h"
@@ -240,6 +241,27 @@ tr_sha1_digest_t tr_session::DhtMediator::torrent_info_hash(tr_torrent_id_t id)
     return {};
 }
 
+int tr_session::DhtMediator::torrent_announce_priority(tr_torrent_id_t id) const
+{
+    // Announce downloading torrents first, since they need peers the most.
+    // Among those, prefer the swarms where we have the fewest peers.
+    static auto constexpr LowPeerCount = uint16_t{ 10U };
+
+    auto const* const tor = session_.torrents().get(id);
+    if (tor == nullptr)
+    {
+        return 0;
+    }
+
+    auto priority = tor->is_done() ? 0 : 2;
+    if (tor->swarm != nullptr && tr_swarmGetStats(tor->swarm).peer_count < LowPeerCount)
+    {
+        ++priority;
+    }
+
+    return priority;
+}
+
 void tr_session::DhtMediator::add_pex(tr_sha1_digest_t const& info_hash, tr_pex const* pex, size_t n_pex)
 {
     if (auto* const tor = session_.torrents().get(info_hash); tor != nullptr)
@@ -733,15 +755,32 @@ void tr_session::on_queue_timer()
 // Periodically save the .resume files of any torrents whose
 // status has recently changed. This prevents loss of metadata
 // in the case of a crash, unclean shutdown, clumsy user, etc.
+namespace
+{
+// The save interval is split into this many ticks.
+auto constexpr SaveSlices = size_t{ 12U };
+} // namespace
+
 void tr_session::on_save_timer()
 {
-    for (auto* const tor : torrents())
+    // Save a share of the dirty torrents on each tick instead of all of
+    // them at once, so the resume-file writes are spread out across the
+    // save interval. Everything that was dirty when an interval started
+    // is saved by the end of that interval.
+    auto const slices_left = SaveSlices - save_slice_;
+    auto const n_dirty = torrents().dirty_count();
+    auto const n_to_save = slices_left == 1U ? n_dirty : (n_dirty + slices_left - 1U) / slices_left;
+    for (auto* const tor : torrents().pop_dirty(n_to_save))
     {
         tor->save_resume_file();
     }
 
-    stats().save_if_dirty();
-    torrent_queue().to_file();
+    save_slice_ = (save_slice_ + 1U) % SaveSlices;
+    if (save_slice_ == 0U)
+    {
+        stats().save_if_dirty();
+        torrent_queue().to_file();
+    }
 }
 
 void tr_session::initImpl(init_data& data)
@@ -904,6 +943,17 @@ void tr_session::setSettings(tr_session::Settings&& settings_in, bool force)
         verifier_->set_sleep_per_seconds_during_verify(val);
     }
 
+    if (auto const& val = new_settings.relocate_speed_limit; force || val != old_settings.relocate_speed_limit)
+    {
+        relocator_->set_speed_limit(Speed{ val, Speed::Units::KByps }.base_quantity());
+    }
+
+    if (force || new_settings.download_dir != old_settings.download_dir ||
+        new_settings.download_dir_low_space_mib != old_settings.download_dir_low_space_mib)
+    {
+        watch_download_dir();
+    }
+
     // We need to update bandwidth if speed settings changed.
     // It's a harmless call, so just call it instead of checking for settings changes
     update_bandwidth(tr_direction::Up);
@@ -1406,6 +1456,9 @@ void tr_session::closeImplPart1(std::promise<void>* closed_promise, std::chrono:
     // close the low-hanging fruit that can be closed immediately w/o consequences
     utp_timer.reset();
     verifier_.reset();
+    relocator_.reset();
+    capacity_cache_.reset();
+    metainfo_parser_.reset();
     save_timer_.reset();
     queue_timer_.reset();
     now_timer_.reset();
@@ -2079,6 +2132,81 @@ void tr_session::verify_add(tr_torrent* const tor)
 
 // ---
 
+void tr_session::relocate_add(
+    tr_torrent_id_t const tor_id,
+    std::string location,
+    std::vector<tr_relocate_worker::File> files,
+    tr_relocate_worker::DoneFunc on_done)
+{
+    if (relocator_)
+    {
+        relocator_->add(tor_id, std::move(location), std::move(files), std::move(on_done));
+    }
+}
+
+void tr_session::relocate_cancel(tr_torrent_id_t const tor_id)
+{
+    if (relocator_)
+    {
+        relocator_->cancel(tor_id);
+    }
+}
+
+std::optional<tr_relocate_worker::Progress> tr_session::relocate_progress(tr_torrent_id_t const tor_id) const
+{
+    return relocator_ ? relocator_->progress(tor_id) : std::nullopt;
+}
+
+// ---
+
+// Keep the download dir's free space cached for session-get,
+// and warn the user when it's running low.
+void tr_session::watch_download_dir()
+{
+    TR_ASSERT(am_in_session_thread());
+
+    if (!capacity_cache_)
+    {
+        return;
+    }
+
+    capacity_cache_->unwatch(download_dir_watch_);
+    download_dir_is_low_ = false;
+
+    auto const threshold = Memory{ settings_.download_dir_low_space_mib, Memory::Units::MBytes }.base_quantity();
+    download_dir_watch_ = capacity_cache_->watch(
+        downloadDir(),
+        threshold,
+        [this](std::string_view const path, uintmax_t const available, bool const is_low)
+        {
+            auto const free_space = Storage{ available, Storage::Units::Bytes }.to_string();
+
+            if (is_low)
+            {
+                tr_logAddWarn(fmt::format(
+                    fmt::runtime(_("Download directory '{path}' is running out of space ({free_space} left)")),
+                    fmt::arg("path", path),
+                    fmt::arg("free_space", free_space)));
+            }
+            else if (download_dir_is_low_)
+            {
+                tr_logAddInfo(fmt::format(
+                    fmt::runtime(_("Download directory '{path}' has {free_space} free again")),
+                    fmt::arg("path", path),
+                    fmt::arg("free_space", free_space)));
+            }
+            else
+            {
+                return;
+            }
+
+            download_dir_is_low_ = is_low;
+            rpcNotify(TR_RPC_SESSION_CHANGED);
+        });
+}
+
+// ---
+
 void tr_session::close_torrent_files(tr_torrent_id_t const tor_id) noexcept
 {
     openFiles().close_torrent(tor_id);
@@ -2196,7 +2324,7 @@ tr_session::tr_session(std::string_view config_dir, tr_variant const& settings_d
 {
     now_timer_->start_repeating(1s);
     queue_timer_->start_repeating(QueueInterval);
-    save_timer_->start_repeating(SaveInterval);
+    save_timer_->start_repeating(SaveInterval / SaveSlices);
 }
 
 void tr_session::addIncoming(std::shared_ptr<tr_peer_socket> socket)
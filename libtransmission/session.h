@@ -17,6 +17,7 @@
 #include <cstddef> // size_t
 #include <cstdint> // uintX_t
 #include <ctime> // time_t
+#include <functional>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -41,16 +42,19 @@
 #include "libtransmission/announce-list.h"
 #include "libtransmission/announcer.h"
 #include "libtransmission/bandwidth.h"
+#include "libtransmission/capacity-cache.h"
 #include "libtransmission/blocklist.h"
 #include "libtransmission/config-dir-lock.h"
 #include "libtransmission/interned-string.h"
 #include "libtransmission/ip-cache.h"
 #include "libtransmission/local-data.h"
+#include "libtransmission/metainfo-parser.h"
 #include "libtransmission/net.h" // for tr_port, tr_tos_t
 #include "libtransmission/open-files.h"
 #include "libtransmission/platform.h"
 #include "libtransmission/port-forwarding.h"
 #include "libtransmission/quark.h"
+#include "libtransmission/relocate.h"
 #include "libtransmission/rpc-server.h"
 #include "libtransmission/session-alt-speeds.h"
 #include "libtransmission/session-id.h"
@@ -176,6 +180,8 @@ private:
 
         [[nodiscard]] tr_sha1_digest_t torrent_info_hash(tr_torrent_id_t id) const override;
 
+        [[nodiscard]] int torrent_announce_priority(tr_torrent_id_t id) const override;
+
         [[nodiscard]] std::string_view config_dir() const override
         {
             return session_.config_dir_;
@@ -362,6 +368,45 @@ private:
         tr_session& session_;
     };
 
+    class CapacityCacheMediator final : public tr_capacity_cache::Mediator
+    {
+    public:
+        explicit CapacityCacheMediator(tr_session& session) noexcept
+            : session_{ session }
+        {
+        }
+
+        [[nodiscard]] tr::TimerMaker& timer_maker() override
+        {
+            return session_.timerMaker();
+        }
+
+        void queue_session_thread(std::function<void()> func) override
+        {
+            session_.queue_session_thread(std::move(func));
+        }
+
+    private:
+        tr_session& session_;
+    };
+
+    class MetainfoParserMediator final : public tr_metainfo_parser::Mediator
+    {
+    public:
+        explicit MetainfoParserMediator(tr_session& session) noexcept
+            : session_{ session }
+        {
+        }
+
+        void queue_session_thread(std::function<void()> func) override
+        {
+            session_.queue_session_thread(std::move(func));
+        }
+
+    private:
+        tr_session& session_;
+    };
+
     // UDP connectivity used for the DHT and µTP
     class tr_udp_core
     {
@@ -503,6 +548,37 @@ public:
     void setDownloadDir(std::string_view dir)
     {
         settings_.download_dir = dir;
+        run_in_session_thread(&tr_session::watch_download_dir, this);
+    }
+
+    // Free space in the folders that RPC clients ask about.
+    // This is `nullptr` once the session starts closing.
+    [[nodiscard]] tr_capacity_cache* capacity_cache() const noexcept
+    {
+        return capacity_cache_.get();
+    }
+
+    [[nodiscard]] tr_announcer const* announcer() const noexcept
+    {
+        return announcer_.get();
+    }
+
+    // This is `nullptr` if DHT is disabled.
+    [[nodiscard]] tr_dht const* dht() const noexcept
+    {
+        return dht_.get();
+    }
+
+    [[nodiscard]] tr_web const* web() const noexcept
+    {
+        return web_.get();
+    }
+
+    // Parses torrents that RPC clients add in bulk.
+    // This is `nullptr` once the session starts closing.
+    [[nodiscard]] tr_metainfo_parser* metainfo_parser() const noexcept
+    {
+        return metainfo_parser_.get();
     }
 
     // default trackers
@@ -855,6 +931,11 @@ public:
         return settings().torrent_complete_verify_enabled;
     }
 
+    [[nodiscard]] constexpr auto shouldMapPieceHashes() const noexcept
+    {
+        return settings().piece_hashes_mmap_enabled;
+    }
+
     [[nodiscard]] constexpr auto shouldDeleteSource() const noexcept
     {
         return settings().should_delete_source_torrents;
@@ -1021,6 +1102,14 @@ public:
     void verify_add(tr_torrent* tor);
     void verify_remove(tr_torrent const* tor);
 
+    void relocate_add(
+        tr_torrent_id_t tor_id,
+        std::string location,
+        std::vector<tr_relocate_worker::File> files,
+        tr_relocate_worker::DoneFunc on_done);
+    void relocate_cancel(tr_torrent_id_t tor_id);
+    [[nodiscard]] std::optional<tr_relocate_worker::Progress> relocate_progress(tr_torrent_id_t tor_id) const;
+
     void fetch(tr_web::FetchOptions&& options) const
     {
         if (web_)
@@ -1094,6 +1183,8 @@ private:
 
     void onAdvertisedPeerPortChanged();
 
+    void watch_download_dir();
+
     struct init_data;
     void initImpl(init_data& data);
     void setSettings(tr_variant const& settings_map, bool force);
@@ -1357,9 +1448,22 @@ private:
 
     // depends-on: torrents_
     std::unique_ptr<tr::Timer> save_timer_;
+    size_t save_slice_ = 0U;
 
     std::unique_ptr<tr_verify_worker> verifier_ = std::make_unique<tr_verify_worker>();
 
+    std::unique_ptr<tr_relocate_worker> relocator_ = std::make_unique<tr_relocate_worker>();
+
+    // depends-on: timer_maker_, session_thread_
+    CapacityCacheMediator capacity_cache_mediator_{ *this };
+    std::unique_ptr<tr_capacity_cache> capacity_cache_ = std::make_unique<tr_capacity_cache>(capacity_cache_mediator_);
+    tr_capacity_cache::WatchId download_dir_watch_ = {};
+    bool download_dir_is_low_ = false;
+
+    // depends-on: session_thread_
+    MetainfoParserMediator metainfo_parser_mediator_{ *this };
+    std::unique_ptr<tr_metainfo_parser> metainfo_parser_ = std::make_unique<tr_metainfo_parser>(metainfo_parser_mediator_);
+
 public:
     std::unique_ptr<tr::Timer> utp_timer;
 };
@@ -7,6 +7,7 @@
 #include <cerrno> // for EINVAL
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -383,6 +384,7 @@ struct MetainfoHandler final : public tr::benc::BasicHandler<MaxBencDepth>
 
             tm_.pieces_.resize(len / Sha1Len);
             std::copy_n(std::data(value), len, reinterpret_cast<char*>(std::data(tm_.pieces_)));
+            tm_.pieces_offset_ = static_cast<uint64_t>(context.tokenSpan().second) - len;
         }
         else if (pathStartsWith(PieceLayersKey))
         {
@@ -697,6 +699,95 @@ bool tr_torrent_metainfo::parse_torrent_file(std::string_view filename, std::vec
     return tr_file_read(filename, *contents, error) && parse_benc({ std::data(*contents), std::size(*contents) }, error);
 }
 
+bool tr_torrent_metainfo::map_piece_hashes(std::string_view torrent_filename, tr_error* error)
+{
+    if (piece_hashes_mapped())
+    {
+        return true;
+    }
+
+    auto const n_bytes = std::size(pieces_) * sizeof(tr_sha1_digest_t);
+    auto const map_size = pieces_offset_ + n_bytes;
+    if (n_bytes == 0U)
+    {
+        if (error != nullptr)
+        {
+            error->set(EINVAL, "no piece hashes to map"sv);
+        }
+
+        return false;
+    }
+
+    // don't map past the end of the file; touching those pages would crash
+    auto const info = tr_sys_path_get_info(torrent_filename, 0, error);
+    if (!info)
+    {
+        return false;
+    }
+
+    if (info->size < map_size)
+    {
+        if (error != nullptr)
+        {
+            error->set(EINVAL, fmt::format("'{:s}' is too small to hold the piece hashes", torrent_filename));
+        }
+
+        return false;
+    }
+
+    auto const fd = tr_sys_file_open(torrent_filename, TR_SYS_FILE_READ, 0, error);
+    if (fd == TR_BAD_SYS_FILE)
+    {
+        return false;
+    }
+
+    auto const* const begin = static_cast<std::byte const*>(tr_sys_file_map_for_reading(fd, 0U, map_size, error));
+    tr_sys_file_close(fd);
+    if (begin == nullptr)
+    {
+        return false;
+    }
+
+    auto const unmap = [map_size](std::byte const* p)
+    {
+        tr_sys_file_unmap(p, map_size);
+    };
+    auto mapping = std::shared_ptr<std::byte const>{ begin, unmap };
+    auto const* const hashes = begin + pieces_offset_;
+
+    // only let go of our copy if the file really has the same hashes
+    if (!std::equal(hashes, hashes + n_bytes, reinterpret_cast<std::byte const*>(std::data(pieces_))))
+    {
+        if (error != nullptr)
+        {
+            error->set(EINVAL, fmt::format("'{:s}' has different piece hashes", torrent_filename));
+        }
+
+        return false;
+    }
+
+    mapped_pieces_ = std::shared_ptr<std::byte const>{ std::move(mapping), hashes };
+    pieces_.clear();
+    pieces_.shrink_to_fit();
+    return true;
+}
+
+void tr_torrent_metainfo::unmap_piece_hashes()
+{
+    if (!piece_hashes_mapped())
+    {
+        return;
+    }
+
+    pieces_.resize(piece_count());
+    for (tr_piece_index_t piece = 0U, n_pieces = piece_count(); piece < n_pieces; ++piece)
+    {
+        pieces_[piece] = piece_hash(piece);
+    }
+
+    mapped_pieces_.reset();
+}
+
 std::string tr_torrent_metainfo::make_filename(
     std::string_view dirname,
     std::string_view name,
@@ -5,8 +5,11 @@
 
 #pragma once
 
+#include <algorithm> // std::copy_n()
+#include <cstddef> // std::byte
 #include <cstdint> // uint32_t, uint64_t
 #include <ctime>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -131,16 +134,36 @@ public:
         return is_private_;
     }
 
-    [[nodiscard]] TR_CONSTEXPR_VEC tr_sha1_digest_t const& piece_hash(tr_piece_index_t piece) const
+    [[nodiscard]] tr_sha1_digest_t piece_hash(tr_piece_index_t piece) const
     {
+        if (mapped_pieces_)
+        {
+            auto digest = tr_sha1_digest_t{};
+            std::copy_n(mapped_pieces_.get() + std::size(digest) * piece, std::size(digest), std::data(digest));
+            return digest;
+        }
+
         return pieces_[piece];
     }
 
-    [[nodiscard]] constexpr bool has_v1_metadata() const noexcept
+    // Drop the in-memory copy of the piece hashes and read them on demand
+    // from a read-only memory map of `torrent_filename` instead.
+    // The file must be the same .torrent file that this metainfo was parsed from.
+    bool map_piece_hashes(std::string_view torrent_filename, tr_error* error = nullptr);
+
+    // Copy the piece hashes back into memory and release the file mapping.
+    void unmap_piece_hashes();
+
+    [[nodiscard]] bool piece_hashes_mapped() const noexcept
+    {
+        return mapped_pieces_ != nullptr;
+    }
+
+    [[nodiscard]] bool has_v1_metadata() const noexcept
     {
         // need 'pieces' field and 'files' or 'length'
         // TODO check for 'files' or 'length'
-        return !std::empty(pieces_);
+        return !std::empty(pieces_) || piece_hashes_mapped();
     }
 
     [[nodiscard]] constexpr bool has_v2_metadata() const noexcept
@@ -221,6 +244,13 @@ private:
 
     std::vector<tr_sha1_digest_t> pieces_;
 
+    // Points into a read-only mapping of the .torrent file when the
+    // piece hashes are mapped instead of being held in `pieces_`.
+    std::shared_ptr<std::byte const> mapped_pieces_;
+
+    // Offset of the 'pieces' string's contents in the bencoded data.
+    uint64_t pieces_offset_ = 0;
+
     std::string comment_;
     std::string creator_;
     std::string source_;
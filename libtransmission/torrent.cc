@@ -8,6 +8,7 @@
 #include <cerrno> // EINVAL
 #include <chrono>
 #include <cstddef> // size_t
+#include <cstdint> // uint64_t
 #include <ctime>
 #include <map>
 #include <sstream>
@@ -718,6 +719,7 @@ void tr_torrent::stop_now()
     if (!is_deleting_)
     {
         save_resume_file();
+        maybe_map_piece_hashes();
     }
 
     set_is_queued(false);
@@ -731,6 +733,8 @@ void tr_torrentRemoveInSessionThread(
 {
     auto const lock = tor->unique_lock();
 
+    tor->cancel_relocation();
+
     if (delete_flag && tor->has_metainfo())
     {
         // ensure the files are all closed and idle before moving
@@ -800,6 +804,9 @@ void tr_torrentFreeInSessionThread(tr_torrent* tor)
 
     if (tor->is_deleting_)
     {
+        // some platforms can't remove a file while it's mapped
+        tor->metainfo_.unmap_piece_hashes();
+
         tr_torrent_metainfo::remove_file(tor->session->torrentDir(), tor->name(), tor->info_hash_string(), ".torrent"sv);
         tr_torrent_metainfo::remove_file(tor->session->torrentDir(), tor->name(), tor->info_hash_string(), ".magnet"sv);
         tr_torrent_metainfo::remove_file(tor->session->resumeDir(), tor->name(), tor->info_hash_string(), ".resume"sv);
@@ -1037,6 +1044,8 @@ void tr_torrent::init(tr_ctor const& ctor)
     {
         date_done_ = now_sec;
     }
+
+    maybe_map_piece_hashes();
 }
 
 void tr_torrent::set_metainfo(tr_torrent_metainfo tm)
@@ -1090,6 +1099,180 @@ void tr_torrent::set_location_in_session_thread(std::string_view const path, boo
 {
     TR_ASSERT(session->am_in_session_thread());
 
+    // a new location replaces any move that's still copying files
+    if (relocate_state_ == setme_state)
+    {
+        relocate_state_ = nullptr;
+    }
+    cancel_relocation();
+
+    if (move_from_old_path && relocate_in_background(path, setme_state))
+    {
+        return;
+    }
+
+    finish_set_location(path, move_from_old_path, setme_state);
+}
+
+// Files that are on another device than `path` are copied there by a
+// worker thread while the torrent keeps using the originals, so that
+// the session thread doesn't block on a long copy. The rest are cheap
+// to rename and are moved when the copies are done.
+bool tr_torrent::relocate_in_background(std::string_view const path, int volatile* setme_state)
+{
+    auto const old_parent = current_dir();
+    if (!has_metainfo() || std::empty(old_parent) || tr_sys_path_is_same(old_parent, path))
+    {
+        return false;
+    }
+
+    // A torrent that's downloading keeps writing to its files,
+    // which would leave the copies stale by the time they're done.
+    if (is_running() && !is_done())
+    {
+        return false;
+    }
+
+    // The target needs to exist to tell which device it's on.
+    // If it can't be created, let finish_set_location() report the error.
+    if (!tr_sys_dir_create(path, TR_SYS_DIR_CREATE_PARENTS, 0777))
+    {
+        return false;
+    }
+
+    auto const paths = std::array<std::string_view, 1>{ old_parent.sv() };
+    auto copies = std::vector<tr_relocate_worker::File>{};
+    for (tr_file_index_t i = 0, n = file_count(); i < n; ++i)
+    {
+        auto const found = files().find(i, std::data(paths), std::size(paths));
+        if (!found || tr_sys_path_is_same_device(found->filename(), path))
+        {
+            continue;
+        }
+
+        auto& file = copies.emplace_back();
+        file.index = i;
+        file.src = found->filename();
+        file.dst = fmt::format("{:s}/{:s}", path, found->subpath());
+        file.size = found->size;
+        file.last_modified_at = found->last_modified_at;
+    }
+
+    if (std::empty(copies))
+    {
+        return false;
+    }
+
+    tr_logAddTraceTor(this, fmt::format("Copying {:d} files to '{:s}'", std::size(copies), path));
+
+    relocate_state_ = setme_state;
+    if (setme_state != nullptr)
+    {
+        *setme_state = TR_LOC_MOVING;
+    }
+
+    session->relocate_add(
+        id(),
+        std::string{ path },
+        std::move(copies),
+        [session = session, tor_id = id(), generation = relocation_generation_, n_file_writes = n_file_writes_](
+            tr_relocate_worker::Result&& result)
+        {
+            session->queue_session_thread(
+                [session, tor_id, generation, n_file_writes, result = std::move(result)]()
+                {
+                    if (auto* const tor = session->torrents().get(tor_id);
+                        tor != nullptr && tor->relocation_generation_ == generation)
+                    {
+                        tor->on_relocate_done(result, n_file_writes);
+                        return;
+                    }
+
+                    // the move was cancelled after the copies were made
+                    if (!result.cancelled && !result.error)
+                    {
+                        for (auto const& file : result.files)
+                        {
+                            tr_sys_path_remove(tr_relocate_worker::staging_path(file.dst));
+                        }
+                    }
+                });
+        });
+
+    return true;
+}
+
+void tr_torrent::on_relocate_done(tr_relocate_worker::Result const& result, uint64_t const n_file_writes_before)
+{
+    TR_ASSERT(session->am_in_session_thread());
+
+    auto* const setme_state = std::exchange(relocate_state_, nullptr);
+
+    if (result.cancelled || result.error)
+    {
+        // the torrent's files haven't been touched, so it can keep going
+        if (result.error)
+        {
+            tr_logAddWarnTor(
+                this,
+                fmt::format(
+                    fmt::runtime(_("Couldn't move '{old_path}' to '{path}': {error} ({error_code})")),
+                    fmt::arg("old_path", current_dir()),
+                    fmt::arg("path", result.location),
+                    fmt::arg("error", result.error.message()),
+                    fmt::arg("error_code", result.error.code())));
+        }
+
+        if (setme_state != nullptr)
+        {
+            *setme_state = TR_LOC_ERROR;
+        }
+
+        return;
+    }
+
+    // ensure the files are all closed and idle before switching
+    session->close_torrent_files(id());
+    session->verify_remove(this);
+
+    // Size and mtime alone can miss a write, e.g. to a preallocated file
+    // in the same second that it was queued, so also check whether the
+    // torrent wrote anything while the copies were being made.
+    auto const was_written = n_file_writes_ != n_file_writes_before;
+    for (auto const& file : result.files)
+    {
+        auto const staged = tr_relocate_worker::staging_path(file.dst);
+        auto const info = tr_sys_path_get_info(file.src);
+        auto const unchanged = !was_written && info && info->size == file.size &&
+            info->last_modified_at == file.last_modified_at;
+        if (unchanged && tr_sys_path_rename(staged, file.dst))
+        {
+            tr_sys_path_remove(file.src);
+        }
+        else
+        {
+            // The file changed while it was being copied, so the copy is stale.
+            // Leave the original for finish_set_location() to move.
+            tr_sys_path_remove(staged);
+        }
+    }
+
+    finish_set_location(result.location, true, setme_state);
+}
+
+void tr_torrent::cancel_relocation()
+{
+    ++relocation_generation_;
+    session->relocate_cancel(id());
+
+    if (auto* const setme_state = std::exchange(relocate_state_, nullptr); setme_state != nullptr)
+    {
+        *setme_state = TR_LOC_ERROR;
+    }
+}
+
+void tr_torrent::finish_set_location(std::string_view const path, bool move_from_old_path, int volatile* setme_state)
+{
     auto ok = true;
     if (move_from_old_path)
     {
@@ -1881,8 +2064,61 @@ void tr_torrent::recheck_completeness()
         {
             save_resume_file();
             callScriptIfEnabled(this, TR_SCRIPT_ON_TORRENT_DONE);
+            maybe_map_piece_hashes();
         }
     }
+
+    maybe_unmap_piece_hashes();
+}
+
+// Seeding and paused torrents rarely need their piece hashes,
+// so read them from the .torrent file on demand instead of keeping them in RAM.
+void tr_torrent::maybe_map_piece_hashes()
+{
+    if (!session->shouldMapPieceHashes() || !has_metainfo() || metainfo_.piece_hashes_mapped())
+    {
+        return;
+    }
+
+    // the verify worker may be reading the hashes from another thread
+    if (verify_state_ != VerifyState::None)
+    {
+        return;
+    }
+
+    if (is_running() && !is_done())
+    {
+        return;
+    }
+
+    if (auto error = tr_error{}; !metainfo_.map_piece_hashes(torrent_file(), &error))
+    {
+        tr_logAddDebugTor(this, fmt::format("Couldn't map piece hashes: {} ({})", error.message(), error.code()));
+    }
+}
+
+// Downloading torrents check every piece they receive, so once a torrent
+// is downloading again (e.g. after a recheck, or when more files are wanted)
+// its piece hashes go back into RAM.
+void tr_torrent::maybe_unmap_piece_hashes()
+{
+    if (!metainfo_.piece_hashes_mapped())
+    {
+        return;
+    }
+
+    // the verify worker may be reading the hashes from another thread
+    if (verify_state_ != VerifyState::None)
+    {
+        return;
+    }
+
+    if (!is_running() || is_done())
+    {
+        return;
+    }
+
+    metainfo_.unmap_piece_hashes();
 }
 
 // --- File DND
@@ -2554,6 +2790,19 @@ void tr_torrent::mark_changed()
     this->bump_date_changed(tr_time());
 }
 
+uint64_t tr_torrent::observe_field(tr_quark const key, size_t const digest)
+{
+    auto& state = observed_fields_[key];
+
+    if (state.changed_at_epoch == 0U || state.digest != digest)
+    {
+        state.changed_at_epoch = session->torrents().bump_change_epoch();
+        state.digest = digest;
+    }
+
+    return state.changed_at_epoch;
+}
+
 [[nodiscard]] bool tr_torrent::ensure_piece_is_checked(tr_piece_index_t piece)
 {
     TR_ASSERT(piece < this->piece_count());
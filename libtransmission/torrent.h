@@ -9,10 +9,12 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <array>
 #include <cstddef> // size_t
 #include <cstdint> // uint64_t, uint16_t
 #include <ctime>
 #include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <span>
@@ -32,6 +34,8 @@
 #include "libtransmission/file-piece-map.h"
 #include "libtransmission/interned-string.h"
 #include "libtransmission/log.h"
+#include "libtransmission/quark.h"
+#include "libtransmission/relocate.h"
 #include "libtransmission/session.h"
 #include "libtransmission/torrent-files.h"
 #include "libtransmission/torrent-magnet.h"
@@ -181,6 +185,17 @@ struct tr_torrent
 
     void set_location(std::string_view location, bool move_from_old_path, int volatile* setme_state);
 
+    // Stops a move that's still copying files to another device.
+    // The torrent stays where it was.
+    void cancel_relocation();
+
+    // Called whenever the torrent's files are written to,
+    // so that a background move can tell if its copies are stale.
+    constexpr void mark_files_written() noexcept
+    {
+        ++n_file_writes_;
+    }
+
     void rename_path(std::string_view oldpath, std::string_view newname, tr_torrent_rename_done_func&& callback);
 
     // these functions should become private when possible,
@@ -214,7 +229,7 @@ struct tr_torrent
         return bandwidth_;
     }
 
-    constexpr void set_speed_limit(tr_direction dir, Speed limit)
+    void set_speed_limit(tr_direction dir, Speed limit)
     {
         if (bandwidth().set_desired_speed(dir, limit))
         {
@@ -222,7 +237,7 @@ struct tr_torrent
         }
     }
 
-    constexpr void use_speed_limit(tr_direction dir, bool do_use)
+    void use_speed_limit(tr_direction dir, bool do_use)
     {
         if (bandwidth().set_limited(dir, do_use))
         {
@@ -656,7 +671,7 @@ struct tr_torrent
         return is_queued_ && dir == queue_direction();
     }
 
-    void set_is_queued(bool queued = true) noexcept
+    void set_is_queued(bool queued = true)
     {
         if (is_queued_ != queued)
         {
@@ -705,9 +720,14 @@ struct tr_torrent
         TR_ASSERT(unique_id_ == tr_torrent_id_t{});
         TR_ASSERT(id != tr_torrent_id_t{});
         unique_id_ = id;
+
+        if (is_dirty_)
+        {
+            session->torrents().mark_dirty(unique_id_);
+        }
     }
 
-    constexpr void set_date_active(time_t when) noexcept
+    void set_date_active(time_t when)
     {
         this->date_active_ = when;
 
@@ -756,7 +776,7 @@ struct tr_torrent
         torrent's content than any other mime-type. */
     [[nodiscard]] std::string_view primary_mime_type() const;
 
-    void set_sequential_download(bool is_sequential) noexcept
+    void set_sequential_download(bool is_sequential)
     {
         if (is_sequential != sequential_download_)
         {
@@ -810,6 +830,24 @@ struct tr_torrent
         return date_changed_ > when;
     }
 
+    // torrent_get's fields, grouped so that RPC clients
+    // can ask for just the groups that changed
+    enum class FieldGroup : uint8_t
+    {
+        Stats,
+        Peers,
+        Files,
+        Trackers,
+        Metadata
+    };
+
+    static auto constexpr NFieldGroups = size_t{ 5U };
+
+    // Records `digest` as a hash of a torrent_get field's current value.
+    // Returns the change epoch (see tr_torrents::change_epoch())
+    // at which the field's value last changed.
+    uint64_t observe_field(tr_quark key, size_t digest);
+
     void set_bandwidth_group(std::string_view group_name) noexcept;
 
     [[nodiscard]] constexpr auto get_priority() const noexcept
@@ -827,7 +865,7 @@ struct tr_torrent
         return max_connected_peers_;
     }
 
-    constexpr void set_peer_limit(uint16_t val) noexcept
+    void set_peer_limit(uint16_t val)
     {
         if (max_connected_peers_ != val)
         {
@@ -838,7 +876,7 @@ struct tr_torrent
 
     // --- idleness
 
-    void set_idle_limit_mode(tr_idlelimit mode) noexcept
+    void set_idle_limit_mode(tr_idlelimit mode)
     {
         auto const is_valid = mode == TR_IDLELIMIT_GLOBAL || mode == TR_IDLELIMIT_SINGLE || mode == TR_IDLELIMIT_UNLIMITED;
         TR_ASSERT(is_valid);
@@ -854,7 +892,7 @@ struct tr_torrent
         return idle_limit_mode_;
     }
 
-    constexpr void set_idle_limit_minutes(uint16_t idle_minutes) noexcept
+    void set_idle_limit_minutes(uint16_t idle_minutes)
     {
         if ((idle_limit_minutes_ != idle_minutes) && (idle_minutes > 0))
         {
@@ -885,7 +923,7 @@ struct tr_torrent
 
     // --- seed ratio
 
-    constexpr void set_seed_ratio_mode(tr_ratiolimit mode) noexcept
+    void set_seed_ratio_mode(tr_ratiolimit mode)
     {
         auto const is_valid = mode == TR_RATIOLIMIT_GLOBAL || mode == TR_RATIOLIMIT_SINGLE || mode == TR_RATIOLIMIT_UNLIMITED;
         TR_ASSERT(is_valid);
@@ -901,7 +939,7 @@ struct tr_torrent
         return seed_ratio_mode_;
     }
 
-    constexpr void set_seed_ratio(double desired_ratio)
+    void set_seed_ratio(double desired_ratio)
     {
         if (static_cast<int>(seed_ratio_ * 100.0) != static_cast<int>(desired_ratio * 100.0))
         {
@@ -1055,6 +1093,7 @@ private:
     friend void tr_torrentStop(tr_torrent* tor);
     friend void tr_torrentUseSessionLimits(tr_torrent* tor, bool enabled);
     friend void tr_torrentVerify(tr_torrent* tor);
+    friend class tr_torrents;
 
     enum class VerifyState : uint8_t
     {
@@ -1305,8 +1344,13 @@ private:
 
     void mark_edited();
 
-    constexpr void set_dirty(bool dirty = true) noexcept
+    void set_dirty(bool dirty = true)
     {
+        if (dirty && !is_dirty_ && unique_id_ != tr_torrent_id_t{})
+        {
+            session->torrents().mark_dirty(unique_id_);
+        }
+
         is_dirty_ = dirty;
     }
 
@@ -1327,12 +1371,17 @@ private:
 
     void create_empty_files() const;
     void recheck_completeness();
+    void maybe_map_piece_hashes();
+    void maybe_unmap_piece_hashes();
 
     [[nodiscard]] bool use_new_metainfo(tr_error* error);
 
     void update_file_path(tr_file_index_t file, std::optional<bool> has_file) const;
 
     void set_location_in_session_thread(std::string_view path, bool move_from_old_path, int volatile* setme_state);
+    void finish_set_location(std::string_view path, bool move_from_old_path, int volatile* setme_state);
+    [[nodiscard]] bool relocate_in_background(std::string_view path, int volatile* setme_state);
+    void on_relocate_done(tr_relocate_worker::Result const& result, uint64_t n_file_writes_before);
 
     void rename_path_in_session_thread(
         std::string_view oldpath,
@@ -1403,6 +1452,15 @@ private:
      */
     tr_peer_id_t peer_id_ = tr_peerIdInit();
 
+    struct ObservedField
+    {
+        uint64_t changed_at_epoch = {};
+        size_t digest = {};
+    };
+
+    // the torrent_get fields that RPC clients have asked for changes to
+    std::map<tr_quark, ObservedField> observed_fields_;
+
     time_t date_active_ = 0;
     time_t date_added_ = 0;
     time_t date_changed_ = 0;
@@ -1420,6 +1478,14 @@ private:
 
     tr_torrent_id_t unique_id_ = 0;
 
+    // A background move's state, and a counter that's bumped whenever
+    // one is cancelled so that its late completion can be ignored.
+    int volatile* relocate_state_ = nullptr;
+    uint32_t relocation_generation_ = 0;
+
+    // how many times the torrent's files have been written to
+    uint64_t n_file_writes_ = 0;
+
     tr_ratiolimit seed_ratio_mode_ = TR_RATIOLIMIT_GLOBAL;
 
     tr_idlelimit idle_limit_mode_ = TR_IDLELIMIT_GLOBAL;
@@ -4,8 +4,14 @@
 // License text can be found in the licenses/ folder.
 
 #include <algorithm>
+#include <cstdint> // uint64_t
+#include <cstddef> // size_t
 #include <ctime>
+#include <functional>
+#include <iterator> // std::back_inserter
+#include <optional>
 #include <string_view>
+#include <utility> // std::exchange
 #include <vector>
 
 #include "libtransmission/magnet-metainfo.h"
@@ -14,44 +20,96 @@
 #include "libtransmission/tr-assert.h"
 #include "libtransmission/types.h"
 
-namespace
+std::optional<size_t> tr_torrents::HashIndex::find(tr_sha1_digest_t const& hash) const noexcept
 {
+    if (std::empty(slots_))
+    {
+        return {};
+    }
+
+    auto const& slot = slots_[probe(hash)];
+    return slot.pos == Empty ? std::nullopt : std::optional{ slot.pos };
+}
 
-constexpr struct
+void tr_torrents::HashIndex::insert_or_assign(tr_sha1_digest_t const& hash, size_t const pos)
 {
-    bool operator()(tr_sha1_digest_t const& a, tr_sha1_digest_t const& b) const
+    TR_ASSERT(pos != Empty);
+
+    if ((size_ + 1U) * 2U > std::size(slots_))
     {
-        return a < b;
+        grow();
     }
 
-    bool operator()(tr_torrent const* a, tr_torrent const* b) const
+    auto& slot = slots_[probe(hash)];
+    if (slot.pos == Empty)
     {
-        return (*this)(a->info_hash(), b->info_hash());
+        slot.hash = hash;
+        ++size_;
     }
+    slot.pos = pos;
+}
 
-    bool operator()(tr_torrent const* a, tr_sha1_digest_t const& b) const
+void tr_torrents::HashIndex::erase(tr_sha1_digest_t const& hash) noexcept
+{
+    if (std::empty(slots_))
     {
-        return (*this)(a->info_hash(), b);
+        return;
     }
 
-    bool operator()(tr_sha1_digest_t const& a, tr_torrent const* b) const
+    auto hole = probe(hash);
+    if (slots_[hole].pos == Empty)
     {
-        return (*this)(a, b->info_hash());
+        return;
     }
-} CompareTorrentByHash{};
 
-} // namespace
+    slots_[hole].pos = Empty;
+    --size_;
 
-tr_torrent* tr_torrents::get(std::string_view magnet_link) const
+    // Move later entries of the same probe run back into the hole so
+    // that every entry is still reachable from its home slot.
+    for (auto idx = next(hole); slots_[idx].pos != Empty; idx = next(idx))
+    {
+        auto const home_idx = home(slots_[idx].hash);
+        auto const is_between = hole <= idx ? hole < home_idx && home_idx <= idx : hole < home_idx || home_idx <= idx;
+        if (is_between)
+        {
+            continue;
+        }
+
+        slots_[hole] = slots_[idx];
+        slots_[idx].pos = Empty;
+        hole = idx;
+    }
+}
+
+size_t tr_torrents::HashIndex::probe(tr_sha1_digest_t const& hash) const noexcept
 {
-    auto magnet = tr_magnet_metainfo{};
-    return magnet.parseMagnet(magnet_link) ? get(magnet.info_hash()) : nullptr;
+    auto idx = home(hash);
+    while (slots_[idx].pos != Empty && slots_[idx].hash != hash)
+    {
+        idx = next(idx);
+    }
+    return idx;
 }
 
-tr_torrent* tr_torrents::get(tr_sha1_digest_t const& hash) const
+void tr_torrents::HashIndex::grow()
 {
-    auto const range = std::ranges::equal_range(by_hash_, hash, CompareTorrentByHash);
-    return range.empty() ? nullptr : range.front();
+    auto const old_slots = std::exchange(slots_, std::vector<Slot>(std::max(MinCapacity, std::size(slots_) * 2U)));
+    for (auto const& slot : old_slots)
+    {
+        if (slot.pos != Empty)
+        {
+            slots_[probe(slot.hash)] = slot;
+        }
+    }
+}
+
+// ---
+
+tr_torrent* tr_torrents::get(std::string_view magnet_link) const
+{
+    auto magnet = tr_magnet_metainfo{};
+    return magnet.parseMagnet(magnet_link) ? get(magnet.info_hash()) : nullptr;
 }
 
 tr_torrent* tr_torrents::find_from_obfuscated_hash(tr_sha1_digest_t const& obfuscated_hash) const
@@ -67,11 +125,32 @@ tr_torrent* tr_torrents::find_from_obfuscated_hash(tr_sha1_digest_t const& obfus
     return nullptr;
 }
 
+std::vector<tr_torrent*> tr_torrents::get_matching(std::function<bool(tr_torrent const*)> const& pred) const
+{
+    auto vec = std::vector<tr_torrent*>{};
+    vec.reserve(size());
+    std::ranges::copy_if(torrents_, std::back_inserter(vec), pred);
+    std::ranges::sort(vec, {}, &tr_torrent::id);
+    return vec;
+}
+
+std::vector<tr_torrent*> tr_torrents::get_all() const
+{
+    auto vec = torrents_;
+    std::ranges::sort(vec, {}, &tr_torrent::id);
+    return vec;
+}
+
 tr_torrent_id_t tr_torrents::add(tr_torrent* tor)
 {
-    auto const id = static_cast<tr_torrent_id_t>(std::size(by_id_));
-    by_id_.push_back(tor);
-    by_hash_.insert(std::ranges::lower_bound(by_hash_, tor, CompareTorrentByHash), tor);
+    TR_ASSERT(tor != nullptr);
+    TR_ASSERT(!contains(tor->info_hash()));
+
+    auto const id = next_id_++;
+    auto const pos = std::size(torrents_);
+    torrents_.push_back(tor);
+    pos_by_id_.try_emplace(id, pos);
+    pos_by_hash_.insert_or_assign(tor->info_hash(), pos);
     return id;
 }
 
@@ -80,10 +159,25 @@ void tr_torrents::remove(tr_torrent const* tor, time_t current_time)
     TR_ASSERT(tor != nullptr);
     TR_ASSERT(get(tor->id()) == tor);
 
-    by_id_[tor->id()] = nullptr;
-    auto const [begin, end] = std::ranges::equal_range(by_hash_, tor, CompareTorrentByHash);
-    by_hash_.erase(begin, end);
-    removed_.emplace_back(tor->id(), current_time);
+    auto const id_iter = pos_by_id_.find(tor->id());
+    if (id_iter == std::end(pos_by_id_))
+    {
+        return;
+    }
+
+    // fill the hole with the last torrent so that `torrents_` stays dense
+    auto const pos = id_iter->second;
+    if (auto* const last = torrents_.back(); last != tor)
+    {
+        torrents_[pos] = last;
+        pos_by_id_[last->id()] = pos;
+        pos_by_hash_.insert_or_assign(last->info_hash(), pos);
+    }
+
+    torrents_.pop_back();
+    pos_by_id_.erase(id_iter);
+    pos_by_hash_.erase(tor->info_hash());
+    removed_.push_back({ tor->id(), current_time, bump_change_epoch() });
 }
 
 std::vector<tr_torrent_id_t> tr_torrents::removedSince(time_t timestamp) const
@@ -91,7 +185,7 @@ std::vector<tr_torrent_id_t> tr_torrents::removedSince(time_t timestamp) const
     auto ids = std::vector<tr_torrent_id_t>{};
     ids.reserve(std::size(removed_));
 
-    for (auto const& [id, removed_at] : removed_)
+    for (auto const& [id, removed_at, epoch] : removed_)
     {
         if (removed_at >= timestamp)
         {
@@ -104,3 +198,35 @@ std::vector<tr_torrent_id_t> tr_torrents::removedSince(time_t timestamp) const
     ids.erase(first, last);
     return ids;
 }
+
+std::vector<tr_torrent_id_t> tr_torrents::removed_since_epoch(uint64_t const epoch) const
+{
+    auto ids = std::vector<tr_torrent_id_t>{};
+
+    // `removed_` is in epoch order, so only its tail can match
+    auto const first = std::ranges::upper_bound(removed_, epoch, {}, &Removed::epoch);
+    ids.reserve(std::distance(first, std::end(removed_)));
+    std::ranges::transform(first, std::end(removed_), std::back_inserter(ids), &Removed::id);
+
+    std::ranges::sort(ids);
+    return ids;
+}
+
+std::vector<tr_torrent*> tr_torrents::pop_dirty(size_t max)
+{
+    auto ret = std::vector<tr_torrent*>{};
+    ret.reserve(std::min(max, std::size(dirty_)));
+
+    while (std::size(ret) < max && !std::empty(dirty_))
+    {
+        auto* const tor = get(dirty_.front());
+        dirty_.pop_front();
+
+        if (tor != nullptr && tor->is_dirty())
+        {
+            ret.emplace_back(tor);
+        }
+    }
+
+    return ret;
+}
@@ -11,10 +11,16 @@
 
 #include <algorithm>
 #include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <cstring> // std::memcpy()
 #include <ctime>
+#include <deque>
 #include <functional>
 #include <iterator>
+#include <limits>
+#include <optional>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -32,14 +38,18 @@ public:
     void remove(tr_torrent const* tor, time_t current_time);
 
     // O(1)
-    [[nodiscard]] constexpr tr_torrent* get(tr_torrent_id_t id) const
+    [[nodiscard]] tr_torrent* get(tr_torrent_id_t id) const
     {
-        auto const uid = static_cast<size_t>(id);
-        return uid >= std::size(by_id_) ? nullptr : by_id_.at(uid);
+        auto const iter = pos_by_id_.find(id);
+        return iter == std::end(pos_by_id_) ? nullptr : torrents_[iter->second];
     }
 
-    // O(log n)
-    [[nodiscard]] tr_torrent* get(tr_sha1_digest_t const& hash) const;
+    // O(1)
+    [[nodiscard]] tr_torrent* get(tr_sha1_digest_t const& hash) const
+    {
+        auto const pos = pos_by_hash_.find(hash);
+        return pos ? torrents_[*pos] : nullptr;
+    }
 
     [[nodiscard]] tr_torrent* get(tr_torrent_metainfo const& metainfo) const
     {
@@ -62,9 +72,40 @@ public:
 
     [[nodiscard]] std::vector<tr_torrent_id_t> removedSince(time_t timestamp) const;
 
+    // A counter that's bumped each time a change is recorded, so that
+    // RPC clients can ask for what changed after the epoch they last saw.
+    [[nodiscard]] constexpr auto change_epoch() const noexcept
+    {
+        return change_epoch_;
+    }
+
+    constexpr uint64_t bump_change_epoch() noexcept
+    {
+        return ++change_epoch_;
+    }
+
+    [[nodiscard]] std::vector<tr_torrent_id_t> removed_since_epoch(uint64_t epoch) const;
+
+    // Queue a torrent whose resume file needs to be saved.
+    // tr_torrent::set_dirty() calls this when a torrent becomes dirty.
+    void mark_dirty(tr_torrent_id_t id)
+    {
+        dirty_.push_back(id);
+    }
+
+    // An upper bound on the number of dirty torrents.
+    [[nodiscard]] auto dirty_count() const noexcept
+    {
+        return std::size(dirty_);
+    }
+
+    // Dequeue up to `max` dirty torrents, in the order they became dirty.
+    // Torrents that have been removed or saved since they were queued are skipped.
+    [[nodiscard]] std::vector<tr_torrent*> pop_dirty(size_t max);
+
     [[nodiscard]] constexpr auto cbegin() const noexcept
     {
-        return std::cbegin(by_hash_);
+        return std::cbegin(torrents_);
     }
     [[nodiscard]] constexpr auto begin() const noexcept
     {
@@ -72,12 +113,12 @@ public:
     }
     [[nodiscard]] constexpr auto begin() noexcept
     {
-        return std::begin(by_hash_);
+        return std::begin(torrents_);
     }
 
     [[nodiscard]] constexpr auto cend() const noexcept
     {
-        return std::cend(by_hash_);
+        return std::cend(torrents_);
     }
 
     [[nodiscard]] constexpr auto end() const noexcept
@@ -87,53 +128,108 @@ public:
 
     [[nodiscard]] constexpr auto end() noexcept
     {
-        return std::end(by_hash_);
+        return std::end(torrents_);
     }
 
     [[nodiscard]] constexpr auto size() const noexcept
     {
-        return std::size(by_hash_);
+        return std::size(torrents_);
     }
 
     [[nodiscard]] constexpr auto empty() const noexcept
     {
-        return std::empty(by_hash_);
+        return std::empty(torrents_);
     }
 
-    [[nodiscard]] auto get_matching(std::function<bool(tr_torrent const*)> pred_in) const
+    // These return the torrents sorted by id, e.g. so that RPC
+    // responses list them in a stable order.
+    [[nodiscard]] std::vector<tr_torrent*> get_matching(std::function<bool(tr_torrent const*)> const& pred) const;
+    [[nodiscard]] std::vector<tr_torrent*> get_all() const;
+
+private:
+    // Info hashes are already uniformly distributed,
+    // so their leading bytes make a perfectly good hash.
+    struct DigestHasher
+    {
+        [[nodiscard]] size_t operator()(tr_sha1_digest_t const& digest) const noexcept
+        {
+            auto ret = size_t{};
+            std::memcpy(&ret, std::data(digest), sizeof(ret));
+            return ret;
+        }
+    };
+
+    // The live torrents, in no particular order. This is kept dense so
+    // that iterating never has to skip over removed torrents: removing a
+    // torrent moves the last torrent into its slot.
+    std::vector<tr_torrent*> torrents_;
+
+    // An open-addressing table from info hash to position in `torrents_`.
+    // Lookups by hash happen for every incoming peer handshake and tracker
+    // or DHT response, so this keeps each one to a probe or two through a
+    // flat array instead of chasing `std::unordered_map`'s per-node lists.
+    // It uses linear probing with backward-shift deletion, so no tombstones
+    // build up as torrents come and go.
+    class HashIndex
     {
-        auto const pred = [&pred_in](tr_torrent const* const tor)
+    public:
+        [[nodiscard]] std::optional<size_t> find(tr_sha1_digest_t const& hash) const noexcept;
+        void insert_or_assign(tr_sha1_digest_t const& hash, size_t pos);
+        void erase(tr_sha1_digest_t const& hash) noexcept;
+
+    private:
+        static auto constexpr MinCapacity = size_t{ 16U };
+        static auto constexpr Empty = std::numeric_limits<size_t>::max();
+
+        struct Slot
         {
-            return tor != nullptr && pred_in(tor);
+            tr_sha1_digest_t hash = {};
+            size_t pos = Empty;
         };
 
-        auto vec = std::vector<tr_torrent*>{};
-        vec.reserve(size());
-        std::ranges::copy_if(by_id_, std::back_inserter(vec), pred);
-        return vec;
-    }
+        [[nodiscard]] size_t home(tr_sha1_digest_t const& hash) const noexcept
+        {
+            return DigestHasher{}(hash) & (std::size(slots_) - 1U);
+        }
+
+        [[nodiscard]] size_t next(size_t const idx) const noexcept
+        {
+            return (idx + 1U) & (std::size(slots_) - 1U);
+        }
 
-    [[nodiscard]] auto get_all() const
+        // returns the slot holding `hash`, or the empty slot where it would go
+        [[nodiscard]] size_t probe(tr_sha1_digest_t const& hash) const noexcept;
+
+        void grow();
+
+        // always a power of two, and at most half full
+        std::vector<Slot> slots_;
+        size_t size_ = 0U;
+    };
+
+    // Lookup tables into `torrents_`. IDs are looked up far less often than
+    // hashes, so a plain `std::unordered_map` is good enough for them.
+    std::unordered_map<tr_torrent_id_t, size_t> pos_by_id_;
+    HashIndex pos_by_hash_;
+
+    // IDs are never reused, since they are exported in the RPC API.
+    // Start at 1 to ensure that every torrent has a positive ID number.
+    // This constraint isn't needed by libtransmission code but 3rd party
+    // RPC clients may be testing for >0 as a validity check.
+    tr_torrent_id_t next_id_ = 1;
+
+    struct Removed
     {
-        return get_matching([](tr_torrent const*) { return true; });
-    }
+        tr_torrent_id_t id = {};
+        time_t removed_at = {};
+        uint64_t epoch = {};
+    };
 
-private:
-    std::vector<tr_torrent*> by_hash_;
-
-    // This is a lookup table where by_id_[id]->id() == id.
-    // There is a small tradeoff here -- lookup is O(1) at the cost
-    // of a wasted slot in the lookup table whenever a torrent is
-    // removed. This improves speed for all use cases at the cost of
-    // wasting a small amount of memory in uncommon use cases, e.g. a
-    // long-lived session where thousands of torrents are removed.
-    //
-    // Insert an empty pointer at by_id_[0] to ensure that the first
-    // added torrent doesn't get an ID of 0; ie, that every torrent has
-    // a positive ID number. This constraint isn't needed by libtransmission
-    // code but the ID is exported in the RPC API to 3rd party clients that
-    // may be testing for >0 as a validity check.
-    std::vector<tr_torrent*> by_id_{ nullptr };
-
-    std::vector<std::pair<tr_torrent_id_t, time_t>> removed_;
+    std::vector<Removed> removed_;
+
+    uint64_t change_epoch_ = 0U;
+
+    // Torrents waiting for their resume files to be saved, oldest first.
+    // This holds ids rather than pointers so that removed torrents can't dangle.
+    std::deque<tr_torrent_id_t> dirty_;
 };
@@ -13,7 +13,9 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <numeric> // std::accumulate()
 #include <ranges>
+#include <set>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -146,6 +148,7 @@ public:
         , announce_timer_{ mediator_.timer_maker().create([this]() { on_announce_timer(); }) }
         , bootstrap_timer_{ mediator_.timer_maker().create([this]() { on_bootstrap_timer(); }) }
         , periodic_timer_{ mediator_.timer_maker().create([this]() { on_periodic_timer(); }) }
+        , save_timer_{ mediator_.timer_maker().create([this]() { maybe_save_state(); }) }
     {
         tr_logAddDebug(fmt::format("Starting DHT on port {port}", fmt::arg("port", peer_port.host())));
 
@@ -161,10 +164,24 @@ public:
 
         mediator_.api().init(static_cast<int>(udp4_socket_), static_cast<int>(udp6_socket_), std::data(id_), nullptr);
 
+        // The nodes saved in the state file were good when we saved them,
+        // so ping them all at once instead of trickling them in with the
+        // bootstrap nodes. Most of them answer, which gets a warm start to
+        // a usable routing table within a few round trips.
+        for (auto const& [address, port] : saved_nodes_)
+        {
+            maybe_add_node(address, port);
+        }
+        saved_nodes_.clear();
+
         on_announce_timer();
-        announce_timer_->start_repeating(1s);
+        announce_timer_->start_repeating(AnnounceTimerInterval);
 
         on_periodic_timer();
+
+        // Snapshot the routing table now and then, so that an unclean
+        // shutdown doesn't cost us the whole table on the next start.
+        save_timer_->start_repeating(SaveStateInterval);
     }
 
     tr_dht_impl(tr_dht_impl&&) = delete;
@@ -176,12 +193,7 @@ public:
     {
         tr_logAddTrace("Uninitializing DHT");
 
-        // Since we only save known good nodes,
-        // only overwrite older data if we know enough nodes.
-        if (is_ready(AF_INET) || is_ready(AF_INET6))
-        {
-            save_state();
-        }
+        maybe_save_state();
 
         mediator_.api().uninit();
         tr_logAddTrace("Done uninitializing DHT");
@@ -328,17 +340,82 @@ private:
 
     ///
 
+    [[nodiscard]] size_t announce_queue_depth() const noexcept override
+    {
+        return std::size(announce_queue_);
+    }
+
+    [[nodiscard]] double searches_per_second() const noexcept override
+    {
+        auto const n_searches = std::accumulate(std::begin(searches_per_tick_), std::end(searches_per_tick_), size_t{});
+        return static_cast<double>(n_searches) / static_cast<double>(std::size(searches_per_tick_));
+    }
+
+    ///
+
     [[nodiscard]] auto announce_torrent(tr_sha1_digest_t const& info_hash, int af, tr_port port)
     {
         auto const* dht_hash = reinterpret_cast<unsigned char const*>(std::data(info_hash));
         auto const rc = mediator_.api().search(dht_hash, port.host(), af, callback, this);
         auto const announce_again_in_n_secs = rc < 0 ? 5s + std::chrono::seconds{ tr_rand_int(5U) } :
-                                                       25min + std::chrono::seconds{ tr_rand_int(3U * 60U) };
-        return announce_again_in_n_secs;
+                                                       AnnounceInterval + std::chrono::seconds{ tr_rand_int(3U * 60U) };
+        return std::pair{ rc >= 0, announce_again_in_n_secs };
+    }
+
+    // Aim to announce every torrent once per AnnounceInterval, spread evenly
+    // across the interval, but never fast enough to overwhelm libdht's search
+    // slots or our socket buffers. If there are too many torrents to keep up,
+    // each of them just gets announced a little less often.
+    [[nodiscard]] size_t search_budget(size_t n_torrents) const noexcept
+    {
+        static auto constexpr MinSearchesPerTick = size_t{ 4U };
+        static auto constexpr MaxSearchesPerTick = size_t{ 16U };
+        static auto constexpr TicksPerInterval = static_cast<size_t>(AnnounceInterval / AnnounceTimerInterval);
+
+        auto const n_searches = n_torrents * 2U; // IPv4 + IPv6
+        auto const wanted = (n_searches + TicksPerInterval - 1U) / TicksPerInterval;
+        return std::clamp(wanted, MinSearchesPerTick, MaxSearchesPerTick);
+    }
+
+    void enqueue_due_announces(time_t const now)
+    {
+        auto const ids = mediator_.torrents_allowing_dht();
+
+        for (auto const id : ids)
+        {
+            auto& info = announce_times_[id];
+            info.seen_at_tick = announce_tick_;
+
+            for (auto const af : { AF_INET, AF_INET6 })
+            {
+                if (auto& family = info.family(af); !family.queued && family.announce_after < now)
+                {
+                    family.queued = true;
+                    announce_queue_.insert({ .priority = mediator_.torrent_announce_priority(id),
+                                             .due = family.announce_after,
+                                             .id = id,
+                                             .af = af });
+                }
+            }
+        }
+
+        // Forget the torrents that were removed or no longer allow DHT,
+        // so that they're announced afresh if they're allowed again.
+        if (std::size(announce_times_) > std::size(ids))
+        {
+            std::erase_if(announce_times_, [this](auto const& item) { return item.second.seen_at_tick != announce_tick_; });
+            std::erase_if(announce_queue_, [this](auto const& queued) { return !announce_times_.contains(queued.id); });
+        }
+
+        budget_ = search_budget(std::size(ids));
     }
 
     void on_announce_timer()
     {
+        ++announce_tick_;
+        auto& n_searches = searches_per_tick_[announce_tick_ % std::size(searches_per_tick_)];
+        n_searches = 0U;
+
         // don't announce if the swarm isn't ready
         if (swarm_status(AF_INET) < SwarmStatus::Poor && swarm_status(AF_INET6) < SwarmStatus::Poor)
         {
@@ -346,20 +423,35 @@ private:
         }
 
         auto const now = tr_time();
-        for (auto const id : mediator_.torrents_allowing_dht())
+        enqueue_due_announces(now);
+
+        while (n_searches < budget_ && !std::empty(announce_queue_))
         {
-            auto& times = announce_times_[id];
+            auto const [priority, due, id, af] = *std::begin(announce_queue_);
+            announce_queue_.erase(std::begin(announce_queue_));
 
-            if (auto& announce_after = times.ipv4_announce_after; announce_after < now)
+            auto const iter = announce_times_.find(id);
+            if (iter == std::end(announce_times_))
             {
-                auto const announce_again_in_n_secs = announce_torrent(mediator_.torrent_info_hash(id), AF_INET, peer_port_);
-                announce_after = now + std::chrono::seconds{ announce_again_in_n_secs }.count();
+                continue;
             }
 
-            if (auto& announce_after = times.ipv6_announce_after; announce_after < now)
+            auto& family = iter->second.family(af);
+            family.queued = false;
+            if (iter->second.seen_at_tick != announce_tick_)
             {
-                auto const announce_again_in_n_secs = announce_torrent(mediator_.torrent_info_hash(id), AF_INET6, peer_port_);
-                announce_after = now + std::chrono::seconds{ announce_again_in_n_secs }.count();
+                // the torrent no longer allows DHT
+                continue;
+            }
+
+            auto const [ok, announce_again_in_n_secs] = announce_torrent(mediator_.torrent_info_hash(id), af, peer_port_);
+            family.announce_after = now + std::chrono::seconds{ announce_again_in_n_secs }.count();
+            ++n_searches;
+
+            if (!ok)
+            {
+                // libdht's search slots are full, so try again next tick
+                break;
             }
         }
     }
@@ -422,6 +514,18 @@ private:
 
     ///
 
+    void maybe_save_state() const
+    {
+        // Since we only save known good nodes,
+        // only overwrite older data if we know enough nodes.
+        if (is_ready(AF_INET) || is_ready(AF_INET6))
+        {
+            save_state();
+        }
+    }
+
+    // N.B. this is atomic: tr_file_save() writes to a temporary file
+    // and then renames it over the old state file.
     void save_state() const
     {
         static auto constexpr MaxNodes = 300;
@@ -523,7 +627,7 @@ private:
                 auto port = tr_port{};
                 std::tie(addr, walk) = tr_address::from_compact_ipv4(walk);
                 std::tie(port, walk) = tr_port::from_compact(walk);
-                bootstrap_queue_.emplace_back(addr, port);
+                saved_nodes_.emplace_back(addr, port);
             }
         }
 
@@ -537,7 +641,7 @@ private:
                 auto port = tr_port{};
                 std::tie(addr, walk) = tr_address::from_compact_ipv6(walk);
                 std::tie(port, walk) = tr_port::from_compact(walk);
-                bootstrap_queue_.emplace_back(addr, port);
+                saved_nodes_.emplace_back(addr, port);
             }
         }
     }
@@ -620,20 +724,62 @@ private:
     std::unique_ptr<tr::Timer> const announce_timer_;
     std::unique_ptr<tr::Timer> const bootstrap_timer_;
     std::unique_ptr<tr::Timer> const periodic_timer_;
+    std::unique_ptr<tr::Timer> const save_timer_;
+
+    static auto constexpr SaveStateInterval = std::chrono::minutes{ 5 };
 
     Id id_ = {};
     int64_t id_timestamp_ = {};
 
+    Nodes saved_nodes_;
     Nodes bootstrap_queue_;
     size_t n_bootstrapped_ = 0;
 
+    static auto constexpr AnnounceInterval = std::chrono::seconds{ 25min };
+    static auto constexpr AnnounceTimerInterval = std::chrono::seconds{ 1s };
+
     struct AnnounceInfo
     {
-        time_t ipv4_announce_after = 0;
-        time_t ipv6_announce_after = 0;
+        struct Family
+        {
+            time_t announce_after = 0;
+            bool queued = false;
+        };
+
+        [[nodiscard]] constexpr Family& family(int af) noexcept
+        {
+            return af == AF_INET ? ipv4 : ipv6;
+        }
+
+        Family ipv4;
+        Family ipv6;
+
+        // the last announce tick that this torrent allowed DHT
+        uint64_t seen_at_tick = 0;
+    };
+
+    // A due announce that's waiting for the search budget.
+    // Higher priorities go first, then the longest-overdue.
+    struct QueuedAnnounce
+    {
+        int priority = 0;
+        time_t due = 0;
+        tr_torrent_id_t id = {};
+        int af = AF_INET;
+
+        [[nodiscard]] bool operator<(QueuedAnnounce const& that) const noexcept
+        {
+            return std::tie(that.priority, due, id, af) < std::tie(priority, that.due, that.id, that.af);
+        }
     };
 
     std::map<tr_torrent_id_t, AnnounceInfo> announce_times_;
+    std::set<QueuedAnnounce> announce_queue_;
+    uint64_t announce_tick_ = 0;
+    size_t budget_ = 0;
+
+    // how many searches were started in each of the last 60 ticks
+    std::array<size_t, 60> searches_per_tick_ = {};
 };
 
 [[nodiscard]] std::unique_ptr<tr_dht> tr_dht::create(
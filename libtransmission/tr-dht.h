@@ -92,6 +92,13 @@ public:
         [[nodiscard]] virtual std::vector<tr_torrent_id_t> torrents_allowing_dht() const = 0;
         [[nodiscard]] virtual tr_sha1_digest_t torrent_info_hash(tr_torrent_id_t) const = 0;
 
+        // When there are more announces due than the search budget allows,
+        // torrents with a higher priority are announced first.
+        [[nodiscard]] virtual int torrent_announce_priority(tr_torrent_id_t /*id*/) const
+        {
+            return 0;
+        }
+
         [[nodiscard]] virtual std::string_view config_dir() const = 0;
         [[nodiscard]] virtual tr::TimerMaker& timer_maker() = 0;
         [[nodiscard]] virtual API& api()
@@ -114,4 +121,10 @@ public:
 
     virtual void maybe_add_node(tr_address const& address, tr_port port) = 0;
     virtual void handle_message(unsigned char const* msg, size_t msglen, struct sockaddr* from, socklen_t fromlen) = 0;
+
+    // number of announces that are due but waiting for the search budget
+    [[nodiscard]] virtual size_t announce_queue_depth() const noexcept = 0;
+
+    // average number of DHT searches started per second over the last minute
+    [[nodiscard]] virtual double searches_per_second() const noexcept = 0;
 };
@@ -9,6 +9,7 @@
 #include <cstdint> // uint16_t
 #include <cstring>
 #include <ctime> // time_t
+#include <functional> // std::not_fn()
 #include <memory>
 #include <optional>
 #include <ranges>
@@ -523,17 +524,31 @@ private:
         {
             return;
         }
+
+        auto shares_a_torrent = false;
         for (auto const& hash_string : parsed->info_hash_strings)
         {
-            if (!mediator_.onPeerFound(hash_string, peer_sockaddr->address(), parsed->port))
+            if (mediator_.onPeerFound(hash_string, peer_sockaddr->address(), parsed->port))
+            {
+                shares_a_torrent = true;
+            }
+            else
             {
                 tr_logAddDebug(fmt::format("Cannot serve torrent #{:s}", hash_string));
             }
         }
+
+        if (shares_a_torrent)
+        {
+            lan_peers_.note(peer_sockaddr->address(), tr_time());
+        }
     }
 
     void announceUpkeep()
     {
+        auto const now = tr_time();
+        lan_peers_.prune(now);
+
         if (!mediator_.allowsLPD())
         {
             return;
@@ -542,7 +557,6 @@ private:
         auto torrents = mediator_.torrents();
 
         // remove torrents that don't need to be announced
-        auto const now = tr_time();
         auto const needs_announce = [&now](auto& info)
         {
             return info.allows_lpd && (info.activity == TR_STATUS_DOWNLOAD || info.activity == TR_STATUS_SEED) &&
@@ -571,7 +585,7 @@ private:
         };
         std::ranges::sort(torrents, TorrentComparator);
 
-        auto const next_announce_after = now + TorrentAnnounceIntervalSec;
+        auto const next_announce_after = now + lan_peers_.announce_interval();
         for (ipp_t ipp = 0; ipp < NUM_TR_AF_INET_TYPES; ++ipp)
         {
             auto const ip_protocol = static_cast<tr_address_type>(ipp);
@@ -666,6 +680,8 @@ private:
     static auto constexpr AnnounceInterval = 1min;
     std::unique_ptr<tr::Timer> announce_timer_;
 
+    LanPeers lan_peers_;
+
     // Flood Protection:
     // To protect against message flooding, stop processing search messages
     // after processing N per upkeep. If we hit that limit, we're either
@@ -678,11 +694,29 @@ private:
         MaxIncomingPerSecond;
     size_t messages_received_since_upkeep_ = 0U; // throw away messages after this number exceeds MaxIncomingPerUpkeep
 
-    static auto constexpr TorrentAnnounceIntervalSec = time_t{ 240U }; // how frequently to reannounce the same torrent
     static auto constexpr TtlSameSubnet = 1;
     static auto constexpr AnnounceScope = int{ TtlSameSubnet }; // the maximum scope for LPD datagrams
 };
 
+void tr_lpd::LanPeers::note(tr_address const& address, time_t const now)
+{
+    if (std::size(peers_) < MaxPeers || peers_.contains(address))
+    {
+        peers_[address] = now;
+    }
+}
+
+void tr_lpd::LanPeers::prune(time_t const now)
+{
+    std::erase_if(peers_, [now](auto const& item) { return item.second + TtlSec < now; });
+}
+
+time_t tr_lpd::LanPeers::announce_interval() const noexcept
+{
+    auto const n_steps = static_cast<time_t>(std::size(peers_) / PeersPerIntervalStep);
+    return std::min(MinAnnounceIntervalSec * (1 + n_steps), MaxAnnounceIntervalSec);
+}
+
 std::unique_ptr<tr_lpd> tr_lpd::create(Mediator& mediator, struct event_base* event_base)
 {
     return std::make_unique<tr_lpd_impl>(mediator, event_base);
@@ -9,7 +9,9 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <cstddef> // size_t
 #include <ctime>
+#include <map>
 #include <memory>
 #include <string_view>
 #include <vector>
@@ -55,6 +57,38 @@ public:
         virtual bool onPeerFound(std::string_view info_hash_str, tr_address address, tr_port port) = 0;
     };
 
+    // LPD peers that recently announced a torrent that we have too.
+    // The more of them there are, the more likely each of our torrents
+    // is to be found through somebody else's announce, so we reannounce
+    // less often to keep the multicast traffic from growing with the LAN.
+    // Only peers that announce a torrent we have are counted, so spoofed
+    // announces for made-up torrents can't stretch the interval.
+    class LanPeers
+    {
+    public:
+        static auto constexpr TtlSec = time_t{ 600U };
+        static auto constexpr MaxPeers = size_t{ 256U };
+        static auto constexpr PeersPerIntervalStep = size_t{ 8U };
+        static auto constexpr MinAnnounceIntervalSec = time_t{ 240U };
+        static auto constexpr MaxAnnounceIntervalSec = time_t{ 3600U };
+
+        void note(tr_address const& address, time_t now);
+
+        void prune(time_t now);
+
+        [[nodiscard]] auto size() const noexcept
+        {
+            return std::size(peers_);
+        }
+
+        // how often to reannounce the same torrent
+        [[nodiscard]] time_t announce_interval() const noexcept;
+
+    private:
+        // when we last heard from each peer
+        std::map<tr_address, time_t> peers_;
+    };
+
     virtual ~tr_lpd() = default;
     static std::unique_ptr<tr_lpd> create(Mediator& mediator, event_base* event_base);
 };
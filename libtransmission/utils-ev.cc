@@ -3,8 +3,10 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <event2/bufferevent.h>
 #include <event2/event.h>
 #include <event2/http.h>
+#include <event2/listener.h>
 
 #include "libtransmission/utils-ev.h"
 
@@ -36,6 +38,22 @@ void EvhttpDeleter::operator()(struct evhttp* evh) const noexcept
     }
 }
 
+void EvconnlistenerDeleter::operator()(struct evconnlistener* listener) const noexcept
+{
+    if (listener != nullptr)
+    {
+        evconnlistener_free(listener);
+    }
+}
+
+void BuffereventDeleter::operator()(struct bufferevent* bev) const noexcept
+{
+    if (bev != nullptr)
+    {
+        bufferevent_free(bev);
+    }
+}
+
 // RPC events (evhttp) will default to pri1, one level higher than pri2 events
 // created here. Depends on event_base having three priority levels
 struct event* event_new_pri2(
@@ -11,8 +11,10 @@
 
 #include <memory>
 
+struct bufferevent;
 struct event;
 struct event_base;
+struct evconnlistener;
 struct evhttp;
 using event_callback_fn = void (*)(evutil_socket_t, short, void*);
 
@@ -40,6 +42,20 @@ struct EvhttpDeleter
 
 using evhttp_unique_ptr = std::unique_ptr<struct evhttp, EvhttpDeleter>;
 
+struct EvconnlistenerDeleter
+{
+    void operator()(struct evconnlistener* listener) const noexcept;
+};
+
+using evconnlistener_unique_ptr = std::unique_ptr<struct evconnlistener, EvconnlistenerDeleter>;
+
+struct BuffereventDeleter
+{
+    void operator()(struct bufferevent* bev) const noexcept;
+};
+
+using bufferevent_unique_ptr = std::unique_ptr<struct bufferevent, BuffereventDeleter>;
+
 struct event* event_new_pri2(
     struct event_base* base,
     evutil_socket_t fd,
@@ -4,11 +4,11 @@
 // License text can be found in the licenses/ folder.
 
 #include <algorithm>
-#include <array>
 #include <cctype> /* isdigit() */
 #include <cstddef> // size_t, std::byte
 #include <cstdint> // int64_t
 #include <deque>
+#include <functional> // std::less
 #include <optional>
 #include <ranges>
 #include <string>
@@ -138,12 +138,14 @@ struct MyHandler : public tr::benc::Handler
 {
     tr_variant* const top_;
     bool inplace_;
+    bool known_keys_only_;
     std::deque<tr_variant*> stack_;
     std::optional<tr_quark> key_;
 
-    MyHandler(tr_variant* top, bool inplace)
+    MyHandler(tr_variant* top, bool inplace, bool known_keys_only)
         : top_{ top }
         , inplace_{ inplace }
+        , known_keys_only_{ known_keys_only }
     {
     }
 
@@ -191,7 +193,9 @@ struct MyHandler : public tr::benc::Handler
 
     bool Key(std::string_view sv, Context const& /*context*/) final
     {
-        key_ = tr_quark_new(sv);
+        // Values of unknown keys still need to be parsed, so park them
+        // under `UnknownKey` and drop that entry when the dict ends.
+        key_ = known_keys_only_ ? tr_quark_lookup(sv).value_or(UnknownKey) : tr_quark_new(sv);
 
         return true;
     }
@@ -203,6 +207,11 @@ struct MyHandler : public tr::benc::Handler
             return false;
         }
 
+        if (auto* const map = stack_.back()->get_if<tr_variant::Map>(); known_keys_only_ && map != nullptr)
+        {
+            map->erase(UnknownKey);
+        }
+
         stack_.pop_back();
         return true;
     }
@@ -255,6 +264,8 @@ private:
 
         return {};
     }
+
+    static auto constexpr UnknownKey = tr_quark{ TR_KEY_NONE };
 };
 } // namespace parse_helpers
 } // namespace
@@ -266,7 +277,7 @@ std::optional<tr_variant> tr_variant_serde::parse_benc(std::string_view input)
 
     auto top = tr_variant{};
     auto stack = Stack{};
-    auto handler = MyHandler{ &top, parse_inplace_ };
+    auto handler = MyHandler{ &top, parse_inplace_, parse_known_keys_only_ };
     if (tr::benc::parse(input, stack, handler, &end_, &error_) && std::empty(stack))
     {
         return std::optional<tr_variant>{ std::move(top) };
@@ -283,17 +294,26 @@ namespace to_string_helpers
 {
 using OutBuf = fmt::memory_buffer;
 
-[[nodiscard]] auto sorted_entries(tr_variant::Map const& map)
+struct SortedEntry
+{
+    std::string_view key_sv;
+    tr_quark key;
+    tr_variant const* child;
+};
+
+[[nodiscard]] auto sorted_entries(tr_variant::Map const& map, tr_variant_serde::KeyStyle const* const key_style)
 {
     static auto constexpr N = 32U;
-    auto entries = small::vector<std::pair<std::string_view, tr_variant const*>, N>{};
+    auto entries = small::vector<SortedEntry, N>{};
     entries.reserve(map.size());
     for (auto const& [key, child] : map)
     {
-        entries.emplace_back(tr_quark_get_string_view(key), &child);
+        auto const out_key = key_style != nullptr ? key_style->key(key) : key;
+        entries.push_back({ tr_quark_get_string_view(out_key), out_key, &child });
     }
 
-    std::ranges::sort(entries);
+    // benc dicts must be sorted by the keys that are written
+    std::ranges::sort(entries, std::less{}, &SortedEntry::key_sv);
     return entries;
 }
 
@@ -325,6 +345,11 @@ struct BencWriter
 
     void operator()(std::string_view sv) const
     {
+        if (key_style_ != nullptr)
+        {
+            sv = key_style_->string(parent_key_, sv).value_or(sv);
+        }
+
         write_string(sv);
     }
 
@@ -341,16 +366,19 @@ struct BencWriter
     void operator()(tr_variant::Map const& map) const
     {
         out_.push_back('d');
-        auto entries = sorted_entries(map);
-        for (auto const& [key, child] : entries)
+        for (auto const& [key_sv, key, child] : sorted_entries(map, key_style_))
         {
-            write_string(key);
-            child->visit(*this);
+            write_string(key_sv);
+            child->visit(BencWriter{ out_, key_style_, key });
         }
         out_.push_back('e');
     }
 
     OutBuf& out_;
+    tr_variant_serde::KeyStyle const* key_style_ = nullptr;
+
+    // key of the innermost dict we're in; used by `key_style_`
+    tr_quark parent_key_ = TR_KEY_NONE;
 
 private:
     void write_string(std::string_view sv) const
@@ -365,9 +393,11 @@ private:
 
     void write_real(double val) const
     {
-        auto buf = std::array<char, 64>{};
-        auto const* const out_ptr = fmt::format_to(std::data(buf), "{:f}", val);
-        write_string({ std::data(buf), static_cast<size_t>(out_ptr - std::data(buf)) });
+        // benc has no real type, so write it as a string with
+        // the shortest digits that read back as the same value
+        auto buf = fmt::memory_buffer{};
+        fmt::format_to(fmt::appender(buf), "{}", val);
+        write_string({ std::data(buf), std::size(buf) });
     }
 
     void append_literal(std::string_view literal) const
@@ -379,11 +409,11 @@ private:
 } // namespace to_string_helpers
 } // namespace
 
-std::string tr_variant_serde::to_benc_string(tr_variant const& var)
+std::string tr_variant_serde::to_benc_string(tr_variant const& var) const
 {
     using namespace to_string_helpers;
 
     auto buf = OutBuf{};
-    var.visit(BencWriter{ buf });
+    var.visit(BencWriter{ buf, key_style_ });
     return fmt::to_string(buf);
 }
@@ -46,7 +46,8 @@ struct json_to_variant_handler : public rapidjson::BaseReaderHandler<>
 {
     static_assert(std::is_same_v<Ch, char>);
 
-    explicit json_to_variant_handler(tr_variant* const top)
+    json_to_variant_handler(tr_variant* const top, bool const known_keys_only)
+        : known_keys_only_{ known_keys_only }
     {
         stack_.emplace(top);
     }
@@ -126,6 +127,11 @@ struct json_to_variant_handler : public rapidjson::BaseReaderHandler<>
 
     bool EndObject(rapidjson::SizeType const len)
     {
+        if (auto* const map = stack_.top()->get_if<tr_variant::Map>(); known_keys_only_ && map != nullptr)
+        {
+            map->erase(UnknownKey);
+        }
+
         pop_stack(len);
         return true;
     }
@@ -168,7 +174,8 @@ private:
         }
         else if (top->holds_alternative<tr_variant::Map>())
         {
-            TR_ASSERT(std::size(*top->get_if<tr_variant::Map>()) == len);
+            // unknown keys were dropped
+            TR_ASSERT(known_keys_only_ || std::size(*top->get_if<tr_variant::Map>()) == len);
         }
 #endif
 
@@ -195,7 +202,10 @@ private:
             TR_ASSERT(!std::empty(cur_key_));
             auto tmp = std::string_view{};
             std::swap(cur_key_, tmp);
-            return &(*map)[tr_quark_new(tmp)];
+
+            // Values of unknown keys still need to be parsed, so park them
+            // under `UnknownKey` and drop that entry when the object ends.
+            return &(*map)[known_keys_only_ ? tr_quark_lookup(tmp).value_or(UnknownKey) : tr_quark_new(tmp)];
         }
 
         return parent;
@@ -210,9 +220,12 @@ private:
      * a preallocation heuristic for the next container at that depth. */
     std::array<size_t, MaxDepth> prealloc_guess_{};
 
+    static auto constexpr UnknownKey = tr_quark{ TR_KEY_NONE };
+
     std::string key_buf_;
     std::string_view cur_key_;
     std::stack<tr_variant*> stack_;
+    bool const known_keys_only_;
 };
 } // namespace parse_helpers
 } // namespace
@@ -228,7 +241,7 @@ std::optional<tr_variant> tr_variant_serde::parse_json(std::string_view input)
 
     auto const size = std::size(input);
     auto top = tr_variant{};
-    auto handler = parse_helpers::json_to_variant_handler{ &top };
+    auto handler = parse_helpers::json_to_variant_handler{ &top, parse_known_keys_only_ };
     auto ms = rapidjson::MemoryStream{ begin, size };
     auto eis = rapidjson::AutoUTFInputStream<unsigned, rapidjson::MemoryStream>{ ms };
     auto reader = rapidjson::GenericReader<rapidjson::AutoUTF<unsigned>, rapidjson::UTF8<char>>{};
@@ -297,16 +310,24 @@ private:
     fmt::memory_buffer buf_;
 };
 
-[[nodiscard]] auto sorted_entries(tr_variant::Map const& map)
+struct SortedEntry
+{
+    std::string_view key_sv;
+    tr_quark key;
+    tr_variant const* child;
+};
+
+[[nodiscard]] auto sorted_entries(tr_variant::Map const& map, tr_variant_serde::KeyStyle const* const key_style)
 {
     static auto constexpr N = 32U;
-    auto entries = small::vector<std::pair<std::string_view, tr_variant const*>, N>{};
+    auto entries = small::vector<SortedEntry, N>{};
     entries.reserve(map.size());
     for (auto const& [key, child] : map)
     {
-        entries.emplace_back(tr_quark_get_string_view(key), &child);
+        auto const out_key = key_style != nullptr ? key_style->key(key) : key;
+        entries.push_back({ tr_quark_get_string_view(out_key), out_key, &child });
     }
-    std::ranges::sort(entries);
+    std::ranges::sort(entries, std::less{}, &SortedEntry::key_sv);
     return entries;
 }
 
@@ -314,6 +335,10 @@ template<typename WriterT>
 struct JsonWriter
 {
     WriterT& writer;
+    tr_variant_serde::KeyStyle const* key_style = nullptr;
+
+    // key of the innermost dict we're in; used by `key_style`
+    tr_quark parent_key = TR_KEY_NONE;
 
     void operator()(std::monostate /*unused*/) const
     {
@@ -339,8 +364,13 @@ struct JsonWriter
         writer.Double(val);
     }
 
-    void operator()(std::string_view const val) const
+    void operator()(std::string_view val) const
     {
+        if (key_style != nullptr)
+        {
+            val = key_style->string(parent_key, val).value_or(val);
+        }
+
         // workaround for this issue: in Writer::String() at
         // rapidjson/writer.h:205: `RAPIDJSON_ASSERT(str != 0);`
         // that fails when val.data() is nullptr when val.empty()
@@ -361,17 +391,17 @@ struct JsonWriter
     void operator()(tr_variant::Map const& val) const
     {
         writer.StartObject();
-        for (auto const& [key, child] : sorted_entries(val))
+        for (auto const& [key_sv, key, child] : sorted_entries(val, key_style))
         {
-            writer.Key(std::data(key), std::size(key));
-            child->visit(*this);
+            writer.Key(std::data(key_sv), std::size(key_sv));
+            child->visit(JsonWriter{ writer, key_style, key });
         }
         writer.EndObject();
     }
 };
 
-template<typename WriterT>
-JsonWriter(WriterT&) -> JsonWriter<WriterT>;
+template<typename WriterT, typename... Args>
+JsonWriter(WriterT&, Args...) -> JsonWriter<WriterT>;
 
 } // namespace to_string_helpers
 } // namespace
@@ -384,14 +414,14 @@ std::string tr_variant_serde::to_json_string(tr_variant const& var) const
     if (compact_)
     {
         auto writer = rapidjson::Writer{ buf };
-        var.visit(JsonWriter{ writer });
+        var.visit(JsonWriter{ writer, key_style_ });
     }
     else
     {
         // Explicitly specify template parameter to workaround
         // https://gcc.gnu.org/bugzilla/show_bug.cgi?id=85790
         auto writer = rapidjson::PrettyWriter<FmtOutputStream>{ buf };
-        var.visit(JsonWriter{ writer });
+        var.visit(JsonWriter{ writer, key_style_ });
     }
     return buf.to_string();
 }
@@ -550,6 +550,22 @@ void tr_variantMergeDicts(tr_variant* tgt, tr_variant const* src);
 class tr_variant_serde
 {
 public:
+    // Lets the JSON writer spell keys differently from their quarks,
+    // e.g. to write legacy RPC keys without rewriting the whole tree.
+    class KeyStyle
+    {
+    public:
+        virtual ~KeyStyle() = default;
+
+        // @return the key to write in place of `key`
+        [[nodiscard]] virtual tr_quark key(tr_quark key) const = 0;
+
+        // Some strings are key names too, e.g. a torrent_get request's `fields`.
+        // @param parent_key the (renamed) key of the innermost dict holding `str`
+        // @return the string to write in place of `str`, or nullopt to keep it
+        [[nodiscard]] virtual std::optional<std::string_view> string(tr_quark parent_key, std::string_view str) const = 0;
+    };
+
     [[nodiscard]] static tr_variant_serde benc() noexcept
     {
         return tr_variant_serde{ Type::Benc };
@@ -577,6 +593,23 @@ public:
         return *this;
     }
 
+    // When set, dict entries whose keys aren't already quarks are
+    // dropped instead of being added as new quarks. Use this when
+    // parsing untrusted input, e.g. RPC requests, so that it can't
+    // grow the quark table.
+    constexpr tr_variant_serde& known_keys_only() noexcept
+    {
+        parse_known_keys_only_ = true;
+        return *this;
+    }
+
+    // When set, keys are written as `style` spells them.
+    constexpr tr_variant_serde& key_style(KeyStyle const* style) noexcept
+    {
+        key_style_ = style;
+        return *this;
+    }
+
     // ---
 
     [[nodiscard]] std::optional<tr_variant> parse(std::string_view input);
@@ -623,7 +656,7 @@ private:
     [[nodiscard]] std::optional<tr_variant> parse_benc(std::string_view input);
 
     [[nodiscard]] std::string to_json_string(tr_variant const& var) const;
-    [[nodiscard]] static std::string to_benc_string(tr_variant const& var);
+    [[nodiscard]] std::string to_benc_string(tr_variant const& var) const;
 
     Type type_;
 
@@ -631,6 +664,10 @@ private:
 
     bool parse_inplace_ = false;
 
+    bool parse_known_keys_only_ = false;
+
+    KeyStyle const* key_style_ = nullptr;
+
     // This is set to the first unparsed character after `parse()`.
     char const* end_ = nullptr;
 };
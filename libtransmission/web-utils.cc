@@ -173,6 +173,35 @@ char const* tr_webGetResponseStr(long code)
     }
 }
 
+bool tr_webEtagMatches(std::string_view if_none_match, std::string_view const etag)
+{
+    if (tr_strv_strip(if_none_match) == "*"sv)
+    {
+        return true;
+    }
+
+    auto const strip_weak = [](std::string_view tag)
+    {
+        tag = tr_strv_strip(tag);
+        if (auto constexpr Weak = "W/"sv; tr_strv_starts_with(tag, Weak))
+        {
+            tag.remove_prefix(std::size(Weak));
+        }
+        return tag;
+    };
+
+    auto const wanted = strip_weak(etag);
+    for (auto tag = std::string_view{}; tr_strv_sep(&if_none_match, &tag, ',');)
+    {
+        if (strip_weak(tag) == wanted)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // --- URLs
 
 namespace
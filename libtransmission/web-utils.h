@@ -92,4 +92,8 @@ constexpr void tr_urlPercentEncode(BackInsertIter out, tr_sha1_digest_t const& d
 
 [[nodiscard]] char const* tr_webGetResponseStr(long response_code);
 
+// Returns true if an `If-None-Match` header value names `etag`.
+// Weak validators ("W/...") match too, as RFC 9110 asks for GET requests.
+[[nodiscard]] bool tr_webEtagMatches(std::string_view if_none_match, std::string_view etag);
+
 [[nodiscard]] std::string tr_urlPercentDecode(std::string_view /*url*/);
@@ -19,10 +19,13 @@
 #include <memory>
 #include <ranges>
 #include <mutex>
+#include <optional>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -275,7 +278,7 @@ public:
 
             response.user_data = options_.done_func_user_data;
 
-            if (options_.range)
+            if (options_.range && !options_.on_data_received)
             {
                 // preallocate the response body buffer
                 auto const& [first, last] = *options_.range;
@@ -367,15 +370,17 @@ public:
             }
         }
 
-        void add_data(void const* data, size_t const n_bytes)
+        // Returns false if the transfer should be aborted.
+        bool add_data(void const* data, size_t const n_bytes)
         {
-            response.body.append(static_cast<char const*>(data), n_bytes);
-            tr_logAddTrace(fmt::format("wrote {} bytes to task {}'s buffer", n_bytes, fmt::ptr(this)));
-
             if (options_.on_data_received)
             {
-                options_.on_data_received(n_bytes);
+                return options_.on_data_received({ static_cast<char const*>(data), n_bytes });
             }
+
+            response.body.append(static_cast<char const*>(data), n_bytes);
+            tr_logAddTrace(fmt::format("wrote {} bytes to task {}'s buffer", n_bytes, fmt::ptr(this)));
+            return true;
         }
 
         void done()
@@ -450,6 +455,14 @@ public:
     static auto constexpr MaxTotalConnections = long{ 96 };
     static auto constexpr MaxCachedConnections = MaxTotalConnections;
 
+    // How many HTTP/2 streams can share a single connection.
+    // This lets webseeds keep many ranges in flight to one server.
+    static auto constexpr MaxConcurrentStreams = long{ 100 };
+
+    // Use a larger receive buffer for range requests so that
+    // large webseed transfers make fewer write callbacks.
+    static auto constexpr RangeBufferSize = long{ 128 * 1024 };
+
     bool const curl_verbose = tr_env_key_exists("TR_CURL_VERBOSE");
     bool const curl_ssl_verify = !tr_env_key_exists("TR_CURL_SSL_NO_VERIFY");
     bool const curl_proxy_ssl_verify = !tr_env_key_exists("TR_CURL_PROXY_SSL_NO_VERIFY");
@@ -555,7 +568,12 @@ public:
             }
         }
 
-        task->add_data(data, bytes_used);
+        if (!task->add_data(data, bytes_used))
+        {
+            // abort w/CURLE_WRITE_ERROR, as above
+            return bytes_used + 1;
+        }
+
         return bytes_used;
     }
 
@@ -676,6 +694,16 @@ public:
             auto const& [first, last] = *range;
             auto const str = fmt::format("{:d}-{:d}", first, last);
             (void)curl_easy_setopt(e, CURLOPT_RANGE, str.c_str());
+            (void)curl_easy_setopt(e, CURLOPT_BUFFERSIZE, RangeBufferSize);
+
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+            // Prefer to wait for a connection that can multiplex this
+            // request over opening a new one to the same server.
+            if (!curl_avoid_http2)
+            {
+                (void)curl_easy_setopt(e, CURLOPT_PIPEWAIT, 1L);
+            }
+#endif
         }
 
         if (curl_avoid_http2)
@@ -742,6 +770,12 @@ public:
 #if LIBCURL_VERSION_NUM >= 0x071E00 /* 7.30.0 */
         (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, MaxTotalConnections);
         (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_HOST_CONNECTIONS, MaxHostConnections);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+        (void)curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, curl_avoid_http2 ? CURLPIPE_NOTHING : CURLPIPE_MULTIPLEX);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x074300 /* 7.67.0 */
+        (void)curl_multi_setopt(multi.get(), CURLMOPT_MAX_CONCURRENT_STREAMS, MaxConcurrentStreams);
 #endif
         auto const start_time = mediator.now();
 
@@ -849,6 +883,12 @@ public:
                     task->response.did_timeout = task->response.status == 0 &&
                         std::chrono::duration<double>(total_time) >= task->timeoutSecs();
                     task->response.primary_ip = primary_ip;
+#if LIBCURL_VERSION_NUM >= 0x073200 /* 7.50.0 */
+                    auto http_version = long{};
+                    curl_easy_getinfo(e, CURLINFO_HTTP_VERSION, &http_version);
+                    task->response.multiplexed = http_version >= CURL_HTTP_VERSION_2_0;
+#endif
+                    update_host_stats(e, *task, total_time);
                     curl_multi_remove_handle(multi.get(), e);
                     remove_task(*task);
                 }
@@ -856,6 +896,105 @@ public:
         }
     }
 
+    void update_host_stats(CURL* const e, Task const& task, double const total_time)
+    {
+        auto const parsed = tr_urlParse(task.url());
+        if (!parsed)
+        {
+            return;
+        }
+
+        auto n_connects = long{};
+        curl_easy_getinfo(e, CURLINFO_NUM_CONNECTS, &n_connects);
+
+        auto bytes_downloaded = uint64_t{};
+#if LIBCURL_VERSION_NUM >= 0x073700 /* 7.55.0 */
+        auto size_download = curl_off_t{};
+        curl_easy_getinfo(e, CURLINFO_SIZE_DOWNLOAD_T, &size_download);
+        bytes_downloaded = static_cast<uint64_t>(std::max(size_download, curl_off_t{}));
+#else
+        auto size_download = double{};
+        curl_easy_getinfo(e, CURLINFO_SIZE_DOWNLOAD, &size_download);
+        bytes_downloaded = static_cast<uint64_t>(std::max(size_download, 0.0));
+#endif
+
+        auto const now = std::chrono::steady_clock::now();
+        auto const lock = std::lock_guard{ host_stats_mutex_ };
+
+        auto iter = host_stats_.find(parsed->host);
+        if (iter == std::end(host_stats_))
+        {
+            prune_host_stats(now, MaxHostStats - 1U);
+            iter = host_stats_.try_emplace(std::string{ parsed->host }).first;
+        }
+
+        auto& [stats, last_used] = iter->second;
+        last_used = now;
+        ++stats.n_requests;
+        stats.n_new_connections += n_connects > 0 ? 1U : 0U;
+        stats.n_multiplexed += task.response.multiplexed ? 1U : 0U;
+        stats.bytes_downloaded += bytes_downloaded;
+        stats.total_time += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::duration<double>(total_time));
+    }
+
+    [[nodiscard]] std::optional<HostStats> host_stats(std::string_view host) const
+    {
+        auto const lock = std::lock_guard{ host_stats_mutex_ };
+        prune_host_stats(std::chrono::steady_clock::now(), MaxHostStats);
+
+        if (auto const iter = host_stats_.find(host); iter != std::end(host_stats_))
+        {
+            return iter->second.stats;
+        }
+
+        return {};
+    }
+
+    [[nodiscard]] std::vector<std::pair<std::string, HostStats>> host_stats() const
+    {
+        auto const lock = std::lock_guard{ host_stats_mutex_ };
+        prune_host_stats(std::chrono::steady_clock::now(), MaxHostStats);
+
+        auto ret = std::vector<std::pair<std::string, HostStats>>{};
+        ret.reserve(std::size(host_stats_));
+        for (auto const& [host, entry] : host_stats_)
+        {
+            ret.emplace_back(host, entry.stats);
+        }
+        return ret;
+    }
+
+    // Keep only the most recently used hosts, so that fetching from
+    // many different hosts (e.g. scraping trackers) can't grow this forever.
+    static auto constexpr MaxHostStats = size_t{ 64U };
+    static auto constexpr HostStatsTtl = std::chrono::hours{ 1 };
+
+    // Drops hosts that haven't been used for `HostStatsTtl`, then the least
+    // recently used ones until at most `max_hosts` are left. This runs when
+    // the stats are read too, so idle hosts don't linger until the next transfer.
+    // Call with `host_stats_mutex_` held.
+    void prune_host_stats(std::chrono::steady_clock::time_point const now, size_t const max_hosts) const
+    {
+        std::erase_if(host_stats_, [now](auto const& item) { return item.second.last_used + HostStatsTtl < now; });
+
+        while (std::size(host_stats_) > max_hosts)
+        {
+            host_stats_.erase(std::ranges::min_element(
+                host_stats_,
+                {},
+                [](auto const& item) { return item.second.last_used; }));
+        }
+    }
+
+    struct HostStatsEntry
+    {
+        HostStats stats;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    mutable std::mutex host_stats_mutex_;
+    mutable std::map<std::string /*host*/, HostStatsEntry, std::less<>> host_stats_;
+
     curl_helpers::shared_unique_ptr const curlsh_{ curl_share_init() };
 
     std::map<std::string /*host*/, std::stack<curl_helpers::easy_unique_ptr>, std::less<>> easy_pool_;
@@ -920,3 +1059,13 @@ bool tr_web::is_idle() const noexcept
 {
     return impl_->is_idle();
 }
+
+std::optional<tr_web::HostStats> tr_web::host_stats(std::string_view host) const
+{
+    return impl_->host_stats(host);
+}
+
+std::vector<std::pair<std::string, tr_web::HostStats>> tr_web::host_stats() const
+{
+    return impl_->host_stats();
+}
@@ -15,6 +15,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 class tr_web
 {
@@ -29,6 +30,26 @@ public:
         bool did_connect = false;
         bool did_timeout = false;
         void* user_data = nullptr;
+
+        // true if the transfer used HTTP/2 or newer, so that other
+        // requests to the same host can share its connection
+        bool multiplexed = false;
+    };
+
+    // Running totals for the transfers made to a single host.
+    struct HostStats
+    {
+        uint64_t n_requests = 0;
+
+        // transfers that had to open a new connection instead of
+        // reusing or multiplexing onto an existing one
+        uint64_t n_new_connections = 0;
+
+        // transfers that were made over HTTP/2 or newer
+        uint64_t n_multiplexed = 0;
+
+        uint64_t bytes_downloaded = 0;
+        std::chrono::milliseconds total_time = {};
     };
 
     // Callback to invoke when fetch() is done
@@ -83,9 +104,13 @@ public:
         // Maximum time to wait before timeout
         std::chrono::seconds timeout_secs = DefaultTimeoutSecs;
 
-        // Called periodically by the web internals when data is received.
-        // Used by webseeds to report to tr_bandwidth for data xfer stats
-        std::function<void(size_t /*n_bytes*/)> on_data_received;
+        // If set, the response body is streamed to this callback as it
+        // arrives instead of being collected in FetchResponse::body.
+        // Called from the web thread. Used by webseeds to write blocks
+        // to disk as soon as they're complete. If `range` is set, this
+        // is only called once the server has answered 206 Partial Content.
+        // Return false to abort the transfer.
+        std::function<bool(std::string_view /*data*/)> on_data_received;
 
         // IP protocol to use when making the request
         IPProtocol ip_proto = IPProtocol::ANY;
@@ -102,6 +127,14 @@ public:
 
     [[nodiscard]] bool is_idle() const noexcept;
 
+    // Returns the stats for transfers to `host`, or nullopt if none have finished.
+    // Safe to call from any thread.
+    [[nodiscard]] std::optional<HostStats> host_stats(std::string_view host) const;
+
+    // Returns the stats for every host with a recently-finished transfer, sorted by host.
+    // Only the most recently used hosts are kept. Safe to call from any thread.
+    [[nodiscard]] std::vector<std::pair<std::string, HostStats>> host_stats() const;
+
     // If you want to give running tasks a chance to finish,
     // call startShutdown() before destroying the tr_web object.
     // Deleting the object will cancel all of its tasks.
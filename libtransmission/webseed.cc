@@ -14,6 +14,7 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <fmt/format.h>
 
@@ -28,7 +29,6 @@
 #include "libtransmission/timer.h"
 #include "libtransmission/torrent.h"
 #include "libtransmission/tr-assert.h"
-#include "libtransmission/tr-buffer.h"
 #include "libtransmission/tr-strbuf.h"
 #include "libtransmission/types.h"
 #include "libtransmission/web-utils.h"
@@ -60,10 +60,10 @@ public:
     tr_block_span_t const blocks;
 
 private:
-    void use_fetched_blocks();
+    void use_fetched_block();
 
     static void on_partial_data_fetched(tr_web::FetchResponse const& web_response);
-    void on_data_received(size_t n_bytes);
+    bool on_data_received(std::string_view data);
 
     tr_webseed_impl* const webseed_;
     tr_session* const session_;
@@ -72,7 +72,15 @@ private:
     // the current position in the task; i.e., the next block to save
     tr_block_info::Location loc_;
 
-    tr::StackBuffer<tr_block_info::BlockSize, std::byte, std::ratio<5, 1>> content_;
+    // The block at `loc_`, filled as the response body streams in.
+    // When it's complete, it's moved to the session thread to be written,
+    // so a task never holds more than one block of unwritten data.
+    std::vector<uint8_t> block_buf_;
+
+    // timing info for RequestSizer, in tr_time_msec()
+    uint64_t const started_at_ = tr_time_msec();
+    uint64_t first_byte_at_ = 0;
+    uint64_t n_bytes_received_ = 0;
 };
 
 /**
@@ -92,12 +100,16 @@ public:
         ++n_tasks_;
     }
 
-    void task_finished(bool success)
+    void task_finished(bool success, bool multiplexed)
     {
         if (!success)
         {
             task_failed();
         }
+        else
+        {
+            is_multiplexed_ = multiplexed;
+        }
 
         TR_ASSERT(n_tasks_ > 0);
         --n_tasks_;
@@ -134,7 +146,12 @@ private:
 
     [[nodiscard]] constexpr size_t max_connections() const noexcept
     {
-        return n_consecutive_failures_ > 0 ? 1 : MaxConnections;
+        if (n_consecutive_failures_ > 0)
+        {
+            return 1;
+        }
+
+        return is_multiplexed_ ? MaxMultiplexedConnections : MaxConnections;
     }
 
     void task_failed()
@@ -151,9 +168,15 @@ private:
     static auto constexpr MaxConnections = size_t{ 4 };
     static auto constexpr MaxConsecutiveFailures = MaxConnections;
 
+    // When the server speaks HTTP/2, tasks are streams multiplexed over a
+    // shared connection rather than connections of their own, so keeping
+    // more ranges in flight helps to hide the server's latency.
+    static auto constexpr MaxMultiplexedConnections = size_t{ 16 };
+
     size_t n_tasks_ = 0;
     size_t n_consecutive_failures_ = 0;
     time_t paused_until_ = 0;
+    bool is_multiplexed_ = false;
 };
 
 class tr_webseed_impl final : public tr_webseed
@@ -302,14 +325,10 @@ public:
             return;
         }
 
-        // Prefer to request large, contiguous chunks from webseeds.
-        // The actual value of '64' is arbitrary here; we could probably
-        // be smarter about this.
-        auto spans = tr_peerMgrGetNextRequests(&tor, this, max_blocks);
-        if (std::size(spans) > max_spans)
-        {
-            spans.resize(max_spans);
-        }
+        auto const spans = tr::webseed::split_spans(
+            tr_peerMgrGetNextRequests(&tor, this, max_blocks),
+            request_sizer.blocks_per_task(),
+            max_spans);
         request_blocks(std::data(spans), std::size(spans));
     }
 
@@ -326,11 +345,12 @@ public:
             return {};
         }
 
-        // Prefer to request large, contiguous chunks from webseeds.
-        // The actual value of '64' is arbitrary here;
-        // we could probably be smarter about this.
-        static auto constexpr PreferredBlocksPerTask = size_t{ 64 };
-        return { .max_spans = n_slots, .max_blocks = n_slots * PreferredBlocksPerTask };
+        auto const now = tr_time_msec();
+        auto const n_tasks = tr::webseed::max_tasks(
+            n_slots,
+            get_piece_speed(now, tr_direction::Down).base_quantity(),
+            tr_peerMgrFastestWebseedSpeed(&tor, now));
+        return { .max_spans = n_tasks, .max_blocks = n_tasks * request_sizer.blocks_per_task() };
     }
 
     void publish(tr_peer_event const& peer_event)
@@ -345,6 +365,7 @@ public:
     std::string const base_url;
 
     ConnectionLimiter connection_limiter;
+    tr::webseed::RequestSizer request_sizer;
     std::set<tr_webseed_task*> tasks;
 
 private:
@@ -364,68 +385,90 @@ private:
 
 // ---
 
-void tr_webseed_task::use_fetched_blocks()
+void tr_webseed_task::use_fetched_block()
 {
-    auto const lock = session_->unique_lock();
-
     auto const& tor = webseed_->tor;
+    auto const block_size = tor.block_size(loc_.block);
+    TR_ASSERT(std::size(block_buf_) == block_size);
 
-    for (;;)
+    if (!tor.has_block(loc_.block))
     {
-        auto const block_size = tor.block_size(loc_.block);
-        if (std::size(content_) < block_size)
-        {
-            break;
-        }
-
-        if (tor.has_block(loc_.block))
-        {
-            content_.drain(block_size);
-        }
-        else
-        {
-            auto block_buf = std::vector<uint8_t>{};
-            block_buf.resize(block_size);
-            content_.to_buf(block_buf);
-
-            session_->run_in_session_thread(
-                [buf = std::move(block_buf), loc = loc_, session = session_, tor_id = tor.id(), webseed = webseed_]()
+        session_->run_in_session_thread(
+            [buf = std::move(block_buf_), loc = loc_, session = session_, tor_id = tor.id(), webseed = webseed_]()
+            {
+                if (auto* const torrent = session->torrents().get(tor_id))
                 {
-                    if (auto* const torrent = session->torrents().get(tor_id))
+                    webseed->active_requests.unset(loc.block);
+                    if (tr_ioWrite(*torrent, session->openFiles(), loc, buf) != 0)
                     {
-                        webseed->active_requests.unset(loc.block);
-                        if (tr_ioWrite(*torrent, session->openFiles(), loc, buf) != 0)
-                        {
-                            return;
-                        }
-                        webseed->publish(tr_peer_event::GotBlock(torrent->block_info(), loc.block));
+                        return;
                     }
-                });
-        }
+                    webseed->publish(tr_peer_event::GotBlock(torrent->block_info(), loc.block));
+                }
+            });
+    }
 
-        loc_ = tor.byte_loc(loc_.byte + block_size);
+    block_buf_ = {};
+    loc_ = tor.byte_loc(loc_.byte + block_size);
 
-        TR_ASSERT(loc_.byte <= end_byte_);
-        TR_ASSERT(loc_.byte == end_byte_ || loc_.block_offset == 0);
-    }
+    TR_ASSERT(loc_.byte <= end_byte_);
+    TR_ASSERT(loc_.byte == end_byte_ || loc_.block_offset == 0);
 }
 
 // ---
 
-void tr_webseed_task::on_data_received(size_t const n_bytes)
+// Called from the web thread as each chunk of the response body arrives.
+// tr_web only calls this once the server has answered 206 Partial Content,
+// so a server that ignores `Range` or sends an error page never gets here.
+// Returns false to abort the transfer.
+bool tr_webseed_task::on_data_received(std::string_view data)
 {
-    if (n_bytes == 0 || dead)
+    if (std::empty(data))
     {
-        return;
+        return true;
     }
 
     auto const lock = session_->unique_lock();
-    webseed_->got_piece_data(n_bytes);
+
+    if (dead)
+    {
+        return false;
+    }
+
+    webseed_->got_piece_data(std::size(data));
+
+    if (first_byte_at_ == 0U)
+    {
+        first_byte_at_ = tr_time_msec();
+    }
+    n_bytes_received_ += std::size(data);
+
+    auto const& tor = webseed_->tor;
+    while (!std::empty(data) && loc_.byte < end_byte_)
+    {
+        auto const block_size = tor.block_size(loc_.block);
+        if (std::empty(block_buf_))
+        {
+            block_buf_.reserve(block_size);
+        }
+
+        auto const n_bytes = std::min(std::size(data), size_t{ block_size } - std::size(block_buf_));
+        block_buf_.insert(std::end(block_buf_), std::begin(data), std::begin(data) + n_bytes);
+        data.remove_prefix(n_bytes);
+
+        if (std::size(block_buf_) == block_size)
+        {
+            use_fetched_block();
+        }
+    }
+
+    // stop a server that sends more than the range we asked for
+    return std::empty(data);
 }
 
 void tr_webseed_task::on_partial_data_fetched(tr_web::FetchResponse const& web_response)
 {
-    auto const& [status, body, primary_ip, did_connect, did_timeout, vtask] = web_response;
+    auto const& [status, body, primary_ip, did_connect, did_timeout, vtask, multiplexed] = web_response;
     auto const success = status == 206;
 
     auto* const task = static_cast<tr_webseed_task*>(vtask);
@@ -437,20 +480,24 @@ void tr_webseed_task::on_partial_data_fetched(tr_web::FetchResponse const& web_r
     }
 
     auto* const webseed = task->webseed_;
-    webseed->connection_limiter.task_finished(success);
+    webseed->connection_limiter.task_finished(success, multiplexed);
 
     if (!success)
     {
+        if (did_timeout)
+        {
+            webseed->request_sizer.task_timed_out();
+        }
+
         webseed->on_rejection({ .begin = task->loc_.block, .end = task->blocks.end });
         webseed->tasks.erase(task);
         delete task;
         return;
     }
 
-    task->content_.add(std::data(body), std::size(body));
-    task->use_fetched_blocks();
-
-    if (task->loc_.byte < task->end_byte_)
+    // The body was streamed to on_data_received() as it arrived,
+    // so all that's left to do here is to decide what comes next.
+    if (task->loc_.byte + std::size(task->block_buf_) < task->end_byte_)
     {
         // Request finished successfully but there's still data missing.
         // That means we've reached the end of a file and need to request
@@ -459,8 +506,12 @@ void tr_webseed_task::on_partial_data_fetched(tr_web::FetchResponse const& web_r
         return;
     }
 
-    TR_ASSERT(std::empty(task->content_));
+    TR_ASSERT(std::empty(task->block_buf_));
     TR_ASSERT(task->loc_.byte == task->end_byte_);
+
+    auto const now = tr_time_msec();
+    auto const first_byte_at = task->first_byte_at_ != 0U ? task->first_byte_at_ : now;
+    webseed->request_sizer.task_finished(task->n_bytes_received_, now - task->started_at_, first_byte_at - task->started_at_);
     webseed->tasks.erase(task);
     delete task;
 
@@ -484,7 +535,7 @@ void tr_webseed_task::request_next_chunk()
 {
     auto const& tor = webseed_->tor;
 
-    auto const downloaded_loc = tor.byte_loc(loc_.byte + std::size(content_));
+    auto const downloaded_loc = tor.byte_loc(loc_.byte + std::size(block_buf_));
 
     auto const [file_index, file_offset] = tor.file_offset(downloaded_loc);
     auto const left_in_file = tor.file_size(file_index) - file_offset;
@@ -499,9 +550,9 @@ void tr_webseed_task::request_next_chunk()
     auto options = tr_web::FetchOptions{ url.sv(), on_partial_data_fetched, this };
     options.range.emplace(file_offset, file_offset + this_chunk - 1);
     options.speed_limit_tag = tor.id();
-    options.on_data_received = [this](size_t const n_bytes)
+    options.on_data_received = [this](std::string_view const data)
     {
-        on_data_received(n_bytes);
+        return on_data_received(data);
     };
     tor.session->fetch(std::move(options));
 }
@@ -510,6 +561,34 @@ void tr_webseed_task::request_next_chunk()
 
 // ---
 
+std::vector<tr_block_span_t> tr::webseed::split_spans(
+    std::vector<tr_block_span_t> const& spans,
+    size_t const blocks_per_task,
+    size_t const max_spans)
+{
+    TR_ASSERT(blocks_per_task > 0U);
+
+    auto ret = std::vector<tr_block_span_t>{};
+    ret.reserve(max_spans);
+    for (auto const& span : spans)
+    {
+        for (auto begin = span.begin; begin < span.end && std::size(ret) < max_spans; begin += blocks_per_task)
+        {
+            auto const end = static_cast<tr_block_index_t>(std::min(size_t{ span.end }, size_t{ begin } + blocks_per_task));
+            ret.push_back({ .begin = begin, .end = end });
+        }
+    }
+    return ret;
+}
+
+size_t tr::webseed::max_tasks(size_t const n_slots, uint64_t const speed, uint64_t const fastest_speed) noexcept
+{
+    static auto constexpr SlowMirrorRatio = uint64_t{ 4U };
+
+    auto const is_slow_mirror = speed * SlowMirrorRatio < fastest_speed;
+    return is_slow_mirror ? std::min(n_slots, size_t{ 1 }) : n_slots;
+}
+
 std::unique_ptr<tr_webseed> tr_webseed::create(
     tr_torrent& torrent,
     std::string_view url,
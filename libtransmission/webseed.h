@@ -9,10 +9,16 @@
 #error only libtransmission should #include this header.
 #endif
 
+#include <algorithm>
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
 #include <memory>
 #include <string_view>
+#include <vector>
 
+#include "libtransmission/block-info.h"
 #include "libtransmission/peer-common.h"
+#include "libtransmission/types.h"
 
 using tr_peer_callback_webseed = tr_peer_callback_generic;
 
@@ -33,3 +39,85 @@ public:
 
     [[nodiscard]] virtual tr_webseed_view get_view() const = 0;
 };
+
+// ---
+
+namespace tr::webseed
+{
+/**
+ * Decides how many blocks each web task should request.
+ *
+ * Small ranges waste fast mirrors' bandwidth on per-request latency,
+ * while large ranges make slow mirrors time out. So estimate each
+ * webseed's per-task throughput and latency from the tasks it has
+ * finished, and size new ranges to take about `TargetTaskDuration`.
+ */
+class RequestSizer
+{
+public:
+    static auto constexpr TargetTaskDuration = uint64_t{ 15000U }; // msec
+    static auto constexpr LatencyMultiple = uint64_t{ 4U };
+    static auto constexpr MinBlocksPerTask = size_t{ 4U };
+    static auto constexpr DefaultBlocksPerTask = size_t{ 64U };
+    static auto constexpr MaxBlocksPerTask = size_t{ 1024U };
+
+    void task_finished(uint64_t n_bytes, uint64_t elapsed_msec, uint64_t latency_msec)
+    {
+        latency_msec = std::min(latency_msec, elapsed_msec);
+        auto const transfer_msec = std::max(elapsed_msec - latency_msec, uint64_t{ 1 });
+        auto const bytes_per_second = n_bytes * 1000U / transfer_msec;
+
+        latency_msec_ = has_estimate_ ? smooth(latency_msec_, latency_msec) : latency_msec;
+        bytes_per_second_ = has_estimate_ ? smooth(bytes_per_second_, bytes_per_second) : bytes_per_second;
+        has_estimate_ = true;
+
+        max_blocks_ = std::min(max_blocks_ * 2U, MaxBlocksPerTask);
+    }
+
+    void task_timed_out() noexcept
+    {
+        max_blocks_ = std::max(blocks_per_task() / 2U, MinBlocksPerTask);
+    }
+
+    [[nodiscard]] size_t blocks_per_task() const noexcept
+    {
+        if (!has_estimate_)
+        {
+            return std::min(DefaultBlocksPerTask, max_blocks_);
+        }
+
+        // On high-latency links, make the ranges long enough
+        // that the transfer time dominates the request time.
+        auto const target_msec = std::max(TargetTaskDuration, latency_msec_ * LatencyMultiple);
+        auto const n_bytes = bytes_per_second_ * (target_msec - latency_msec_) / 1000U;
+        auto const n_blocks = static_cast<size_t>(n_bytes / tr_block_info::BlockSize);
+        return std::clamp(n_blocks, MinBlocksPerTask, max_blocks_);
+    }
+
+private:
+    [[nodiscard]] static constexpr uint64_t smooth(uint64_t const old_value, uint64_t const new_value) noexcept
+    {
+        // exponentially-weighted moving average with alpha = 1/4
+        return (old_value * 3U + new_value) / 4U;
+    }
+
+    uint64_t bytes_per_second_ = 0;
+    uint64_t latency_msec_ = 0;
+    size_t max_blocks_ = MaxBlocksPerTask;
+    bool has_estimate_ = false;
+};
+
+// Splits `spans` into ranges of at most `blocks_per_task` blocks, so that
+// large contiguous wants can be fetched in parallel. At most `max_spans`
+// ranges are returned.
+[[nodiscard]] std::vector<tr_block_span_t> split_spans(
+    std::vector<tr_block_span_t> const& spans,
+    size_t blocks_per_task,
+    size_t max_spans);
+
+// Returns how many tasks a webseed with `n_slots` free connection slots may
+// start. When a torrent has several webseeds, prefer the fastest ones: a
+// mirror that's much slower than the fastest keeps only one task running,
+// which is enough to notice if it speeds up.
+[[nodiscard]] size_t max_tasks(size_t n_slots, uint64_t speed, uint64_t fastest_speed) noexcept;
+} // namespace tr::webseed
@@ -117,6 +117,9 @@ void RpcClient::sendNetworkRequest(QByteArray const& body, QFutureInterface<RpcR
     auto req = QNetworkRequest{};
     req.setUrl(url_);
     req.setRawHeader("Content-Type", "application/json; charset=UTF-8");
+    // benc is cheaper for the server to write and for us to parse.
+    // Servers that don't support it ignore this and send JSON.
+    req.setRawHeader("Accept", BencContentType + ", application/json");
     req.setRawHeader("User-Agent", "Transmission/" SHORT_VERSION_STRING);
     if (!session_id_.isEmpty())
     {
@@ -251,16 +254,18 @@ void RpcClient::networkRequestFinished(QNetworkReply* reply)
     }
     else
     {
-        auto const json = reply->readAll().trimmed().toStdString();
+        auto const content_type = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+        auto const is_benc = content_type.startsWith(BencContentType);
+        auto const body = is_benc ? reply->readAll().toStdString() : reply->readAll().trimmed().toStdString();
 
         if (verbose_)
         {
-            fmt::print("{:s}:{:d} got raw response:\n{:s}\n", __FILE__, __LINE__, json);
+            fmt::print("{:s}:{:d} got raw response:\n{:s}\n", __FILE__, __LINE__, body);
         }
 
         auto response = RpcResponse{};
 
-        if (auto var = tr_variant_serde::json().parse(json))
+        if (auto var = (is_benc ? tr_variant_serde::benc() : tr_variant_serde::json()).parse(body))
         {
             api_compat::convert_incoming_data(*var);
 
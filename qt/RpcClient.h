@@ -91,6 +91,8 @@ private:
                                                            static_cast<qsizetype>(TrRpcSessionIdHeader.size()) };
     static inline QByteArray const VersionHeaderName = { TrRpcVersionHeader.data(),
                                                          static_cast<qsizetype>(TrRpcVersionHeader.size()) };
+    static inline QByteArray const BencContentType = { TrRpcBencContentType.data(),
+                                                       static_cast<qsizetype>(TrRpcBencContentType.size()) };
 
     void connectNetworkAccessManager();
 
@@ -7,12 +7,19 @@
 #include <array>
 #include <cassert>
 #include <cstddef> // std::byte
+#include <ctime>
 #include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
 
 #define LIBTRANSMISSION_ANNOUNCER_MODULE
 
 #include <libtransmission/announcer-common.h>
+#include <libtransmission/interned-string.h>
 #include <libtransmission/net.h>
 
 #include "test-fixtures.h"
@@ -88,6 +95,37 @@ TEST_F(AnnouncerTest, parseHttpAnnounceResponsePexCompact)
     }
 }
 
+TEST_F(AnnouncerTest, parseHttpAnnounceResponseManyPexCompact)
+{
+    // Large trackers commonly return a couple hundred compact peers
+    static auto constexpr NumPeers = size_t{ 200U };
+
+    auto compact = std::string{};
+    auto compact6 = std::string{};
+    for (size_t i = 0; i < NumPeers; ++i)
+    {
+        auto const lo = static_cast<char>(i & 0xFFU);
+        compact += std::string{ '\x0a', '\x00', '\x01', lo, '\x1a', lo };
+        compact6 += std::string{ '\x20', '\x01', '\x0d', '\xb8' } + std::string(11U, '\0') + lo + std::string{ '\x1a', lo };
+    }
+
+    auto const benc = fmt::format(
+        "d8:intervali1800e5:peers{:d}:{:s}6:peers6{:d}:{:s}e",
+        std::size(compact),
+        compact,
+        std::size(compact6),
+        compact6);
+
+    auto response = tr_announce_response{};
+    tr_announcerParseHttpAnnounceResponse(response, benc, LogName);
+    EXPECT_EQ(""sv, response.errmsg);
+    ASSERT_EQ(NumPeers, std::size(response.pex));
+    ASSERT_EQ(NumPeers, std::size(response.pex6));
+    EXPECT_EQ("10.0.1.0:6656"sv, response.pex.front().display_name());
+    EXPECT_EQ("10.0.1.199:6855"sv, response.pex.back().display_name());
+    EXPECT_EQ("[2001:db8::c7]:6855"sv, response.pex6.back().display_name());
+}
+
 TEST_F(AnnouncerTest, parseHttpAnnounceResponsePexList)
 {
     // clang-format off
@@ -307,3 +345,192 @@ TEST_F(AnnouncerTest, parseHttpScrapeResponseMultiWithMissing)
     EXPECT_EQ(8, response.rows[2].leechers);
     EXPECT_EQ(9, response.rows[2].downloads);
 }
+
+TEST_F(AnnouncerTest, scheduleReturnsDueDeadlinesInOrder)
+{
+    using Kind = tr_announcer_schedule::Kind;
+
+    auto schedule = tr_announcer_schedule{};
+    schedule.set(1, 10U, Kind::Announce, 300);
+    schedule.set(1, 10U, Kind::Scrape, 100);
+    schedule.set(2, 20U, Kind::Scrape, 200);
+    EXPECT_EQ(3U, schedule.size());
+
+    // nothing is due yet
+    EXPECT_TRUE(std::empty(schedule.pop_due(99)));
+
+    auto const due = schedule.pop_due(200);
+    ASSERT_EQ(2U, std::size(due));
+    EXPECT_EQ((tr_announcer_schedule::Entry{ 100, 1, 10U, Kind::Scrape }), due[0]);
+    EXPECT_EQ((tr_announcer_schedule::Entry{ 200, 2, 20U, Kind::Scrape }), due[1]);
+
+    // popped deadlines are gone
+    EXPECT_EQ(1U, schedule.size());
+    EXPECT_TRUE(std::empty(schedule.pop_due(200)));
+    EXPECT_EQ(1U, std::size(schedule.pop_due(300)));
+    EXPECT_EQ(0U, schedule.size());
+}
+
+TEST_F(AnnouncerTest, scheduleKeepsOneDeadlinePerKind)
+{
+    using Kind = tr_announcer_schedule::Kind;
+
+    auto schedule = tr_announcer_schedule{};
+
+    // setting the same deadline again doesn't add another entry
+    for (int i = 0; i < 100; ++i)
+    {
+        schedule.set(1, 10U, Kind::Announce, 100);
+        schedule.set(1, 10U, Kind::Scrape, 100);
+    }
+    EXPECT_EQ(2U, schedule.size());
+    EXPECT_EQ(2U, schedule.heap_size());
+
+    // moving a deadline replaces the old one
+    schedule.set(1, 10U, Kind::Announce, 50);
+    schedule.set(1, 10U, Kind::Scrape, 150);
+    auto due = schedule.pop_due(100);
+    ASSERT_EQ(1U, std::size(due));
+    EXPECT_EQ(50, due[0].at);
+    EXPECT_EQ(Kind::Announce, due[0].kind);
+
+    // a deadline of 0 removes it
+    schedule.set(1, 10U, Kind::Scrape, 0);
+    EXPECT_EQ(0U, schedule.size());
+    EXPECT_TRUE(std::empty(schedule.pop_due(1000)));
+    EXPECT_EQ(0U, schedule.heap_size());
+}
+
+TEST_F(AnnouncerTest, scheduleHeapStaysBounded)
+{
+    using Kind = tr_announcer_schedule::Kind;
+
+    static auto constexpr NumTiers = size_t{ 10U };
+
+    // deadlines that keep moving, as deferred tiers' do, don't grow the heap without bound
+    auto schedule = tr_announcer_schedule{};
+    for (time_t now = 1; now <= 10000; ++now)
+    {
+        for (size_t tier_id = 0U; tier_id < NumTiers; ++tier_id)
+        {
+            schedule.set(1, tier_id, Kind::Announce, now + 60);
+            schedule.set(1, tier_id, Kind::Scrape, now + 120);
+        }
+
+        EXPECT_EQ(NumTiers * 2U, schedule.size());
+        EXPECT_LE(schedule.heap_size(), 64U + NumTiers * 2U);
+    }
+
+    // erasing a tier removes both of its deadlines
+    schedule.erase(0U);
+    EXPECT_EQ((NumTiers - 1U) * 2U, schedule.size());
+    auto const due = schedule.pop_due(1000000);
+    EXPECT_EQ((NumTiers - 1U) * 2U, std::size(due));
+    EXPECT_TRUE(std::ranges::none_of(due, [](auto const& entry) { return entry.tier_id == 0U; }));
+}
+
+TEST_F(AnnouncerTest, scrapePlanGroupsTiersByTracker)
+{
+    static auto constexpr Now = time_t{ 1000 };
+
+    auto tracker_a = tr_scrape_info{ tr_interned_string{ "https://a.example/scrape"sv }, 3U };
+    auto tracker_b = tr_scrape_info{ tr_interned_string{ "https://b.example/scrape"sv }, TrMultiscrapeMax };
+
+    // tiers due on both trackers, interleaved
+    auto const due = std::vector<std::pair<tr_scrape_info*, int>>{
+        { &tracker_a, 1 }, { &tracker_b, 2 }, { &tracker_a, 3 }, { &tracker_b, 4 }, { &tracker_a, 5 },
+    };
+    auto const plan = tr_scrape_plan<int>::make(due, {}, 20U, Now);
+
+    // each tracker's tiers are packed into one request
+    ASSERT_EQ(2U, std::size(plan.requests));
+    EXPECT_EQ(&tracker_a, plan.requests[0].first);
+    EXPECT_EQ((std::vector<int>{ 1, 3, 5 }), plan.requests[0].second);
+    EXPECT_EQ(&tracker_b, plan.requests[1].first);
+    EXPECT_EQ((std::vector<int>{ 2, 4 }), plan.requests[1].second);
+    EXPECT_TRUE(std::empty(plan.busy));
+    EXPECT_TRUE(std::empty(plan.throttled));
+    EXPECT_TRUE(std::empty(plan.deferred));
+}
+
+TEST_F(AnnouncerTest, scrapePlanSkipsTiersThatAreAnnouncing)
+{
+    static auto constexpr Now = time_t{ 1000 };
+
+    auto tracker = tr_scrape_info{ tr_interned_string{ "https://a.example/scrape"sv }, TrMultiscrapeMax };
+
+    auto const due = std::vector<std::pair<tr_scrape_info*, int>>{ { &tracker, 1 }, { &tracker, 2 }, { &tracker, 3 } };
+    auto const plan = tr_scrape_plan<int>::make(due, { 3, 1 }, 20U, Now);
+
+    ASSERT_EQ(1U, std::size(plan.requests));
+    EXPECT_EQ((std::vector<int>{ 2 }), plan.requests[0].second);
+
+    // and if all of them are announcing, no request is made at all
+    auto const none = tr_scrape_plan<int>::make(due, { 1, 2, 3 }, 20U, Now + 10);
+    EXPECT_TRUE(std::empty(none.requests));
+    EXPECT_TRUE(std::empty(none.deferred));
+    EXPECT_EQ(1U, tracker.requests_in_flight);
+}
+
+TEST_F(AnnouncerTest, scrapePlanKeepsWithinTrackerBudget)
+{
+    static auto constexpr Now = time_t{ 1000 };
+
+    // a tracker that takes two hashes per request
+    auto tracker = tr_scrape_info{ tr_interned_string{ "https://a.example/scrape"sv }, 2U };
+    auto const due = std::vector<std::pair<tr_scrape_info*, int>>{
+        { &tracker, 1 }, { &tracker, 2 }, { &tracker, 3 }, { &tracker, 4 }, { &tracker, 5 },
+    };
+
+    // only one request goes out at a time...
+    auto plan = tr_scrape_plan<int>::make(due, {}, 20U, Now);
+    ASSERT_EQ(1U, std::size(plan.requests));
+    EXPECT_EQ((std::vector<int>{ 1, 2 }), plan.requests[0].second);
+    EXPECT_EQ(1U, tracker.requests_in_flight);
+    EXPECT_EQ(Now + tr_scrape_info::MinRequestInterval, tracker.next_request_at);
+
+    // ...and the rest wait until the tracker may be sent another
+    EXPECT_EQ(3U, std::size(plan.throttled));
+    EXPECT_TRUE(std::empty(plan.busy));
+    EXPECT_TRUE(tracker.is_throttled(Now));
+    EXPECT_FALSE(tracker.is_throttled(tracker.next_request_at));
+
+    // once the tracker has too many requests in flight,
+    // the tiers wait for one of them to be answered
+    auto const later = tracker.next_request_at;
+    plan = tr_scrape_plan<int>::make(due, {}, 20U, later);
+    ASSERT_EQ(1U, std::size(plan.requests));
+    EXPECT_EQ(tr_scrape_info::MaxRequestsInFlight, tracker.requests_in_flight);
+    EXPECT_TRUE(tracker.is_busy());
+    EXPECT_EQ(3U, std::size(plan.busy));
+    EXPECT_TRUE(std::empty(plan.throttled));
+
+    plan = tr_scrape_plan<int>::make(due, {}, 20U, later + 60);
+    EXPECT_TRUE(std::empty(plan.requests));
+    EXPECT_EQ(5U, std::size(plan.busy));
+
+    // an answer frees up room for another request
+    --tracker.requests_in_flight;
+    plan = tr_scrape_plan<int>::make(due, {}, 20U, later + 60);
+    EXPECT_EQ(1U, std::size(plan.requests));
+    EXPECT_EQ(3U, std::size(plan.busy));
+}
+
+TEST_F(AnnouncerTest, scrapePlanKeepsWithinUpkeepBudget)
+{
+    static auto constexpr Now = time_t{ 1000 };
+
+    auto tracker_a = tr_scrape_info{ tr_interned_string{ "https://a.example/scrape"sv }, TrMultiscrapeMax };
+    auto tracker_b = tr_scrape_info{ tr_interned_string{ "https://b.example/scrape"sv }, TrMultiscrapeMax };
+
+    auto const due = std::vector<std::pair<tr_scrape_info*, int>>{ { &tracker_a, 1 }, { &tracker_b, 2 } };
+    auto const plan = tr_scrape_plan<int>::make(due, {}, 1U, Now);
+
+    ASSERT_EQ(1U, std::size(plan.requests));
+    EXPECT_EQ(&tracker_a, plan.requests[0].first);
+    EXPECT_EQ((std::vector<int>{ 2 }), plan.deferred);
+
+    // the tracker that wasn't sent anything wasn't charged for it
+    EXPECT_EQ(0U, tracker_b.requests_in_flight);
+    EXPECT_FALSE(tracker_b.is_throttled(Now));
+}
@@ -474,6 +474,66 @@ TEST_F(AnnouncerUdpTest, canDestructCleanlyEvenWhenBusy)
     // the announcer and mediator will go out-of-scope & be destroyed.
 }
 
+TEST_F(AnnouncerUdpTest, ignoresUnknownTransactionIds)
+{
+    auto mediator = MockMediator{};
+    auto announcer = tr_announcer_udp::create(mediator);
+    auto upkeep_timer = createUpkeepTimer(mediator, announcer);
+
+    // tell announcer to scrape
+    auto [request, expected_response] = buildSimpleScrapeRequestAndResponse();
+    auto response = std::optional<tr_scrape_response>{};
+    announcer->scrape(request, [&response](tr_scrape_response const& resp) { response = resp; });
+
+    auto from = sockaddr_storage{};
+    auto* const from_ptr = reinterpret_cast<struct sockaddr*>(&from);
+    auto fromlen = socklen_t{};
+
+    // connect
+    auto const connect_transaction_id = parseConnectionRequest(waitForAnnouncerToSendMessage(mediator, from_ptr, &fromlen));
+    auto const connection_id = sendConnectionResponse(*announcer, connect_transaction_id, from_ptr, fromlen);
+    auto const [scrape_transaction_id, info_hashes] = parseScrapeRequest(
+        waitForAnnouncerToSendMessage(mediator, from_ptr, &fromlen),
+        connection_id);
+    expectEqual(request, info_hashes);
+
+    // a stale connection response is not ours anymore
+    auto buf = MessageBuffer{};
+    buf.add_uint32(ConnectAction);
+    buf.add_uint32(connect_transaction_id);
+    buf.add_uint64(connection_id);
+    auto msg = std::vector<uint8_t>{};
+    msg.resize(std::size(buf));
+    buf.to_buf(msg);
+    EXPECT_FALSE(announcer->handle_message(std::data(msg), std::size(msg), from_ptr, fromlen));
+
+    // neither is a scrape response with the wrong transaction id
+    auto const make_scrape_response = [&](tau_transaction_t transaction_id)
+    {
+        auto scrape_buf = MessageBuffer{};
+        scrape_buf.add_uint32(ScrapeAction);
+        scrape_buf.add_uint32(transaction_id);
+        scrape_buf.add_uint32(expected_response.rows[0].seeders.value_or(-1));
+        scrape_buf.add_uint32(expected_response.rows[0].downloads.value_or(-1));
+        scrape_buf.add_uint32(expected_response.rows[0].leechers.value_or(-1));
+        auto scrape_msg = std::vector<uint8_t>{};
+        scrape_msg.resize(std::size(scrape_buf));
+        scrape_buf.to_buf(scrape_msg);
+        return scrape_msg;
+    };
+    msg = make_scrape_response(scrape_transaction_id + 1U);
+    EXPECT_FALSE(announcer->handle_message(std::data(msg), std::size(msg), from_ptr, fromlen));
+    EXPECT_FALSE(response.has_value());
+
+    // the right one is matched, but only once
+    msg = make_scrape_response(scrape_transaction_id);
+    EXPECT_TRUE(announcer->handle_message(std::data(msg), std::size(msg), from_ptr, fromlen));
+    ASSERT_TRUE(response.has_value());
+    expectEqual(expected_response, *response);
+    EXPECT_FALSE(announcer->handle_message(std::data(msg), std::size(msg), from_ptr, fromlen));
+    EXPECT_TRUE(announcer->is_idle());
+}
+
 TEST_F(AnnouncerUdpTest, canMultiScrape)
 {
     auto mediator = MockMediator{};
@@ -1314,6 +1314,70 @@ TEST_F(ApiCompatTest, canConvertRpc)
     }
 }
 
+TEST_F(ApiCompatTest, canConvertRpcResponseKeysWhileSerializing)
+{
+    using Style = tr::api_compat::Style;
+    using TestCase = std::tuple<std::string_view, std::string_view, std::string_view>;
+
+    // clang-format off
+    static auto constexpr TestCases = std::array<TestCase, 11U>{ {
+        { "free_space error response", BadFreeSpaceResponse, BadFreeSpaceResponseLegacy },
+        { "free_space response", WellFormedFreeSpaceResponse, WellFormedFreeSpaceLegacyResponse },
+        { "session_get response", CurrentSessionGetResponseJson, LegacySessionGetResponseJson },
+        { "port_test error response", CurrentPortTestErrorResponse, LegacyPortTestErrorResponse },
+        { "bad method name", BadMethodNameResponse, BadMethodNameLegacyResponse },
+        { "unrecognised info", UnrecognisedInfoResponse, UnrecognisedInfoLegacyResponse },
+        { "files wanted response object", CurrentFilesWantedResponseObjectJson, LegacyFilesWantedResponseObjectJson },
+        { "files wanted response array", CurrentFilesWantedResponseArrayJson, LegacyFilesWantedResponseArrayJson },
+        { "prefer encryption response", CurrentPreferEncryptionResponse, LegacyPreferEncryptionResponse },
+        { "require encryption response", CurrentRequireEncryptionResponse, LegacyRequireEncryptionResponse },
+        { "prefer clear response", CurrentPreferClearResponse, LegacyPreferClearResponse },
+    } };
+    // clang-format on
+
+    for (auto const& [name, src, expected] : TestCases)
+    {
+        auto serde = tr_variant_serde::json();
+        auto parsed = serde.parse(src);
+        ASSERT_TRUE(parsed.has_value()) << name << ": " << serde.error_;
+
+        // should match what convert() + serializing does
+        tr::api_compat::convert_except_keys(*parsed, Style::Tr4);
+        auto const key_style = tr::api_compat::make_key_style(*parsed, Style::Tr4);
+        ASSERT_NE(nullptr, key_style) << name;
+        EXPECT_EQ(expected, serde.key_style(key_style.get()).to_string(*parsed)) << name;
+    }
+}
+
+TEST_F(ApiCompatTest, canConvertRpcResponseKeysWhileSerializingBenc)
+{
+    using Style = tr::api_compat::Style;
+
+    static auto constexpr Responses = std::array{
+        BadFreeSpaceResponse,
+        CurrentSessionGetResponseJson,
+        CurrentFilesWantedResponseObjectJson,
+    };
+
+    for (auto const src : Responses)
+    {
+        auto parsed = tr_variant_serde::json().parse(src);
+        ASSERT_TRUE(parsed.has_value()) << src;
+        auto expected = tr_variant_serde::json().parse(src);
+        ASSERT_TRUE(expected.has_value()) << src;
+
+        // renamed keys change the sort order, so benc has to sort by the renamed keys
+        tr::api_compat::convert(*expected, Style::Tr4);
+        tr::api_compat::convert_except_keys(*parsed, Style::Tr4);
+        auto const key_style = tr::api_compat::make_key_style(*parsed, Style::Tr4);
+        ASSERT_NE(nullptr, key_style) << src;
+        EXPECT_EQ(
+            tr_variant_serde::benc().to_string(*expected),
+            tr_variant_serde::benc().key_style(key_style.get()).to_string(*parsed))
+            << src;
+    }
+}
+
 TEST_F(ApiCompatTest, canConvertJsonDataFiles)
 {
     using Style = tr::api_compat::Style;
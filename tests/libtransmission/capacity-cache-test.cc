@@ -0,0 +1,364 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint> // uintmax_t
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <libtransmission/capacity-cache.h>
+#include <libtransmission/error.h>
+#include <libtransmission/file.h>
+#include <libtransmission/timer.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+class CapacityCacheTest : public ::tr::test::TransmissionTest
+{
+protected:
+    class MockTimer final : public tr::Timer
+    {
+    public:
+        void stop() override
+        {
+        }
+
+        void set_callback(std::function<void()> callback) override
+        {
+            callback_ = std::move(callback);
+        }
+
+        void set_repeating(bool /* is_repeating */ = true) override
+        {
+        }
+
+        void set_interval(std::chrono::milliseconds /* msec */) override
+        {
+        }
+
+        void start() override
+        {
+        }
+
+        [[nodiscard]] std::chrono::milliseconds interval() const noexcept override
+        {
+            return {};
+        }
+
+        [[nodiscard]] bool is_repeating() const noexcept override
+        {
+            return {};
+        }
+
+        void fire() const
+        {
+            callback_();
+        }
+
+    private:
+        std::function<void()> callback_;
+    };
+
+    class MockTimerMaker final : public tr::TimerMaker
+    {
+    public:
+        [[nodiscard]] std::unique_ptr<tr::Timer> create() override
+        {
+            auto timer = std::make_unique<MockTimer>();
+            last_timer = timer.get();
+            return timer;
+        }
+
+        MockTimer* last_timer = nullptr;
+    };
+
+    class MockMediator final : public tr_capacity_cache::Mediator
+    {
+    public:
+        [[nodiscard]] tr::TimerMaker& timer_maker() override
+        {
+            return timer_maker_;
+        }
+
+        void queue_session_thread(std::function<void()> func) override
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+            queued_.emplace_back(std::move(func));
+        }
+
+        [[nodiscard]] tr_capacity_cache::Clock::time_point now() const override
+        {
+            return now_;
+        }
+
+        // run the callbacks that the worker threads have queued
+        void pump()
+        {
+            auto queued = std::vector<std::function<void()>>{};
+            {
+                auto const lock = std::scoped_lock{ mutex_ };
+                std::swap(queued, queued_);
+            }
+
+            for (auto const& func : queued)
+            {
+                func();
+            }
+        }
+
+        void fire_upkeep() const
+        {
+            timer_maker_.last_timer->fire();
+        }
+
+        tr_capacity_cache::Clock::time_point now_ = tr_capacity_cache::Clock::now();
+
+    private:
+        MockTimerMaker timer_maker_;
+        std::mutex mutex_;
+        std::vector<std::function<void()>> queued_;
+    };
+
+    // The fake disk. Its state is shared with the worker threads,
+    // which may outlive the test if it fails.
+    struct Disk
+    {
+        std::atomic<uintmax_t> available = 1000U;
+        std::atomic<size_t> n_started = 0U;
+        std::atomic<size_t> n_checks = 0U;
+        std::atomic<bool> is_hung = false;
+    };
+
+    static tr_capacity_cache::GetCapacityFunc make_get_capacity(std::shared_ptr<Disk> disk)
+    {
+        return [disk = std::move(disk)](std::string_view /*path*/, tr_error* /*error*/)
+        {
+            ++disk->n_started;
+
+            while (disk->is_hung)
+            {
+                std::this_thread::sleep_for(10ms);
+            }
+
+            ++disk->n_checks;
+            return std::optional<tr_sys_path_capacity>{ tr_sys_path_capacity{ disk->available, 2000U } };
+        };
+    }
+
+    // pump the mediator until `test` passes
+    bool wait_for(std::function<bool()> const& test)
+    {
+        return tr::test::waitFor(
+            [this, &test]()
+            {
+                mediator_.pump();
+                return test();
+            },
+            5s);
+    }
+
+    static auto constexpr MaxAge = 30s;
+    static auto constexpr MaxWait = 5s;
+    static auto constexpr Path = "/mnt/downloads"sv;
+
+    MockMediator mediator_;
+    std::shared_ptr<Disk> disk_ = std::make_shared<Disk>();
+};
+
+TEST_F(CapacityCacheTest, getNeverBlocks)
+{
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+
+    // not known yet, but that starts a check
+    EXPECT_FALSE(cache.get(Path));
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path).has_value(); }));
+    EXPECT_EQ(1000U, cache.get(Path)->available);
+
+    // cached values are served without checking the disk again
+    EXPECT_EQ(1000U, cache.get(Path)->available);
+    EXPECT_EQ(1U, disk_->n_checks);
+}
+
+TEST_F(CapacityCacheTest, waitersShareOneCheck)
+{
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+
+    auto n_answered = size_t{};
+    auto const callback = [&n_answered](std::optional<tr_sys_path_capacity> const& capacity, tr_error const& error)
+    {
+        EXPECT_FALSE(error);
+        ASSERT_TRUE(capacity);
+        EXPECT_EQ(1000U, capacity->available);
+        ++n_answered;
+    };
+
+    cache.get(Path, callback);
+    cache.get(Path, callback);
+    EXPECT_EQ(0U, n_answered);
+    EXPECT_TRUE(wait_for([&n_answered]() { return n_answered == 2U; }));
+    EXPECT_EQ(1U, disk_->n_checks);
+
+    // a fresh value is answered right away
+    cache.get(Path, callback);
+    EXPECT_EQ(3U, n_answered);
+}
+
+TEST_F(CapacityCacheTest, staleValuesAreNotServed)
+{
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+    EXPECT_FALSE(cache.get(Path));
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path).has_value(); }));
+
+    // an aging value is still served, but gets refreshed
+    disk_->available = 500U;
+    mediator_.now_ += MaxAge / 2 + 1s;
+    EXPECT_EQ(1000U, cache.get(Path)->available);
+    EXPECT_TRUE(wait_for([this]() { return disk_->n_checks == 2U; }));
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path)->available == 500U; }));
+
+    // an expired value is not served
+    disk_->is_hung = true;
+    mediator_.now_ += MaxAge + 1s;
+    EXPECT_FALSE(cache.get(Path));
+    disk_->is_hung = false;
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path).has_value(); }));
+}
+
+TEST_F(CapacityCacheTest, waitersTimeOut)
+{
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+    disk_->is_hung = true;
+
+    auto answered = std::optional<tr_error>{};
+    cache.get(
+        Path,
+        [&answered](std::optional<tr_sys_path_capacity> const& capacity, tr_error const& error)
+        {
+            EXPECT_FALSE(capacity);
+            answered = error;
+        });
+
+    mediator_.fire_upkeep();
+    EXPECT_FALSE(answered);
+
+    mediator_.now_ += MaxWait;
+    mediator_.fire_upkeep();
+    ASSERT_TRUE(answered);
+    EXPECT_EQ(ETIMEDOUT, answered->code());
+
+    // the hung check still finishes and updates the cache
+    disk_->is_hung = false;
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path).has_value(); }));
+}
+
+TEST_F(CapacityCacheTest, waitersAreAnsweredOnDestruction)
+{
+    auto cache = std::make_unique<tr_capacity_cache>(mediator_, make_get_capacity(disk_), MaxAge, MaxWait);
+    disk_->is_hung = true;
+
+    auto answered = std::optional<tr_error>{};
+    cache->get(
+        Path,
+        [&answered](std::optional<tr_sys_path_capacity> const& capacity, tr_error const& error)
+        {
+            EXPECT_FALSE(capacity);
+            answered = error;
+        });
+    EXPECT_FALSE(answered);
+
+    cache.reset();
+    ASSERT_TRUE(answered);
+    EXPECT_EQ(ECANCELED, answered->code());
+
+    // the hung check finishes without a cache to report to
+    disk_->is_hung = false;
+    EXPECT_TRUE(wait_for([this]() { return disk_->n_checks == 1U; }));
+}
+
+TEST_F(CapacityCacheTest, watchersAreToldWhenThresholdIsCrossed)
+{
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+
+    auto notified = std::vector<bool>{};
+    auto const id = cache.watch(
+        Path,
+        800U,
+        [&notified](std::string_view path, uintmax_t /*available*/, bool is_low)
+        {
+            EXPECT_EQ(Path, path);
+            notified.emplace_back(is_low);
+        });
+
+    // the first check is always reported
+    EXPECT_TRUE(wait_for([&notified]() { return std::size(notified) == 1U; }));
+    EXPECT_FALSE(notified.back());
+
+    // watched folders are refreshed by the upkeep timer
+    auto const refresh = [this, &cache](uintmax_t available)
+    {
+        auto const n_checks = disk_->n_checks.load();
+        disk_->available = available;
+        mediator_.now_ += MaxAge / 2 + 1s;
+        mediator_.fire_upkeep();
+        EXPECT_TRUE(wait_for([this, n_checks]() { return disk_->n_checks > n_checks; }));
+        EXPECT_TRUE(wait_for([&cache, available]() { return cache.get(Path)->available == available; }));
+    };
+
+    refresh(600U);
+    EXPECT_EQ((std::vector<bool>{ false, true }), notified);
+
+    // no news if it's still low
+    refresh(500U);
+    EXPECT_EQ((std::vector<bool>{ false, true }), notified);
+
+    refresh(900U);
+    EXPECT_EQ((std::vector<bool>{ false, true, false }), notified);
+
+    cache.unwatch(id);
+    disk_->available = 100U;
+    mediator_.now_ += MaxAge / 2 + 1s;
+    EXPECT_TRUE(wait_for([&cache]() { return cache.get(Path)->available == 100U; }));
+    EXPECT_EQ((std::vector<bool>{ false, true, false }), notified);
+}
+
+TEST_F(CapacityCacheTest, refreshesAreLimited)
+{
+    static auto constexpr MaxRefreshes = tr_capacity_cache::MaxRefreshes;
+
+    auto cache = tr_capacity_cache{ mediator_, make_get_capacity(disk_), MaxAge, MaxWait };
+    disk_->is_hung = true;
+
+    auto paths = std::vector<std::string>{};
+    for (size_t i = 0U; i <= MaxRefreshes; ++i)
+    {
+        paths.emplace_back("/mnt/disk" + std::to_string(i));
+        EXPECT_FALSE(cache.get(paths.back()));
+    }
+
+    // one folder has to wait until a hung check returns
+    EXPECT_TRUE(wait_for([this]() { return disk_->n_started == MaxRefreshes; }));
+    mediator_.fire_upkeep();
+    EXPECT_EQ(MaxRefreshes, disk_->n_started);
+
+    disk_->is_hung = false;
+    auto const all_known = [&cache, &paths]()
+    {
+        return std::ranges::all_of(paths, [&cache](auto const& path) { return cache.get(path).has_value(); });
+    };
+    EXPECT_TRUE(wait_for(all_known));
+    EXPECT_EQ(MaxRefreshes + 1U, disk_->n_checks);
+}
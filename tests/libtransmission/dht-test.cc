@@ -194,6 +194,15 @@ protected:
             auto addrport = tr_socket_address::from_sockaddr(sa);
             assert(addrport);
             pinged_.push_back(Pinged{ .addrport = *addrport, .timestamp = tr_time() });
+
+            // Fake a network where every pinged node answers at once
+            // and is added to the routing table as a good node.
+            if (responsive_)
+            {
+                ++good_;
+                ++incoming_;
+            }
+
             return 0;
         }
 
@@ -257,6 +266,7 @@ protected:
         int incoming_ = 0;
         size_t n_periodic_calls_ = 0;
         bool inited_ = false;
+        bool responsive_ = false;
         std::vector<Pinged> pinged_;
         std::vector<Searched> searched_;
         std::array<char, IdLength> id_ = {};
@@ -353,6 +363,16 @@ protected:
             return {};
         }
 
+        [[nodiscard]] int torrent_announce_priority(tr_torrent_id_t id) const override
+        {
+            if (auto const iter = priorities_.find(id); iter != std::end(priorities_))
+            {
+                return iter->second;
+            }
+
+            return 0;
+        }
+
         [[nodiscard]] std::string_view config_dir() const override
         {
             return config_dir_;
@@ -375,6 +395,7 @@ protected:
         std::string config_dir_;
         std::vector<tr_torrent_id_t> torrents_allowing_dht_;
         std::map<tr_torrent_id_t, tr_sha1_digest_t> info_hashes_;
+        std::map<tr_torrent_id_t, int> priorities_;
         MockDht mock_dht_;
         MockTimerMaker mock_timer_maker_;
     };
@@ -505,8 +526,16 @@ TEST_F(DhtTest, loadsStateFromStateFileExpiredId)
 
 TEST_F(DhtTest, stopsBootstrappingWhenSwarmHealthIsGoodEnough)
 {
-    auto const state_file = MockStateFile{};
-    state_file.save(sandboxDir());
+    // Make a 'dht.bootstrap' file. Unlike the nodes in the state file,
+    // which are all pinged at once, these are trickled in one at a time.
+    if (auto ofs = std::ofstream{ tr_pathbuf{ sandboxDir(), "/dht.bootstrap" } }; ofs)
+    {
+        for (auto i = 1; i <= 5; ++i)
+        {
+            ofs << "10.10.10." << i << ' ' << 6880 + i << '\n';
+        }
+        ofs.close();
+    }
 
     // Make the DHT
     auto mediator = MockMediator{ event_base_ };
@@ -554,6 +583,22 @@ TEST_F(DhtTest, savesStateIfSwarmIsGood)
     EXPECT_TRUE(tr_sys_path_exists(dat_file));
 }
 
+TEST_F(DhtTest, savesStatePeriodicallyIfSwarmIsGood)
+{
+    auto const dat_file = MockStateFile::filename(sandboxDir());
+    EXPECT_FALSE(tr_sys_path_exists(dat_file));
+
+    auto mediator = MockMediator{ event_base_ };
+    mediator.config_dir_ = sandboxDir();
+    mediator.mock_dht_.setHealthySwarm();
+
+    auto dht = tr_dht::create(mediator, ArbitraryPeerPort, ArbitrarySock4, ArbitrarySock6);
+
+    // the state should be snapshotted without waiting for shutdown
+    waitFor(event_base_, [&dat_file]() { return tr_sys_path_exists(dat_file); }, 5s);
+    EXPECT_TRUE(tr_sys_path_exists(dat_file));
+}
+
 TEST_F(DhtTest, doesNotSaveStateIfSwarmIsBad)
 {
     auto const state_file = MockStateFile{};
@@ -575,6 +620,43 @@ TEST_F(DhtTest, doesNotSaveStateIfSwarmIsBad)
     EXPECT_FALSE(tr_sys_path_exists(dat_file));
 }
 
+TEST_F(DhtTest, warmStartsFromStateFile)
+{
+    // Save enough nodes for a healthy routing table
+    auto state_file = MockStateFile{};
+    state_file.ipv4_nodes_.clear();
+    state_file.ipv6_nodes_.clear();
+    for (auto i = 1; i <= 25; ++i)
+    {
+        auto const port = tr_port::from_host(static_cast<uint16_t>(6880 + i));
+        state_file.ipv4_nodes_.emplace_back(*tr_address::from_string(fmt::format("10.10.11.{:d}", i)), port);
+        state_file.ipv6_nodes_.emplace_back(*tr_address::from_string(fmt::format("1002:1035::{:x}", i)), port);
+    }
+    state_file.save(sandboxDir());
+
+    tr_timeUpdate(time(nullptr));
+
+    auto constexpr Id = tr_torrent_id_t{ 1 };
+    auto mediator = MockMediator{ event_base_ };
+    mediator.config_dir_ = sandboxDir();
+    mediator.info_hashes_[Id] = tr_rand_obj<tr_sha1_digest_t>();
+    mediator.torrents_allowing_dht_ = { Id };
+    mediator.mock_dht_.responsive_ = true;
+
+    // Every saved node should be pinged while the DHT is being created,
+    // rather than one every few seconds. Since every node answers in this
+    // fake network, the routing table is ready in time for the DHT's
+    // first round of announces, which are made as it's created.
+    auto const begin = std::chrono::steady_clock::now();
+    auto dht = tr_dht::create(mediator, ArbitraryPeerPort, ArbitrarySock4, ArbitrarySock6);
+    auto const time_to_ready = std::chrono::steady_clock::now() - begin;
+
+    auto const& mock_dht = mediator.mock_dht_;
+    EXPECT_EQ(std::size(state_file.ipv4_nodes_) + std::size(state_file.ipv6_nodes_), std::size(mock_dht.pinged_));
+    EXPECT_EQ(2U, std::size(mock_dht.searched_));
+    EXPECT_LT(time_to_ready, 2s);
+}
+
 TEST_F(DhtTest, usesBootstrapFile)
 {
     // Make the 'dht.bootstrap' file.
@@ -660,6 +742,77 @@ TEST_F(DhtTest, announcesTorrents)
     EXPECT_EQ(AF_INET6, mock_dht.searched_[1].af);
 }
 
+TEST_F(DhtTest, announcesHighPriorityTorrentsFirstWithinBudget)
+{
+    tr_timeUpdate(time(nullptr));
+
+    auto mediator = MockMediator{ event_base_ };
+    mediator.config_dir_ = sandboxDir();
+    for (auto id = tr_torrent_id_t{ 1 }; id <= 3; ++id)
+    {
+        mediator.info_hashes_[id] = tr_rand_obj<tr_sha1_digest_t>();
+        mediator.torrents_allowing_dht_.push_back(id);
+    }
+    static auto constexpr PriorityId = tr_torrent_id_t{ 3 };
+    mediator.priorities_[PriorityId] = 1;
+
+    auto& mock_dht = mediator.mock_dht_;
+    mock_dht.setHealthySwarm();
+
+    // The DHT announces as soon as it's created. Three torrents need
+    // six searches, which is more than a single tick's budget allows.
+    auto dht = tr_dht::create(mediator, ArbitraryPeerPort, ArbitrarySock4, ArbitrarySock6);
+    auto const& searched = mock_dht.searched_;
+    ASSERT_EQ(4U, std::size(searched));
+    EXPECT_EQ(2U, dht->announce_queue_depth());
+    EXPECT_EQ(mediator.info_hashes_[PriorityId], searched[0].info_hash);
+    EXPECT_EQ(mediator.info_hashes_[PriorityId], searched[1].info_hash);
+    EXPECT_NE(mediator.info_hashes_[PriorityId], searched[2].info_hash);
+    EXPECT_GT(dht->searches_per_second(), 0.0);
+
+    // the rest are announced on the next tick
+    waitFor(event_base_, [&searched]() { return std::size(searched) >= 6U; }, 5s);
+    EXPECT_EQ(6U, std::size(searched));
+    EXPECT_EQ(0U, dht->announce_queue_depth());
+}
+
+TEST_F(DhtTest, reannouncesResumedTorrents)
+{
+    tr_timeUpdate(time(nullptr));
+
+    auto mediator = MockMediator{ event_base_ };
+    mediator.config_dir_ = sandboxDir();
+    for (auto id = tr_torrent_id_t{ 1 }; id <= 3; ++id)
+    {
+        mediator.info_hashes_[id] = tr_rand_obj<tr_sha1_digest_t>();
+        mediator.torrents_allowing_dht_.push_back(id);
+    }
+
+    auto& mock_dht = mediator.mock_dht_;
+    mock_dht.setHealthySwarm();
+
+    // The first tick's budget only covers torrents 1 and 2,
+    // so torrent 3's announces are still waiting in the queue.
+    auto dht = tr_dht::create(mediator, ArbitraryPeerPort, ArbitrarySock4, ArbitrarySock6);
+    auto const& searched = mock_dht.searched_;
+    ASSERT_EQ(4U, std::size(searched));
+    EXPECT_EQ(2U, dht->announce_queue_depth());
+
+    // pause torrent 3 before its announces are sent
+    static auto constexpr PausedId = tr_torrent_id_t{ 3 };
+    mediator.torrents_allowing_dht_ = { 1, 2 };
+    waitFor(event_base_, MockTimerInterval * 5);
+    EXPECT_EQ(4U, std::size(searched));
+    EXPECT_EQ(0U, dht->announce_queue_depth());
+
+    // resume it
+    mediator.torrents_allowing_dht_ = { 1, 2, PausedId };
+    waitFor(event_base_, [&searched]() { return std::size(searched) >= 6U; }, 5s);
+    ASSERT_EQ(6U, std::size(searched));
+    EXPECT_EQ(mediator.info_hashes_[PausedId], searched[4].info_hash);
+    EXPECT_EQ(mediator.info_hashes_[PausedId], searched[5].info_hash);
+}
+
 TEST_F(DhtTest, callsPeriodicPeriodically)
 {
     auto mediator = MockMediator{ event_base_ };
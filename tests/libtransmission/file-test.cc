@@ -28,6 +28,7 @@
 #include <gtest/gtest.h>
 
 #include <libtransmission/error.h>
+#include <libtransmission/file-utils.h>
 #include <libtransmission/file.h>
 #include <libtransmission/string-utils.h>
 #include <libtransmission/tr-macros.h>
@@ -642,6 +643,30 @@ TEST_F(FileTest, pathIsSame)
     // NOLINTEND(readability-suspicious-call-argument)
 }
 
+TEST_F(FileTest, pathIsSameDevice)
+{
+    auto const test_dir = createTestDir(currentTestName());
+
+    auto const path1 = tr_pathbuf{ test_dir, "/a"sv };
+    auto const path2 = tr_pathbuf{ test_dir, "/b"sv };
+
+    // a non-existent path isn't on any device
+    auto error = tr_error{};
+    EXPECT_FALSE(tr_sys_path_is_same_device(path1, test_dir, &error));
+    EXPECT_TRUE(error);
+    error = {};
+
+    // a file and its directory are on the same device
+    createFileWithContents(path1, "test");
+    EXPECT_TRUE(tr_sys_path_is_same_device(path1, test_dir, &error));
+    EXPECT_FALSE(error) << error;
+
+    // so are two files in the same directory
+    tr_sys_dir_create(path2, 0, 0777);
+    EXPECT_TRUE(tr_sys_path_is_same_device(path1, path2, &error));
+    EXPECT_FALSE(error) << error;
+}
+
 TEST_F(FileTest, pathResolve)
 {
     auto const test_dir = createTestDir(currentTestName());
@@ -1057,6 +1082,43 @@ TEST_F(FileTest, fileCopy)
     EXPECT_FALSE(error) << error;
 }
 
+TEST_F(FileTest, fileCopyRange)
+{
+    auto const test_dir = createTestDir(currentTestName());
+
+    auto const path1 = tr_pathbuf{ test_dir, "/a.txt"sv };
+    auto const path2 = tr_pathbuf{ test_dir, "/b.txt"sv };
+    auto constexpr Contents = "hello, world!"sv;
+    createFileWithContents(path1, Contents);
+
+    auto const in = tr_sys_file_open(path1, TR_SYS_FILE_READ, 0);
+    auto const out = tr_sys_file_open(path2, TR_SYS_FILE_WRITE | TR_SYS_FILE_CREATE | TR_SYS_FILE_TRUNCATE, 0600);
+    ASSERT_NE(TR_BAD_SYS_FILE, in);
+    ASSERT_NE(TR_BAD_SYS_FILE, out);
+
+    // copy the file in two pieces, out of order
+    auto error = tr_error{};
+    auto n_copied = uint64_t{};
+    EXPECT_TRUE(tr_sys_file_copy_range(in, out, 5U, std::size(Contents) - 5U, &n_copied, &error));
+    EXPECT_FALSE(error) << error;
+    EXPECT_EQ(std::size(Contents) - 5U, n_copied);
+    EXPECT_TRUE(tr_sys_file_copy_range(in, out, 0U, 5U, &n_copied, &error));
+    EXPECT_FALSE(error) << error;
+    EXPECT_EQ(5U, n_copied);
+
+    // copying past the end of the source copies what's there
+    EXPECT_TRUE(tr_sys_file_copy_range(in, out, std::size(Contents) - 1U, 100U, &n_copied, &error));
+    EXPECT_FALSE(error) << error;
+    EXPECT_EQ(1U, n_copied);
+
+    tr_sys_file_close(out);
+    tr_sys_file_close(in);
+
+    auto contents = std::vector<char>{};
+    EXPECT_TRUE(tr_file_read(path2, contents));
+    EXPECT_EQ(Contents, std::string_view(std::data(contents), std::size(contents)));
+}
+
 TEST_F(FileTest, fileOpen)
 {
     auto const test_dir = createTestDir(currentTestName());
@@ -281,6 +281,28 @@ TEST_P(JSONTest, unescape)
     EXPECT_EQ("/usr/lib"sv, *sv);
 }
 
+TEST_P(JSONTest, knownKeysOnly)
+{
+    static auto constexpr Input =
+        R"({ "arguments": { "ids": [ 7 ], "not a known json quark 1": 1 },)"
+        R"(  "not a known json quark 2": { "id": 2 }, "tag": 3 })"sv;
+
+    auto var = tr_variant_serde::json().inplace().known_keys_only().parse(Input).value_or(tr_variant{});
+    auto* map = var.get_if<tr_variant::Map>();
+    ASSERT_NE(map, nullptr);
+    EXPECT_EQ(2U, std::size(*map));
+    EXPECT_EQ(3, map->value_if<int64_t>(TR_KEY_tag));
+
+    auto* args = map->find_if<tr_variant::Map>(TR_KEY_arguments);
+    ASSERT_NE(args, nullptr);
+    EXPECT_EQ(1U, std::size(*args));
+    EXPECT_NE(args->find_if<tr_variant::Vector>(TR_KEY_ids), nullptr);
+
+    // and no new quarks were added
+    EXPECT_FALSE(tr_quark_lookup("not a known json quark 1"sv));
+    EXPECT_FALSE(tr_quark_lookup("not a known json quark 2"sv));
+}
+
 TEST_P(JSONTest, parseJsonFuzz)
 {
     auto serde = tr_variant_serde::json().inplace();
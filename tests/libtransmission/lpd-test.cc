@@ -5,12 +5,15 @@
 
 #include <array>
 #include <chrono>
+#include <cstddef> // size_t
 #include <ctime>
 #include <set>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include <fmt/format.h>
+
 #include <gtest/gtest.h>
 
 #include <libtransmission/transmission.h> // tr_torrent_activity
@@ -219,4 +222,63 @@ TEST_F(LpdTest, DISABLED_DoesNotReannounceTooSoon)
     }
 }
 
+TEST_F(LpdTest, announceIntervalGrowsWithLanPeers)
+{
+    using LanPeers = tr_lpd::LanPeers;
+    static auto constexpr Now = time_t{ 10000 };
+
+    auto const make_address = [](size_t const n)
+    {
+        return *tr_address::from_string(fmt::format("192.168.{:d}.{:d}", n / 256U, n % 256U));
+    };
+
+    // with nobody else around, use the shortest interval
+    auto peers = LanPeers{};
+    EXPECT_EQ(LanPeers::MinAnnounceIntervalSec, peers.announce_interval());
+
+    // each step of peers makes it a little longer
+    for (size_t i = 0U; i < LanPeers::PeersPerIntervalStep; ++i)
+    {
+        peers.note(make_address(i), Now);
+    }
+    EXPECT_EQ(LanPeers::MinAnnounceIntervalSec * 2, peers.announce_interval());
+
+    // hearing from the same peers again doesn't
+    for (size_t i = 0U; i < LanPeers::PeersPerIntervalStep; ++i)
+    {
+        peers.note(make_address(i), Now + 1);
+    }
+    EXPECT_EQ(LanPeers::PeersPerIntervalStep, peers.size());
+    EXPECT_EQ(LanPeers::MinAnnounceIntervalSec * 2, peers.announce_interval());
+
+    // but no matter how many peers there are, the interval is capped
+    for (size_t i = 0U; i < LanPeers::MaxPeers * 2U; ++i)
+    {
+        peers.note(make_address(i), Now + 2);
+    }
+    EXPECT_EQ(LanPeers::MaxPeers, peers.size());
+    EXPECT_EQ(LanPeers::MaxAnnounceIntervalSec, peers.announce_interval());
+}
+
+TEST_F(LpdTest, lanPeersExpire)
+{
+    using LanPeers = tr_lpd::LanPeers;
+    static auto constexpr Now = time_t{ 10000 };
+
+    auto peers = LanPeers{};
+    peers.note(*tr_address::from_string("192.168.0.1"), Now);
+    peers.note(*tr_address::from_string("192.168.0.2"), Now + 100);
+
+    peers.prune(Now + LanPeers::TtlSec);
+    EXPECT_EQ(2U, peers.size());
+
+    // peers that have gone quiet stop counting
+    peers.prune(Now + LanPeers::TtlSec + 1);
+    EXPECT_EQ(1U, peers.size());
+
+    peers.prune(Now + 100 + LanPeers::TtlSec + 1);
+    EXPECT_EQ(0U, peers.size());
+    EXPECT_EQ(LanPeers::MinAnnounceIntervalSec, peers.announce_interval());
+}
+
 } // namespace tr::test
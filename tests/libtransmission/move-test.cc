@@ -4,7 +4,10 @@
 // License text can be found in the licenses/ folder.
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -14,9 +17,11 @@
 #include <libtransmission/transmission.h>
 
 #include <libtransmission/block-info.h>
+#include <libtransmission/file-utils.h>
 #include <libtransmission/file.h> // tr_sys_path_*()
 #include <libtransmission/inout.h>
 #include <libtransmission/quark.h>
+#include <libtransmission/relocate.h>
 #include <libtransmission/torrent-files.h>
 #include <libtransmission/torrent.h>
 #include <libtransmission/tr-strbuf.h>
@@ -196,4 +201,125 @@ TEST_F(MoveTest, setLocation)
     tr_torrentRemove(tor, true);
 }
 
+
+/***
+****
+***/
+
+class RelocateWorkerTest : public SandboxedTest
+{
+protected:
+    [[nodiscard]] auto makeFile(std::string_view src_dir, std::string_view dst_dir, std::string_view name, size_t size)
+    {
+        auto file = tr_relocate_worker::File{};
+        file.src = tr_pathbuf{ src_dir, '/', name };
+        file.dst = tr_pathbuf{ dst_dir, '/', name };
+        file.size = size;
+        createFileWithContents(file.src, std::string(size, 'x'));
+        return file;
+    }
+
+    [[nodiscard]] auto onDone()
+    {
+        return [this](tr_relocate_worker::Result&& result)
+        {
+            auto const lock = std::scoped_lock{ mutex_ };
+            result_ = std::move(result);
+        };
+    }
+
+    [[nodiscard]] std::optional<tr_relocate_worker::Result> result() const
+    {
+        auto const lock = std::scoped_lock{ mutex_ };
+        return result_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::optional<tr_relocate_worker::Result> result_;
+};
+
+TEST_F(RelocateWorkerTest, copiesToStagingPaths)
+{
+    auto const src_dir = tr_pathbuf{ sandboxDir(), "/src"sv };
+    auto const dst_dir = tr_pathbuf{ sandboxDir(), "/dst"sv };
+    tr_sys_dir_create(src_dir, TR_SYS_DIR_CREATE_PARENTS, 0777);
+    tr_sys_dir_create(dst_dir, TR_SYS_DIR_CREATE_PARENTS, 0777);
+
+    auto files = std::vector<tr_relocate_worker::File>{};
+    files.emplace_back(makeFile(src_dir, dst_dir, "a.txt"sv, 100U));
+    files.emplace_back(makeFile(src_dir, dst_dir, "b.txt"sv, 200U));
+
+    auto worker = tr_relocate_worker{};
+    worker.add(1, std::string{ dst_dir }, files, onDone());
+    EXPECT_TRUE(waitFor([this]() { return result().has_value(); }, MaxWaitMsec));
+
+    auto const done = result();
+    ASSERT_TRUE(done);
+    EXPECT_EQ(1, done->tor_id);
+    EXPECT_EQ(dst_dir.sv(), done->location);
+    EXPECT_FALSE(done->cancelled);
+    EXPECT_FALSE(done->error) << done->error;
+    EXPECT_FALSE(worker.progress(1));
+
+    // the worker only stages the copies; the originals are left alone
+    for (auto const& file : files)
+    {
+        auto contents = std::vector<char>{};
+        EXPECT_TRUE(tr_file_read(tr_relocate_worker::staging_path(file.dst), contents));
+        EXPECT_EQ(file.size, std::size(contents));
+        EXPECT_TRUE(tr_sys_path_exists(file.src));
+        EXPECT_FALSE(tr_sys_path_exists(file.dst));
+    }
+}
+
+TEST_F(RelocateWorkerTest, cancelRemovesStagedCopies)
+{
+    auto const src_dir = tr_pathbuf{ sandboxDir(), "/src"sv };
+    auto const dst_dir = tr_pathbuf{ sandboxDir(), "/dst"sv };
+    tr_sys_dir_create(src_dir, TR_SYS_DIR_CREATE_PARENTS, 0777);
+    tr_sys_dir_create(dst_dir, TR_SYS_DIR_CREATE_PARENTS, 0777);
+
+    auto files = std::vector<tr_relocate_worker::File>{};
+    files.emplace_back(makeFile(src_dir, dst_dir, "a.txt"sv, 1000U));
+    files.emplace_back(makeFile(src_dir, dst_dir, "b.txt"sv, 1000U));
+
+    // slow enough that the job is still throttled after the first file
+    auto worker = tr_relocate_worker{};
+    worker.set_speed_limit(10U);
+    worker.add(1, std::string{ dst_dir }, files, onDone());
+
+    auto const first_file_copied = [&worker]()
+    {
+        auto const progress = worker.progress(1);
+        return progress && progress->bytes_copied == 1000U;
+    };
+    EXPECT_TRUE(waitFor(first_file_copied, MaxWaitMsec));
+
+    auto const progress = worker.progress(1);
+    ASSERT_TRUE(progress);
+    EXPECT_EQ(dst_dir.sv(), progress->location);
+    EXPECT_EQ(2000U, progress->bytes_total);
+    ASSERT_EQ(2U, std::size(progress->files));
+    EXPECT_EQ(1000U, progress->files[0].second);
+    EXPECT_EQ(0U, progress->files[1].second);
+
+    // cancelling doesn't wait for the job to stop
+    auto const cancel_began = std::chrono::steady_clock::now();
+    worker.cancel(1);
+    EXPECT_LT(std::chrono::steady_clock::now() - cancel_began, std::chrono::seconds{ 1 });
+    EXPECT_FALSE(worker.progress(1));
+
+    EXPECT_TRUE(waitFor([this]() { return result().has_value(); }, MaxWaitMsec));
+    auto const done = result();
+    ASSERT_TRUE(done);
+    EXPECT_TRUE(done->cancelled);
+    EXPECT_FALSE(worker.progress(1));
+    for (auto const& file : files)
+    {
+        EXPECT_FALSE(tr_sys_path_exists(tr_relocate_worker::staging_path(file.dst)));
+        EXPECT_TRUE(tr_sys_path_exists(file.src));
+    }
+}
+
 } // namespace tr::test
@@ -3,8 +3,102 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <string_view>
+
 #include <gtest/gtest.h>
 
-TEST(PeerMsgs, placeholder)
+#include <libtransmission/peer-msgs-benc.h>
+
+using namespace std::literals;
+
+TEST(PeerMsgs, parseLtepHandshake)
 {
+    // clang-format off
+    auto constexpr Benc =
+        "d"
+            "1:ei1e"
+            "4:ipv44:\x01\x02\x03\x04"
+            "1:m" "d"
+                "12:ut_holepunchi4e"
+                "11:ut_metadatai2e"
+                "6:ut_pexi1e"
+            "e"
+            "13:metadata_sizei12345e"
+            "1:pi51413e"
+            "4:reqqi512e"
+            "11:upload_onlyi1e"
+            "1:v" "18:Transmission 4.1.0"
+            "6:yourip" "4:\x05\x06\x07\x08"
+            "7:unknown" "l" "i1e" "d" "1:pi9e" "e" "e"
+        "e"sv;
+    // clang-format on
+
+    auto handshake = tr_ltep_handshake{};
+    EXPECT_TRUE(tr_ltepParseHandshake(Benc, handshake));
+    EXPECT_EQ(1, handshake.e);
+    EXPECT_EQ("\x01\x02\x03\x04"sv, handshake.ipv4);
+    EXPECT_FALSE(handshake.ipv6);
+    EXPECT_EQ(4, handshake.ut_holepunch);
+    EXPECT_EQ(2, handshake.ut_metadata);
+    EXPECT_EQ(1, handshake.ut_pex);
+    EXPECT_EQ(12345, handshake.metadata_size);
+    EXPECT_EQ(51413, handshake.p); // not the nested "p" in "unknown"
+    EXPECT_EQ(512, handshake.reqq);
+    EXPECT_EQ(1, handshake.upload_only);
+    EXPECT_EQ("Transmission 4.1.0"sv, handshake.v);
+    EXPECT_EQ("\x05\x06\x07\x08"sv, handshake.yourip);
+}
+
+TEST(PeerMsgs, parseLtepHandshakeIgnoresWrongTypes)
+{
+    auto handshake = tr_ltep_handshake{};
+    EXPECT_TRUE(tr_ltepParseHandshake("d1:e1:x1:vi5e1:mi3ee"sv, handshake));
+    EXPECT_FALSE(handshake.e);
+    EXPECT_FALSE(handshake.v);
+    EXPECT_FALSE(handshake.ut_pex);
+}
+
+TEST(PeerMsgs, parseLtepHandshakeRejectsNonDict)
+{
+    auto handshake = tr_ltep_handshake{};
+    EXPECT_FALSE(tr_ltepParseHandshake("li1ee"sv, handshake));
+    EXPECT_FALSE(tr_ltepParseHandshake("i1e"sv, handshake));
+    EXPECT_FALSE(tr_ltepParseHandshake("d1:pi1e"sv, handshake));
+    EXPECT_FALSE(tr_ltepParseHandshake(""sv, handshake));
+}
+
+TEST(PeerMsgs, parseUtPex)
+{
+    auto constexpr Benc = "d5:added6:abcdef7:added.f1:\x10" "6:added618:0123456789abcdefgh7:dropped0:e"sv;
+
+    auto pex = tr_ut_pex_msg{};
+    EXPECT_TRUE(tr_ltepParseUtPex(Benc, pex));
+    EXPECT_EQ("abcdef"sv, pex.added);
+    EXPECT_EQ("\x10"sv, pex.added_f);
+    EXPECT_EQ("0123456789abcdefgh"sv, pex.added6);
+    EXPECT_FALSE(pex.added6_f);
+
+    // the decoded strings point into the input buffer
+    ASSERT_TRUE(pex.added);
+    EXPECT_EQ(std::data(Benc) + 10, std::data(*pex.added));
+}
+
+TEST(PeerMsgs, parseUtMetadata)
+{
+    auto constexpr Benc = "d8:msg_typei1e5:piecei2e10:total_sizei34567eexxxxxxxx"sv;
+
+    auto msg = tr_ut_metadata_msg{};
+    EXPECT_TRUE(tr_ltepParseUtMetadata(Benc, msg));
+    EXPECT_EQ(1, msg.msg_type);
+    EXPECT_EQ(2, msg.piece);
+    EXPECT_EQ(34567, msg.total_size);
+    EXPECT_EQ("xxxxxxxx"sv, msg.trailer);
+
+    EXPECT_TRUE(tr_ltepParseUtMetadata("d8:msg_typei0ee"sv, msg));
+    EXPECT_EQ(0, msg.msg_type);
+    EXPECT_EQ(-1, msg.piece);
+    EXPECT_EQ(0, msg.total_size);
+    EXPECT_EQ(""sv, msg.trailer);
+
+    EXPECT_FALSE(tr_ltepParseUtMetadata("3:abc"sv, msg));
 }
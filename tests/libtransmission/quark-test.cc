@@ -7,6 +7,10 @@
 #include <cstddef> // size_t
 #include <string>
 #include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
 
 #include <libtransmission/quark.h>
 
@@ -32,3 +36,68 @@ TEST_F(QuarkTest, newQuarkByStringView)
     auto const q = tr_quark_new(UniqueString);
     EXPECT_EQ(UniqueString, tr_quark_get_string_view(q));
 }
+
+TEST_F(QuarkTest, newQuarkReturnsExistingQuark)
+{
+    EXPECT_EQ(TR_KEY_ut_pex, tr_quark_new("ut_pex"));
+
+    auto constexpr UniqueString = std::string_view{ "another string that is not a predefined quark" };
+    auto const q = tr_quark_new(UniqueString);
+    EXPECT_EQ(q, tr_quark_new(std::string{ UniqueString }));
+    EXPECT_EQ(q, tr_quark_lookup(UniqueString));
+}
+
+TEST_F(QuarkTest, newQuarkIsZeroTerminated)
+{
+    // long enough to not fit in a shared block
+    auto const long_string = std::string(8192U, 'x');
+    auto const long_q = tr_quark_new(long_string);
+    auto const short_q = tr_quark_new("short runtime quark");
+
+    for (auto const q : { long_q, short_q })
+    {
+        auto const sv = tr_quark_get_string_view(q);
+        EXPECT_EQ('\0', *(std::data(sv) + std::size(sv)));
+    }
+
+    EXPECT_EQ(long_string, tr_quark_get_string_view(long_q));
+    EXPECT_EQ("short runtime quark", tr_quark_get_string_view(short_q));
+}
+
+TEST_F(QuarkTest, newQuarkIsThreadSafe)
+{
+    static auto constexpr NumThreads = 8U;
+    static auto constexpr NumKeys = 500U;
+
+    auto results = std::vector<std::vector<tr_quark>>(NumThreads);
+    auto threads = std::vector<std::thread>{};
+    for (size_t i = 0U; i < NumThreads; ++i)
+    {
+        threads.emplace_back(
+            [&quarks = results[i]]()
+            {
+                for (size_t key = 0U; key < NumKeys; ++key)
+                {
+                    auto const q = tr_quark_new(fmt::format("thread-safety test key {:d}", key));
+                    quarks.push_back(q);
+                    EXPECT_EQ(q, tr_quark_lookup(tr_quark_get_string_view(q)));
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // every thread should have gotten the same quark for the same key
+    for (auto const& quarks : results)
+    {
+        EXPECT_EQ(results.front(), quarks);
+    }
+
+    for (size_t key = 0U; key < NumKeys; ++key)
+    {
+        EXPECT_EQ(fmt::format("thread-safety test key {:d}", key), tr_quark_get_string_view(results.front()[key]));
+    }
+}
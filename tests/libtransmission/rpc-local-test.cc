@@ -0,0 +1,227 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <array>
+#include <cstdint> // int64_t, uint32_t
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/file.h>
+#include <libtransmission/quark.h>
+#include <libtransmission/rpc-local.h>
+#include <libtransmission/session.h>
+#include <libtransmission/tr-strbuf.h>
+#include <libtransmission/transmission.h>
+#include <libtransmission/variant.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+namespace tr::test
+{
+
+class RpcLocalTest : public SessionTest
+{
+protected:
+    void SetUp() override
+    {
+        SessionTest::SetUp();
+
+        path_ = tr_pathbuf{ sandboxDir(), "/rpc.sock"sv };
+        inSessionThread(
+            [this]()
+            {
+                server_ = std::make_unique<tr_rpc_local_server>(session_);
+                EXPECT_TRUE(server_->start(path_, 0600));
+            });
+    }
+
+    void TearDown() override
+    {
+        inSessionThread([this]() { server_.reset(); });
+        SessionTest::TearDown();
+    }
+
+    template<typename Func>
+    void inSessionThread(Func&& func)
+    {
+        auto promise = std::promise<void>{};
+        auto future = promise.get_future();
+        session_->run_in_session_thread(
+            [&func, &promise]()
+            {
+                func();
+                promise.set_value();
+            });
+        future.wait();
+    }
+
+    [[nodiscard]] int connectToServer() const
+    {
+        auto addr = sockaddr_un{};
+        addr.sun_family = AF_UNIX;
+        std::ranges::copy(path_, addr.sun_path);
+
+        auto const sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+        EXPECT_NE(-1, sockfd);
+        EXPECT_EQ(0, connect(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)));
+
+        // don't let a broken server hang the test
+        auto timeout = timeval{};
+        timeout.tv_sec = 5;
+        setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        return sockfd;
+    }
+
+    static std::string makeMessage(std::string_view const payload)
+    {
+        auto const len = static_cast<uint32_t>(std::size(payload));
+        auto message = std::string{};
+        message += static_cast<char>(len >> 24U);
+        message += static_cast<char>(len >> 16U);
+        message += static_cast<char>(len >> 8U);
+        message += static_cast<char>(len);
+        message += payload;
+        return message;
+    }
+
+    static bool readAll(int const sockfd, char* buf, size_t len)
+    {
+        while (len > 0U)
+        {
+            auto const n_read = read(sockfd, buf, len);
+            if (n_read <= 0)
+            {
+                return false;
+            }
+
+            buf += n_read;
+            len -= static_cast<size_t>(n_read);
+        }
+
+        return true;
+    }
+
+    // returns nullopt if the server closed the connection
+    static std::optional<std::string> readMessage(int const sockfd)
+    {
+        auto header = std::array<unsigned char, 4U>{};
+        if (!readAll(sockfd, reinterpret_cast<char*>(std::data(header)), std::size(header)))
+        {
+            return {};
+        }
+
+        auto message = std::string(
+            (size_t{ header[0] } << 24U) | (size_t{ header[1] } << 16U) | (size_t{ header[2] } << 8U) | header[3],
+            '\0');
+        if (!readAll(sockfd, std::data(message), std::size(message)))
+        {
+            return {};
+        }
+
+        return message;
+    }
+
+    static std::optional<int64_t> getId(std::optional<tr_variant> const& response)
+    {
+        auto const* const map = response ? response->get_if<tr_variant::Map>() : nullptr;
+        return map != nullptr ? map->value_if<int64_t>(TR_KEY_id) : std::nullopt;
+    }
+
+    std::string path_;
+    std::unique_ptr<tr_rpc_local_server> server_;
+};
+
+TEST_F(RpcLocalTest, pipelinedRequestsAreAnsweredInOrder)
+{
+    auto const sockfd = connectToServer();
+
+    // send them all before reading any of the responses
+    auto requests = std::string{};
+    requests += makeMessage(R"({"jsonrpc":"2.0","method":"session_get","params":{"fields":["version"]},"id":1})"sv);
+    requests += makeMessage(R"({"jsonrpc":"2.0","method":"session_stats"})"sv);
+    requests += makeMessage("d2:idi2e7:jsonrpc3:2.06:method13:session_statse"sv);
+    EXPECT_EQ(static_cast<ssize_t>(std::size(requests)), write(sockfd, std::data(requests), std::size(requests)));
+
+    // JSON requests get JSON responses
+    auto response = readMessage(sockfd);
+    ASSERT_TRUE(response);
+    EXPECT_EQ(1, getId(tr_variant_serde::json().parse(*response)));
+
+    // notifications get an empty response
+    response = readMessage(sockfd);
+    ASSERT_TRUE(response);
+    EXPECT_EQ(""sv, *response);
+
+    // benc requests get benc responses
+    response = readMessage(sockfd);
+    ASSERT_TRUE(response);
+    EXPECT_TRUE(response->starts_with('d'));
+    EXPECT_EQ(2, getId(tr_variant_serde::benc().parse(*response)));
+
+    close(sockfd);
+}
+
+TEST_F(RpcLocalTest, oversizedMessagesCloseTheConnection)
+{
+    auto const sockfd = connectToServer();
+
+    auto constexpr Header = std::array<unsigned char, 4U>{ 0xFF, 0xFF, 0xFF, 0xFF };
+    EXPECT_EQ(static_cast<ssize_t>(std::size(Header)), write(sockfd, std::data(Header), std::size(Header)));
+    EXPECT_FALSE(readMessage(sockfd));
+
+    close(sockfd);
+}
+
+TEST_F(RpcLocalTest, changingThePathMovesTheListener)
+{
+    auto const http_path = tr_pathbuf{ sandboxDir(), "/http.sock"sv };
+    auto const first_path = tr_pathbuf{ sandboxDir(), "/first.sock"sv };
+    auto const second_path = tr_pathbuf{ sandboxDir(), "/second.sock"sv };
+
+    auto const set_local_socket = [this, &http_path](std::string_view const path)
+    {
+        auto settings = tr_sessionGetSettings(session_);
+        auto* const map = settings.get_if<tr_variant::Map>();
+        ASSERT_NE(nullptr, map);
+        map->insert_or_assign(TR_KEY_rpc_enabled, true);
+        map->insert_or_assign(TR_KEY_rpc_bind_address, fmt::format("unix:{:s}", http_path));
+        map->insert_or_assign(TR_KEY_rpc_local_socket, path);
+        tr_sessionSet(session_, settings);
+    };
+
+    set_local_socket(first_path);
+    EXPECT_TRUE(waitFor([&first_path]() { return tr_sys_path_exists(first_path); }, 5s));
+
+    // changing the path while running moves the listener without a restart
+    set_local_socket(second_path);
+    EXPECT_TRUE(waitFor([&second_path]() { return tr_sys_path_exists(second_path); }, 5s));
+    EXPECT_FALSE(tr_sys_path_exists(first_path));
+
+    // and clearing it stops listening
+    set_local_socket(""sv);
+    EXPECT_TRUE(waitFor([&second_path]() { return !tr_sys_path_exists(second_path); }, 5s));
+}
+
+} // namespace tr::test
+
+#endif
@@ -0,0 +1,128 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include <gtest/gtest.h>
+
+#include <libtransmission/error.h>
+#include <libtransmission/rpc-server.h>
+#include <libtransmission/tr-strbuf.h>
+
+#include "test-fixtures.h"
+
+using namespace std::literals;
+
+namespace tr::test
+{
+
+using RpcServerTest = SandboxedTest;
+
+namespace
+{
+// repetitive enough that gzip makes it smaller
+std::string makeCompressible(char const ch)
+{
+    auto content = std::string{ "<html><body>" };
+    for (int i = 0; i < 64; ++i)
+    {
+        content += fmt::format("<p>{:c}{:c}{:c}</p>\n", ch, ch, ch);
+    }
+    content += "</body></html>";
+    return content;
+}
+} // namespace
+
+TEST_F(RpcServerTest, webFilesAreCachedUntilTheyChange)
+{
+    auto const filename = tr_pathbuf{ sandboxDir(), "/index.html"sv };
+    auto const first_content = makeCompressible('a');
+    createFileWithContents(filename, first_content);
+
+    auto files = tr_rpc_web_files{};
+    auto error = tr_error{};
+    auto const first = files.get(filename, &error);
+    ASSERT_TRUE(first);
+    EXPECT_FALSE(error) << error;
+    EXPECT_EQ(first_content, first->content);
+    EXPECT_EQ(1U, files.size());
+
+    // an unchanged file is served from the cache
+    EXPECT_EQ(first, files.get(filename, &error));
+    EXPECT_EQ(1U, files.size());
+
+    // a changed file is read again and replaces the old one
+    auto const second_content = makeCompressible('b') + "<!-- changed -->";
+    createFileWithContents(filename, second_content);
+    auto const second = files.get(filename, &error);
+    ASSERT_TRUE(second);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(second_content, second->content);
+    EXPECT_NE(first->etag, second->etag);
+    EXPECT_EQ(1U, files.size());
+
+    // a missing file is an error
+    EXPECT_FALSE(files.get(tr_pathbuf{ sandboxDir(), "/missing.html"sv }, &error));
+    EXPECT_TRUE(error);
+}
+
+TEST_F(RpcServerTest, webFilesHaveAnEtagPerEncoding)
+{
+    auto const filename = tr_pathbuf{ sandboxDir(), "/index.html"sv };
+    createFileWithContents(filename, makeCompressible('a'));
+
+    auto files = tr_rpc_web_files{};
+    auto const file = files.get(filename, nullptr);
+    ASSERT_TRUE(file);
+    ASSERT_FALSE(std::empty(file->gzipped));
+    EXPECT_LT(std::size(file->gzipped), std::size(file->content));
+
+    // the gzipped and identity bodies must not share a strong validator
+    EXPECT_TRUE(file->use_gzip(true));
+    EXPECT_FALSE(file->use_gzip(false));
+    EXPECT_NE(file->etag, file->gzipped_etag);
+    EXPECT_EQ(file->gzipped_etag, file->etag_for(true));
+    EXPECT_EQ(file->etag, file->etag_for(false));
+
+    // files that gzip can't shrink are always sent as-is
+    auto const tiny_filename = tr_pathbuf{ sandboxDir(), "/tiny.txt"sv };
+    createFileWithContents(tiny_filename, "x"sv);
+    auto const tiny = files.get(tiny_filename, nullptr);
+    ASSERT_TRUE(tiny);
+    EXPECT_TRUE(std::empty(tiny->gzipped));
+    EXPECT_FALSE(tiny->use_gzip(true));
+}
+
+TEST_F(RpcServerTest, webFilesAreNotModifiedOnlyForTheSameEncoding)
+{
+    auto const filename = tr_pathbuf{ sandboxDir(), "/index.html"sv };
+    createFileWithContents(filename, makeCompressible('a'));
+
+    auto files = tr_rpc_web_files{};
+    auto const file = files.get(filename, nullptr);
+    ASSERT_TRUE(file);
+
+    // a client that has the body it would be sent gets a 304
+    EXPECT_TRUE(file->is_not_modified(false, file->etag));
+    EXPECT_TRUE(file->is_not_modified(true, file->gzipped_etag));
+    EXPECT_TRUE(file->is_not_modified(true, fmt::format("W/{:s}", file->gzipped_etag)));
+    EXPECT_TRUE(file->is_not_modified(false, fmt::format(R"("nope", {:s})", file->etag)));
+
+    // but not if it has the other encoding's body
+    EXPECT_FALSE(file->is_not_modified(true, file->etag));
+    EXPECT_FALSE(file->is_not_modified(false, file->gzipped_etag));
+
+    // or an older version of the file
+    auto const old_etag = file->etag;
+    createFileWithContents(filename, makeCompressible('b') + "<!-- changed -->");
+    auto const changed = files.get(filename, nullptr);
+    ASSERT_TRUE(changed);
+    EXPECT_FALSE(changed->is_not_modified(false, old_etag));
+}
+
+} // namespace tr::test
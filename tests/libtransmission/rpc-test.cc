@@ -5,16 +5,24 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef> // size_t
 #include <cstdint> // int64_t
 #include <future>
 #include <iterator> // std::inserter
+#include <optional>
 #include <set>
+#include <string>
 #include <string_view>
 #include <vector>
 
+#include <fmt/format.h>
+
 #include <gtest/gtest.h>
 
+#include <libtransmission/crypto-utils.h>
+#include <libtransmission/file-utils.h>
 #include <libtransmission/quark.h>
 #include <libtransmission/transmission.h>
 #include <libtransmission/rpcimpl.h>
@@ -48,6 +56,69 @@ namespace
 
     return serde.to_string(response);
 }
+
+// Checks that `benc` holds the same values as `json`. Bencode has no bool,
+// real, or null types, so those are written as ints and strings instead.
+void expectBencMatchesJson(tr_variant const& json, tr_variant const& benc, std::string const& path = "$")
+{
+    switch (json.index())
+    {
+    case tr_variant::NullIndex:
+        EXPECT_EQ(""sv, benc.value_if<std::string_view>()) << path;
+        break;
+
+    case tr_variant::BoolIndex:
+        EXPECT_EQ(std::optional<int64_t>{ *json.value_if<bool>() ? 1 : 0 }, benc.value_if<int64_t>()) << path;
+        break;
+
+    case tr_variant::IntIndex:
+        EXPECT_EQ(json.value_if<int64_t>(), benc.value_if<int64_t>()) << path;
+        break;
+
+    case tr_variant::DoubleIndex:
+        EXPECT_TRUE(benc.value_if<std::string_view>()) << path;
+        EXPECT_EQ(json.value_if<double>(), benc.value_if<double>()) << path;
+        break;
+
+    case tr_variant::StringIndex:
+    case tr_variant::StringViewIndex:
+        EXPECT_EQ(json.value_if<std::string_view>(), benc.value_if<std::string_view>()) << path;
+        break;
+
+    case tr_variant::VectorIndex:
+        {
+            auto const& json_vec = *json.get_if<tr_variant::Vector>();
+            auto const* const benc_vec = benc.get_if<tr_variant::Vector>();
+            ASSERT_NE(nullptr, benc_vec) << path;
+            ASSERT_EQ(std::size(json_vec), std::size(*benc_vec)) << path;
+            for (size_t idx = 0U, n = std::size(json_vec); idx < n; ++idx)
+            {
+                expectBencMatchesJson(json_vec[idx], (*benc_vec)[idx], fmt::format("{:s}[{:d}]", path, idx));
+            }
+        }
+        break;
+
+    case tr_variant::MapIndex:
+        {
+            auto const& json_map = *json.get_if<tr_variant::Map>();
+            auto const* const benc_map = benc.get_if<tr_variant::Map>();
+            ASSERT_NE(nullptr, benc_map) << path;
+            ASSERT_EQ(std::size(json_map), std::size(*benc_map)) << path;
+            for (auto const& [key, child] : json_map)
+            {
+                auto const child_path = fmt::format("{:s}.{:s}", path, tr_quark_get_string_view(key));
+                auto const iter = benc_map->find(key);
+                ASSERT_NE(std::end(*benc_map), iter) << child_path;
+                expectBencMatchesJson(child, iter->second, child_path);
+            }
+        }
+        break;
+
+    default:
+        ADD_FAILURE() << path << " has unexpected type " << json.index();
+        break;
+    }
+}
 } // namespace
 
 TEST_F(RpcTest, EmptyRequest)
@@ -726,6 +797,242 @@ TEST_F(RpcTest, torrentGet)
     tr_torrentRemove(tor, false);
 }
 
+TEST_F(RpcTest, eventSourceSendsOnlyChangedFields)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    ASSERT_NE(nullptr, tor);
+
+    auto params = tr_variant::Map{ 1U };
+    auto fields = tr_variant::Vector{};
+    fields.emplace_back(tr_quark_get_string_view(TR_KEY_labels));
+    fields.emplace_back(tr_quark_get_string_view(TR_KEY_name));
+    fields.emplace_back("not_a_field"sv);
+    params.try_emplace(TR_KEY_fields, std::move(fields));
+
+    auto source = tr_rpc_event_source{ session_, params };
+    EXPECT_TRUE(source.is_valid());
+
+    // the first event is a snapshot
+    auto event = source.next();
+    auto const* event_map = event.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, event_map);
+    EXPECT_EQ(nullptr, event_map->find_if<tr_variant::Map>(TR_KEY_session_stats));
+    auto const* torrents = event_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    ASSERT_EQ(1U, std::size(*torrents));
+    auto const* torrent_map = (*torrents)[0].get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, torrent_map);
+    EXPECT_EQ(3U, std::size(*torrent_map));
+    EXPECT_EQ(tor->id(), torrent_map->value_if<int64_t>(TR_KEY_id));
+    EXPECT_EQ(tor->name(), torrent_map->value_if<std::string_view>(TR_KEY_name));
+
+    // nothing changed, so there's nothing to send
+    EXPECT_FALSE(source.next().has_value());
+
+    // only the changed field is sent
+    tor->set_labels({ tr_interned_string{ "foo"sv } });
+    event = source.next();
+    event_map = event.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, event_map);
+    torrents = event_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    ASSERT_EQ(1U, std::size(*torrents));
+    torrent_map = (*torrents)[0].get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, torrent_map);
+    EXPECT_EQ(2U, std::size(*torrent_map));
+    EXPECT_EQ(tor->id(), torrent_map->value_if<int64_t>(TR_KEY_id));
+    EXPECT_NE(nullptr, torrent_map->find_if<tr_variant::Vector>(TR_KEY_labels));
+
+    // removed torrents are listed once
+    auto const id = tor->id();
+    tr_torrentRemove(tor, false);
+    EXPECT_TRUE(waitFor([this, id]() { return session_->torrents().get(id) == nullptr; }, 5000));
+    event = source.next();
+    event_map = event.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, event_map);
+    auto const* removed = event_map->find_if<tr_variant::Vector>(TR_KEY_removed);
+    ASSERT_NE(nullptr, removed);
+    ASSERT_EQ(1U, std::size(*removed));
+    EXPECT_EQ(id, (*removed)[0].value_if<int64_t>());
+    EXPECT_FALSE(source.next().has_value());
+}
+
+TEST_F(RpcTest, eventSourceNeedsFieldsOrSessionStats)
+{
+    EXPECT_FALSE((tr_rpc_event_source{ session_, tr_variant::Map{} }.is_valid()));
+
+    auto params = tr_variant::Map{ 1U };
+    params.try_emplace(TR_KEY_session_stats, true);
+    auto source = tr_rpc_event_source{ session_, params };
+    EXPECT_TRUE(source.is_valid());
+
+    auto const event = source.next();
+    auto const* const event_map = event.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, event_map);
+    auto const* const stats_map = event_map->find_if<tr_variant::Map>(TR_KEY_session_stats);
+    ASSERT_NE(nullptr, stats_map);
+    EXPECT_EQ(0, stats_map->value_if<int64_t>(TR_KEY_torrent_count));
+    EXPECT_EQ(nullptr, event_map->find_if<tr_variant::Vector>(TR_KEY_torrents));
+}
+
+TEST_F(RpcTest, torrentGetChangedSinceSendsOnlyChangedGroups)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    ASSERT_NE(nullptr, tor);
+
+    auto const torrent_get = [this](uint64_t const changed_since)
+    {
+        auto const request = fmt::format(
+            R"json({{"jsonrpc":"2.0","method":"torrent_get","id":1,)json"
+            R"json("params":{{"fields":["labels","name","priorities"],"changed_since":{:d}}}}})json",
+            changed_since);
+        auto response = tr_variant{};
+        tr_rpc_request_exec_json(
+            session_,
+            request,
+            [&response](std::string&& json) { response = tr_variant_serde::json().parse(json).value_or(tr_variant{}); });
+
+        auto result = tr_variant{};
+        if (auto* const response_map = response.get_if<tr_variant::Map>(); response_map != nullptr)
+        {
+            if (auto* const result_map = response_map->find_if<tr_variant::Map>(TR_KEY_result); result_map != nullptr)
+            {
+                result = std::move(*result_map);
+            }
+        }
+        return result;
+    };
+
+    // the first request gets everything
+    auto result = torrent_get(0U);
+    auto const* result_map = result.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, result_map);
+    auto epoch = result_map->value_if<int64_t>(TR_KEY_change_epoch);
+    ASSERT_TRUE(epoch);
+    auto const* torrents = result_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    ASSERT_EQ(1U, std::size(*torrents));
+    auto const* torrent_map = (*torrents)[0].get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, torrent_map);
+    EXPECT_EQ(4U, std::size(*torrent_map));
+
+    // nothing changed, so there's nothing to send
+    result = torrent_get(*epoch);
+    result_map = result.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, result_map);
+    EXPECT_EQ(epoch, result_map->value_if<int64_t>(TR_KEY_change_epoch));
+    torrents = result_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    EXPECT_TRUE(std::empty(*torrents));
+
+    // an epoch from a previous session gets everything
+    result = torrent_get(*epoch + 1000U);
+    result_map = result.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, result_map);
+    torrents = result_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    EXPECT_EQ(1U, std::size(*torrents));
+
+    // only the changed group's fields are sent
+    tor->set_labels({ tr_interned_string{ "foo"sv } });
+    result = torrent_get(*epoch);
+    result_map = result.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, result_map);
+    EXPECT_GT(result_map->value_if<int64_t>(TR_KEY_change_epoch), epoch);
+    epoch = result_map->value_if<int64_t>(TR_KEY_change_epoch);
+    torrents = result_map->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, torrents);
+    ASSERT_EQ(1U, std::size(*torrents));
+    torrent_map = (*torrents)[0].get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, torrent_map);
+    EXPECT_EQ(3U, std::size(*torrent_map));
+    EXPECT_EQ(tor->id(), torrent_map->value_if<int64_t>(TR_KEY_id));
+    EXPECT_NE(nullptr, torrent_map->find_if<tr_variant::Vector>(TR_KEY_labels));
+    EXPECT_EQ(tor->name(), torrent_map->value_if<std::string_view>(TR_KEY_name));
+    EXPECT_EQ(nullptr, torrent_map->find_if<tr_variant::Vector>(TR_KEY_priorities));
+
+    // removed torrents are listed
+    auto const id = tor->id();
+    tr_torrentRemove(tor, false);
+    EXPECT_TRUE(waitFor([this, id]() { return session_->torrents().get(id) == nullptr; }, 5000));
+    result = torrent_get(*epoch);
+    result_map = result.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, result_map);
+    auto const* removed = result_map->find_if<tr_variant::Vector>(TR_KEY_removed);
+    ASSERT_NE(nullptr, removed);
+    ASSERT_EQ(1U, std::size(*removed));
+    EXPECT_EQ(id, (*removed)[0].value_if<int64_t>());
+}
+
+TEST_F(RpcTest, torrentAddBatchAnswersEachTorrent)
+{
+    static auto constexpr TorrentFile = LIBTRANSMISSION_TEST_ASSETS_DIR "/debian-11.2.0-amd64-DVD-1.iso.torrent"sv;
+    static auto constexpr MagnetLink = "magnet:?xt=urn:btih:d2354010a3ca4ade5b7427bb093a62a3899ff381&dn=Test"sv;
+
+    auto contents = std::vector<char>{};
+    ASSERT_TRUE(tr_file_read(TorrentFile, contents));
+    auto const metainfo = tr_base64_encode({ std::data(contents), std::size(contents) });
+
+    auto const make_args = [](tr_quark const key, std::string_view const val)
+    {
+        auto args = tr_variant::Map{ 2U };
+        args.try_emplace(key, val);
+        args.try_emplace(TR_KEY_paused, true);
+        return args;
+    };
+
+    auto torrents = tr_variant::Vector{};
+    torrents.emplace_back(make_args(TR_KEY_metainfo, metainfo));
+    torrents.emplace_back(make_args(TR_KEY_metainfo, metainfo));
+    torrents.emplace_back(make_args(TR_KEY_filename, MagnetLink));
+    torrents.emplace_back(42);
+    torrents.emplace_back(make_args(TR_KEY_metainfo, "Zm9v"sv));
+
+    auto params = tr_variant::Map{ 1U };
+    params.try_emplace(TR_KEY_torrents, std::move(torrents));
+
+    auto request_map = tr_variant::Map{ 4U };
+    request_map.try_emplace(TR_KEY_jsonrpc, JsonRpc::Version);
+    request_map.try_emplace(TR_KEY_method, tr_variant::unmanaged_string(TR_KEY_torrent_add_batch));
+    request_map.try_emplace(TR_KEY_params, std::move(params));
+    request_map.try_emplace(TR_KEY_id, 12345);
+
+    auto request = tr_variant{ std::move(request_map) };
+    auto promise = std::promise<tr_variant>{};
+    auto future = promise.get_future();
+    tr_rpc_request_exec(session_, request, [&promise](tr_variant&& resp) { promise.set_value(std::move(resp)); });
+    auto const response = future.get();
+
+    auto const* const response_map = response.get_if<tr_variant::Map>();
+    ASSERT_NE(nullptr, response_map);
+    auto const* const result = response_map->find_if<tr_variant::Map>(TR_KEY_result);
+    ASSERT_NE(nullptr, result);
+    auto const* const results = result->find_if<tr_variant::Vector>(TR_KEY_torrents);
+    ASSERT_NE(nullptr, results);
+    ASSERT_EQ(5U, std::size(*results));
+
+    // results are in the request's order, and the torrents were added in it too
+    auto const get_key = [results](size_t const idx)
+    {
+        auto const* const map = (*results)[idx].get_if<tr_variant::Map>();
+        return map != nullptr && std::size(*map) == 1U ? std::begin(*map)->first : tr_quark{ TR_KEY_NONE };
+    };
+    EXPECT_EQ(TR_KEY_torrent_added, get_key(0U));
+    EXPECT_EQ(TR_KEY_torrent_duplicate, get_key(1U));
+    EXPECT_EQ(TR_KEY_torrent_added, get_key(2U));
+    EXPECT_EQ(TR_KEY_error, get_key(3U));
+    EXPECT_EQ(TR_KEY_error, get_key(4U));
+    EXPECT_EQ(2U, std::size(session_->torrents()));
+
+    auto const get_error_code = [results](size_t const idx)
+    {
+        auto const* const error = (*results)[idx].get_if<tr_variant::Map>()->find_if<tr_variant::Map>(TR_KEY_error);
+        return error != nullptr ? error->value_if<int64_t>(TR_KEY_code) : std::nullopt;
+    };
+    EXPECT_EQ(JsonRpc::Error::INVALID_PARAMS, get_error_code(3U));
+    EXPECT_EQ(JsonRpc::Error::UNRECOGNIZED_INFO, get_error_code(4U));
+}
+
 TEST_F(RpcTest, recentlyActiveEmptyOnStartup)
 {
     static auto constexpr TorrentFile = LIBTRANSMISSION_TEST_ASSETS_DIR "/debian-11.2.0-amd64-DVD-1.iso.torrent"sv;
@@ -836,6 +1143,238 @@ constexpr std::string_view BadResponse = R"json({
     "jsonrpc": "2.0"
 })json";
 
+TEST_F(RpcTest, torrentGetLegacyJsonMatchesConvertedResponse)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    EXPECT_NE(nullptr, tor);
+
+    static auto constexpr Requests = std::array{
+        R"json({"method":"torrent-get","arguments":{"fields":["id","downloadDir","totalSize"]},"tag":7})json"sv,
+        R"json({"method":"torrent-get","arguments":{"fields":["id","hashString"],"format":"table"},"tag":8})json"sv,
+        R"json({"method":"session-get","arguments":{"fields":["download-dir","peer-port"]},"tag":9})json"sv,
+        R"json({"method":"no-such-method","tag":10})json"sv,
+    };
+
+    for (auto const request : Requests)
+    {
+        // the keys of legacy responses are renamed while serializing,
+        // so this skips a pass over the response. It should look the same.
+        auto expected = std::string{};
+        tr_rpc_request_exec(
+            session_,
+            request,
+            [&expected](tr_variant&& resp) { expected = tr_variant_serde::json().compact().to_string(resp); });
+
+        auto actual = std::string{};
+        tr_rpc_request_exec_json(session_, request, [&actual](std::string&& json) { actual = std::move(json); });
+
+        EXPECT_FALSE(std::empty(actual)) << request;
+        EXPECT_EQ(expected, actual) << request;
+    }
+
+    // cleanup
+    tr_torrentRemove(tor, false);
+}
+
+TEST_F(RpcTest, bencRequestsAndResponsesMatchJson)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    EXPECT_NE(nullptr, tor);
+
+    // a real that needs more than six decimal places to round-trip
+    tr_sessionSetRatioLimit(session_, 0.1234567);
+
+    static auto constexpr Requests = std::array{
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id","total_size","percent_done"]},"id":1})json"sv,
+        R"json({"jsonrpc":"2.0","method":"session_get","params":{"fields":["seed_ratio_limit","seed_ratio_limited"]},)json"
+        R"json("id":null})json"sv,
+        R"json({"method":"torrent-get","arguments":{"fields":["id","downloadDir","totalSize"]},"tag":2})json"sv,
+        R"json({"jsonrpc":"2.0","method":"no_such_method","id":3})json"sv,
+    };
+
+    for (auto const request : Requests)
+    {
+        auto json = std::string{};
+        tr_rpc_request_exec_json(session_, request, [&json](std::string&& response) { json = std::move(response); });
+        auto const expected = tr_variant_serde::json().parse(json);
+        ASSERT_TRUE(expected) << request;
+
+        auto const benc_request = tr_variant_serde::benc().to_string(*tr_variant_serde::json().parse(request));
+        auto benc = std::string{};
+        tr_rpc_request_exec_serialized(
+            session_,
+            benc_request,
+            tr_rpc_encoding::Benc,
+            tr_rpc_encoding::Benc,
+            [&benc](std::string&& response) { benc = std::move(response); });
+
+        auto const actual = tr_variant_serde::benc().parse(benc);
+        ASSERT_TRUE(actual) << request;
+        expectBencMatchesJson(*expected, *actual);
+    }
+
+    // cleanup
+    tr_torrentRemove(tor, false);
+}
+
+TEST_F(RpcTest, snapshotMatchesSessionThreadResponses)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    EXPECT_NE(nullptr, tor);
+
+    auto const snapshot = tr_rpc_snapshot{ session_ };
+    EXPECT_TRUE(snapshot.is_current());
+
+    auto const tor_id = std::to_string(tor->id());
+    auto const requests = std::array{
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id","percent_done","peers_from"]},"id":1})json"s,
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id","error"],"format":"table","ids":[)json"s +
+            tor_id + R"json(,9999]},"id":"two"})json"s,
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id","queue_position"],"ids":)json"s + tor_id +
+            R"json(},"id":3})json"s,
+    };
+
+    for (auto const& request : requests)
+    {
+        auto expected = std::string{};
+        tr_rpc_request_exec_json(session_, request, [&expected](std::string&& json) { expected = std::move(json); });
+
+        auto const actual = snapshot.exec_json(request);
+        ASSERT_TRUE(actual) << request;
+        EXPECT_EQ(expected, *actual) << request;
+
+        // bencoded requests can be answered too
+        auto const benc_request = tr_variant_serde::benc().to_string(*tr_variant_serde::json().parse(request));
+        tr_rpc_request_exec_serialized(
+            session_,
+            benc_request,
+            tr_rpc_encoding::Benc,
+            tr_rpc_encoding::Benc,
+            [&expected](std::string&& benc) { expected = std::move(benc); });
+        auto const benc_actual = snapshot.exec_serialized(benc_request, tr_rpc_encoding::Benc, tr_rpc_encoding::Benc);
+        ASSERT_TRUE(benc_actual) << request;
+        EXPECT_EQ(expected, *benc_actual) << request;
+    }
+
+    auto const stats = snapshot.exec_json(R"json({"jsonrpc":"2.0","method":"session_stats","id":5})json"sv);
+    ASSERT_TRUE(stats);
+    EXPECT_NE(std::string::npos, stats->find(R"("torrent_count":1)"sv)) << *stats;
+
+    // cleanup
+    tr_torrentRemove(tor, false);
+}
+
+TEST_F(RpcTest, snapshotLeavesOtherRequestsToSessionThread)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::NoFiles);
+    EXPECT_NE(nullptr, tor);
+
+    auto const snapshot = tr_rpc_snapshot{ session_ };
+
+    static auto constexpr Unanswerable = std::array{
+        // not every field comes from tr_stat
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id","name"]},"id":1})json"sv,
+        // ids that need a lookup
+        R"json({"jsonrpc":"2.0","method":"torrent_get","params":{"fields":["id"],"ids":"recently_active"},"id":2})json"sv,
+        // methods that aren't in the snapshot
+        R"json({"jsonrpc":"2.0","method":"session_get","id":3})json"sv,
+        R"json({"jsonrpc":"2.0","method":"torrent_stop","id":4})json"sv,
+        R"json({"jsonrpc":"2.0","method":"free_space","params":{"path":"/"},"id":4})json"sv,
+        // legacy and batch requests
+        R"json({"method":"session-stats","tag":5})json"sv,
+        R"json([{"jsonrpc":"2.0","method":"session_stats","id":6}])json"sv,
+    };
+
+    for (auto const request : Unanswerable)
+    {
+        EXPECT_FALSE(snapshot.exec_json(request)) << request;
+    }
+
+    // read-only notifications don't have responses
+    auto const notification = snapshot.exec_json(R"json({"jsonrpc":"2.0","method":"session_stats"})json"sv);
+    ASSERT_TRUE(notification);
+    EXPECT_EQ(""sv, *notification);
+
+    // a method with side effects makes the snapshot out of date
+    static auto constexpr Request = R"json({"jsonrpc":"2.0","method":"session_stats","id":7})json"sv;
+    EXPECT_TRUE(snapshot.exec_json(Request));
+    tr_rpc_request_exec_json(session_, R"json({"jsonrpc":"2.0","method":"torrent_stop","id":8})json"sv, [](std::string&&) {});
+    EXPECT_FALSE(snapshot.is_current());
+    EXPECT_FALSE(snapshot.exec_json(Request));
+
+    // cleanup
+    tr_torrentRemove(tor, false);
+}
+
+TEST_F(RpcTest, snapshotIsOutOfDateAfterAsyncWorkFinishes)
+{
+    auto* tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    EXPECT_NE(nullptr, tor);
+
+    // hold up the session thread so that the rename can't finish yet
+    auto release = std::promise<void>{};
+    auto released = release.get_future().share();
+    session_->run_in_session_thread([released]() { released.wait(); });
+
+    auto done = std::atomic<bool>{};
+    auto const request = fmt::format(
+        R"json({{"jsonrpc":"2.0","method":"torrent_rename_path",)json"
+        R"json("params":{{"ids":[{:d}],"path":"{:s}","name":"renamed"}},"id":1}})json",
+        tor->id(),
+        tor->name());
+    tr_rpc_request_exec_json(session_, request, [&done](std::string&& /*response*/) { done = true; });
+
+    // a snapshot taken while the rename is in progress...
+    auto const snapshot = tr_rpc_snapshot{ session_ };
+    EXPECT_TRUE(snapshot.is_current());
+    EXPECT_FALSE(done.load());
+
+    // ...is out of date once the rename is done
+    release.set_value();
+    EXPECT_TRUE(waitFor([&done]() { return done.load(); }, 5s));
+    EXPECT_FALSE(snapshot.is_current());
+
+    // cleanup
+    tr_torrentRemove(tor, false);
+}
+
+TEST_F(RpcTest, latencyHistogramBuckets)
+{
+    auto latency = tr_rpc_latency{};
+    latency.record(TR_KEY_torrent_get, 10us, false);
+    latency.record(TR_KEY_torrent_get, 100us, true);
+    latency.record(TR_KEY_torrent_get, 1h, false);
+    latency.record(TR_KEY_name, 10us, false); // not a method
+
+    auto const map = latency.to_map();
+    EXPECT_EQ(1U, std::size(map));
+
+    auto const* const method_map = map.find_if<tr_variant::Map>(TR_KEY_torrent_get);
+    ASSERT_NE(nullptr, method_map);
+    EXPECT_EQ(3, method_map->value_if<int64_t>(TR_KEY_count));
+    EXPECT_EQ(1, method_map->value_if<int64_t>(TR_KEY_snapshot_count));
+
+    auto const* const buckets = method_map->find_if<tr_variant::Vector>(TR_KEY_buckets);
+    ASSERT_NE(nullptr, buckets);
+    ASSERT_EQ(tr_rpc_latency::NumBuckets, std::size(*buckets));
+    for (size_t i = 0U; i < tr_rpc_latency::NumBuckets; ++i)
+    {
+        auto const expected = i == 0U || i == 1U || i == tr_rpc_latency::NumBuckets - 1U ? 1 : 0;
+        EXPECT_EQ(expected, (*buckets)[i].value_if<int64_t>()) << i;
+    }
+
+    // requests that a tr_rpc_latency is passed to are recorded
+    tr_rpc_request_exec_json(
+        session_,
+        R"json({"jsonrpc":"2.0","method":"session_get","params":{"fields":["version"]},"id":1})json"sv,
+        [](std::string&&) {},
+        &latency);
+    auto const map_after = latency.to_map();
+    auto const* const session_get_map = map_after.find_if<tr_variant::Map>(TR_KEY_session_get);
+    ASSERT_NE(nullptr, session_get_map);
+    EXPECT_EQ(1, session_get_map->value_if<int64_t>(TR_KEY_count));
+}
+
 TEST_F(RpcTest, relativeFreeSpaceError)
 {
     auto constexpr Input = BadRequest;
@@ -293,4 +293,71 @@ TEST_F(TorrentMetainfoTest, preservesInfoDictOrder)
     }
 }
 
+TEST_F(TorrentMetainfoTest, mapPieceHashes)
+{
+    auto const path = tr_pathbuf{ LIBTRANSMISSION_TEST_ASSETS_DIR, "/ubuntu-20.04.4-desktop-amd64.iso.torrent"sv };
+    auto tm = tr_torrent_metainfo{};
+    EXPECT_TRUE(tm.parse_torrent_file(path));
+    EXPECT_FALSE(tm.piece_hashes_mapped());
+
+    auto expected = std::vector<tr_sha1_digest_t>{};
+    for (tr_piece_index_t piece = 0U, n_pieces = tm.piece_count(); piece < n_pieces; ++piece)
+    {
+        expected.emplace_back(tm.piece_hash(piece));
+    }
+
+    auto error = tr_error{};
+    EXPECT_TRUE(tm.map_piece_hashes(path, &error));
+    EXPECT_FALSE(error) << error;
+    EXPECT_TRUE(tm.piece_hashes_mapped());
+    EXPECT_TRUE(tm.has_v1_metadata());
+    for (tr_piece_index_t piece = 0U, n_pieces = tm.piece_count(); piece < n_pieces; ++piece)
+    {
+        EXPECT_EQ(expected[piece], tm.piece_hash(piece));
+    }
+
+    // copies share the mapping
+    auto const copy = tm;
+    EXPECT_TRUE(copy.piece_hashes_mapped());
+    EXPECT_EQ(expected.back(), copy.piece_hash(copy.piece_count() - 1U));
+
+    tm.unmap_piece_hashes();
+    EXPECT_FALSE(tm.piece_hashes_mapped());
+    for (tr_piece_index_t piece = 0U, n_pieces = tm.piece_count(); piece < n_pieces; ++piece)
+    {
+        EXPECT_EQ(expected[piece], tm.piece_hash(piece));
+    }
+}
+
+TEST_F(TorrentMetainfoTest, mapPieceHashesRejectsChangedFile)
+{
+    auto const src = tr_pathbuf{ LIBTRANSMISSION_TEST_ASSETS_DIR, "/ubuntu-20.04.4-desktop-amd64.iso.torrent"sv };
+    auto contents = std::vector<char>{};
+    auto tm = tr_torrent_metainfo{};
+    EXPECT_TRUE(tm.parse_torrent_file(src, &contents));
+    auto const first_hash = tm.piece_hash(0U);
+
+    // corrupt the first piece hash in a copy of the .torrent file
+    auto constexpr Key = "6:pieces"sv;
+    auto const key_pos = std::string_view{ std::data(contents), std::size(contents) }.find(Key);
+    ASSERT_NE(std::string_view::npos, key_pos);
+    auto const colon_pos = std::string_view{ std::data(contents), std::size(contents) }.find(':', key_pos + std::size(Key));
+    ASSERT_NE(std::string_view::npos, colon_pos);
+    ++contents[colon_pos + 1U];
+    auto const path = tr_pathbuf{ sandboxDir(), "/changed.torrent"sv };
+    createFileWithContents(path, std::data(contents), std::size(contents));
+
+    auto error = tr_error{};
+    EXPECT_FALSE(tm.map_piece_hashes(path, &error));
+    EXPECT_TRUE(error);
+    EXPECT_FALSE(tm.piece_hashes_mapped());
+    EXPECT_EQ(first_hash, tm.piece_hash(0U));
+
+    // a missing file can't be mapped either
+    error = {};
+    EXPECT_FALSE(tm.map_piece_hashes(tr_pathbuf{ sandboxDir(), "/missing.torrent"sv }, &error));
+    EXPECT_TRUE(error);
+    EXPECT_FALSE(tm.piece_hashes_mapped());
+}
+
 } // namespace tr::test
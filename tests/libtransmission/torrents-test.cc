@@ -3,6 +3,7 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <algorithm>
 #include <array>
 #include <ctime> // time, size_t, time_t
 #include <memory>
@@ -11,6 +12,8 @@
 #include <utility>
 #include <vector>
 
+#include <fmt/format.h>
+
 #include <gtest/gtest.h>
 
 #include <libtransmission/transmission.h>
@@ -299,6 +302,36 @@ TEST_F(TorrentsTest, removedSince)
     EXPECT_EQ(remove, torrents.removedSince(50));
 }
 
+TEST_F(TorrentsTest, removedSinceEpoch)
+{
+    auto constexpr Filenames = std::array<std::string_view, 3>{ "Android-x86 8.1 r6 iso.torrent"sv,
+                                                                "debian-11.2.0-amd64-DVD-1.iso.torrent"sv,
+                                                                "ubuntu-18.04.6-desktop-amd64.iso.torrent"sv };
+
+    auto owned = std::vector<std::unique_ptr<tr_torrent>>{};
+    auto torrents = tr_torrents{};
+    for (auto const& name : Filenames)
+    {
+        auto tm = tr_torrent_metainfo{};
+        EXPECT_TRUE(tm.parse_torrent_file(tr_pathbuf{ LIBTRANSMISSION_TEST_ASSETS_DIR, '/', name }));
+        owned.emplace_back(std::make_unique<tr_torrent>(std::move(tm)));
+        owned.back()->init_id(torrents.add(owned.back().get()));
+    }
+
+    auto const start = torrents.change_epoch();
+    torrents.remove(owned[0].get(), 100);
+    auto const middle = torrents.change_epoch();
+    EXPECT_GT(middle, start);
+    torrents.remove(owned[1].get(), 100);
+    torrents.remove(owned[2].get(), 100);
+
+    auto expected = std::vector<tr_torrent_id_t>{ owned[0]->id(), owned[1]->id(), owned[2]->id() };
+    EXPECT_EQ(expected, torrents.removed_since_epoch(start));
+    expected = { owned[1]->id(), owned[2]->id() };
+    EXPECT_EQ(expected, torrents.removed_since_epoch(middle));
+    EXPECT_TRUE(std::empty(torrents.removed_since_epoch(torrents.change_epoch())));
+}
+
 using TorrentsPieceSpanTest = tr::test::SessionTest;
 
 TEST_F(TorrentsPieceSpanTest, exposesFilePieceSpan)
@@ -308,3 +341,158 @@ TEST_F(TorrentsPieceSpanTest, exposesFilePieceSpan)
     EXPECT_EQ(file_view.beginPiece, 0);
     EXPECT_EQ(file_view.endPiece, 32);
 }
+
+TEST_F(TorrentsTest, removeKeepsOthersReachable)
+{
+    auto constexpr Filenames = std::array<std::string_view, 4>{ "Android-x86 8.1 r6 iso.torrent"sv,
+                                                                "debian-11.2.0-amd64-DVD-1.iso.torrent"sv,
+                                                                "ubuntu-18.04.6-desktop-amd64.iso.torrent"sv,
+                                                                "ubuntu-20.04.4-desktop-amd64.iso.torrent"sv };
+
+    auto owned = std::vector<std::unique_ptr<tr_torrent>>{};
+    auto torrents = tr_torrents{};
+    auto torrents_v = std::vector<tr_torrent*>{};
+
+    auto const add = [&](std::string_view name)
+    {
+        auto const path = tr_pathbuf{ LIBTRANSMISSION_TEST_ASSETS_DIR, '/', name };
+        auto tm = tr_torrent_metainfo{};
+        EXPECT_TRUE(tm.parse_torrent_file(path));
+        owned.emplace_back(std::make_unique<tr_torrent>(std::move(tm)));
+
+        auto* const tor = owned.back().get();
+        tor->init_id(torrents.add(tor));
+        return tor;
+    };
+
+    for (auto const& name : Filenames)
+    {
+        torrents_v.push_back(add(name));
+    }
+
+    // remove one from the middle
+    auto* const removed = torrents_v[1];
+    torrents.remove(removed, 100);
+    EXPECT_EQ(std::size(Filenames) - 1U, std::size(torrents));
+    EXPECT_EQ(nullptr, torrents.get(removed->id()));
+    EXPECT_EQ(nullptr, torrents.get(removed->info_hash()));
+
+    // the others can still be found by id and by hash
+    auto remaining = std::set<tr_torrent const*>{};
+    for (auto* const tor : torrents_v)
+    {
+        if (tor != removed)
+        {
+            EXPECT_EQ(tor, torrents.get(tor->id()));
+            EXPECT_EQ(tor, torrents.get(tor->info_hash()));
+            remaining.insert(tor);
+        }
+    }
+
+    // iterating visits only the live torrents
+    auto visited = std::set<tr_torrent const*>{};
+    for (auto* const tor : torrents)
+    {
+        EXPECT_NE(nullptr, tor);
+        visited.insert(tor);
+    }
+    EXPECT_EQ(remaining, visited);
+    EXPECT_EQ(std::size(remaining), std::size(torrents.get_all()));
+
+    // removing from the middle reorders the torrents internally, but not what's returned
+    auto const all = torrents.get_all();
+    EXPECT_TRUE(std::ranges::is_sorted(all, {}, &tr_torrent::id));
+
+    // re-adding the torrent gives it a new id instead of reusing the old one
+    auto* const readded = add(Filenames[1]);
+    EXPECT_GT(readded->id(), torrents_v.back()->id());
+    EXPECT_EQ(readded, torrents.get(readded->id()));
+    EXPECT_EQ(readded, torrents.get(readded->info_hash()));
+    EXPECT_EQ(nullptr, torrents.get(removed->id()));
+    EXPECT_EQ(std::size(Filenames), std::size(torrents));
+
+    // remove the last-added torrent too
+    torrents.remove(readded, 200);
+    EXPECT_EQ(nullptr, torrents.get(readded->id()));
+    EXPECT_EQ(std::size(Filenames) - 1U, std::size(torrents));
+}
+
+TEST_F(TorrentsTest, hashLookupsSurviveChurn)
+{
+    static auto constexpr NumTorrents = 1000;
+
+    auto owned = std::vector<std::unique_ptr<tr_torrent>>{};
+    auto torrents = tr_torrents{};
+
+    // Give every eighth torrent the same leading bytes so that
+    // they share a home slot and have to probe past each other.
+    auto const add = [&](int const idx)
+    {
+        auto tm = tr_torrent_metainfo{};
+        EXPECT_TRUE(tm.parseMagnet(fmt::format("magnet:?xt=urn:btih:{:02x}{:014x}{:024x}", idx % 8, 0, idx)));
+        owned.emplace_back(std::make_unique<tr_torrent>(std::move(tm)));
+
+        auto* const tor = owned.back().get();
+        tor->init_id(torrents.add(tor));
+        return tor;
+    };
+
+    auto live = std::vector<tr_torrent*>{};
+    for (int idx = 0; idx < NumTorrents; ++idx)
+    {
+        live.push_back(add(idx));
+    }
+
+    // remove every third one
+    auto removed = std::vector<tr_torrent*>{};
+    for (size_t idx = 0U; idx < std::size(live); idx += 3U)
+    {
+        torrents.remove(live[idx], 100);
+        removed.push_back(live[idx]);
+        live[idx] = nullptr;
+    }
+    std::erase(live, nullptr);
+
+    EXPECT_EQ(std::size(live), std::size(torrents));
+    for (auto* const tor : live)
+    {
+        EXPECT_EQ(tor, torrents.get(tor->info_hash()));
+        EXPECT_EQ(tor, torrents.get(tor->id()));
+    }
+    for (auto const* const tor : removed)
+    {
+        EXPECT_EQ(nullptr, torrents.get(tor->info_hash()));
+    }
+
+    // then remove the rest
+    for (auto const* const tor : live)
+    {
+        torrents.remove(tor, 200);
+        EXPECT_EQ(nullptr, torrents.get(tor->info_hash()));
+    }
+    EXPECT_TRUE(std::empty(torrents));
+}
+
+using TorrentsDirtyTest = tr::test::SessionTest;
+
+TEST_F(TorrentsDirtyTest, popDirtyReturnsOnlyUnsavedTorrents)
+{
+    auto* const tor = zeroTorrentInit(ZeroTorrentState::Complete);
+    auto& torrents = session_->torrents();
+    tor->save_resume_file();
+    (void)torrents.pop_dirty(torrents.dirty_count());
+    EXPECT_EQ(0U, torrents.dirty_count());
+
+    // a torrent is only queued once, no matter how often it changes
+    tr_torrentSetPeerLimit(tor, 10);
+    tr_torrentSetPeerLimit(tor, 20);
+    EXPECT_EQ(1U, torrents.dirty_count());
+    EXPECT_EQ(std::vector<tr_torrent*>{ tor }, torrents.pop_dirty(10U));
+    EXPECT_EQ(0U, torrents.dirty_count());
+    tor->save_resume_file();
+
+    // torrents that were saved since they were queued are skipped
+    tr_torrentSetPeerLimit(tor, 30);
+    tor->save_resume_file();
+    EXPECT_TRUE(std::empty(torrents.pop_dirty(10U)));
+}
@@ -395,6 +395,41 @@ TEST_F(VariantTest, bencSortWhenSerializing)
     EXPECT_EQ(ExpectedOut, serde.to_string(*var));
 }
 
+TEST_F(VariantTest, bencKnownKeysOnly)
+{
+    static auto constexpr In = "d1:md6:ut_pexi1e26:not a known quark at all 1i2ee1:vi3e26:not a known quark at all 2d1:pi4eee"sv;
+    static auto constexpr ExpectedOut = "d1:md6:ut_pexi1ee1:vi3ee"sv;
+
+    auto serde = tr_variant_serde::benc();
+    auto var = serde.inplace().known_keys_only().parse(In);
+    EXPECT_TRUE(var.has_value());
+    EXPECT_EQ(std::data(In) + std::size(In), serde.end());
+    EXPECT_EQ(ExpectedOut, serde.to_string(*var));
+
+    // and no new quarks were added
+    EXPECT_FALSE(tr_quark_lookup("not a known quark at all 1"sv));
+    EXPECT_FALSE(tr_quark_lookup("not a known quark at all 2"sv));
+}
+
+TEST_F(VariantTest, bencRealsRoundTrip)
+{
+    static auto constexpr Reals = std::array{ 0.5, 0.1234567, 1.0 / 3.0, -2.0, 1e100, -1e-300 };
+
+    auto serde = tr_variant_serde::benc();
+    for (auto const real : Reals)
+    {
+        // reals are written as strings, and must read back the same
+        auto const benc = serde.to_string(tr_variant{ real });
+        auto const var = serde.parse(benc);
+        ASSERT_TRUE(var.has_value()) << benc;
+        EXPECT_TRUE(var->value_if<std::string_view>()) << benc;
+        EXPECT_EQ(real, var->value_if<double>()) << benc;
+    }
+
+    EXPECT_EQ("3:0.5"sv, serde.to_string(tr_variant{ 0.5 }));
+    EXPECT_EQ("6:1e+100"sv, serde.to_string(tr_variant{ 1e100 }));
+}
+
 TEST_F(VariantTest, bencMalformedTooManyEndings)
 {
     static auto constexpr In = "leee"sv;
@@ -3,14 +3,27 @@
 // or any future license endorsed by Mnemosyne LLC.
 // License text can be found in the licenses/ folder.
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstdint> // uint16_t
 #include <cstdlib> // std::abort()
 #include <future>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
 
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <fmt/format.h>
+
 #include <libtransmission/web.h>
 
 #include "test-fixtures.h"
@@ -109,3 +122,214 @@ TEST_F(WebTest, destroyWithTaskInFlightDoesNotHang)
             ++n_done;
         });
 }
+
+TEST_F(WebTest, hostStatsCountFinishedRequests)
+{
+    runWithinBudget(
+        [](std::atomic<int>& n_done)
+        {
+            auto mediator = tr_web::Mediator{};
+            auto const web = tr_web::create(mediator);
+            EXPECT_FALSE(web->host_stats("127.0.0.1"sv));
+
+            // Nothing listens on port 1, so this fails quickly.
+            // Failed requests are still counted.
+            auto promise = std::promise<tr_web::FetchResponse>{};
+            auto future = promise.get_future();
+            web->fetch({ "http://127.0.0.1:1/"sv,
+                         [&promise](tr_web::FetchResponse const& response) { promise.set_value(response); },
+                         nullptr,
+                         5s });
+            auto const response = future.get();
+            EXPECT_FALSE(response.multiplexed);
+
+            auto const stats = web->host_stats("127.0.0.1"sv);
+            ASSERT_TRUE(stats);
+            EXPECT_EQ(1U, stats->n_requests);
+            EXPECT_EQ(0U, stats->n_multiplexed);
+            EXPECT_EQ(0U, stats->bytes_downloaded);
+            EXPECT_FALSE(web->host_stats("127.0.0.2"sv));
+
+            auto const all_stats = web->host_stats();
+            ASSERT_EQ(1U, std::size(all_stats));
+            EXPECT_EQ("127.0.0.1"sv, all_stats.front().first);
+            EXPECT_EQ(1U, all_stats.front().second.n_requests);
+            ++n_done;
+        });
+}
+
+#ifndef _WIN32
+
+namespace
+{
+// Answers a single HTTP request on 127.0.0.1 with a canned response.
+class OneShotHttpServer
+{
+public:
+    explicit OneShotHttpServer(std::string response)
+        : response_{ std::move(response) }
+    {
+        auto addr = sockaddr_in{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        auto len = socklen_t{ sizeof(addr) };
+
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_NE(-1, listen_fd_);
+        EXPECT_EQ(0, bind(listen_fd_, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)));
+        EXPECT_EQ(0, listen(listen_fd_, 1));
+        EXPECT_EQ(0, getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len));
+        port_ = ntohs(addr.sin_port);
+
+        thread_ = std::thread{ [this]() { serve(); } };
+    }
+
+    OneShotHttpServer(OneShotHttpServer const&) = delete;
+    OneShotHttpServer(OneShotHttpServer&&) = delete;
+    OneShotHttpServer& operator=(OneShotHttpServer const&) = delete;
+    OneShotHttpServer& operator=(OneShotHttpServer&&) = delete;
+
+    ~OneShotHttpServer()
+    {
+        thread_.join();
+        close(listen_fd_);
+    }
+
+    [[nodiscard]] std::string url() const
+    {
+        return fmt::format("http://127.0.0.1:{:d}/file", port_);
+    }
+
+private:
+    void serve() const
+    {
+        auto const fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd == -1)
+        {
+            return;
+        }
+
+#ifdef SO_NOSIGPIPE
+        auto const on = 1;
+        (void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+#ifdef MSG_NOSIGNAL
+        static auto constexpr SendFlags = MSG_NOSIGNAL;
+#else
+        static auto constexpr SendFlags = 0;
+#endif
+
+        // read the request headers
+        auto request = std::string{};
+        auto buf = std::array<char, 1024>{};
+        while (request.find("\r\n\r\n"sv) == std::string::npos)
+        {
+            auto const n_read = recv(fd, std::data(buf), std::size(buf), 0);
+            if (n_read <= 0)
+            {
+                break;
+            }
+            request.append(std::data(buf), static_cast<size_t>(n_read));
+        }
+
+        // the client may abort partway through
+        auto response = std::string_view{ response_ };
+        while (!std::empty(response))
+        {
+            auto const n_sent = send(fd, std::data(response), std::size(response), SendFlags);
+            if (n_sent <= 0)
+            {
+                break;
+            }
+            response.remove_prefix(static_cast<size_t>(n_sent));
+        }
+
+        close(fd);
+    }
+
+    std::string const response_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::thread thread_;
+};
+
+std::string make_http_response(std::string_view const status, std::string_view const body)
+{
+    return fmt::format(
+        "HTTP/1.1 {:s}\r\nContent-Length: {:d}\r\nConnection: close\r\n\r\n{:s}",
+        status,
+        std::size(body),
+        body);
+}
+
+struct StreamedFetch
+{
+    tr_web::FetchResponse response;
+    std::string streamed;
+    size_t n_calls = 0U;
+};
+
+// Fetch bytes [first..last] from `server`, streaming the body.
+// `max_calls` is how many chunks are accepted before aborting the transfer.
+StreamedFetch fetch_streamed(OneShotHttpServer const& server, uint64_t first, uint64_t last, size_t max_calls = SIZE_MAX)
+{
+    auto mediator = tr_web::Mediator{};
+    auto const web = tr_web::create(mediator);
+
+    auto ret = StreamedFetch{};
+    auto promise = std::promise<tr_web::FetchResponse>{};
+    auto future = promise.get_future();
+    auto options = tr_web::FetchOptions{ server.url(),
+                                         [&promise](tr_web::FetchResponse const& response) { promise.set_value(response); },
+                                         nullptr,
+                                         5s };
+    options.range.emplace(first, last);
+    options.on_data_received = [&ret, max_calls](std::string_view const data)
+    {
+        ret.streamed += data;
+        return ++ret.n_calls < max_calls;
+    };
+    web->fetch(std::move(options));
+    ret.response = future.get();
+    return ret;
+}
+} // namespace
+
+TEST_F(WebTest, rangedFetchStreamsPartialContent)
+{
+    static auto constexpr Body = "0123456789"sv;
+
+    auto const server = OneShotHttpServer{ make_http_response("206 Partial Content"sv, Body) };
+    auto const fetched = fetch_streamed(server, 0U, std::size(Body) - 1U);
+    EXPECT_EQ(206, fetched.response.status);
+    EXPECT_EQ(Body, fetched.streamed);
+    EXPECT_TRUE(std::empty(fetched.response.body));
+}
+
+TEST_F(WebTest, rangedFetchDoesNotStreamFullFile)
+{
+    // a server that ignores `Range` and sends the whole file
+    auto const server = OneShotHttpServer{ make_http_response("200 OK"sv, std::string(64U * 1024U, 'x')) };
+    auto const fetched = fetch_streamed(server, 16U, 31U);
+    EXPECT_EQ(200, fetched.response.status);
+    EXPECT_EQ(0U, fetched.n_calls);
+}
+
+TEST_F(WebTest, rangedFetchDoesNotStreamErrorPage)
+{
+    auto const server = OneShotHttpServer{ make_http_response("404 Not Found"sv, "<html>Not Found</html>"sv) };
+    auto const fetched = fetch_streamed(server, 0U, 9U);
+    EXPECT_EQ(404, fetched.response.status);
+    EXPECT_EQ(0U, fetched.n_calls);
+}
+
+TEST_F(WebTest, streamingCallbackCanAbortTransfer)
+{
+    // the server sends far more than the client wants
+    auto const server = OneShotHttpServer{ make_http_response("206 Partial Content"sv, std::string(4U * 1024U * 1024U, 'x')) };
+    auto const fetched = fetch_streamed(server, 0U, 9U, 1U);
+    EXPECT_EQ(1U, fetched.n_calls);
+    EXPECT_LT(std::size(fetched.streamed), 4U * 1024U * 1024U);
+}
+
+#endif
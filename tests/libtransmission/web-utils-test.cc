@@ -306,3 +306,22 @@ TEST_F(WebUtilsTest, urlPercentEncode)
         EXPECT_EQ(encoded, buf);
     }
 }
+
+TEST_F(WebUtilsTest, etagMatches)
+{
+    static auto constexpr Tests = std::array<std::tuple<std::string_view, std::string_view, bool>, 8U>{ {
+        { R"("abc")"sv, R"("abc")"sv, true },
+        { R"("xyz", "abc")"sv, R"("abc")"sv, true },
+        { R"("xyz","abc" )"sv, R"("abc")"sv, true },
+        { R"(W/"abc")"sv, R"("abc")"sv, true },
+        { " * "sv, R"("abc")"sv, true },
+        { R"("abcd")"sv, R"("abc")"sv, false },
+        { R"(abc)"sv, R"("abc")"sv, false },
+        { ""sv, R"("abc")"sv, false },
+    } };
+
+    for (auto const& [if_none_match, etag, expected] : Tests)
+    {
+        EXPECT_EQ(expected, tr_webEtagMatches(if_none_match, etag)) << if_none_match;
+    }
+}
@@ -0,0 +1,167 @@
+// This file Copyright © Mnemosyne LLC.
+// It may be used under GPLv2 (SPDX: GPL-2.0-only), GPLv3 (SPDX: GPL-3.0-only),
+// or any future license endorsed by Mnemosyne LLC.
+// License text can be found in the licenses/ folder.
+
+#include <cstddef> // size_t
+#include <cstdint> // uint64_t
+#include <vector>
+
+#include <libtransmission/transmission.h>
+
+#include <libtransmission/block-info.h>
+#include <libtransmission/types.h>
+#include <libtransmission/webseed.h>
+
+#include "test-fixtures.h"
+
+using WebseedTest = ::tr::test::TransmissionTest;
+using RequestSizer = tr::webseed::RequestSizer;
+
+namespace
+{
+auto constexpr KiB = uint64_t{ 1024U };
+auto constexpr MiB = KiB * KiB;
+
+// Report a task that received `n_bytes` at `bytes_per_second` after waiting `latency_msec` for the first byte.
+void finish_task(RequestSizer& sizer, uint64_t const n_bytes, uint64_t const bytes_per_second, uint64_t const latency_msec)
+{
+    sizer.task_finished(n_bytes, latency_msec + (n_bytes * 1000U / bytes_per_second), latency_msec);
+}
+
+// How many blocks take `target_msec` to fetch, including `latency_msec` of waiting
+size_t expected_blocks(uint64_t const bytes_per_second, uint64_t const target_msec, uint64_t const latency_msec)
+{
+    return static_cast<size_t>(bytes_per_second * (target_msec - latency_msec) / 1000U / tr_block_info::BlockSize);
+}
+
+void expect_spans(std::vector<tr_block_span_t> const& expected, std::vector<tr_block_span_t> const& actual)
+{
+    ASSERT_EQ(std::size(expected), std::size(actual));
+    for (size_t idx = 0U, n = std::size(expected); idx < n; ++idx)
+    {
+        EXPECT_EQ(expected[idx].begin, actual[idx].begin) << idx;
+        EXPECT_EQ(expected[idx].end, actual[idx].end) << idx;
+    }
+}
+} // namespace
+
+TEST_F(WebseedTest, requestSizerUsesDefaultUntilMeasured)
+{
+    auto const sizer = RequestSizer{};
+    EXPECT_EQ(RequestSizer::DefaultBlocksPerTask, sizer.blocks_per_task());
+}
+
+TEST_F(WebseedTest, requestSizerSizesFromThroughput)
+{
+    static auto constexpr Latency = uint64_t{ 100U };
+
+    // a 1 MiB/s mirror gets ranges that take about `TargetTaskDuration`
+    auto sizer = RequestSizer{};
+    finish_task(sizer, MiB, MiB, Latency);
+    EXPECT_EQ(expected_blocks(MiB, RequestSizer::TargetTaskDuration, Latency), sizer.blocks_per_task());
+
+    // a very slow mirror still gets the minimum
+    sizer = RequestSizer{};
+    finish_task(sizer, 16U * KiB, KiB, Latency);
+    EXPECT_EQ(RequestSizer::MinBlocksPerTask, sizer.blocks_per_task());
+
+    // a very fast mirror is capped at the maximum
+    sizer = RequestSizer{};
+    finish_task(sizer, 64U * MiB, 64U * MiB, Latency);
+    EXPECT_EQ(RequestSizer::MaxBlocksPerTask, sizer.blocks_per_task());
+}
+
+TEST_F(WebseedTest, requestSizerSmoothsThroughput)
+{
+    static auto constexpr Latency = uint64_t{ 100U };
+    static auto constexpr SlowSpeed = 64U * KiB;
+    static auto constexpr FastSpeed = 4U * SlowSpeed;
+
+    auto sizer = RequestSizer{};
+    finish_task(sizer, SlowSpeed, SlowSpeed, Latency);
+    EXPECT_EQ(expected_blocks(SlowSpeed, RequestSizer::TargetTaskDuration, Latency), sizer.blocks_per_task());
+
+    // one fast task moves the estimate a quarter of the way there
+    finish_task(sizer, FastSpeed, FastSpeed, Latency);
+    static auto constexpr SmoothedSpeed = (SlowSpeed * 3U + FastSpeed) / 4U;
+    EXPECT_EQ(expected_blocks(SmoothedSpeed, RequestSizer::TargetTaskDuration, Latency), sizer.blocks_per_task());
+}
+
+TEST_F(WebseedTest, requestSizerGrowsRangesOnHighLatencyLinks)
+{
+    static auto constexpr Speed = 100U * KiB;
+    static auto constexpr LowLatency = uint64_t{ 100U };
+    static auto constexpr HighLatency = uint64_t{ 10000U };
+    static_assert(HighLatency * RequestSizer::LatencyMultiple > RequestSizer::TargetTaskDuration);
+
+    auto low = RequestSizer{};
+    finish_task(low, Speed, Speed, LowLatency);
+    EXPECT_EQ(expected_blocks(Speed, RequestSizer::TargetTaskDuration, LowLatency), low.blocks_per_task());
+
+    // the transfer should still take most of the task's time
+    auto high = RequestSizer{};
+    finish_task(high, Speed, Speed, HighLatency);
+    EXPECT_EQ(expected_blocks(Speed, HighLatency * RequestSizer::LatencyMultiple, HighLatency), high.blocks_per_task());
+    EXPECT_GT(high.blocks_per_task(), low.blocks_per_task());
+}
+
+TEST_F(WebseedTest, requestSizerBacksOffAfterTimeouts)
+{
+    static auto constexpr Latency = uint64_t{ 100U };
+
+    auto sizer = RequestSizer{};
+    finish_task(sizer, MiB, MiB, Latency);
+    auto const n_blocks = sizer.blocks_per_task();
+
+    // a timeout halves the range size
+    sizer.task_timed_out();
+    EXPECT_EQ(n_blocks / 2U, sizer.blocks_per_task());
+
+    // but never below the minimum
+    for (int i = 0; i < 16; ++i)
+    {
+        sizer.task_timed_out();
+    }
+    EXPECT_EQ(RequestSizer::MinBlocksPerTask, sizer.blocks_per_task());
+
+    // each success lets it grow again
+    finish_task(sizer, MiB, MiB, Latency);
+    EXPECT_EQ(RequestSizer::MinBlocksPerTask * 2U, sizer.blocks_per_task());
+    finish_task(sizer, MiB, MiB, Latency);
+    EXPECT_EQ(RequestSizer::MinBlocksPerTask * 4U, sizer.blocks_per_task());
+}
+
+TEST_F(WebseedTest, splitSpansIntoTaskSizedRanges)
+{
+    // a large contiguous want is split for parallel tasks
+    expect_spans({ { 0U, 4U }, { 4U, 8U }, { 8U, 10U } }, tr::webseed::split_spans({ { 0U, 10U } }, 4U, 10U));
+
+    // small wants are left alone
+    expect_spans(
+        { { 0U, 3U }, { 10U, 14U }, { 14U, 18U }, { 18U, 20U } },
+        tr::webseed::split_spans({ { 0U, 3U }, { 10U, 20U } }, 4U, 10U));
+
+    // no more than `max_spans` ranges are made
+    expect_spans({ { 0U, 10U }, { 10U, 20U }, { 20U, 30U } }, tr::webseed::split_spans({ { 0U, 100U } }, 10U, 3U));
+    expect_spans({ { 0U, 10U } }, tr::webseed::split_spans({ { 0U, 10U }, { 20U, 30U } }, 10U, 1U));
+}
+
+TEST_F(WebseedTest, slowMirrorsRunOneTask)
+{
+    static auto constexpr NSlots = size_t{ 4U };
+
+    // the only webseed, or one that's as fast as the others, uses every slot
+    EXPECT_EQ(NSlots, tr::webseed::max_tasks(NSlots, 0U, 0U));
+    EXPECT_EQ(NSlots, tr::webseed::max_tasks(NSlots, 100U * KiB, 100U * KiB));
+
+    // a mirror that's a little slower than the fastest still uses every slot
+    EXPECT_EQ(NSlots, tr::webseed::max_tasks(NSlots, 100U * KiB, 400U * KiB));
+
+    // a mirror that's much slower than the fastest runs only one task
+    EXPECT_EQ(1U, tr::webseed::max_tasks(NSlots, 100U * KiB, 401U * KiB));
+    EXPECT_EQ(1U, tr::webseed::max_tasks(NSlots, 0U, 100U * KiB));
+
+    // but it never gets more tasks than it has slots
+    EXPECT_EQ(0U, tr::webseed::max_tasks(0U, 0U, 100U * KiB));
+}
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <array>
 #include <cctype> // isspace
+#include <cerrno>
 #include <cmath> // floor
 #include <chrono>
 #include <cstdint> // int64_t
@@ -21,6 +22,12 @@
 #include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #include <curl/curl.h>
 
 #include <fmt/chrono.h>
@@ -73,9 +80,13 @@ struct RemoteConfig
     std::string filter;
     std::string netrc;
     std::string session_id;
+    std::string local_socket_path;
     std::string torrent_ids;
     std::string unix_socket_path;
 
+    // the connection to `local_socket_path`, kept open between requests
+    int local_sockfd = -1;
+
     bool debug = false;
     bool json = false;
     bool use_ssl = false;
@@ -218,7 +229,7 @@ enum
 
 using Arg = tr_option::Arg;
 static_assert(TrDefaultPeerPort == 51413, "update 'port' desc");
-auto constexpr Options = std::array<tr_option, 106>{ {
+auto constexpr Options = std::array<tr_option, 107>{ {
     { 'a', "add", "Add torrent files by filename or URL", "a", Arg::None, nullptr },
     { 970, "alt-speed", "Use the alternate Limits", "as", Arg::None, nullptr },
     { 971, "no-alt-speed", "Don't use the alternate Limits", "AS", Arg::None, nullptr },
@@ -265,6 +276,7 @@ auto constexpr Options = std::array<tr_option, 106>{ {
     { 'L', "labels", "Set the current torrents' labels", "L", Arg::Required, "<label[,label...]>" },
     { 960, "move", "Move current torrent's data to a new folder", nullptr, Arg::Required, "<path>" },
     { 968, "unix-socket", "Use a Unix domain socket", nullptr, Arg::Required, "<path>" },
+    { 969, "local-socket", "Use Transmission's local RPC socket instead of HTTP", nullptr, Arg::Required, "<path>" },
     { 961, "find", "Tell Transmission where to find a torrent's data", nullptr, Arg::Required, "<path>" },
     { 964, "rename", "Rename torrents root folder or a file", nullptr, Arg::Required, "<name>" },
     { 965, "path", "Provide path for rename functions", nullptr, Arg::Required, "<path>" },
@@ -433,6 +445,7 @@ enum
     case 'b': /* debug */
     case 'n': /* auth */
     case 968: /* Unix domain socket */
+    case 969: /* local RPC socket */
     case 'j': /* JSON */
     case 810: /* authenv */
     case 'N': /* netrc */
@@ -2241,7 +2254,7 @@ void print_blocklist_size(tr_variant::Map const& result)
     }
 }
 
-int process_response(char const* rpcurl, std::string_view const response, RemoteConfig& config)
+int process_response(char const* rpcurl, std::string_view const response, bool const is_benc, RemoteConfig& config)
 {
     if (config.json)
     {
@@ -2254,7 +2267,7 @@ int process_response(char const* rpcurl, std::string_view const response, Remote
         fmt::print(stderr, "got response (len {:d}):\n--------\n{:s}\n--------\n", std::size(response), response);
     }
 
-    auto parsed = tr_variant_serde::json().inplace().parse(response);
+    auto parsed = (is_benc ? tr_variant_serde::benc() : tr_variant_serde::json()).inplace().parse(response);
     if (!parsed)
     {
         fmt::print(stderr, "Unable to parse response '{}'\n", response);
@@ -2408,11 +2421,25 @@ CURL* tr_curl_easy_init(std::string* writebuf, RemoteConfig& config)
         (void)curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0);
     }
 
+    struct curl_slist* custom_headers = nullptr;
+
     if (auto const& str = config.session_id; !std::empty(str))
     {
         auto const h = fmt::format("{:s}: {:s}", TrRpcSessionIdHeader, str);
-        auto* const custom_headers = curl_slist_append(nullptr, h.c_str());
+        custom_headers = curl_slist_append(custom_headers, h.c_str());
+    }
 
+    // benc is cheaper for the server to write and for us to parse, but
+    // --json prints the response as-is, so keep that human-readable.
+    // Servers that don't support benc ignore this and send JSON.
+    if (!config.json)
+    {
+        auto const h = fmt::format("Accept: {:s}, application/json", TrRpcBencContentType);
+        custom_headers = curl_slist_append(custom_headers, h.c_str());
+    }
+
+    if (custom_headers != nullptr)
+    {
         (void)curl_easy_setopt(curl, CURLOPT_HTTPHEADER, custom_headers);
         (void)curl_easy_setopt(curl, CURLOPT_PRIVATE, custom_headers);
     }
@@ -2442,6 +2469,164 @@ void tr_curl_easy_cleanup(CURL* curl)
 
     return 60L; /* default value */
 }
+
+// --- local RPC socket. See section 2.2.7 of docs/rpc-spec.md
+
+#ifndef _WIN32
+auto constexpr LocalHeaderSize = size_t{ 4U };
+
+[[nodiscard]] bool local_write(int const sockfd, std::string_view data)
+{
+#ifdef MSG_NOSIGNAL
+    auto constexpr Flags = MSG_NOSIGNAL;
+#else
+    auto constexpr Flags = 0;
+#endif
+
+    while (!std::empty(data))
+    {
+        auto const n_written = send(sockfd, std::data(data), std::size(data), Flags);
+        if (n_written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n_written <= 0)
+        {
+            return false;
+        }
+
+        data.remove_prefix(static_cast<size_t>(n_written));
+    }
+
+    return true;
+}
+
+[[nodiscard]] bool local_read(int const sockfd, char* buf, size_t len)
+{
+    while (len > 0U)
+    {
+        auto const n_read = read(sockfd, buf, len);
+        if (n_read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n_read <= 0)
+        {
+            if (n_read == 0)
+            {
+                errno = ECONNRESET;
+            }
+
+            return false;
+        }
+
+        buf += n_read;
+        len -= static_cast<size_t>(n_read);
+    }
+
+    return true;
+}
+
+[[nodiscard]] int local_connect(std::string_view const path)
+{
+    auto addr = sockaddr_un{};
+    if (std::size(path) >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::ranges::copy(path, addr.sun_path);
+
+    auto const sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sockfd == -1)
+    {
+        return -1;
+    }
+
+    if (connect(sockfd, reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)) == -1)
+    {
+        auto const err = errno;
+        close(sockfd);
+        errno = err;
+        return -1;
+    }
+
+    return sockfd;
+}
+#endif
+
+int flush_local(tr_variant const& var, RemoteConfig& config)
+{
+    auto const& path = config.local_socket_path;
+
+#ifdef _WIN32
+    fmt::print(stderr, "Unable to connect to '{}': Unix sockets are unsupported on Windows\n", path);
+    return EXIT_FAILURE;
+#else
+    // benc is cheaper for both ends to write and to parse,
+    // but `--json` prints responses as-is, so ask for JSON then
+    auto serde = config.json ? tr_variant_serde::json() : tr_variant_serde::benc();
+    auto const body = serde.compact().to_string(var);
+    auto const len = static_cast<uint32_t>(std::size(body));
+    auto payload = std::string{};
+    payload.reserve(LocalHeaderSize + std::size(body));
+    payload += static_cast<char>(len >> 24U);
+    payload += static_cast<char>(len >> 16U);
+    payload += static_cast<char>(len >> 8U);
+    payload += static_cast<char>(len);
+    payload += body;
+
+    if (config.debug)
+    {
+        fmt::print(stderr, "sending:\n--------\n{:s}\n--------\n", body);
+    }
+
+    if (config.local_sockfd == -1)
+    {
+        config.local_sockfd = local_connect(path);
+        if (config.local_sockfd == -1)
+        {
+            fmt::print(stderr, "Unable to connect to '{}': {}\n", path, tr_strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto const sockfd = config.local_sockfd;
+    auto header = std::array<unsigned char, LocalHeaderSize>{};
+    auto response = std::string{};
+    auto ok = local_write(sockfd, payload) &&
+        local_read(sockfd, reinterpret_cast<char*>(std::data(header)), std::size(header));
+    if (ok)
+    {
+        response.resize((size_t{ header[0] } << 24U) | (size_t{ header[1] } << 16U) | (size_t{ header[2] } << 8U) | header[3]);
+        ok = local_read(sockfd, std::data(response), std::size(response));
+    }
+
+    if (!ok)
+    {
+        fmt::print(stderr, "Unable to send request to '{}': {}\n", path, tr_strerror(errno));
+        close(sockfd);
+        config.local_sockfd = -1;
+        return EXIT_FAILURE;
+    }
+
+    if (std::empty(response))
+    {
+        if (!config.json)
+        {
+            fmt::print("{:s} acknowledged notification\n", path);
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    return process_response(path.c_str(), response, !config.json, config);
+#endif
+}
 } // namespace flush_utils
 
 int flush(char const* rpcurl, tr_variant* const var, RemoteConfig& config)
@@ -2449,6 +2634,13 @@ int flush(char const* rpcurl, tr_variant* const var, RemoteConfig& config)
     using namespace flush_utils;
 
     api_compat::convert(*var, config.network_style);
+
+    if (!std::empty(config.local_socket_path))
+    {
+        auto const status = flush_local(*var, config);
+        var->clear();
+        return status;
+    }
     auto const payload = tr_variant_serde::json().compact().to_string(*var);
     auto const scheme = config.use_ssl ? "https"sv : "http"sv;
     auto const rpcurl_http = fmt::format("{:s}://{:s}", scheme, rpcurl);
@@ -2478,7 +2670,12 @@ int flush(char const* rpcurl, tr_variant* const var, RemoteConfig& config)
         switch (response)
         {
         case 200:
-            status |= process_response(rpcurl, buf, config);
+            {
+                char const* content_type = nullptr;
+                curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &content_type);
+                auto const is_benc = content_type != nullptr && tr_strv_starts_with(content_type, TrRpcBencContentType);
+                status |= process_response(rpcurl, buf, is_benc, config);
+            }
             break;
 
         case 204:
@@ -2634,6 +2831,10 @@ int process_args(char const* rpcurl, int argc, char const* const* argv, RemoteCo
                 config.unix_socket_path = optarg_sv;
                 break;
 
+            case 969: /* local RPC socket */
+                config.local_socket_path = optarg_sv;
+                break;
+
             case 'n': /* auth */
                 config.auth = optarg_sv;
                 break;
@@ -3644,5 +3845,14 @@ int tr_main(int argc, char* argv[])
         rpcurl = fmt::format("{:s}:{:d}{:s}{:s}", host, port, TrDefaultHttpServerBasePath, TrHttpServerRpcRelativePath);
     }
 
-    return process_args(rpcurl.c_str(), argc, (char const* const*)argv, config);
+    auto const status = process_args(rpcurl.c_str(), argc, (char const* const*)argv, config);
+
+#ifndef _WIN32
+    if (config.local_sockfd != -1)
+    {
+        close(config.local_sockfd);
+    }
+#endif
+
+    return status;
 }